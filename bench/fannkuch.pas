@@ -0,0 +1,105 @@
+program fannkuch;
+{ Pancake flips over every permutation of 1..n, with the permutation packed as the decimal digits of an integer
+  (the language has no arrays yet) and generated by Heap's algorithm }
+var n, max_flips, checksum, sign: integer;
+    perm: integer;
+
+function power(k: integer): integer;
+var i, p: integer;
+begin
+    p := 1;
+    for i := 1 to k do
+        p := p * 10;
+    power := p
+end;
+
+function digit(p, position: integer): integer;
+{ Digit at a position counted from 1 on the left }
+var shift, scale, high: integer;
+begin
+    shift := n - position;
+    scale := power(shift);
+    high := p / scale;
+    digit := high - high / 10 * 10
+end;
+
+procedure swap(var p: integer; a, b: integer);
+var da, db, shift, scale_a, scale_b: integer;
+begin
+    da := digit(p, a);
+    db := digit(p, b);
+    shift := n - a;
+    scale_a := power(shift);
+    shift := n - b;
+    scale_b := power(shift);
+    p := p + (db - da) * scale_a + (da - db) * scale_b
+end;
+
+function flips(p: integer): integer;
+{ Reverses the first d digits while the first digit d is not 1 }
+var count, first, shift, scale, top, head, tail, reversed, i, q: integer;
+begin
+    q := p;
+    count := 0;
+    shift := n - 1;
+    top := power(shift);
+    first := q / top;
+    while first > 1 do
+    begin
+        shift := n - first;
+        scale := power(shift);
+        head := q / scale;
+        tail := q - head * scale;
+        reversed := 0;
+        for i := 1 to first do
+        begin
+            reversed := reversed * 10 + head - head / 10 * 10;
+            head := head / 10
+        end;
+        q := reversed * scale + tail;
+        count := count + 1;
+        first := q / top
+    end;
+    flips := count
+end;
+
+procedure visit(p: integer);
+var count: integer;
+begin
+    count := flips(p);
+    if count > max_flips then
+        max_flips := count;
+    checksum := checksum + sign * count;
+    sign := 0 - sign
+end;
+
+procedure permute(k: integer; var p: integer);
+var i, m, odd: integer;
+begin
+    if k = 1 then
+        visit(p);
+    if k > 1 then
+    begin
+        m := k - 1;
+        odd := k - k / 2 * 2;
+        permute(m, p);
+        for i := 1 to m do
+        begin
+            if odd = 1 then
+                swap(p, 1, k)
+            else
+                swap(p, i, k);
+            permute(m, p)
+        end
+    end
+end;
+
+begin
+    n := 9;
+    perm := 123456789;
+    max_flips := 0;
+    checksum := 0;
+    sign := 1;
+    permute(n, perm);
+    writeln('Pfannkuchen(', n, ') = ', max_flips, ', checksum ', checksum)
+end.
@@ -0,0 +1,21 @@
+program fib;
+{ Recursive calls: fib(35) makes about 30 million of them }
+var n: integer;
+
+function fib(k: integer): integer;
+var a, b: integer;
+begin
+    if k >= 2 then
+    begin
+        a := k - 1;
+        b := k - 2;
+        fib := fib(a) + fib(b)
+    end
+    else
+        fib := k;
+end;
+
+begin
+    n := 35;
+    writeln('fib(', n, ') = ', fib(n))
+end.
@@ -0,0 +1,52 @@
+program matrix;
+{ Real arithmetic: multiplies 3x3 matrices held in scalar variables (the language has no arrays yet), the product
+  of rotations stays a rotation so the values stay bounded }
+var a11, a12, a13, a21, a22, a23, a31, a32, a33,
+    b11, b12, b13, b21, b22, b23, b31, b32, b33,
+    c11, c12, c13, c21, c22, c23, c31, c32, c33: real;
+    step: integer;
+
+begin
+    a11 := 1.0;
+    a12 := 0.0;
+    a13 := 0.0;
+    a21 := 0.0;
+    a22 := 1.0;
+    a23 := 0.0;
+    a31 := 0.0;
+    a32 := 0.0;
+    a33 := 1.0;
+    b11 := 0.999950000;
+    b12 := 0.0 - 0.009997833;
+    b13 := 0.000199983;
+    b21 := 0.009999833;
+    b22 := 0.999750017;
+    b23 := 0.0 - 0.019997667;
+    b31 := 0.000000000;
+    b32 := 0.019998667;
+    b33 := 0.999800007;
+    for step := 1 to 10000000 do
+    begin
+        c11 := a11 * b11 + a12 * b21 + a13 * b31;
+        c12 := a11 * b12 + a12 * b22 + a13 * b32;
+        c13 := a11 * b13 + a12 * b23 + a13 * b33;
+        c21 := a21 * b11 + a22 * b21 + a23 * b31;
+        c22 := a21 * b12 + a22 * b22 + a23 * b32;
+        c23 := a21 * b13 + a22 * b23 + a23 * b33;
+        c31 := a31 * b11 + a32 * b21 + a33 * b31;
+        c32 := a31 * b12 + a32 * b22 + a33 * b32;
+        c33 := a31 * b13 + a32 * b23 + a33 * b33;
+        a11 := c11;
+        a12 := c12;
+        a13 := c13;
+        a21 := c21;
+        a22 := c22;
+        a23 := c23;
+        a31 := c31;
+        a32 := c32;
+        a33 := c33
+    end;
+    writeln(a11:12:6, a12:12:6, a13:12:6);
+    writeln(a21:12:6, a22:12:6, a23:12:6);
+    writeln(a31:12:6, a32:12:6, a33:12:6)
+end.
@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+// Runs a command and writes its wall time in seconds, the instructions it retired (user space, with its children) and
+// its peak resident set size in KiB on one line. The instructions are "-" when the kernel cannot count them (no PMU in
+// a virtual machine or perf_event_paranoid above 2). With several runs the fastest one is kept, and the largest RSS.
+// measure [-r runs] [-i input] [-o output] command [arguments]
+
+typedef struct _Measure {
+    double seconds;
+    int64_t instructions; // -1 when they are not counted
+    long rss; // KiB
+} Measure;
+
+int open_counter(pid_t pid) { // Instructions of the process and its children once it calls exec, -1 when not available
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.enable_on_exec = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(SYS_perf_event_open, &attr, pid, -1, -1, 0);
+}
+
+void run_child(int start_fd, const char *input, const char *output, char **argv) { // Waits for the counter then runs the command
+    char go;
+    if (read(start_fd, &go, 1) != 1)
+        _exit(127);
+    close(start_fd);
+    if (input != NULL) {
+        int fd = open(input, O_RDONLY);
+        if (fd < 0 || dup2(fd, 0) < 0) {
+            fprintf(stderr, "Error: failed to open the input file %s\n", input);
+            _exit(127);
+        }
+        close(fd);
+    }
+    if (output != NULL) {
+        int fd = open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0 || dup2(fd, 1) < 0) {
+            fprintf(stderr, "Error: failed to open the output file %s\n", output);
+            _exit(127);
+        }
+        close(fd);
+    }
+    execvp(argv[0], argv);
+    fprintf(stderr, "Error: failed to run %s\n", argv[0]);
+    _exit(127);
+}
+
+int measure_run(const char *input, const char *output, char **argv, Measure *result) { // 0 when the command fails
+    int start[2];
+    if (pipe(start) < 0) {
+        fprintf(stderr, "Error: failed to create a pipe\n");
+        return 0;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Error: failed to fork\n");
+        return 0;
+    }
+    if (pid == 0) {
+        close(start[1]);
+        run_child(start[0], input, output, argv);
+    }
+    close(start[0]);
+    int counter = open_counter(pid);
+    struct timespec begin, end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    if (write(start[1], "", 1) != 1)
+        fprintf(stderr, "Error: failed to start %s\n", argv[0]);
+    close(start[1]);
+    int status;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) < 0) {
+        fprintf(stderr, "Error: failed to wait for %s\n", argv[0]);
+        return 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    result->seconds = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+    result->rss = usage.ru_maxrss;
+    result->instructions = -1;
+    if (counter >= 0) {
+        uint64_t count;
+        if (read(counter, &count, sizeof(count)) == sizeof(count))
+            result->instructions = count;
+        close(counter);
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "Error: %s failed with status %d\n", argv[0], WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+        return 0;
+    }
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    int runs = 1, i = 1;
+    const char *input = NULL, *output = NULL;
+    for (; i < argc && argv[i][0] == '-'; i++) {
+        if (!strcmp(argv[i], "-r") && i + 1 < argc && (runs = atoi(argv[i+1])) > 0)
+            i++;
+        else if (!strcmp(argv[i], "-i") && i + 1 < argc)
+            input = argv[++i];
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+            output = argv[++i];
+        else {
+            fprintf(stderr, "Error: illegal parameter: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (i >= argc) {
+        fprintf(stderr, "Error: no command to measure\n");
+        return 1;
+    }
+    Measure best = { 0, -1, 0 }, run;
+    for (int n = 0; n < runs; n++) {
+        if (!measure_run(input, output, argv + i, &run))
+            return 1;
+        if (n == 0 || run.seconds < best.seconds) {
+            best.seconds = run.seconds;
+            best.instructions = run.instructions;
+        }
+        if (run.rss > best.rss)
+            best.rss = run.rss;
+    }
+    if (best.instructions >= 0)
+        printf("%.3f %lld %ld\n", best.seconds, (long long) best.instructions, best.rss);
+    else
+        printf("%.3f - %ld\n", best.seconds, best.rss);
+    return 0;
+}
@@ -0,0 +1,370 @@
+program nbody;
+{ Real arithmetic and calls: the n-body simulation of the Jovian planets, with every coordinate in its own variable
+  (the language has no arrays yet) and square roots by Newton steps from the distance of the previous step }
+const dt = 0.01; steps = 500000;
+var sunx, suny, sunz, sunvx, sunvy, sunvz, sunm,
+    jupx, jupy, jupz, jupvx, jupvy, jupvz, jupm,
+    satx, saty, satz, satvx, satvy, satvz, satm,
+    urax, uray, uraz, uravx, uravy, uravz, uram,
+    nepx, nepy, nepz, nepvx, nepvy, nepvz, nepm,
+    r_sun_jup, r_sun_sat, r_sun_ura, r_sun_nep, r_jup_sat, r_jup_ura, r_jup_nep, r_sat_ura, r_sat_nep, r_ura_nep,
+    dx, dy, dz, square, distance, magnitude, px, py, pz, e: real;
+    step: integer;
+
+function root(v, guess: real): real;
+{ Square root of v from a close guess }
+var r: real; i: integer;
+begin
+    r := guess;
+    for i := 1 to 3 do
+        r := 0.5 * (r + v / r);
+    root := r
+end;
+
+procedure report(decimals: integer);
+{ Writes the total energy }
+begin
+    e := 0.0;
+    e := e + 0.5 * sunm * (sunvx * sunvx + sunvy * sunvy + sunvz * sunvz);
+    e := e + 0.5 * jupm * (jupvx * jupvx + jupvy * jupvy + jupvz * jupvz);
+    e := e + 0.5 * satm * (satvx * satvx + satvy * satvy + satvz * satvz);
+    e := e + 0.5 * uram * (uravx * uravx + uravy * uravy + uravz * uravz);
+    e := e + 0.5 * nepm * (nepvx * nepvx + nepvy * nepvy + nepvz * nepvz);
+    dx := sunx - jupx;
+    dy := suny - jupy;
+    dz := sunz - jupz;
+    square := dx * dx + dy * dy + dz * dz;
+    distance := root(square, r_sun_jup);
+    e := e - sunm * jupm / distance;
+    dx := sunx - satx;
+    dy := suny - saty;
+    dz := sunz - satz;
+    square := dx * dx + dy * dy + dz * dz;
+    distance := root(square, r_sun_sat);
+    e := e - sunm * satm / distance;
+    dx := sunx - urax;
+    dy := suny - uray;
+    dz := sunz - uraz;
+    square := dx * dx + dy * dy + dz * dz;
+    distance := root(square, r_sun_ura);
+    e := e - sunm * uram / distance;
+    dx := sunx - nepx;
+    dy := suny - nepy;
+    dz := sunz - nepz;
+    square := dx * dx + dy * dy + dz * dz;
+    distance := root(square, r_sun_nep);
+    e := e - sunm * nepm / distance;
+    dx := jupx - satx;
+    dy := jupy - saty;
+    dz := jupz - satz;
+    square := dx * dx + dy * dy + dz * dz;
+    distance := root(square, r_jup_sat);
+    e := e - jupm * satm / distance;
+    dx := jupx - urax;
+    dy := jupy - uray;
+    dz := jupz - uraz;
+    square := dx * dx + dy * dy + dz * dz;
+    distance := root(square, r_jup_ura);
+    e := e - jupm * uram / distance;
+    dx := jupx - nepx;
+    dy := jupy - nepy;
+    dz := jupz - nepz;
+    square := dx * dx + dy * dy + dz * dz;
+    distance := root(square, r_jup_nep);
+    e := e - jupm * nepm / distance;
+    dx := satx - urax;
+    dy := saty - uray;
+    dz := satz - uraz;
+    square := dx * dx + dy * dy + dz * dz;
+    distance := root(square, r_sat_ura);
+    e := e - satm * uram / distance;
+    dx := satx - nepx;
+    dy := saty - nepy;
+    dz := satz - nepz;
+    square := dx * dx + dy * dy + dz * dz;
+    distance := root(square, r_sat_nep);
+    e := e - satm * nepm / distance;
+    dx := urax - nepx;
+    dy := uray - nepy;
+    dz := uraz - nepz;
+    square := dx * dx + dy * dy + dz * dz;
+    distance := root(square, r_ura_nep);
+    e := e - uram * nepm / distance;
+    writeln(e:0:decimals)
+end;
+
+begin
+    sunx := 0.0;
+    suny := 0.0;
+    sunz := 0.0;
+    sunvx := 0.0;
+    sunvy := 0.0;
+    sunvz := 0.0;
+    sunm := 39.478417604357;
+    jupx := 4.841431442465;
+    jupy := 0.0 - 1.160320044027;
+    jupz := 0.0 - 0.103622044471;
+    jupvx := 0.606326392996;
+    jupvy := 2.811986844916;
+    jupvz := 0.0 - 0.02521836166;
+    jupm := 0.03769367487;
+    satx := 8.343366718245;
+    saty := 4.124798564124;
+    satz := 0.0 - 0.403523417114;
+    satvx := 0.0 - 1.010774346179;
+    satvy := 1.82566237123;
+    satvz := 0.008415761377;
+    satm := 0.011286326132;
+    urax := 12.894369562139;
+    uray := 0.0 - 15.111151401699;
+    uraz := 0.0 - 0.223307578893;
+    uravx := 1.082791006442;
+    uravy := 0.86871301817;
+    uravz := 0.0 - 0.010832637401;
+    uram := 0.001723724057;
+    nepx := 15.379697114851;
+    nepy := 0.0 - 25.919314609988;
+    nepz := 0.17925877295;
+    nepvx := 0.979090732244;
+    nepvy := 0.594698998648;
+    nepvz := 0.0 - 0.034755955504;
+    nepm := 0.00203368687;
+    px := 0.0;
+    py := 0.0;
+    pz := 0.0;
+    px := px + jupvx * jupm;
+    py := py + jupvy * jupm;
+    pz := pz + jupvz * jupm;
+    px := px + satvx * satm;
+    py := py + satvy * satm;
+    pz := pz + satvz * satm;
+    px := px + uravx * uram;
+    py := py + uravy * uram;
+    pz := pz + uravz * uram;
+    px := px + nepvx * nepm;
+    py := py + nepvy * nepm;
+    pz := pz + nepvz * nepm;
+    sunvx := 0.0 - px / sunm;
+    sunvy := 0.0 - py / sunm;
+    sunvz := 0.0 - pz / sunm;
+    dx := sunx - jupx;
+    dy := suny - jupy;
+    dz := sunz - jupz;
+    square := dx * dx + dy * dy + dz * dz;
+    r_sun_jup := square;
+    for step := 1 to 20 do
+        r_sun_jup := 0.5 * (r_sun_jup + square / r_sun_jup);
+    dx := sunx - satx;
+    dy := suny - saty;
+    dz := sunz - satz;
+    square := dx * dx + dy * dy + dz * dz;
+    r_sun_sat := square;
+    for step := 1 to 20 do
+        r_sun_sat := 0.5 * (r_sun_sat + square / r_sun_sat);
+    dx := sunx - urax;
+    dy := suny - uray;
+    dz := sunz - uraz;
+    square := dx * dx + dy * dy + dz * dz;
+    r_sun_ura := square;
+    for step := 1 to 20 do
+        r_sun_ura := 0.5 * (r_sun_ura + square / r_sun_ura);
+    dx := sunx - nepx;
+    dy := suny - nepy;
+    dz := sunz - nepz;
+    square := dx * dx + dy * dy + dz * dz;
+    r_sun_nep := square;
+    for step := 1 to 20 do
+        r_sun_nep := 0.5 * (r_sun_nep + square / r_sun_nep);
+    dx := jupx - satx;
+    dy := jupy - saty;
+    dz := jupz - satz;
+    square := dx * dx + dy * dy + dz * dz;
+    r_jup_sat := square;
+    for step := 1 to 20 do
+        r_jup_sat := 0.5 * (r_jup_sat + square / r_jup_sat);
+    dx := jupx - urax;
+    dy := jupy - uray;
+    dz := jupz - uraz;
+    square := dx * dx + dy * dy + dz * dz;
+    r_jup_ura := square;
+    for step := 1 to 20 do
+        r_jup_ura := 0.5 * (r_jup_ura + square / r_jup_ura);
+    dx := jupx - nepx;
+    dy := jupy - nepy;
+    dz := jupz - nepz;
+    square := dx * dx + dy * dy + dz * dz;
+    r_jup_nep := square;
+    for step := 1 to 20 do
+        r_jup_nep := 0.5 * (r_jup_nep + square / r_jup_nep);
+    dx := satx - urax;
+    dy := saty - uray;
+    dz := satz - uraz;
+    square := dx * dx + dy * dy + dz * dz;
+    r_sat_ura := square;
+    for step := 1 to 20 do
+        r_sat_ura := 0.5 * (r_sat_ura + square / r_sat_ura);
+    dx := satx - nepx;
+    dy := saty - nepy;
+    dz := satz - nepz;
+    square := dx * dx + dy * dy + dz * dz;
+    r_sat_nep := square;
+    for step := 1 to 20 do
+        r_sat_nep := 0.5 * (r_sat_nep + square / r_sat_nep);
+    dx := urax - nepx;
+    dy := uray - nepy;
+    dz := uraz - nepz;
+    square := dx * dx + dy * dy + dz * dz;
+    r_ura_nep := square;
+    for step := 1 to 20 do
+        r_ura_nep := 0.5 * (r_ura_nep + square / r_ura_nep);
+    report(9);
+    for step := 1 to steps do
+    begin
+        dx := sunx - jupx;
+        dy := suny - jupy;
+        dz := sunz - jupz;
+        square := dx * dx + dy * dy + dz * dz;
+        distance := root(square, r_sun_jup);
+        r_sun_jup := distance;
+        magnitude := dt / (square * distance);
+        sunvx := sunvx - dx * jupm * magnitude;
+        sunvy := sunvy - dy * jupm * magnitude;
+        sunvz := sunvz - dz * jupm * magnitude;
+        jupvx := jupvx + dx * sunm * magnitude;
+        jupvy := jupvy + dy * sunm * magnitude;
+        jupvz := jupvz + dz * sunm * magnitude;
+        dx := sunx - satx;
+        dy := suny - saty;
+        dz := sunz - satz;
+        square := dx * dx + dy * dy + dz * dz;
+        distance := root(square, r_sun_sat);
+        r_sun_sat := distance;
+        magnitude := dt / (square * distance);
+        sunvx := sunvx - dx * satm * magnitude;
+        sunvy := sunvy - dy * satm * magnitude;
+        sunvz := sunvz - dz * satm * magnitude;
+        satvx := satvx + dx * sunm * magnitude;
+        satvy := satvy + dy * sunm * magnitude;
+        satvz := satvz + dz * sunm * magnitude;
+        dx := sunx - urax;
+        dy := suny - uray;
+        dz := sunz - uraz;
+        square := dx * dx + dy * dy + dz * dz;
+        distance := root(square, r_sun_ura);
+        r_sun_ura := distance;
+        magnitude := dt / (square * distance);
+        sunvx := sunvx - dx * uram * magnitude;
+        sunvy := sunvy - dy * uram * magnitude;
+        sunvz := sunvz - dz * uram * magnitude;
+        uravx := uravx + dx * sunm * magnitude;
+        uravy := uravy + dy * sunm * magnitude;
+        uravz := uravz + dz * sunm * magnitude;
+        dx := sunx - nepx;
+        dy := suny - nepy;
+        dz := sunz - nepz;
+        square := dx * dx + dy * dy + dz * dz;
+        distance := root(square, r_sun_nep);
+        r_sun_nep := distance;
+        magnitude := dt / (square * distance);
+        sunvx := sunvx - dx * nepm * magnitude;
+        sunvy := sunvy - dy * nepm * magnitude;
+        sunvz := sunvz - dz * nepm * magnitude;
+        nepvx := nepvx + dx * sunm * magnitude;
+        nepvy := nepvy + dy * sunm * magnitude;
+        nepvz := nepvz + dz * sunm * magnitude;
+        dx := jupx - satx;
+        dy := jupy - saty;
+        dz := jupz - satz;
+        square := dx * dx + dy * dy + dz * dz;
+        distance := root(square, r_jup_sat);
+        r_jup_sat := distance;
+        magnitude := dt / (square * distance);
+        jupvx := jupvx - dx * satm * magnitude;
+        jupvy := jupvy - dy * satm * magnitude;
+        jupvz := jupvz - dz * satm * magnitude;
+        satvx := satvx + dx * jupm * magnitude;
+        satvy := satvy + dy * jupm * magnitude;
+        satvz := satvz + dz * jupm * magnitude;
+        dx := jupx - urax;
+        dy := jupy - uray;
+        dz := jupz - uraz;
+        square := dx * dx + dy * dy + dz * dz;
+        distance := root(square, r_jup_ura);
+        r_jup_ura := distance;
+        magnitude := dt / (square * distance);
+        jupvx := jupvx - dx * uram * magnitude;
+        jupvy := jupvy - dy * uram * magnitude;
+        jupvz := jupvz - dz * uram * magnitude;
+        uravx := uravx + dx * jupm * magnitude;
+        uravy := uravy + dy * jupm * magnitude;
+        uravz := uravz + dz * jupm * magnitude;
+        dx := jupx - nepx;
+        dy := jupy - nepy;
+        dz := jupz - nepz;
+        square := dx * dx + dy * dy + dz * dz;
+        distance := root(square, r_jup_nep);
+        r_jup_nep := distance;
+        magnitude := dt / (square * distance);
+        jupvx := jupvx - dx * nepm * magnitude;
+        jupvy := jupvy - dy * nepm * magnitude;
+        jupvz := jupvz - dz * nepm * magnitude;
+        nepvx := nepvx + dx * jupm * magnitude;
+        nepvy := nepvy + dy * jupm * magnitude;
+        nepvz := nepvz + dz * jupm * magnitude;
+        dx := satx - urax;
+        dy := saty - uray;
+        dz := satz - uraz;
+        square := dx * dx + dy * dy + dz * dz;
+        distance := root(square, r_sat_ura);
+        r_sat_ura := distance;
+        magnitude := dt / (square * distance);
+        satvx := satvx - dx * uram * magnitude;
+        satvy := satvy - dy * uram * magnitude;
+        satvz := satvz - dz * uram * magnitude;
+        uravx := uravx + dx * satm * magnitude;
+        uravy := uravy + dy * satm * magnitude;
+        uravz := uravz + dz * satm * magnitude;
+        dx := satx - nepx;
+        dy := saty - nepy;
+        dz := satz - nepz;
+        square := dx * dx + dy * dy + dz * dz;
+        distance := root(square, r_sat_nep);
+        r_sat_nep := distance;
+        magnitude := dt / (square * distance);
+        satvx := satvx - dx * nepm * magnitude;
+        satvy := satvy - dy * nepm * magnitude;
+        satvz := satvz - dz * nepm * magnitude;
+        nepvx := nepvx + dx * satm * magnitude;
+        nepvy := nepvy + dy * satm * magnitude;
+        nepvz := nepvz + dz * satm * magnitude;
+        dx := urax - nepx;
+        dy := uray - nepy;
+        dz := uraz - nepz;
+        square := dx * dx + dy * dy + dz * dz;
+        distance := root(square, r_ura_nep);
+        r_ura_nep := distance;
+        magnitude := dt / (square * distance);
+        uravx := uravx - dx * nepm * magnitude;
+        uravy := uravy - dy * nepm * magnitude;
+        uravz := uravz - dz * nepm * magnitude;
+        nepvx := nepvx + dx * uram * magnitude;
+        nepvy := nepvy + dy * uram * magnitude;
+        nepvz := nepvz + dz * uram * magnitude;
+        sunx := sunx + dt * sunvx;
+        suny := suny + dt * sunvy;
+        sunz := sunz + dt * sunvz;
+        jupx := jupx + dt * jupvx;
+        jupy := jupy + dt * jupvy;
+        jupz := jupz + dt * jupvz;
+        satx := satx + dt * satvx;
+        saty := saty + dt * satvy;
+        satz := satz + dt * satvz;
+        urax := urax + dt * uravx;
+        uray := uray + dt * uravy;
+        uraz := uraz + dt * uravz;
+        nepx := nepx + dt * nepvx;
+        nepy := nepy + dt * nepvy;
+        nepz := nepz + dt * nepvz
+    end;
+    report(9)
+end.
@@ -0,0 +1,25 @@
+program primes;
+{ Integer division and loops: counts the primes below a limit by trial division (stands in for a sieve until arrays exist) }
+var n, limit, count, d, square, rest: integer;
+
+begin
+    limit := 2000000;
+    count := 1;
+    n := 3;
+    while n < limit do
+    begin
+        d := 3;
+        square := 9;
+        rest := 1;
+        while (square <= n) and (rest <> 0) do
+        begin
+            rest := n - n / d * d;
+            d := d + 2;
+            square := d * d
+        end;
+        if rest <> 0 then
+            count := count + 1;
+        n := n + 2
+    end;
+    writeln(count, ' primes below ', limit)
+end.
@@ -0,0 +1,84 @@
+#!/bin/sh
+# Runs the programs of bench/ (or the ones named as arguments) on every backend and writes a table of the wall time,
+# the instructions retired and the peak RSS of each run, the best of $RUNS runs (3 by default). The compile steps are
+# not timed, except for the interpreter and the JIT which compile the program right before running it. The output of
+# every backend is checked against the one of the interpreter.
+# PCOMP, CC and PCOMP_FLAGS (e.g. -O1) select the compiler, the C compiler and the optimization level.
+
+BENCH_DIR=$(cd "$(dirname "$0")" && pwd)
+PCOMP=$(cd "$(dirname "${PCOMP:-$BENCH_DIR/../pcomp}")" && pwd)/$(basename "${PCOMP:-pcomp}")
+MEASURE=$BENCH_DIR/measure
+CC=${CC:-cc}
+RUNS=${RUNS:-3}
+
+if [ ! -x "$PCOMP" ] || [ ! -x "$MEASURE" ]; then
+    echo "Error: build the compiler and bench/measure first (make bench)" >&2
+    exit 1
+fi
+if [ $# -eq 0 ]; then
+    set -- $(cd "$BENCH_DIR" && ls *.pas | sed 's/\.pas$//')
+fi
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+row() { # program backend measure-output status
+    set -- "$1" "$2" $3 "$4"
+    if [ $# -eq 6 ]; then
+        printf "%-10s %-12s %10s %16s %14s  %s\n" "$1" "$2" "$3" "$4" "$5" "$6"
+    else
+        printf "%-10s %-12s %10s %16s %14s  %s\n" "$1" "$2" - - - "$3"
+    fi
+}
+
+measure() { # program backend command..., the output goes to $WORK/<program>.<backend>.out
+    program=$1
+    backend=$2
+    shift 2
+    out=$WORK/$program.$backend.out
+    if ! result=$("$MEASURE" -r "$RUNS" -o "$out" "$@" 2>"$WORK/error"); then
+        row "$program" "$backend" "" "failed: $(head -n 1 "$WORK/error")"
+        return
+    fi
+    if [ ! -f "$WORK/$program.reference" ]; then
+        cp "$out" "$WORK/$program.reference"
+        status=ok
+    elif cmp -s "$out" "$WORK/$program.reference"; then
+        status=ok
+    else
+        status="output differs"
+    fi
+    row "$program" "$backend" "$result" "$status"
+}
+
+printf "%-10s %-12s %10s %16s %14s  %s\n" program backend "time (s)" instructions "peak RSS (KiB)" output
+for program in "$@"; do
+    if [ ! -f "$BENCH_DIR/$program.pas" ]; then
+        echo "Error: no benchmark $program" >&2
+        continue
+    fi
+    cp "$BENCH_DIR/$program.pas" "$WORK/"
+    source=$WORK/$program.pas
+    base=$WORK/$program
+    measure "$program" interpreter "$PCOMP" $PCOMP_FLAGS --run "$source"
+    if "$PCOMP" $PCOMP_FLAGS -pbc "$source" >/dev/null; then
+        measure "$program" bytecode "$PCOMP" "$base.pbc"
+    else
+        row "$program" bytecode "" "compile failed"
+    fi
+    measure "$program" jit "$PCOMP" $PCOMP_FLAGS --jit "$source"
+    if "$PCOMP" $PCOMP_FLAGS -C "$source" >/dev/null && "$CC" -O2 -w "$base.c" -o "$base.c.exe"; then
+        measure "$program" c "$base.c.exe"
+    else
+        row "$program" c "" "compile failed"
+    fi
+    if "$PCOMP" $PCOMP_FLAGS -S "$source" >/dev/null && "$CC" "$base.s" -o "$base.s.exe"; then
+        measure "$program" native "$base.s.exe"
+    else
+        row "$program" native "" "compile failed"
+    fi
+    if "$PCOMP" $PCOMP_FLAGS -static "$source" >/dev/null; then
+        measure "$program" static "$base"
+    else
+        row "$program" static "" "compile failed"
+    fi
+done
@@ -0,0 +1,22 @@
+program strings;
+{ String building: each concatenation copies both strings into a new one. The interpreter and the JIT free the ones no
+  variable holds any more, the compiled programs keep all of them (about 80 MB here) until they exit }
+var line, word: string;
+    round, i, total: integer;
+
+begin
+    total := 0;
+    for round := 1 to 10000 do
+    begin
+        line := '';
+        word := 'pas';
+        for i := 1 to 20 do
+        begin
+            line := line + word + ', ';
+            word := word + 'al'
+        end;
+        total := total + i
+    end;
+    writeln(total, ' words');
+    writeln(line)
+end.
@@ -0,0 +1,1133 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "compiler_context.h"
+#include "assembler.h"
+
+#define RIP_BASE 16 // Base register of the rip-relative operands
+#define MAX_OPERANDS 3
+
+typedef enum {
+    REGISTER_OPERAND, IMMEDIATE_OPERAND, MEMORY_OPERAND, TARGET_OPERAND
+} AsmOperandKind;
+
+typedef struct _AsmOperand {
+    AsmOperandKind kind;
+    int reg, size; // Register number and size in bytes, 16 for the xmm registers
+    int64_t value; // Immediate or displacement
+    int base, index, scale; // Registers of a memory operand, -1 when absent
+    int symbol; // Symbol of the displacement or target, -1 for none
+    int indirect; // *operand of a call or jump
+} AsmOperand;
+
+struct _Assembler {
+    CompilerContext *ctx;
+    Assembly *as;
+    int section; // -1 in a dropped section (.note.GNU-stack)
+    int line;
+    int failed;
+};
+
+typedef struct _ConditionName {
+    const char *name;
+    int code;
+} ConditionName;
+
+const char *asm_registers_64[] = { "rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+                                   "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15" };
+const char *asm_registers_32[] = { "eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+                                   "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d" };
+const char *asm_registers_16[] = { "ax", "cx", "dx", "bx", "sp", "bp", "si", "di",
+                                   "r8w", "r9w", "r10w", "r11w", "r12w", "r13w", "r14w", "r15w" };
+const char *asm_registers_8[] = { "al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil",
+                                  "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b" };
+
+const ConditionName asm_conditions[] = {
+    { "o", 0x0 }, { "no", 0x1 }, { "b", 0x2 }, { "c", 0x2 }, { "nae", 0x2 }, { "ae", 0x3 }, { "nb", 0x3 }, { "nc", 0x3 },
+    { "e", 0x4 }, { "z", 0x4 }, { "ne", 0x5 }, { "nz", 0x5 }, { "be", 0x6 }, { "na", 0x6 }, { "a", 0x7 }, { "nbe", 0x7 },
+    { "s", 0x8 }, { "ns", 0x9 }, { "p", 0xA }, { "pe", 0xA }, { "np", 0xB }, { "po", 0xB }, { "l", 0xC }, { "nge", 0xC },
+    { "ge", 0xD }, { "nl", 0xD }, { "le", 0xE }, { "ng", 0xE }, { "g", 0xF }, { "nle", 0xF }
+};
+
+int asm_error(Assembler *a, const char *message, const char *detail) {
+    fprintf(a->ctx->log_fptr, "Error: assembler line %d: %s \"%s\"\n", a->line, message, detail);
+    a->failed = 1;
+    return 0;
+}
+
+// Symbols
+
+uint32_t asm_name_hash(const char *name, size_t length) { // FNV-1a
+    uint32_t h = 2166136261u;
+    for (size_t n = 0; n < length; n++)
+        h = (h ^ (unsigned char) name[n]) * 16777619u;
+    return h;
+}
+
+int asm_lookup(const Assembly *as, const char *name, size_t length) {
+    if (as->bucket_count == 0)
+        return -1;
+    for (uint32_t b = asm_name_hash(name, length) & (as->bucket_count - 1); as->buckets[b] >= 0; b = (b + 1) & (as->bucket_count - 1)) {
+        const char *other = as->symbols[as->buckets[b]].name;
+        if (!strncmp(other, name, length) && other[length] == '\0')
+            return as->buckets[b];
+    }
+    return -1;
+}
+
+int find_symbol(const Assembly *as, const char *name) {
+    return asm_lookup(as, name, strlen(name));
+}
+
+int asm_grow_buckets(Assembly *as) {
+    int count = as->bucket_count == 0 ? 256 : as->bucket_count * 2;
+    int *buckets = malloc(count * sizeof(int));
+    if (buckets == NULL)
+        return 0;
+    memset(buckets, -1, count * sizeof(int));
+    for (int s = 0; s < as->symbol_count; s++) {
+        const char *name = as->symbols[s].name;
+        uint32_t b = asm_name_hash(name, strlen(name)) & (count - 1);
+        while (buckets[b] >= 0)
+            b = (b + 1) & (count - 1);
+        buckets[b] = s;
+    }
+    free(as->buckets);
+    as->buckets = buckets;
+    as->bucket_count = count;
+    return 1;
+}
+
+int asm_symbol(Assembler *a, const char *name, size_t length) { // Index of the symbol, created undefined when new
+    Assembly *as = a->as;
+    int s = asm_lookup(as, name, length);
+    if (s >= 0)
+        return s;
+    if ((as->symbol_count + 1) * 2 > as->bucket_count && !asm_grow_buckets(as)) {
+        fprintf(a->ctx->log_fptr, "Error: failed to allocate memory for the assembler symbols\n");
+        a->failed = 1;
+        return -1;
+    }
+    if (as->symbol_count >= as->symbol_capacity) {
+        int capacity = as->symbol_capacity == 0 ? 256 : as->symbol_capacity * 2;
+        AsmSymbol *symbols = realloc(as->symbols, capacity * sizeof(AsmSymbol));
+        if (symbols == NULL) {
+            fprintf(a->ctx->log_fptr, "Error: failed to reallocate more memory to the assembler symbols\n");
+            a->failed = 1;
+            return -1;
+        }
+        as->symbols = symbols;
+        as->symbol_capacity = capacity;
+    }
+    AsmSymbol *symb = &as->symbols[as->symbol_count];
+    symb->name = malloc(length + 1);
+    if (symb->name == NULL) {
+        fprintf(a->ctx->log_fptr, "Error: failed to allocate memory for an assembler symbol\n");
+        a->failed = 1;
+        return -1;
+    }
+    memcpy(symb->name, name, length);
+    symb->name[length] = '\0';
+    symb->section = -1;
+    symb->offset = symb->size = 0;
+    symb->global = symb->function = 0;
+    uint32_t b = asm_name_hash(name, length) & (as->bucket_count - 1);
+    while (as->buckets[b] >= 0)
+        b = (b + 1) & (as->bucket_count - 1);
+    as->buckets[b] = as->symbol_count;
+    return as->symbol_count++;
+}
+
+// Section contents
+
+AsmSection* asm_current(Assembler *a) {
+    if (a->section < 0) {
+        asm_error(a, "no content allowed in section", ".note.GNU-stack");
+        return NULL;
+    }
+    return &a->as->sections[a->section];
+}
+
+uint8_t* asm_reserve(Assembler *a, size_t count) { // count new bytes at the end of the current section
+    AsmSection *section = asm_current(a);
+    if (section == NULL)
+        return NULL;
+    if (section->size + count > section->capacity) {
+        size_t capacity = section->capacity == 0 ? 4096 : section->capacity;
+        while (capacity < section->size + count)
+            capacity *= 2;
+        uint8_t *bytes = realloc(section->bytes, capacity);
+        if (bytes == NULL) {
+            fprintf(a->ctx->log_fptr, "Error: failed to reallocate more memory to an assembler section\n");
+            a->failed = 1;
+            return NULL;
+        }
+        section->bytes = bytes;
+        section->capacity = capacity;
+    }
+    section->size += count;
+    return section->bytes + section->size - count;
+}
+
+void asm_put(Assembler *a, uint64_t value, int size) { // Little endian
+    if (a->section == BSS_SECTION && value != 0) {
+        asm_error(a, "only zeros allowed in section", ".bss");
+        return;
+    }
+    uint8_t *bytes = asm_reserve(a, size);
+    for (int n = 0; bytes != NULL && n < size; n++, value >>= 8)
+        bytes[n] = value & 0xff;
+}
+
+void asm_relocation(Assembler *a, int symbol, RelocationKind kind, int64_t addend) { // At the current end of the section
+    AsmSection *section = asm_current(a);
+    if (section == NULL || symbol < 0)
+        return;
+    if (a->section == BSS_SECTION) {
+        asm_error(a, "no address allowed in section", ".bss");
+        return;
+    }
+    if (section->relocation_count >= section->relocation_capacity) {
+        int capacity = section->relocation_capacity == 0 ? 256 : section->relocation_capacity * 2;
+        AsmRelocation *relocations = realloc(section->relocations, capacity * sizeof(AsmRelocation));
+        if (relocations == NULL) {
+            fprintf(a->ctx->log_fptr, "Error: failed to reallocate more memory to the assembler relocations\n");
+            a->failed = 1;
+            return;
+        }
+        section->relocations = relocations;
+        section->relocation_capacity = capacity;
+    }
+    AsmRelocation *relocation = &section->relocations[section->relocation_count++];
+    relocation->offset = section->size;
+    relocation->symbol = symbol;
+    relocation->kind = kind;
+    relocation->addend = addend;
+}
+
+// Operands
+
+int is_symbol_char(char ch) {
+    return isalnum((unsigned char) ch) || ch == '_' || ch == '.' || ch == '$';
+}
+
+char* skip_blanks(char *p) {
+    while (*p == ' ' || *p == '\t')
+        p++;
+    return p;
+}
+
+char* trim_blanks(char *p) { // Leading and trailing blanks removed in place
+    p = skip_blanks(p);
+    size_t length = strlen(p);
+    while (length > 0 && (p[length - 1] == ' ' || p[length - 1] == '\t' || p[length - 1] == '\r'))
+        p[--length] = '\0';
+    return p;
+}
+
+int parse_register(const char *name, size_t length, int *size) { // Register number, -1 if unknown
+    char text[8];
+    if (length == 0 || length >= sizeof(text))
+        return -1;
+    memcpy(text, name, length);
+    text[length] = '\0';
+    for (int r = 0; r < 16; r++) {
+        if (!strcmp(text, asm_registers_64[r])) { *size = 8; return r; }
+        if (!strcmp(text, asm_registers_32[r])) { *size = 4; return r; }
+        if (!strcmp(text, asm_registers_16[r])) { *size = 2; return r; }
+        if (!strcmp(text, asm_registers_8[r])) { *size = 1; return r; }
+    }
+    if (!strncmp(text, "xmm", 3) && isdigit((unsigned char) text[3])) {
+        int r = atoi(text + 3);
+        if (r < 16 && (text[4] == '\0' || (isdigit((unsigned char) text[4]) && text[5] == '\0'))) {
+            *size = 16;
+            return r;
+        }
+    }
+    return -1;
+}
+
+int parse_number(const char *text, int64_t *value) { // The whole text is a number
+    char *end;
+    if (*text == '\0')
+        return 0;
+    *value = (int64_t) strtoull(text + (*text == '-' || *text == '+'), &end, 0);
+    if (*text == '-')
+        *value = -*value;
+    return *skip_blanks(end) == '\0';
+}
+
+int parse_reference(Assembler *a, char *text, int *symbol, int64_t *value) { // symbol[+-number] or number
+    text = trim_blanks(text);
+    *symbol = -1;
+    *value = 0;
+    if (*text == '\0')
+        return 1;
+    if (isdigit((unsigned char) *text) || *text == '-' || *text == '+')
+        return parse_number(text, value) || asm_error(a, "invalid number", text);
+    char *end = text;
+    while (is_symbol_char(*end))
+        end++;
+    if (end == text)
+        return asm_error(a, "invalid operand", text);
+    *symbol = asm_symbol(a, text, end - text);
+    end = skip_blanks(end);
+    if (*end != '\0' && !parse_number(end, value))
+        return asm_error(a, "invalid symbol offset", end);
+    return *symbol >= 0;
+}
+
+int parse_operand(Assembler *a, char *text, AsmOperand *op) {
+    text = trim_blanks(text);
+    memset(op, 0, sizeof(AsmOperand));
+    op->reg = op->base = op->index = op->symbol = -1;
+    op->scale = 1;
+    if (*text == '*') {
+        op->indirect = 1;
+        text = skip_blanks(text + 1);
+    }
+    if (*text == '%') {
+        op->kind = REGISTER_OPERAND;
+        op->reg = parse_register(text + 1, strlen(text + 1), &op->size);
+        return op->reg >= 0 || asm_error(a, "unknown register", text);
+    }
+    if (*text == '$') {
+        op->kind = IMMEDIATE_OPERAND;
+        return parse_number(text + 1, &op->value) || asm_error(a, "unsupported immediate", text);
+    }
+    char *open = strchr(text, '(');
+    if (open == NULL) { // Target of a call or jump
+        op->kind = TARGET_OPERAND;
+        char *at = strchr(text, '@');
+        if (at != NULL) {
+            if (strcmp(at, "@PLT")) // Every branch relocation goes through the procedure linkage table anyway
+                return asm_error(a, "unsupported symbol suffix", at);
+            *at = '\0';
+        }
+        if (!parse_reference(a, text, &op->symbol, &op->value))
+            return 0;
+        return op->symbol >= 0 || asm_error(a, "unsupported absolute address", text);
+    }
+    op->kind = MEMORY_OPERAND;
+    char *close = strchr(open, ')');
+    if (close == NULL || *skip_blanks(close + 1) != '\0')
+        return asm_error(a, "invalid memory operand", text);
+    *open = *close = '\0';
+    if (!parse_reference(a, text, &op->symbol, &op->value))
+        return 0;
+    char *parts[3] = { open + 1, NULL, NULL };
+    for (int n = 1; n < 3 && parts[n - 1] != NULL; n++) {
+        parts[n] = strchr(parts[n - 1], ',');
+        if (parts[n] != NULL)
+            *parts[n]++ = '\0';
+    }
+    int size;
+    char *base = trim_blanks(parts[0]);
+    if (*base != '\0') {
+        if (!strcmp(base, "%rip"))
+            op->base = RIP_BASE;
+        else if (*base != '%' || (op->base = parse_register(base + 1, strlen(base + 1), &size)) < 0 || size != 8)
+            return asm_error(a, "invalid base register", base);
+    }
+    if (parts[1] != NULL) {
+        char *index = trim_blanks(parts[1]);
+        if (*index != '%' || (op->index = parse_register(index + 1, strlen(index + 1), &size)) < 0 || size != 8
+            || op->index == 4 || op->base == RIP_BASE)
+            return asm_error(a, "invalid index register", index);
+    }
+    if (parts[2] != NULL) {
+        op->scale = atoi(trim_blanks(parts[2]));
+        if (op->scale != 1 && op->scale != 2 && op->scale != 4 && op->scale != 8)
+            return asm_error(a, "invalid scale", parts[2]);
+    }
+    if (op->symbol >= 0 && op->base != RIP_BASE)
+        return asm_error(a, "symbols only address memory relative to rip", text);
+    if (op->base < 0)
+        return asm_error(a, "unsupported absolute address", text);
+    return 1;
+}
+
+// Instruction encoding
+
+int fits_int8(int64_t value) {
+    return value >= -128 && value <= 127;
+}
+
+int fits_int32(int64_t value) {
+    return value >= INT32_MIN && value <= INT32_MAX;
+}
+
+int fits_immediate(int64_t value, int size) { // Sign or zero extended into an operand of size bytes
+    if (size == 1)
+        return value >= -128 && value <= 255;
+    if (size == 2)
+        return value >= -32768 && value <= 65535;
+    if (size == 4)
+        return value >= INT32_MIN && value <= (int64_t) UINT32_MAX;
+    return fits_int32(value);
+}
+
+int needs_byte_rex(const AsmOperand *ops, int count) { // spl, bpl, sil and dil only exist with a REX prefix
+    for (int n = 0; n < count; n++) {
+        if (ops[n].kind == REGISTER_OPERAND && ops[n].size == 1 && ops[n].reg >= 4 && ops[n].reg <= 7)
+            return 1;
+    }
+    return 0;
+}
+
+int asm_encode(Assembler *a, int prefix, int wide, int byte_rex, const uint8_t *opcode, int opcode_length, int reg,
+               const AsmOperand *rm, int immediate_size, int64_t immediate) {
+    // [prefix] [REX] opcode ModRM [SIB] [displacement] [immediate], reg is a register number or the opcode extension
+    int rex = (wide ? 8 : 0) | ((reg >> 3) & 1) << 2;
+    if (rm->kind == REGISTER_OPERAND)
+        rex |= (rm->reg >> 3) & 1;
+    else {
+        if (rm->base >= 0 && rm->base != RIP_BASE)
+            rex |= (rm->base >> 3) & 1;
+        if (rm->index >= 0)
+            rex |= ((rm->index >> 3) & 1) << 1;
+    }
+    if (prefix)
+        asm_put(a, prefix, 1);
+    if (rex || byte_rex)
+        asm_put(a, 0x40 | rex, 1);
+    for (int n = 0; n < opcode_length; n++)
+        asm_put(a, opcode[n], 1);
+
+    int displacement_field = -1;
+    if (rm->kind == REGISTER_OPERAND)
+        asm_put(a, 0xc0 | (reg & 7) << 3 | (rm->reg & 7), 1);
+    else if (rm->base == RIP_BASE) {
+        asm_put(a, 0x05 | (reg & 7) << 3, 1);
+        displacement_field = a->section >= 0 ? a->as->sections[a->section].size : 0;
+        asm_relocation(a, rm->symbol, RELOCATION_PC32, 0); // Addend set once the instruction length is known
+        asm_put(a, rm->symbol >= 0 ? 0 : (uint32_t) rm->value, 4);
+    }
+    else {
+        int sib = rm->index >= 0 || (rm->base & 7) == 4;
+        int mode = rm->value == 0 && (rm->base & 7) != 5 ? 0 : fits_int8(rm->value) ? 1 : 2;
+        if (!fits_int32(rm->value))
+            return asm_error(a, "displacement out of range", "");
+        asm_put(a, mode << 6 | (reg & 7) << 3 | (sib ? 4 : rm->base & 7), 1);
+        if (sib) {
+            int scale = rm->scale == 8 ? 3 : rm->scale == 4 ? 2 : rm->scale == 2 ? 1 : 0;
+            asm_put(a, scale << 6 | ((rm->index >= 0 ? rm->index : 4) & 7) << 3 | (rm->base & 7), 1);
+        }
+        if (mode > 0)
+            asm_put(a, (uint64_t) rm->value, mode == 1 ? 1 : 4);
+    }
+    if (immediate_size > 0)
+        asm_put(a, (uint64_t) immediate, immediate_size);
+    if (displacement_field >= 0 && rm->symbol >= 0 && !a->failed) { // rip points at the next instruction
+        AsmSection *section = &a->as->sections[a->section];
+        section->relocations[section->relocation_count - 1].addend = rm->value - (int64_t) (section->size - displacement_field);
+    }
+    return !a->failed;
+}
+
+int asm_encode_register(Assembler *a, int prefix, int wide, int byte_rex, uint8_t opcode, int reg, int immediate_size,
+                        int64_t immediate) { // Register in the low bits of the opcode (push, pop, mov $imm)
+    if (prefix)
+        asm_put(a, prefix, 1);
+    if (wide || reg >= 8 || byte_rex)
+        asm_put(a, 0x40 | (wide ? 8 : 0) | ((reg >> 3) & 1), 1);
+    asm_put(a, opcode + (reg & 7), 1);
+    if (immediate_size > 0)
+        asm_put(a, (uint64_t) immediate, immediate_size);
+    return !a->failed;
+}
+
+int asm_encode_target(Assembler *a, const uint8_t *opcode, int opcode_length, const AsmOperand *target) {
+    for (int n = 0; n < opcode_length; n++)
+        asm_put(a, opcode[n], 1);
+    asm_relocation(a, target->symbol, RELOCATION_PLT32, target->value - 4); // Like GNU as, the linker may bind it directly
+    asm_put(a, 0, 4);
+    return !a->failed;
+}
+
+int condition_code(const char *name) {
+    for (size_t n = 0; n < sizeof(asm_conditions) / sizeof(asm_conditions[0]); n++) {
+        if (!strcmp(name, asm_conditions[n].name))
+            return asm_conditions[n].code;
+    }
+    return -1;
+}
+
+int size_prefix(int size) {
+    return size == 2 ? 0x66 : 0;
+}
+
+int immediate_size(int size) { // Immediates of 64 bit operations are 32 bits sign extended
+    return size == 8 ? 4 : size;
+}
+
+int is_register(const AsmOperand *op, int xmm) {
+    return op->kind == REGISTER_OPERAND && (op->size == 16) == xmm;
+}
+
+int is_register_or_memory(const AsmOperand *op, int xmm) {
+    return op->kind == MEMORY_OPERAND || is_register(op, xmm);
+}
+
+int check_operand_count(Assembler *a, const char *mnemonic, int count, int expected) {
+    return count == expected || asm_error(a, "wrong operand count for", mnemonic);
+}
+
+int encode_sse(Assembler *a, const char *mnemonic, const AsmOperand *ops, int count, int *handled) {
+    // Scalar single and double precision instructions, operands are xmm registers or memory unless converting
+    typedef struct { const char *name; int prefix; uint8_t opcode; } SseForm;
+    const SseForm forms[] = {
+        { "addss", 0xf3, 0x58 }, { "addsd", 0xf2, 0x58 }, { "subss", 0xf3, 0x5c }, { "subsd", 0xf2, 0x5c },
+        { "mulss", 0xf3, 0x59 }, { "mulsd", 0xf2, 0x59 }, { "divss", 0xf3, 0x5e }, { "divsd", 0xf2, 0x5e },
+        { "sqrtss", 0xf3, 0x51 }, { "sqrtsd", 0xf2, 0x51 }, { "ucomiss", 0, 0x2e }, { "ucomisd", 0x66, 0x2e },
+        { "comiss", 0, 0x2f }, { "comisd", 0x66, 0x2f }, { "xorps", 0, 0x57 }, { "xorpd", 0x66, 0x57 },
+        { "andps", 0, 0x54 }, { "andpd", 0x66, 0x54 }, { "cvtss2sd", 0xf3, 0x5a }, { "cvtsd2ss", 0xf2, 0x5a }
+    };
+    *handled = 1;
+    for (size_t n = 0; n < sizeof(forms) / sizeof(forms[0]); n++) {
+        if (strcmp(mnemonic, forms[n].name))
+            continue;
+        if (!check_operand_count(a, mnemonic, count, 2))
+            return 0;
+        if (!is_register_or_memory(&ops[0], 1) || !is_register(&ops[1], 1))
+            return asm_error(a, "invalid operands for", mnemonic);
+        const uint8_t opcode[] = { 0x0f, forms[n].opcode };
+        return asm_encode(a, forms[n].prefix, 0, 0, opcode, 2, ops[1].reg, &ops[0], 0, 0);
+    }
+    if (!strcmp(mnemonic, "movss") || !strcmp(mnemonic, "movsd")) {
+        int prefix = mnemonic[4] == 's' ? 0xf3 : 0xf2;
+        if (!check_operand_count(a, mnemonic, count, 2))
+            return 0;
+        if (is_register(&ops[1], 1) && is_register_or_memory(&ops[0], 1)) {
+            const uint8_t opcode[] = { 0x0f, 0x10 };
+            return asm_encode(a, prefix, 0, 0, opcode, 2, ops[1].reg, &ops[0], 0, 0);
+        }
+        if (is_register(&ops[0], 1) && ops[1].kind == MEMORY_OPERAND) {
+            const uint8_t opcode[] = { 0x0f, 0x11 };
+            return asm_encode(a, prefix, 0, 0, opcode, 2, ops[0].reg, &ops[1], 0, 0);
+        }
+        return asm_error(a, "invalid operands for", mnemonic);
+    }
+    if (!strncmp(mnemonic, "cvtsi2s", 7) && (mnemonic[7] == 's' || mnemonic[7] == 'd')) { // Integer to real
+        const char *suffix = mnemonic + 8;
+        if ((*suffix != '\0' && strcmp(suffix, "l") && strcmp(suffix, "q")) || !check_operand_count(a, mnemonic, count, 2))
+            return asm_error(a, "unknown instruction", mnemonic);
+        if (!is_register_or_memory(&ops[0], 0) || !is_register(&ops[1], 1) || (ops[0].kind == REGISTER_OPERAND && ops[0].size < 4))
+            return asm_error(a, "invalid operands for", mnemonic);
+        int wide = *suffix == 'q' || (ops[0].kind == REGISTER_OPERAND && ops[0].size == 8);
+        const uint8_t opcode[] = { 0x0f, 0x2a };
+        return asm_encode(a, mnemonic[7] == 's' ? 0xf3 : 0xf2, wide, 0, opcode, 2, ops[1].reg, &ops[0], 0, 0);
+    }
+    if (!strncmp(mnemonic, "cvt", 3) && (!strncmp(mnemonic + 3, "tss2si", 6) || !strncmp(mnemonic + 3, "tsd2si", 6)
+        || !strncmp(mnemonic + 3, "ss2si", 5) || !strncmp(mnemonic + 3, "sd2si", 5))) { // Real to integer, t truncates
+        int truncate = mnemonic[3] == 't';
+        const char *suffix = mnemonic + (truncate ? 9 : 8);
+        if ((*suffix != '\0' && strcmp(suffix, "l") && strcmp(suffix, "q")) || !check_operand_count(a, mnemonic, count, 2))
+            return asm_error(a, "unknown instruction", mnemonic);
+        if (!is_register_or_memory(&ops[0], 1) || !is_register(&ops[1], 0) || ops[1].size < 4)
+            return asm_error(a, "invalid operands for", mnemonic);
+        const uint8_t opcode[] = { 0x0f, truncate ? 0x2c : 0x2d };
+        int prefix = mnemonic[truncate ? 5 : 4] == 's' ? 0xf3 : 0xf2;
+        return asm_encode(a, prefix, ops[1].size == 8, 0, opcode, 2, ops[1].reg, &ops[0], 0, 0);
+    }
+    if ((!strcmp(mnemonic, "movd") || !strcmp(mnemonic, "movq")) && count == 2 && (ops[0].size == 16 || ops[1].size == 16)) {
+        if (is_register(&ops[1], 1) && is_register_or_memory(&ops[0], 0)) { // General register or memory to xmm
+            const uint8_t opcode[] = { 0x0f, 0x6e };
+            return asm_encode(a, 0x66, mnemonic[3] == 'q', 0, opcode, 2, ops[1].reg, &ops[0], 0, 0);
+        }
+        if (is_register(&ops[0], 1) && is_register_or_memory(&ops[1], 0)) {
+            const uint8_t opcode[] = { 0x0f, 0x7e };
+            return asm_encode(a, 0x66, mnemonic[3] == 'q', 0, opcode, 2, ops[0].reg, &ops[1], 0, 0);
+        }
+        return asm_error(a, "invalid operands for", mnemonic);
+    }
+    *handled = 0;
+    return 0;
+}
+
+int encode_control(Assembler *a, const char *mnemonic, const AsmOperand *ops, int count, int *handled) {
+    // Operand-free instructions, calls, jumps and the conditional instructions
+    typedef struct { const char *name; uint8_t bytes[2]; int length; } FixedForm;
+    const FixedForm forms[] = {
+        { "ret", { 0xc3 }, 1 }, { "leave", { 0xc9 }, 1 }, { "cltd", { 0x99 }, 1 }, { "cqto", { 0x48, 0x99 }, 2 },
+        { "cltq", { 0x48, 0x98 }, 2 }, { "syscall", { 0x0f, 0x05 }, 2 }, { "nop", { 0x90 }, 1 }, { "ud2", { 0x0f, 0x0b }, 2 }
+    };
+    *handled = 1;
+    for (size_t n = 0; n < sizeof(forms) / sizeof(forms[0]); n++) {
+        if (strcmp(mnemonic, forms[n].name))
+            continue;
+        if (!check_operand_count(a, mnemonic, count, 0))
+            return 0;
+        for (int b = 0; b < forms[n].length; b++)
+            asm_put(a, forms[n].bytes[b], 1);
+        return !a->failed;
+    }
+    if (!strcmp(mnemonic, "call") || !strcmp(mnemonic, "callq") || !strcmp(mnemonic, "jmp") || !strcmp(mnemonic, "jmpq")) {
+        int call = mnemonic[0] == 'c';
+        if (!check_operand_count(a, mnemonic, count, 1))
+            return 0;
+        if (ops[0].indirect && is_register_or_memory(&ops[0], 0) && (ops[0].kind == MEMORY_OPERAND || ops[0].size == 8)) {
+            const uint8_t opcode = 0xff;
+            return asm_encode(a, 0, 0, 0, &opcode, 1, call ? 2 : 4, &ops[0], 0, 0);
+        }
+        if (ops[0].kind != TARGET_OPERAND || ops[0].indirect)
+            return asm_error(a, "invalid operand for", mnemonic);
+        const uint8_t opcode = call ? 0xe8 : 0xe9;
+        return asm_encode_target(a, &opcode, 1, &ops[0]);
+    }
+    int code;
+    if (mnemonic[0] == 'j' && (code = condition_code(mnemonic + 1)) >= 0) {
+        if (!check_operand_count(a, mnemonic, count, 1))
+            return 0;
+        if (ops[0].kind != TARGET_OPERAND || ops[0].indirect)
+            return asm_error(a, "invalid operand for", mnemonic);
+        const uint8_t opcode[] = { 0x0f, 0x80 + code };
+        return asm_encode_target(a, opcode, 2, &ops[0]);
+    }
+    if (!strncmp(mnemonic, "set", 3) && (code = condition_code(mnemonic + 3)) >= 0) {
+        if (!check_operand_count(a, mnemonic, count, 1))
+            return 0;
+        if (!is_register_or_memory(&ops[0], 0) || (ops[0].kind == REGISTER_OPERAND && ops[0].size != 1))
+            return asm_error(a, "invalid operand for", mnemonic);
+        const uint8_t opcode[] = { 0x0f, 0x90 + code };
+        return asm_encode(a, 0, 0, needs_byte_rex(ops, count), opcode, 2, 0, &ops[0], 0, 0);
+    }
+    if (!strncmp(mnemonic, "cmov", 4)) {
+        char condition[8];
+        snprintf(condition, sizeof(condition), "%s", mnemonic + 4);
+        size_t length = strlen(condition);
+        if ((code = condition_code(condition)) < 0 && length > 1 && strchr("wlq", condition[length - 1]) != NULL) {
+            condition[length - 1] = '\0';
+            code = condition_code(condition);
+        }
+        if (code >= 0) {
+            if (!check_operand_count(a, mnemonic, count, 2))
+                return 0;
+            if (!is_register_or_memory(&ops[0], 0) || !is_register(&ops[1], 0) || ops[1].size < 2)
+                return asm_error(a, "invalid operands for", mnemonic);
+            const uint8_t opcode[] = { 0x0f, 0x40 + code };
+            return asm_encode(a, size_prefix(ops[1].size), ops[1].size == 8, 0, opcode, 2, ops[1].reg, &ops[0], 0, 0);
+        }
+    }
+    *handled = 0;
+    return 0;
+}
+
+int encode_extension(Assembler *a, const char *mnemonic, const AsmOperand *ops, int count, int *handled) {
+    // movz and movs, source size then destination size in the suffix (movzbl, movslq)
+    const char *sizes = "bwlq";
+    *handled = 0;
+    if (strlen(mnemonic) != 6 || (strncmp(mnemonic, "movz", 4) && strncmp(mnemonic, "movs", 4))
+        || strchr(sizes, mnemonic[4]) == NULL || strchr(sizes, mnemonic[5]) == NULL)
+        return 0;
+    *handled = 1;
+    int from = 1 << (strchr(sizes, mnemonic[4]) - sizes), to = 1 << (strchr(sizes, mnemonic[5]) - sizes);
+    int sign = mnemonic[3] == 's';
+    if (!check_operand_count(a, mnemonic, count, 2))
+        return 0;
+    if (from >= to || from == 8 || (from == 4 && (!sign || to != 8)) || !is_register(&ops[1], 0) || ops[1].size != to
+        || !is_register_or_memory(&ops[0], 0) || (ops[0].kind == REGISTER_OPERAND && ops[0].size != from))
+        return asm_error(a, "invalid operands for", mnemonic);
+    if (from == 4) {
+        const uint8_t opcode = 0x63;
+        return asm_encode(a, 0, 1, 0, &opcode, 1, ops[1].reg, &ops[0], 0, 0);
+    }
+    const uint8_t opcode[] = { 0x0f, (sign ? 0xbe : 0xb6) + (from == 2) };
+    return asm_encode(a, size_prefix(to), to == 8, needs_byte_rex(ops, count), opcode, 2, ops[1].reg, &ops[0], 0, 0);
+}
+
+int encode_integer(Assembler *a, const char *base, int size, const AsmOperand *ops, int count, int *handled) {
+    // Integer instructions, size comes from the suffix of the mnemonic or from the register operands
+    const char *alu[] = { "add", "or", NULL, NULL, "and", "sub", "xor", "cmp" };
+    const char *unary[] = { NULL, NULL, "not", "neg", "mul", NULL, "div", "idiv" };
+    const char *shifts[] = { NULL, NULL, NULL, NULL, "shl", "shr", NULL, "sar" };
+    int byte_rex = needs_byte_rex(ops, count), wide = size == 8, prefix = size_prefix(size);
+    *handled = 1;
+    for (int n = 0; n < 8; n++) {
+        if (alu[n] == NULL || strcmp(base, alu[n]))
+            continue;
+        if (!check_operand_count(a, base, count, 2))
+            return 0;
+        if (ops[0].kind == IMMEDIATE_OPERAND && is_register_or_memory(&ops[1], 0)) {
+            if (!fits_immediate(ops[0].value, size))
+                return asm_error(a, "immediate out of range for", base);
+            uint8_t opcode = size == 1 ? 0x80 : fits_int8(ops[0].value) ? 0x83 : 0x81;
+            return asm_encode(a, prefix, wide, byte_rex, &opcode, 1, n, &ops[1], opcode == 0x81 ? immediate_size(size) : 1, ops[0].value);
+        }
+        if (is_register(&ops[0], 0) && is_register_or_memory(&ops[1], 0)) {
+            uint8_t opcode = n * 8 + (size == 1 ? 0 : 1);
+            return asm_encode(a, prefix, wide, byte_rex, &opcode, 1, ops[0].reg, &ops[1], 0, 0);
+        }
+        if (ops[0].kind == MEMORY_OPERAND && is_register(&ops[1], 0)) {
+            uint8_t opcode = n * 8 + (size == 1 ? 2 : 3);
+            return asm_encode(a, prefix, wide, byte_rex, &opcode, 1, ops[1].reg, &ops[0], 0, 0);
+        }
+        return asm_error(a, "invalid operands for", base);
+    }
+    if (!strcmp(base, "mov")) {
+        if (!check_operand_count(a, base, count, 2))
+            return 0;
+        if (ops[0].kind == IMMEDIATE_OPERAND && is_register(&ops[1], 0)) {
+            if (size == 8 && !fits_int32(ops[0].value)) // movabs
+                return asm_encode_register(a, 0, 1, 0, 0xb8, ops[1].reg, 8, ops[0].value);
+            if (!fits_immediate(ops[0].value, size))
+                return asm_error(a, "immediate out of range for", base);
+            if (size == 8) {
+                const uint8_t opcode = 0xc7;
+                return asm_encode(a, 0, 1, 0, &opcode, 1, 0, &ops[1], 4, ops[0].value);
+            }
+            return asm_encode_register(a, prefix, 0, byte_rex, size == 1 ? 0xb0 : 0xb8, ops[1].reg, size, ops[0].value);
+        }
+        if (ops[0].kind == IMMEDIATE_OPERAND && ops[1].kind == MEMORY_OPERAND) {
+            if (!fits_immediate(ops[0].value, size))
+                return asm_error(a, "immediate out of range for", base);
+            const uint8_t opcode = size == 1 ? 0xc6 : 0xc7;
+            return asm_encode(a, prefix, wide, 0, &opcode, 1, 0, &ops[1], immediate_size(size), ops[0].value);
+        }
+        if (is_register(&ops[0], 0) && is_register_or_memory(&ops[1], 0)) {
+            const uint8_t opcode = size == 1 ? 0x88 : 0x89;
+            return asm_encode(a, prefix, wide, byte_rex, &opcode, 1, ops[0].reg, &ops[1], 0, 0);
+        }
+        if (ops[0].kind == MEMORY_OPERAND && is_register(&ops[1], 0)) {
+            const uint8_t opcode = size == 1 ? 0x8a : 0x8b;
+            return asm_encode(a, prefix, wide, byte_rex, &opcode, 1, ops[1].reg, &ops[0], 0, 0);
+        }
+        return asm_error(a, "invalid operands for", base);
+    }
+    if (!strcmp(base, "test")) {
+        if (!check_operand_count(a, base, count, 2))
+            return 0;
+        if (ops[0].kind == IMMEDIATE_OPERAND && is_register_or_memory(&ops[1], 0)) {
+            if (!fits_immediate(ops[0].value, size))
+                return asm_error(a, "immediate out of range for", base);
+            const uint8_t opcode = size == 1 ? 0xf6 : 0xf7;
+            return asm_encode(a, prefix, wide, byte_rex, &opcode, 1, 0, &ops[1], immediate_size(size), ops[0].value);
+        }
+        if (is_register(&ops[0], 0) && is_register_or_memory(&ops[1], 0)) {
+            const uint8_t opcode = size == 1 ? 0x84 : 0x85;
+            return asm_encode(a, prefix, wide, byte_rex, &opcode, 1, ops[0].reg, &ops[1], 0, 0);
+        }
+        return asm_error(a, "invalid operands for", base);
+    }
+    if (!strcmp(base, "lea")) {
+        if (!check_operand_count(a, base, count, 2))
+            return 0;
+        if (ops[0].kind != MEMORY_OPERAND || !is_register(&ops[1], 0) || size < 2)
+            return asm_error(a, "invalid operands for", base);
+        const uint8_t opcode = 0x8d;
+        return asm_encode(a, prefix, wide, 0, &opcode, 1, ops[1].reg, &ops[0], 0, 0);
+    }
+    if (!strcmp(base, "imul") && count >= 2) {
+        if (count == 2 && is_register_or_memory(&ops[0], 0) && is_register(&ops[1], 0) && size > 1) {
+            const uint8_t opcode[] = { 0x0f, 0xaf };
+            return asm_encode(a, prefix, wide, 0, opcode, 2, ops[1].reg, &ops[0], 0, 0);
+        }
+        const AsmOperand *target = &ops[count - 1], *source = count == 3 ? &ops[1] : target; // imul $n, %reg multiplies the register
+        if (ops[0].kind == IMMEDIATE_OPERAND && is_register_or_memory(source, 0) && is_register(target, 0) && size > 1
+            && fits_immediate(ops[0].value, size)) {
+            const uint8_t opcode = fits_int8(ops[0].value) ? 0x6b : 0x69;
+            int length = opcode == 0x6b ? 1 : immediate_size(size);
+            return asm_encode(a, prefix, wide, 0, &opcode, 1, target->reg, source, length, ops[0].value);
+        }
+        return asm_error(a, "invalid operands for", base);
+    }
+    for (int n = 0; n < 8; n++) {
+        if ((unary[n] == NULL || strcmp(base, unary[n])) && (n != 5 || strcmp(base, "imul")))
+            continue;
+        if (!check_operand_count(a, base, count, 1))
+            return 0;
+        if (!is_register_or_memory(&ops[0], 0))
+            return asm_error(a, "invalid operand for", base);
+        const uint8_t opcode = size == 1 ? 0xf6 : 0xf7;
+        return asm_encode(a, prefix, wide, byte_rex, &opcode, 1, n, &ops[0], 0, 0);
+    }
+    if (!strcmp(base, "inc") || !strcmp(base, "dec")) {
+        if (!check_operand_count(a, base, count, 1))
+            return 0;
+        if (!is_register_or_memory(&ops[0], 0))
+            return asm_error(a, "invalid operand for", base);
+        const uint8_t opcode = size == 1 ? 0xfe : 0xff;
+        return asm_encode(a, prefix, wide, byte_rex, &opcode, 1, base[0] == 'd', &ops[0], 0, 0);
+    }
+    for (int n = 0; n < 8; n++) {
+        if ((shifts[n] == NULL || strcmp(base, shifts[n])) && (n != 4 || strcmp(base, "sal")))
+            continue;
+        const AsmOperand *target = &ops[count - 1];
+        if ((count != 1 && count != 2) || !is_register_or_memory(target, 0))
+            return asm_error(a, "invalid operands for", base);
+        uint8_t opcode = size == 1 ? 0xd0 : 0xd1;
+        if (count == 2 && ops[0].kind == IMMEDIATE_OPERAND && ops[0].value != 1) { // Shifts by 1 have their own opcode
+            if (ops[0].value < 0 || ops[0].value > 63)
+                return asm_error(a, "shift count out of range for", base);
+            opcode = size == 1 ? 0xc0 : 0xc1;
+            return asm_encode(a, prefix, wide, byte_rex, &opcode, 1, n, target, 1, ops[0].value);
+        }
+        if (count == 2 && ops[0].kind != IMMEDIATE_OPERAND && (!is_register(&ops[0], 0) || ops[0].reg != 1 || ops[0].size != 1))
+            return asm_error(a, "shift count must be an immediate or %cl for", base);
+        if (count == 2 && ops[0].kind != IMMEDIATE_OPERAND)
+            opcode += 2;
+        return asm_encode(a, prefix, wide, byte_rex, &opcode, 1, n, target, 0, 0);
+    }
+    if (!strcmp(base, "push") || !strcmp(base, "pop")) {
+        int push = base[1] == 'u';
+        if (!check_operand_count(a, base, count, 1))
+            return 0;
+        if (is_register(&ops[0], 0) && ops[0].size == 8)
+            return asm_encode_register(a, 0, 0, 0, push ? 0x50 : 0x58, ops[0].reg, 0, 0);
+        if (push && ops[0].kind == IMMEDIATE_OPERAND && fits_int32(ops[0].value)) {
+            asm_put(a, fits_int8(ops[0].value) ? 0x6a : 0x68, 1);
+            asm_put(a, (uint64_t) ops[0].value, fits_int8(ops[0].value) ? 1 : 4);
+            return !a->failed;
+        }
+        if (ops[0].kind == MEMORY_OPERAND) {
+            const uint8_t opcode = push ? 0xff : 0x8f;
+            return asm_encode(a, 0, 0, 0, &opcode, 1, push ? 6 : 0, &ops[0], 0, 0);
+        }
+        return asm_error(a, "invalid operand for", base);
+    }
+    *handled = 0;
+    return 0;
+}
+
+int asm_instruction(Assembler *a, const char *mnemonic, char *operands) {
+    AsmOperand ops[MAX_OPERANDS];
+    int count = 0;
+    operands = trim_blanks(operands);
+    while (*operands != '\0') { // Commas inside parentheses belong to a memory operand
+        if (count == MAX_OPERANDS)
+            return asm_error(a, "too many operands for", mnemonic);
+        char *end = operands;
+        for (int depth = 0; *end != '\0' && (*end != ',' || depth > 0); end++)
+            depth += *end == '(' ? 1 : *end == ')' ? -1 : 0;
+        int last = *end == '\0';
+        *end = '\0';
+        if (!parse_operand(a, operands, &ops[count++]))
+            return 0;
+        operands = last ? end : end + 1;
+    }
+    if (asm_current(a) == NULL)
+        return 0;
+
+    int handled, result = encode_sse(a, mnemonic, ops, count, &handled);
+    if (!handled)
+        result = encode_control(a, mnemonic, ops, count, &handled);
+    if (!handled)
+        result = encode_extension(a, mnemonic, ops, count, &handled);
+    if (!handled) { // Size from the registers, else from the suffix
+        int size = 0;
+        for (int n = 0; n < count; n++) {
+            if (ops[n].kind == REGISTER_OPERAND && ops[n].size != 16)
+                size = ops[n].size;
+        }
+        if (size != 0)
+            result = encode_integer(a, mnemonic, size, ops, count, &handled);
+    }
+    if (!handled) {
+        size_t length = strlen(mnemonic);
+        char base[16];
+        const char *suffix = length > 1 && length < sizeof(base) ? strchr("bwlq", mnemonic[length - 1]) : NULL;
+        if (suffix != NULL) {
+            memcpy(base, mnemonic, length - 1);
+            base[length - 1] = '\0';
+            int size = 1 << (suffix - "bwlq");
+            for (int n = 0; n < count; n++) {
+                if (ops[n].kind == REGISTER_OPERAND && ops[n].size != 16 && ops[n].size != size && strcmp(base, "shl")
+                    && strcmp(base, "shr") && strcmp(base, "sar") && strcmp(base, "sal"))
+                    return asm_error(a, "operand size does not match the suffix of", mnemonic);
+            }
+            result = encode_integer(a, base, size, ops, count, &handled);
+        }
+    }
+    if (!handled)
+        return asm_error(a, "unknown instruction", mnemonic);
+    return result;
+}
+
+// Directives
+
+int parse_string(Assembler *a, char **text, int terminate) { // Quoted string with the escapes of GNU as
+    char *p = skip_blanks(*text);
+    if (*p++ != '"')
+        return asm_error(a, "expected a string", *text);
+    while (*p != '"') {
+        unsigned char ch = *p++;
+        if (ch == '\0')
+            return asm_error(a, "unterminated string", *text);
+        if (ch == '\\') {
+            ch = *p++;
+            if (ch >= '0' && ch <= '7') {
+                int value = ch - '0';
+                for (int n = 0; n < 2 && *p >= '0' && *p <= '7'; n++)
+                    value = value * 8 + (*p++ - '0');
+                ch = value;
+            }
+            else if (ch == 'x') {
+                int value = 0;
+                while (isxdigit((unsigned char) *p)) {
+                    value = value * 16 + (isdigit((unsigned char) *p) ? *p - '0' : (tolower((unsigned char) *p) - 'a' + 10));
+                    p++;
+                }
+                ch = value;
+            }
+            else if (ch == 'n') ch = '\n';
+            else if (ch == 't') ch = '\t';
+            else if (ch == 'r') ch = '\r';
+            else if (ch == 'b') ch = '\b';
+            else if (ch == 'f') ch = '\f';
+            else if (ch == '\0')
+                return asm_error(a, "unterminated string", *text);
+        }
+        asm_put(a, ch, 1);
+    }
+    if (terminate)
+        asm_put(a, 0, 1);
+    *text = skip_blanks(p + 1);
+    return !a->failed;
+}
+
+int asm_directive(Assembler *a, const char *name, char *arguments) {
+    arguments = trim_blanks(arguments);
+    if (!strcmp(name, ".text") || !strcmp(name, ".data") || !strcmp(name, ".bss") || !strcmp(name, ".section")) {
+        const char *section = !strcmp(name, ".section") ? arguments : name;
+        size_t length = strcspn(section, ", \t");
+        if (length == 5 && !strncmp(section, ".text", 5))
+            a->section = TEXT_SECTION;
+        else if (length == 5 && !strncmp(section, ".data", 5))
+            a->section = DATA_SECTION;
+        else if (length == 7 && !strncmp(section, ".rodata", 7))
+            a->section = RODATA_SECTION;
+        else if (length == 4 && !strncmp(section, ".bss", 4))
+            a->section = BSS_SECTION;
+        else if (length == 15 && !strncmp(section, ".note.GNU-stack", 15))
+            a->section = -1; // Marks the stack non-executable, which the object writer does on its own
+        else
+            return asm_error(a, "unsupported section", section);
+        return 1;
+    }
+    if (!strcmp(name, ".globl") || !strcmp(name, ".global") || !strcmp(name, ".type") || !strcmp(name, ".size")) {
+        size_t length = 0;
+        while (is_symbol_char(arguments[length]))
+            length++;
+        int symbol = length > 0 ? asm_symbol(a, arguments, length) : -1;
+        if (symbol < 0)
+            return asm_error(a, "expected a symbol after", name);
+        AsmSymbol *symb = &a->as->symbols[symbol];
+        char *value = skip_blanks(arguments + length);
+        value = *value == ',' ? skip_blanks(value + 1) : value;
+        if (name[1] == 'g')
+            symb->global = 1;
+        else if (name[1] == 't')
+            symb->function = !strcmp(value, "@function");
+        else if (!strncmp(value, ".-", 2) && !strcmp(value + 2, symb->name) && symb->section == a->section && a->section >= 0)
+            symb->size = a->as->sections[a->section].size - symb->offset;
+        return 1;
+    }
+    if (!strcmp(name, ".file") || !strcmp(name, ".ident"))
+        return 1;
+    if (asm_current(a) == NULL)
+        return 0;
+    AsmSection *section = &a->as->sections[a->section];
+    if (!strcmp(name, ".balign") || !strcmp(name, ".align") || !strcmp(name, ".p2align")) {
+        int64_t alignment;
+        if (!parse_number(arguments, &alignment) || alignment < 0 || alignment > 4096)
+            return asm_error(a, "invalid alignment", arguments);
+        if (name[1] == 'p')
+            alignment = (int64_t) 1 << alignment;
+        if (alignment & (alignment - 1))
+            return asm_error(a, "alignment is not a power of two", arguments);
+        if (alignment > section->alignment)
+            section->alignment = alignment;
+        while (section->size % alignment != 0)
+            asm_put(a, a->section == TEXT_SECTION ? 0x90 : 0, 1);
+        return !a->failed;
+    }
+    if (!strcmp(name, ".zero") || !strcmp(name, ".skip")) {
+        int64_t count;
+        if (!parse_number(arguments, &count) || count < 0 || count > (1 << 30))
+            return asm_error(a, "invalid size", arguments);
+        uint8_t *bytes = asm_reserve(a, count);
+        if (bytes != NULL)
+            memset(bytes, 0, count);
+        return !a->failed;
+    }
+    if (!strcmp(name, ".string") || !strcmp(name, ".asciz") || !strcmp(name, ".ascii")) {
+        for (;;) {
+            if (!parse_string(a, &arguments, name[3] != 'c'))
+                return 0;
+            if (*arguments != ',')
+                break;
+            arguments++;
+        }
+        return *arguments == '\0' || asm_error(a, "unexpected text after a string", arguments);
+    }
+    if (!strcmp(name, ".double")) {
+        for (char *p = arguments; *p != '\0'; ) {
+            char *end;
+            double value = strtod(p, &end);
+            end = skip_blanks(end);
+            if (end == p || (*end != ',' && *end != '\0'))
+                return asm_error(a, "invalid real number", p);
+            uint64_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            asm_put(a, bits, 8);
+            p = *end == ',' ? skip_blanks(end + 1) : end;
+        }
+        return !a->failed;
+    }
+    int size = !strcmp(name, ".byte") ? 1 :!strcmp(name, ".word") || !strcmp(name, ".short") ? 2
+               : !strcmp(name, ".long") || !strcmp(name, ".int") ? 4 : !strcmp(name, ".quad") ? 8 : 0;
+    if (size == 0)
+        return asm_error(a, "unsupported directive", name);
+    while (*arguments != '\0') {
+        char *end = strchr(arguments, ',');
+        if (end != NULL)
+            *end = '\0';
+        int symbol;
+        int64_t value;
+        if (!parse_reference(a, arguments, &symbol, &value))
+            return 0;
+        if (symbol >= 0 && size != 8)
+            return asm_error(a, "only .quad holds addresses", arguments);
+        if (symbol >= 0)
+            asm_relocation(a, symbol, RELOCATION_64, value);
+        asm_put(a, symbol >= 0 ? 0 : (uint64_t) value, size);
+        arguments = end != NULL ? end + 1 : arguments + strlen(arguments);
+    }
+    return !a->failed;
+}
+
+// Lines
+
+int asm_line(Assembler *a, char *line) {
+    int quoted = 0; // Comments start with # outside of the strings
+    for (char *p = line; *p != '\0'; p++) {
+        if (*p == '\\' && quoted && p[1] != '\0')
+            p++;
+        else if (*p == '"')
+            quoted = !quoted;
+        else if (*p == '#' && !quoted) {
+            *p = '\0';
+            break;
+        }
+    }
+    char *p = skip_blanks(line);
+    for (;;) { // Labels
+        char *end = p;
+        while (is_symbol_char(*end))
+            end++;
+        if (end == p || *end != ':')
+            break;
+        int symbol = asm_symbol(a, p, end - p);
+        if (symbol < 0)
+            return 0;
+        AsmSymbol *symb = &a->as->symbols[symbol];
+        if (symb->section >= 0) {
+            *end = '\0';
+            return asm_error(a, "symbol already defined", p);
+        }
+        if (asm_current(a) == NULL)
+            return 0;
+        symb->section = a->section;
+        symb->offset = a->as->sections[a->section].size;
+        p = skip_blanks(end + 1);
+    }
+    if (*trim_blanks(p) == '\0')
+        return 1;
+    char *end = p;
+    while (*end != '\0' && *end != ' ' && *end != '\t')
+        end++;
+    char *arguments = end;
+    if (*end != '\0')
+        *arguments++ = '\0';
+    if (*p == '.')
+        return asm_directive(a, p, arguments);
+    return asm_instruction(a, p, arguments);
+}
+
+int resolve_local_relocations(Assembler *a) {
+    // Displacements to a label of the same section are final, the other relocations are kept for the writers
+    for (int s = 0; s < SECTION_COUNT; s++) {
+        AsmSection *section = &a->as->sections[s];
+        int kept = 0;
+        for (int r = 0; r < section->relocation_count; r++) {
+            AsmRelocation relocation = section->relocations[r];
+            const AsmSymbol *symb = &a->as->symbols[relocation.symbol];
+            if (relocation.kind != RELOCATION_64 && symb->section == s && !symb->global) {
+                int64_t value = (int64_t) symb->offset + relocation.addend - (int64_t) relocation.offset;
+                for (int n = 0; n < 4; n++)
+                    section->bytes[relocation.offset + n] = ((uint64_t) value >> (8 * n)) & 0xff;
+            }
+            else
+                section->relocations[kept++] = relocation;
+        }
+        section->relocation_count = kept;
+    }
+    return 1;
+}
+
+Assembler* start_assembly(CompilerContext *ctx) {
+    Assembler *a = calloc(1, sizeof(Assembler));
+    Assembly *as = calloc(1, sizeof(Assembly));
+    if (a == NULL || as == NULL) {
+        fprintf(ctx->log_fptr, "Error: failed to allocate memory for the assembler\n");
+        free(a);
+        free(as);
+        return NULL;
+    }
+    for (int s = 0; s < SECTION_COUNT; s++)
+        as->sections[s].alignment = 1;
+    a->ctx = ctx;
+    a->as = as;
+    a->section = TEXT_SECTION;
+    return a;
+}
+
+int assemble_part(Assembler *a, const char *text, size_t length) {
+    // Next whole lines of the text, the section and the symbols carry over from the previous parts
+    if (a->failed)
+        return 0;
+    char *copy = malloc(length + 1);
+    if (copy == NULL) {
+        fprintf(a->ctx->log_fptr, "Error: failed to allocate memory for the assembler\n");
+        a->failed = 1;
+        return 0;
+    }
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    for (char *line = copy; line < copy + length && !a->failed; ) {
+        char *next = strchr(line, '\n');
+        if (next != NULL)
+            *next++ = '\0';
+        a->line++;
+        asm_line(a, line);
+        line = next != NULL ? next : copy + length;
+    }
+    free(copy);
+    return !a->failed;
+}
+
+Assembly* finish_assembly(Assembler *a) { // Frees the assembler, NULL when a part failed
+    Assembly *as = a->as;
+    if (a->failed || !resolve_local_relocations(a)) {
+        free_assembly(as);
+        as = NULL;
+    }
+    free(a);
+    return as;
+}
+
+void free_assembly(Assembly *as) {
+    if (as == NULL)
+        return;
+    for (int s = 0; s < SECTION_COUNT; s++) {
+        free(as->sections[s].bytes);
+        free(as->sections[s].relocations);
+    }
+    for (int s = 0; s < as->symbol_count; s++)
+        free(as->symbols[s].name);
+    free(as->symbols);
+    free(as->buckets);
+    free(as);
+}
@@ -0,0 +1,62 @@
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "compiler_context.h"
+
+// Built-in assembler for the AT&T syntax the code generator (and the bundled runtime) writes: the usual directives and
+// the integer, SSE and control instructions with their register, immediate and memory operands. Every jump and call
+// takes a 32 bit displacement, the ones reaching a label of their own section are patched at the end and the others
+// are left as relocations for the object writer or the linker. The text can be given in parts of whole lines, such as the
+// routines of a program as they are generated.
+
+typedef enum {
+    TEXT_SECTION, DATA_SECTION, RODATA_SECTION, BSS_SECTION, // .bss only holds zeros, left out of the files
+    SECTION_COUNT
+} SectionKind;
+
+typedef enum {
+    RELOCATION_PC32, RELOCATION_PLT32, RELOCATION_64
+} RelocationKind;
+
+typedef struct _AsmRelocation {
+    size_t offset; // In the section holding the field
+    int symbol;
+    RelocationKind kind;
+    int64_t addend;
+} AsmRelocation;
+
+typedef struct _AsmSection {
+    uint8_t *bytes;
+    size_t size, capacity;
+    AsmRelocation *relocations;
+    int relocation_count, relocation_capacity;
+    int alignment;
+} AsmSection;
+
+typedef struct _AsmSymbol {
+    char *name;
+    int section; // -1 while undefined
+    size_t offset, size;
+    int global, function;
+} AsmSymbol;
+
+typedef struct _Assembly {
+    AsmSection sections[SECTION_COUNT];
+    AsmSymbol *symbols;
+    int symbol_count, symbol_capacity;
+    int *buckets; // Open addressing table of symbol indexes (-1 when empty)
+    int bucket_count;
+} Assembly;
+
+typedef struct _Assembler Assembler; // Defined in assembler.c
+
+Assembler* start_assembly(CompilerContext *);
+int assemble_part(Assembler *, const char *, size_t);
+Assembly* finish_assembly(Assembler *);
+int find_symbol(const Assembly *, const char *);
+void free_assembly(Assembly *);
+
+#endif
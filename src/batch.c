@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "scanner.h"
+#include "compiler_context.h"
+#include "batch.h"
+
+typedef struct _BatchQueue { // Shared by the worker threads, every source file is handed out exactly once
+    char **paths;
+    int path_count;
+    int next_path;
+    int success_count;
+    const CompileOptions *options;
+    pthread_mutex_t queue_lock;
+    pthread_mutex_t output_lock;
+} BatchQueue;
+
+int default_thread_count() {
+#ifdef _SC_NPROCESSORS_ONLN
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (count > 0)
+        return count > MAX_THREAD_COUNT ? MAX_THREAD_COUNT : (int) count;
+#endif
+    return 1;
+}
+
+void free_paths(char **paths, int path_count) {
+    if (paths != NULL) {
+        for (int i = 0; i < path_count; i++)
+            free(paths[i]);
+        free(paths);
+    }
+}
+
+char** read_response_file(FILE *log_fptr, const char *path, int *path_count) {
+    // A response file lists one source file path per line, empty lines are skipped; the paths are freed with free_paths
+    FILE *fptr = fopen(path, "r");
+    if (fptr == NULL) {
+        fprintf(log_fptr, "Error: failed to find response file at path \"%s\"\n", path);
+        return NULL;
+    }
+    int n = 1;
+    char **paths = malloc(n * BUFFER_SIZE * sizeof(char *));
+    char line[4096];
+    *path_count = 0;
+    if (paths == NULL) {
+        fprintf(log_fptr, "Error: failed to allocate memory for the response file paths\n");
+        fclose(fptr);
+        return NULL;
+    }
+    while (fgets(line, sizeof(line), fptr) != NULL) {
+        int length = strlen(line);
+        while (length > 0 && (line[length-1] == '\n' || line[length-1] == '\r' || line[length-1] == ' ' || line[length-1] == '\t'))
+            line[--length] = '\0';
+        if (length == 0)
+            continue;
+        if (*path_count >= n * BUFFER_SIZE) {
+            char **new_paths = realloc(paths, ++n * BUFFER_SIZE * sizeof(char *));
+            if (new_paths == NULL) {
+                fprintf(log_fptr, "Error: failed to reallocate more memory to the response file paths\n");
+                free_paths(paths, *path_count);
+                fclose(fptr);
+                return NULL;
+            }
+            paths = new_paths;
+        }
+        paths[*path_count] = malloc(length + 1);
+        if (paths[*path_count] == NULL) {
+            fprintf(log_fptr, "Error: failed to allocate memory for a response file path\n");
+            free_paths(paths, *path_count);
+            fclose(fptr);
+            return NULL;
+        }
+        strcpy(paths[*path_count], line);
+        (*path_count)++;
+    }
+    fclose(fptr);
+    return paths;
+}
+
+void flush_log(BatchQueue *queue, const char *path, FILE *log_fptr) {
+    // Diagnostics of a source file are buffered then printed in one go so that files compiled concurrently don't interleave
+    long size = ftell(log_fptr);
+    if (size > 0) {
+        char buffer[4096];
+        rewind(log_fptr);
+        pthread_mutex_lock(&queue->output_lock);
+        printf("%s:\n", path);
+        while (size > 0) {
+            size_t read_size = fread(buffer, 1, size < (long) sizeof(buffer) ? (size_t) size : sizeof(buffer), log_fptr);
+            if (read_size == 0)
+                break;
+            fwrite(buffer, 1, read_size, stdout);
+            size -= read_size;
+        }
+        fflush(stdout);
+        pthread_mutex_unlock(&queue->output_lock);
+    }
+    rewind(log_fptr);
+}
+
+void* batch_worker(void *arg) {
+    BatchQueue *queue = arg;
+    CompilerContext *ctx = make_context(); // Each worker reuses a single context, it is reset after every source file
+    if (ctx == NULL)
+        return NULL;
+    ctx->options = *queue->options;
+    FILE *log_fptr = tmpfile();
+    if (log_fptr != NULL)
+        ctx->log_fptr = log_fptr;
+    while (1) {
+        pthread_mutex_lock(&queue->queue_lock);
+        int path_idx = queue->next_path++;
+        pthread_mutex_unlock(&queue->queue_lock);
+        if (path_idx >= queue->path_count)
+            break;
+        int result = compile_file(ctx, queue->paths[path_idx]);
+        if (log_fptr != NULL) {
+            fflush(log_fptr);
+            flush_log(queue, queue->paths[path_idx], log_fptr);
+        }
+        if (result) {
+            pthread_mutex_lock(&queue->queue_lock);
+            queue->success_count++;
+            pthread_mutex_unlock(&queue->queue_lock);
+        }
+    }
+    if (log_fptr != NULL)
+        fclose(log_fptr);
+    free_context(ctx);
+    return NULL;
+}
+
+int compile_batch(char **paths, int path_count, int thread_count, const CompileOptions *options) { // Returns the number of source files that failed
+    if (path_count == 1 || thread_count <= 1) { // No worker threads needed, diagnostics go straight to stdout
+        CompilerContext *ctx = make_context();
+        if (ctx == NULL)
+            return path_count;
+        ctx->options = *options;
+        int success_count = 0;
+        for (int i = 0; i < path_count; i++) {
+            if (path_count > 1)
+                printf("%s:\n", paths[i]);
+            success_count += compile_file(ctx, paths[i]);
+        }
+        free_context(ctx);
+        if (path_count > 1)
+            printf("Compiled %d of %d source files\n", success_count, path_count);
+        return path_count - success_count;
+    }
+
+    if (thread_count > path_count)
+        thread_count = path_count;
+    if (thread_count > MAX_THREAD_COUNT)
+        thread_count = MAX_THREAD_COUNT;
+    BatchQueue queue;
+    queue.paths = paths;
+    queue.path_count = path_count;
+    queue.next_path = 0;
+    queue.success_count = 0;
+    queue.options = options;
+    pthread_mutex_init(&queue.queue_lock, NULL);
+    pthread_mutex_init(&queue.output_lock, NULL);
+
+    pthread_t workers[MAX_THREAD_COUNT];
+    int worker_count = 0;
+    for (int i = 0; i < thread_count; i++) {
+        if (pthread_create(&workers[worker_count], NULL, batch_worker, &queue) != 0) {
+            printf("Warning: failed to start worker thread %d, continuing with %d threads\n", i + 1, worker_count);
+            break;
+        }
+        worker_count++;
+    }
+    if (worker_count == 0) // Compile on the calling thread if no worker could be started
+        batch_worker(&queue);
+    for (int i = 0; i < worker_count; i++)
+        pthread_join(workers[i], NULL);
+
+    pthread_mutex_destroy(&queue.queue_lock);
+    pthread_mutex_destroy(&queue.output_lock);
+    printf("Compiled %d of %d source files\n", queue.success_count, path_count);
+    return path_count - queue.success_count;
+}
@@ -0,0 +1,15 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdio.h>
+
+#include "compiler_context.h"
+
+#define MAX_THREAD_COUNT 256
+
+int default_thread_count();
+char** read_response_file(FILE *, const char *, int *);
+void free_paths(char **, int);
+int compile_batch(char **, int, int, const CompileOptions *);
+
+#endif
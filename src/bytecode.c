@@ -0,0 +1,234 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "compiler_context.h"
+#include "code_generator.h"
+#include "interpreter.h"
+#include "bytecode.h"
+
+#define align_8(size) (((size) + 7) & ~(size_t) 7)
+
+int write_bytecode(CompilerContext *ctx, const Program *program, FILE *fptr) { // Written before running, the statics hold their initial values
+    Value *statics = malloc((program->static_count + 1) * sizeof(Value));
+    if (statics == NULL) {
+        fprintf(ctx->log_fptr, "Error: failed to allocate memory for the bytecode statics\n");
+        return 0;
+    }
+    uint32_t string_size = 0;
+    for (int s = 0; s < program->static_count; s++) {
+        statics[s] = program->statics[s];
+        if (program->static_classes[s] == STRING_VALUE) {
+            statics[s].s = (char *) (uintptr_t) string_size; // Offset in the pool
+            string_size += strlen(program->statics[s].s) + 1;
+        }
+    }
+    BytecodeHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BYTECODE_MAGIC, sizeof(BYTECODE_MAGIC));
+    header.version = BYTECODE_VERSION;
+    header.entry = program->entry;
+    header.instruction_count = program->instruction_count;
+    header.static_count = program->static_count;
+    header.string_size = string_size;
+    int result = fwrite(&header, sizeof(header), 1, fptr) == 1;
+    for (int n = 0; result && n < program->instruction_count; n++) {
+        Instruction instruction = program->instructions[n];
+        instruction.handler = NULL;
+        result = fwrite(&instruction, sizeof(instruction), 1, fptr) == 1;
+    }
+    if (result && program->static_count > 0)
+        result = fwrite(statics, sizeof(Value), program->static_count, fptr) == (size_t) program->static_count;
+    if (result && program->static_count > 0) {
+        const uint8_t padding[8] = { 0 };
+        result = fwrite(program->static_classes, 1, program->static_count, fptr) == (size_t) program->static_count
+                 && fwrite(padding, 1, align_8(program->static_count) - program->static_count, fptr)
+                    == align_8(program->static_count) - program->static_count;
+    }
+    for (int s = 0; result && s < program->static_count; s++) {
+        if (program->static_classes[s] == STRING_VALUE)
+            result = fputs(program->statics[s].s, fptr) >= 0 && fputc('\0', fptr) != EOF;
+    }
+    if (!result)
+        fprintf(ctx->log_fptr, "Error: failed to write the bytecode file\n");
+    free(statics);
+    return result;
+}
+
+void* map_bytecode(CompilerContext *ctx, const char *path, size_t *size) { // Private writable copy of the file, NULL on failure
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(ctx->log_fptr, "Error: failed to open bytecode file at path \"%s\"\n", path);
+        return NULL;
+    }
+    struct stat file_stat;
+    void *mapping = NULL;
+    if (fstat(fd, &file_stat) == 0 && file_stat.st_size >= (off_t) sizeof(BytecodeHeader)) {
+        *size = file_stat.st_size;
+        mapping = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0); // The handlers are written when running
+        if (mapping == MAP_FAILED)
+            mapping = NULL;
+    }
+    close(fd);
+    if (mapping == NULL)
+        fprintf(ctx->log_fptr, "Error: failed to map bytecode file at path \"%s\"\n", path);
+    return mapping;
+#else
+    FILE *fptr = fopen(path, "rb");
+    if (fptr == NULL) {
+        fprintf(ctx->log_fptr, "Error: failed to open bytecode file at path \"%s\"\n", path);
+        return NULL;
+    }
+    void *mapping = NULL;
+    long length = fseek(fptr, 0, SEEK_END) == 0 ? ftell(fptr) : -1;
+    if (length >= (long) sizeof(BytecodeHeader) && fseek(fptr, 0, SEEK_SET) == 0 && (mapping = malloc(length)) != NULL) {
+        *size = length;
+        if (fread(mapping, 1, length, fptr) != (size_t) length) {
+            free(mapping);
+            mapping = NULL;
+        }
+    }
+    fclose(fptr);
+    if (mapping == NULL)
+        fprintf(ctx->log_fptr, "Error: failed to read bytecode file at path \"%s\"\n", path);
+    return mapping;
+#endif
+}
+
+void unmap_bytecode(void *mapping, size_t size) {
+#ifndef _WIN32
+    munmap(mapping, size);
+#else
+    free(mapping);
+#endif
+}
+
+int slot_operands(int opcode) { // Operands holding slots: 1 for a, 2 for b, 4 for c
+    if (opcode <= OP_OR || opcode == OP_PRINT_F)
+        return 7;
+    if (opcode >= OP_JLT_I && opcode <= OP_JEQ_I)
+        return 6;
+    if (opcode == OP_IFZ || opcode == OP_IFNZ)
+        return 2;
+    if (opcode == OP_GOTO || opcode == OP_PRINTLN || opcode == OP_READLN || opcode == OP_ENTER || opcode == OP_RET_VOID
+        || opcode == OP_HALT)
+        return 0;
+    if ((opcode >= OP_READ_I && opcode <= OP_READ_S) || opcode == OP_ARG || opcode == OP_ARG_REF || opcode == OP_CALL
+        || opcode == OP_RET)
+        return 1;
+    return 3; // Unary operations, OP_ADDI, the loop steps, the prints and the references
+}
+
+int valid_slot(int32_t operand, int static_count, int frame_size) {
+    if (operand < 0)
+        return 0;
+    return (operand & 1) == STATIC_BASE ? (operand >> 1) < static_count : (operand >> 1) < frame_size;
+}
+
+int check_routine(const Program *program, int start, int end) {
+    // Instructions of the routine from its OP_ENTER up to the next one: slots inside the statics and the frame checked by
+    // OP_ENTER, jumps inside the routine, calls to the start of another one and no way to run past its end
+    const Instruction *instructions = program->instructions;
+    int frame_size = instructions[start].a, is_main = start == program->entry;
+    if (frame_size < SCRATCH_COUNT || frame_size > STACK_SIZE)
+        return 0;
+    int last = instructions[end - 1].opcode;
+    if (last != OP_HALT && last != OP_GOTO && last != OP_RET && last != OP_RET_VOID)
+        return 0;
+    for (int n = start + 1; n < end; n++) {
+        const Instruction *instruction = &instructions[n];
+        int opcode = instruction->opcode, slots = slot_operands(opcode);
+        if (opcode < 0 || opcode >= OPCODE_COUNT || opcode == OP_ENTER)
+            return 0;
+        if ((slots & 1) && !(opcode == OP_CALL && instruction->a == -1) && !valid_slot(instruction->a, program->static_count, frame_size))
+            return 0;
+        if (((slots & 2) && !valid_slot(instruction->b, program->static_count, frame_size))
+            || ((slots & 4) && !valid_slot(instruction->c, program->static_count, frame_size)))
+            return 0;
+        if ((opcode == OP_GOTO || opcode == OP_IFZ || opcode == OP_IFNZ || (opcode >= OP_JLT_I && opcode <= OP_JEQ_I))
+            && (instruction->a <= start || instruction->a >= end))
+            return 0;
+        if ((opcode == OP_INC_LOOP || opcode == OP_DEC_LOOP) && (instruction->c <= start || instruction->c >= end
+            || (instructions[instruction->c].opcode != OP_JGT_I && instructions[instruction->c].opcode != OP_JLT_I)))
+            return 0;
+        if ((opcode == OP_ARG || opcode == OP_ARG_REF) && (instruction->b < 0 || instruction->b >= frame_size))
+            return 0;
+        if (opcode == OP_CALL && (instruction->b < 0 || instruction->b >= program->instruction_count || instruction->b == program->entry
+            || instructions[instruction->b].opcode != OP_ENTER || instruction->c < 0 || instruction->c > frame_size))
+            return 0;
+        if ((opcode == OP_RET || opcode == OP_RET_VOID) && is_main) // Nothing to return to
+            return 0;
+    }
+    return 1;
+}
+
+int check_instructions(const Program *program) {
+    // Every operand is checked as the file may not come from this compiler, the values of the statics and of the frames are
+    // still trusted to have the class the instructions read (a crafted file can make an integer read as a string)
+    const Instruction *instructions = program->instructions;
+    if (program->instruction_count == 0 || instructions[0].opcode != OP_ENTER || instructions[program->entry].opcode != OP_ENTER)
+        return 0;
+    for (int start = 0, end; start < program->instruction_count; start = end) {
+        for (end = start + 1; end < program->instruction_count && instructions[end].opcode != OP_ENTER; end++)
+            ;
+        if (!check_routine(program, start, end))
+            return 0;
+    }
+    return 1;
+}
+
+Program* load_bytecode(CompilerContext *ctx, const char *path) {
+    size_t size = 0;
+    uint8_t *mapping = map_bytecode(ctx, path, &size);
+    if (mapping == NULL)
+        return NULL;
+    BytecodeHeader *header = (BytecodeHeader *) mapping;
+    size_t instructions_size = (size_t) header->instruction_count * sizeof(Instruction);
+    size_t statics_size = (size_t) header->static_count * sizeof(Value);
+    size_t classes_size = align_8((size_t) header->static_count);
+    int result = !memcmp(header->magic, BYTECODE_MAGIC, sizeof(BYTECODE_MAGIC)) && header->version == BYTECODE_VERSION
+                 && header->instruction_count > 0 && header->static_count >= 0 && header->entry >= 0
+                 && header->entry < header->instruction_count
+                 && sizeof(BytecodeHeader) + instructions_size + statics_size + classes_size + header->string_size == size;
+    Program *program = result ? malloc(sizeof(Program)) : NULL;
+    if (program != NULL) {
+        program->instructions = (Instruction *) (mapping + sizeof(BytecodeHeader));
+        program->statics = (Value *) (mapping + sizeof(BytecodeHeader) + instructions_size);
+        program->static_classes = mapping + sizeof(BytecodeHeader) + instructions_size + statics_size;
+        program->instruction_count = program->instruction_capacity = header->instruction_count;
+        program->static_count = program->static_capacity = header->static_count;
+        program->entry = header->entry;
+        program->mapping = mapping;
+        program->mapping_size = size;
+        result = check_instructions(program);
+
+        // String statics point into the pool, which must end every string it holds
+        char *pool = (char *) program->static_classes + classes_size;
+        result = result && (header->string_size == 0 || pool[header->string_size - 1] == '\0');
+        for (int s = 0; result && s < program->static_count; s++) {
+            if (program->static_classes[s] > STRING_VALUE)
+                result = 0;
+            else if (program->static_classes[s] == STRING_VALUE) {
+                uintptr_t offset = (uintptr_t) program->statics[s].s;
+                result = offset < header->string_size;
+                program->statics[s].s = pool + offset;
+            }
+        }
+    }
+    if (!result) {
+        fprintf(ctx->log_fptr, "Error: \"%s\" is not a valid bytecode file\n", path);
+        if (program != NULL)
+            free_program(program);
+        else
+            unmap_bytecode(mapping, size);
+        return NULL;
+    }
+    return program;
+}
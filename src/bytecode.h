@@ -0,0 +1,30 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "compiler_context.h"
+#include "interpreter.h"
+
+// Bytecode files (.pbc) hold a decoded program as it is laid out in memory so the loader maps the file and runs it in
+// place: a header, the instructions (their handlers zeroed), the statics, their classes padded to 8 bytes then the pool
+// of the string literals. String statics hold the offset of their text in the pool until the loader fixes them up.
+
+#define BYTECODE_MAGIC "PBC"
+#define BYTECODE_VERSION 4
+
+typedef struct _BytecodeHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t entry;
+    int32_t instruction_count;
+    int32_t static_count;
+    uint32_t string_size;
+} BytecodeHeader;
+
+int write_bytecode(CompilerContext *, const Program *, FILE *);
+Program* load_bytecode(CompilerContext *, const char *);
+void unmap_bytecode(void *, size_t);
+
+#endif
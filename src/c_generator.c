@@ -0,0 +1,774 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "scanner.h"
+#include "symbol_table.h"
+#include "tac.h"
+#include "tac_array.h"
+#include "control_flow.h"
+#include "compiler_context.h"
+#include "code_generator.h"
+#include "c_generator.h"
+#include "write_format.h"
+
+// Portable C translation of the intermediate code, meant to be built with the system compiler (cc -O2). Every routine
+// becomes a C function named pas_<mangled name> and the main block main, global variables are named g_<name>, local ones
+// l_<name>, parameters p_<name> (pointers for the ones passed by reference) and temporaries t<n>. Labels stay labels,
+// integer arithmetic wraps around like the native code and the input and output go through the small runtime of the prelude.
+
+typedef struct _CGenerator {
+    CompilerContext *ctx;
+    FILE *fptr;
+    const TacArray *code;
+    const ParamType *params; // Parameters of the routine being translated
+    uint8_t *locals; // Symbols declared by the routine being translated
+    int *declared_temps; // Routine that last declared each temporary
+} CGenerator;
+
+const char *c_prelude =
+    "#include <stdio.h>\n"
+    "#include <stdlib.h>\n"
+    "#include <string.h>\n"
+    "#include <errno.h>\n"
+    "#include <unistd.h>\n"
+    "\n"
+    "// Integer arithmetic wraps around like the native code\n"
+    "#define PAS_ADD(x, y) ((int) ((unsigned) (x) + (unsigned) (y)))\n"
+    "#define PAS_SUB(x, y) ((int) ((unsigned) (x) - (unsigned) (y)))\n"
+    "#define PAS_MUL(x, y) ((int) ((unsigned) (x) * (unsigned) (y)))\n"
+    "#define PAS_NEG(x) ((int) -(unsigned) (x))\n"
+    "\n"
+    "// The joined strings are never freed, the variables holding them are not tracked like in the interpreter\n"
+    "static const char *pas_concat(const char *s1, const char *s2) {\n"
+    "    size_t length_1 = strlen(s1), length_2 = strlen(s2);\n"
+    "    char *str = malloc(length_1 + length_2 + 1);\n"
+    "    if (str == NULL) {\n"
+    "        fputs(\"Error: out of memory for the strings\\n\", stderr);\n"
+    "        exit(EXIT_FAILURE);\n"
+    "    }\n"
+    "    memcpy(str, s1, length_1);\n"
+    "    memcpy(str + length_1, s2, length_2 + 1);\n"
+    "    return str;\n"
+    "}\n"
+    "\n"
+    "static const char *pas_char_string(int c) {\n"
+    "    char buffer[2] = { (char) c, 0 };\n"
+    "    return pas_concat(buffer, \"\");\n"
+    "}\n"
+    "\n"
+    "// Same text as the other backends: integers two digits at a time, reals with their shortest round-trip digits\n"
+    "static const char pas_digit_pairs[] =\n"
+    "    \"00010203040506070809101112131415161718192021222324252627282930313233343536373839\"\n"
+    "    \"40414243444546474849505152535455565758596061626364656667686970717273747576777879\"\n"
+    "    \"8081828384858687888990919293949596979899\";\n"
+    "\n"
+    "static const double pas_powers[] = { // Exact up to 10^22, the nearest doubles above\n"
+    "    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,\n"
+    "    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22, 1e23,\n"
+    "    1e24, 1e25, 1e26, 1e27, 1e28, 1e29, 1e30, 1e31, 1e32, 1e33, 1e34, 1e35,\n"
+    "    1e36, 1e37, 1e38, 1e39, 1e40, 1e41, 1e42, 1e43, 1e44, 1e45, 1e46, 1e47,\n"
+    "    1e48, 1e49, 1e50, 1e51, 1e52, 1e53, 1e54\n"
+    "};\n"
+    "\n"
+    "static double pas_scale(double value, int exponent) {\n"
+    "    return exponent >= 0 ? value * pas_powers[exponent] : value / pas_powers[-exponent];\n"
+    "}\n"
+    "\n"
+    "static unsigned long long pas_round(double value) { // Ties to even\n"
+    "    unsigned long long n = (unsigned long long) value;\n"
+    "    double fraction = value - (double) n;\n"
+    "    return n + (fraction > 0.5 || (fraction == 0.5 && (n & 1)));\n"
+    "}\n"
+    "\n"
+    "static int pas_digits(char *buffer, unsigned long long n) {\n"
+    "    char digits[20];\n"
+    "    int start = sizeof(digits);\n"
+    "    for (; n >= 100; n /= 100) {\n"
+    "        start -= 2;\n"
+    "        memcpy(digits + start, pas_digit_pairs + 2 * (n % 100), 2);\n"
+    "    }\n"
+    "    if (n >= 10) {\n"
+    "        start -= 2;\n"
+    "        memcpy(digits + start, pas_digit_pairs + 2 * n, 2);\n"
+    "    }\n"
+    "    else\n"
+    "        digits[--start] = '0' + n;\n"
+    "    memcpy(buffer, digits + start, sizeof(digits) - start);\n"
+    "    return sizeof(digits) - start;\n"
+    "}\n"
+    "\n"
+    "static int pas_shortest(char *digits, float value, int *exponent) {\n"
+    "    double d = value;\n"
+    "    unsigned bits;\n"
+    "    memcpy(&bits, &value, sizeof(bits));\n"
+    "    int e = ((int) (bits >> 23) - 127) * 1233 / 4096;\n"
+    "    while (e < 38 && pas_scale(1.0, e + 1) <= d)\n"
+    "        e++;\n"
+    "    while (e > -46 && pas_scale(1.0, e) > d)\n"
+    "        e--;\n"
+    "    unsigned long long n = 0, limit = 10;\n"
+    "    for (int count = 1; count <= 9; count++, limit *= 10) {\n"
+    "        n = pas_round(pas_scale(d, count - 1 - e));\n"
+    "        *exponent = e;\n"
+    "        if (n >= limit) {\n"
+    "            n /= 10;\n"
+    "            *exponent = e + 1;\n"
+    "        }\n"
+    "        if ((float) pas_scale(n, *exponent + 1 - count) == value)\n"
+    "            break;\n"
+    "    }\n"
+    "    int count = pas_digits(digits, n);\n"
+    "    while (count > 1 && digits[count - 1] == '0')\n"
+    "        count--;\n"
+    "    return count;\n"
+    "}\n"
+    "\n"
+    "static int pas_fixed(char *buffer, const char *digits, int count, int exponent, int decimals) {\n"
+    "    int length = 0;\n"
+    "    if (exponent < 0)\n"
+    "        buffer[length++] = '0';\n"
+    "    for (int n = 0; n <= exponent; n++)\n"
+    "        buffer[length++] = n < count ? digits[n] : '0';\n"
+    "    if (decimals > 0)\n"
+    "        buffer[length++] = '.';\n"
+    "    for (int n = exponent + 1; n <= exponent + decimals; n++)\n"
+    "        buffer[length++] = n >= 0 && n < count ? digits[n] : '0';\n"
+    "    return length;\n"
+    "}\n"
+    "\n"
+    "static void pas_print_text(const char *text, int length, int width) {\n"
+    "    for (; width > length; width--)\n"
+    "        putchar(' ');\n"
+    "    fwrite(text, 1, length, stdout);\n"
+    "}\n"
+    "\n"
+    "static void pas_print_int(int value, int width) {\n"
+    "    char text[12];\n"
+    "    int sign = value < 0;\n"
+    "    text[0] = '-';\n"
+    "    pas_print_text(text, sign + pas_digits(text + sign, sign ? -(long long) value : value), width);\n"
+    "}\n"
+    "\n"
+    "static void pas_print_real(float value, int width, int precision) {\n"
+    "    char text[96], digits[20], *out = text;\n"
+    "    int count, exponent;\n"
+    "    unsigned bits;\n"
+    "    memcpy(&bits, &value, sizeof(bits));\n"
+    "    if (bits >> 31)\n"
+    "        *out++ = '-';\n"
+    "    bits &= 0x7fffffff;\n"
+    "    memcpy(&value, &bits, sizeof(bits));\n"
+    "    if (bits >> 23 == 0xff) {\n"
+    "        memcpy(out, bits & 0x7fffff ? \"nan\" : \"inf\", 3);\n"
+    "        pas_print_text(text, out + 3 - text, width);\n"
+    "        return;\n"
+    "    }\n"
+    "    if (precision > 32)\n"
+    "        precision = 32;\n"
+    "    if (precision >= 0 && pas_scale(value, precision) < 9223372036854775808.0) {\n"
+    "        count = pas_digits(digits, pas_round(pas_scale(value, precision)));\n"
+    "        out += pas_fixed(out, digits, count, count - 1 - precision, precision);\n"
+    "    }\n"
+    "    else {\n"
+    "        if (value == 0.0f) {\n"
+    "            digits[0] = '0';\n"
+    "            count = 1;\n"
+    "            exponent = 0;\n"
+    "        }\n"
+    "        else\n"
+    "            count = pas_shortest(digits, value, &exponent);\n"
+    "        if (precision >= 0)\n"
+    "            out += pas_fixed(out, digits, count, exponent, precision);\n"
+    "        else if (exponent >= -4 && exponent < 6)\n"
+    "            out += pas_fixed(out, digits, count, exponent, count - exponent - 1 > 0 ? count - exponent - 1 : 0);\n"
+    "        else {\n"
+    "            *out++ = digits[0];\n"
+    "            if (count > 1) {\n"
+    "                *out++ = '.';\n"
+    "                memcpy(out, digits + 1, count - 1);\n"
+    "                out += count - 1;\n"
+    "            }\n"
+    "            *out++ = 'e';\n"
+    "            *out++ = exponent < 0 ? '-' : '+';\n"
+    "            memcpy(out, pas_digit_pairs + 2 * abs(exponent), 2);\n"
+    "            out += 2;\n"
+    "        }\n"
+    "    }\n"
+    "    pas_print_text(text, out - text, width);\n"
+    "}\n"
+    "\n"
+    "static void pas_print_char(int value, int width) {\n"
+    "    char text = (char) value;\n"
+    "    pas_print_text(&text, 1, width);\n"
+    "}\n"
+    "\n"
+    "static void pas_print_string(const char *value, int width) { pas_print_text(value, strlen(value), width); }\n"
+    "static void pas_print_boolean(int value, int width) { pas_print_text(value ? \"TRUE\" : \"FALSE\", value ? 4 : 5, width); }\n"
+    "static void pas_print_line(void) { putchar('\\n'); }\n"
+    "\n"
+    "// Input read in blocks like the other backends, a number reaching the end of the data is parsed again once the next\n"
+    "// block is appended. Integers take 8 digits at a time, reals keep their first 19 significant digits.\n"
+    "static char pas_input[65536 + 16];\n"
+    "static int pas_in_position, pas_in_end, pas_in_eof;\n"
+    "\n"
+    "static int pas_fill_input(int keep) {\n"
+    "    if (pas_in_eof)\n"
+    "        return 0;\n"
+    "    memmove(pas_input, pas_input + keep, pas_in_end - keep);\n"
+    "    pas_in_position -= keep;\n"
+    "    pas_in_end -= keep;\n"
+    "    if (pas_in_end == 65536)\n"
+    "        return 0;\n"
+    "    fflush(stdout);\n"
+    "    long count;\n"
+    "    do\n"
+    "        count = read(0, pas_input + pas_in_end, 65536 - pas_in_end);\n"
+    "    while (count < 0 && errno == EINTR);\n"
+    "    if (count <= 0) {\n"
+    "        pas_in_eof = 1;\n"
+    "        count = 0;\n"
+    "    }\n"
+    "    pas_in_end += count;\n"
+    "    pas_input[pas_in_end] = 0;\n"
+    "    return count;\n"
+    "}\n"
+    "\n"
+    "static void pas_skip_blanks(void) {\n"
+    "    for (;;) {\n"
+    "        while (pas_in_position < pas_in_end && (unsigned char) pas_input[pas_in_position] <= ' ')\n"
+    "            pas_in_position++;\n"
+    "        if (pas_in_position < pas_in_end || !pas_fill_input(pas_in_position))\n"
+    "            return;\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "static int pas_eight_digits(const char *p, unsigned long long *value) {\n"
+    "    unsigned long long word = 0;\n"
+    "    for (int n = 7; n >= 0; n--)\n"
+    "        word = word << 8 | (unsigned char) p[n];\n"
+    "    if (((word + 0x4646464646464646ULL) | (word - 0x3030303030303030ULL)) & 0x8080808080808080ULL)\n"
+    "        return 0;\n"
+    "    word -= 0x3030303030303030ULL;\n"
+    "    word = word * 10 + (word >> 8);\n"
+    "    *value = ((word & 0x000000FF000000FFULL) * 0x000F424000000064ULL + ((word >> 16) & 0x000000FF000000FFULL) * 0x0000271000000001ULL) >> 32;\n"
+    "    return 1;\n"
+    "}\n"
+    "\n"
+    "static int pas_read_int(void) {\n"
+    "    unsigned long long n, word;\n"
+    "    int negative, p, length;\n"
+    "    pas_skip_blanks();\n"
+    "    do {\n"
+    "        p = pas_in_position;\n"
+    "        negative = pas_input[p] == '-';\n"
+    "        p += negative || pas_input[p] == '+';\n"
+    "        for (n = 0; pas_eight_digits(pas_input + p, &word); p += 8)\n"
+    "            n = n * 100000000 + word;\n"
+    "        for (; (unsigned) (pas_input[p] - '0') < 10; p++)\n"
+    "            n = n * 10 + (pas_input[p] - '0');\n"
+    "        length = p - pas_in_position; // The data moves down even when no block follows\n"
+    "    } while (p == pas_in_end && pas_fill_input(pas_in_position));\n"
+    "    pas_in_position += length;\n"
+    "    return (int) (unsigned) (negative ? 0 - n : n);\n"
+    "}\n"
+    "\n"
+    "static float pas_read_real(void) { // Exact when the digits and the power of ten fit in a float, else rounded by strtof\n"
+    "    static const float powers[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };\n"
+    "    unsigned long long w, word;\n"
+    "    int exponent, negative, p, length;\n"
+    "    pas_skip_blanks();\n"
+    "    do {\n"
+    "        int digits = 0;\n"
+    "        p = pas_in_position;\n"
+    "        negative = pas_input[p] == '-';\n"
+    "        p += negative || pas_input[p] == '+';\n"
+    "        w = 0;\n"
+    "        exponent = 0;\n"
+    "        while (pas_input[p] == '0')\n"
+    "            p++;\n"
+    "        for (; digits <= 11 && pas_eight_digits(pas_input + p, &word); digits += 8, p += 8)\n"
+    "            w = w * 100000000 + word;\n"
+    "        for (; (unsigned) (pas_input[p] - '0') < 10; p++) {\n"
+    "            if (digits < 19) {\n"
+    "                w = w * 10 + (pas_input[p] - '0');\n"
+    "                digits++;\n"
+    "            }\n"
+    "            else\n"
+    "                exponent++;\n"
+    "        }\n"
+    "        if (pas_input[p] == '.') {\n"
+    "            p++;\n"
+    "            for (; digits == 0 && pas_input[p] == '0'; p++)\n"
+    "                exponent--;\n"
+    "            for (; digits <= 11 && pas_eight_digits(pas_input + p, &word); digits += 8, exponent -= 8, p += 8)\n"
+    "                w = w * 100000000 + word;\n"
+    "            for (; (unsigned) (pas_input[p] - '0') < 10; p++) {\n"
+    "                if (digits < 19) {\n"
+    "                    w = w * 10 + (pas_input[p] - '0');\n"
+    "                    digits++;\n"
+    "                    exponent--;\n"
+    "                }\n"
+    "            }\n"
+    "        }\n"
+    "        if (pas_input[p] == 'e' || pas_input[p] == 'E') {\n"
+    "            int e = p + 1, power = 0;\n"
+    "            int negative_power = pas_input[e] == '-';\n"
+    "            e += negative_power || pas_input[e] == '+';\n"
+    "            if ((unsigned) (pas_input[e] - '0') < 10 || e == pas_in_end) {\n"
+    "                for (; (unsigned) (pas_input[e] - '0') < 10; e++) {\n"
+    "                    if (power < 100000)\n"
+    "                        power = power * 10 + (pas_input[e] - '0');\n"
+    "                }\n"
+    "                exponent += negative_power ? -power : power;\n"
+    "                p = e;\n"
+    "            }\n"
+    "        }\n"
+    "        length = p - pas_in_position;\n"
+    "    } while (p == pas_in_end && pas_fill_input(pas_in_position));\n"
+    "    pas_in_position += length;\n"
+    "    float value;\n"
+    "    if (w <= 1 << 24 && exponent >= -10 && exponent <= 10)\n"
+    "        value = exponent < 0 ? (float) w / powers[-exponent] : (float) w * powers[exponent];\n"
+    "    else {\n"
+    "        char text[48];\n"
+    "        snprintf(text, sizeof(text), \"%llue%d\", w, exponent);\n"
+    "        value = strtof(text, NULL);\n"
+    "    }\n"
+    "    return negative ? -value : value;\n"
+    "}\n"
+    "\n"
+    "static int pas_read_char(void) {\n"
+    "    if (pas_in_position == pas_in_end && !pas_fill_input(pas_in_position))\n"
+    "        return 0;\n"
+    "    return (unsigned char) pas_input[pas_in_position++];\n"
+    "}\n"
+    "\n"
+    "static const char *pas_read_string(void) { // Rest of the line without its line break\n"
+    "    int length = 0;\n"
+    "    for (;;) {\n"
+    "        const char *line_break = memchr(pas_input + pas_in_position + length, '\\n', pas_in_end - pas_in_position - length);\n"
+    "        if (line_break != NULL) {\n"
+    "            length = line_break - (pas_input + pas_in_position);\n"
+    "            break;\n"
+    "        }\n"
+    "        length = pas_in_end - pas_in_position;\n"
+    "        if (!pas_fill_input(pas_in_position))\n"
+    "            break;\n"
+    "    }\n"
+    "    char *str = malloc(length + 1);\n"
+    "    if (str == NULL) {\n"
+    "        fputs(\"Error: out of memory for the strings\\n\", stderr);\n"
+    "        exit(EXIT_FAILURE);\n"
+    "    }\n"
+    "    memcpy(str, pas_input + pas_in_position, length);\n"
+    "    str[length] = 0;\n"
+    "    pas_in_position += length;\n"
+    "    return str;\n"
+    "}\n"
+    "\n"
+    "static void pas_read_line(void) {\n"
+    "    for (;;) {\n"
+    "        const char *line_break = memchr(pas_input + pas_in_position, '\\n', pas_in_end - pas_in_position);\n"
+    "        if (line_break != NULL) {\n"
+    "            pas_in_position = line_break - pas_input + 1;\n"
+    "            return;\n"
+    "        }\n"
+    "        pas_in_position = pas_in_end;\n"
+    "        if (!pas_fill_input(pas_in_position))\n"
+    "            return;\n"
+    "    }\n"
+    "}\n";
+
+const char* c_type(TokenType type) { // Ready to be followed by a name
+    ValueClass class = value_class(value_type(type));
+    return class == REAL_VALUE ? "float " : class == STRING_VALUE ? "const char *" : "int ";
+}
+
+const char* c_initial_value(TokenType type) {
+    return value_class(value_type(type)) == STRING_VALUE ? "\"\"" : "0";
+}
+
+int is_c_literal(const CGenerator *gen, Operand operand) { // Literals, constants, true and false
+    const Symbol *symb = operand_symbol(gen->code, operand);
+    return symb != NULL && (is_constant_symbol(symb) || symbol_builtin_lookup(symb->name) == symb);
+}
+
+void write_c_string(FILE *fptr, const char *str) { // C string literal with its escapes
+    fputc('"', fptr);
+    for (; *str != '\0'; str++) {
+        unsigned char ch = *str;
+        if (ch == '"' || ch == '\\' || ch == '?') // No trigraphs
+            fprintf(fptr, "\\%c", ch);
+        else if (ch < 32 || ch >= 127)
+            fprintf(fptr, "\\%03o", ch);
+        else
+            fputc(ch, fptr);
+    }
+    fputc('"', fptr);
+}
+
+void write_c_literal(CGenerator *gen, const Symbol *symb) {
+    switch (value_type(symb->token_type)) {
+        case REAL_TOKEN: { // Exact in hexadecimal
+            float value = symb->values->f;
+            if (isnan(value))
+                fprintf(gen->fptr, "(0.0f / 0.0f)");
+            else if (isinf(value))
+                fprintf(gen->fptr, "(%s1.0f / 0.0f)", value < 0 ? "-" : "");
+            else
+                fprintf(gen->fptr, "%s%af%s", value < 0 ? "(" : "", (double) value, value < 0 ? ")" : "");
+            break;
+        }
+        case STRING_TOKEN:
+            write_c_string(gen->fptr, symb->values->str);
+            break;
+        case CHAR_TOKEN:
+            fprintf(gen->fptr, "%d", (unsigned char) symb->values->c);
+            break;
+        default:
+            if (symb->values->i == INT32_MIN)
+                fprintf(gen->fptr, "(-2147483647 - 1)");
+            else
+                fprintf(gen->fptr, symb->values->i < 0 ? "(%d)" : "%d", symb->values->i);
+            break;
+    }
+}
+
+const ParamType* find_param(const CGenerator *gen, const Symbol *symb) {
+    for (const ParamType *param = gen->params; param != NULL; param = param->next) {
+        if (param->param_symbol == symb)
+            return param;
+    }
+    return NULL;
+}
+
+void write_c_operand(CGenerator *gen, Operand operand) { // Value of the operand, an lvalue for the variables
+    const TacArray *code = gen->code;
+    if (operand_kind(operand) == TEMP_OPERAND) {
+        fprintf(gen->fptr, "t%d", operand_index(operand));
+        return;
+    }
+    const Symbol *symb = operand_symbol(code, operand);
+    if (symb == NULL) {
+        fprintf(gen->ctx->log_fptr, "Error: an instruction operand has no value\n");
+        fprintf(gen->fptr, "0");
+        return;
+    }
+    if (is_c_literal(gen, operand)) {
+        if (symbol_builtin_lookup(symb->name) == symb)
+            fprintf(gen->fptr, "%d", symb->values->i);
+        else
+            write_c_literal(gen, symb);
+        return;
+    }
+    const ParamType *param = find_param(gen, symb);
+    if (param != NULL)
+        fprintf(gen->fptr, param->ref_pass ? "(*p_%s)" : "p_%s", symb->name);
+    else
+        fprintf(gen->fptr, "%c_%s", gen->locals[operand_index(operand)] ? 'l' : 'g', symb->name);
+}
+
+void write_c_value(CGenerator *gen, Operand operand, ValueClass class, int owned) {
+    // Operand converted to the class, a character made a string only lives in the statement unless it is owned
+    ValueClass operand_class = value_class(operand_type(gen->code, operand));
+    if (class == STRING_VALUE && operand_type(gen->code, operand) == CHAR_TOKEN) {
+        fprintf(gen->fptr, owned ? "pas_char_string(" : "((const char[]) { (char) ");
+        write_c_operand(gen, operand);
+        fprintf(gen->fptr, owned ? ")" : ", 0 })");
+    }
+    else if (class != operand_class && class != STRING_VALUE) {
+        fprintf(gen->fptr, class == REAL_VALUE ? "(float) " : "(int) ");
+        write_c_operand(gen, operand);
+    }
+    else
+        write_c_operand(gen, operand);
+}
+
+void write_c_assignment(CGenerator *gen, Operand a) {
+    fprintf(gen->fptr, "    ");
+    write_c_operand(gen, a);
+    fprintf(gen->fptr, " = ");
+}
+
+void generate_c_arithmetic(CGenerator *gen, int index) {
+    const TacArray *code = gen->code;
+    TacOp op = code->ops[index];
+    Operand a = code->a[index], b = code->b[index], c = code->c[index];
+    ValueClass class = value_class(operand_type(code, a));
+    write_c_assignment(gen, a);
+    if (class == STRING_VALUE || (class == INT_VALUE && op != TAC_DIV && op != TAC_MOD)) {
+        const char *functions[] = { [TAC_ADD] = "PAS_ADD", [TAC_SUB] = "PAS_SUB", [TAC_MULT] = "PAS_MUL" };
+        fprintf(gen->fptr, "%s(", class == STRING_VALUE ? "pas_concat" : functions[op]);
+        write_c_value(gen, b, class, 0);
+        fprintf(gen->fptr, ", ");
+        write_c_value(gen, c, class, 0);
+        fprintf(gen->fptr, ");\n");
+        return;
+    }
+    const char *operators[] = { [TAC_ADD] = "+", [TAC_SUB] = "-", [TAC_MULT] = "*", [TAC_DIV] = "/", [TAC_MOD] = "%" };
+    write_c_value(gen, b, class, 0);
+    fprintf(gen->fptr, " %s ", class == REAL_VALUE && op == TAC_MOD ? "/" : operators[op]);
+    write_c_value(gen, c, class, 0);
+    fprintf(gen->fptr, ";\n");
+}
+
+void generate_c_comparison(CGenerator *gen, int index) { // Compared as strings, reals or integers like the native code
+    const TacArray *code = gen->code;
+    const char *operators[] = { [TAC_LT] = "<", [TAC_GT] = ">", [TAC_NEQ] = "!=", [TAC_LTE] = "<=", [TAC_GTE] = ">=", [TAC_EQ] = "==" };
+    Operand b = code->b[index], c = code->c[index];
+    ValueClass class_b = value_class(operand_type(code, b)), class_c = value_class(operand_type(code, c));
+    write_c_assignment(gen, code->a[index]);
+    if (class_b == STRING_VALUE || class_c == STRING_VALUE) {
+        fprintf(gen->fptr, "strcmp(");
+        write_c_value(gen, b, STRING_VALUE, 0);
+        fprintf(gen->fptr, ", ");
+        write_c_value(gen, c, STRING_VALUE, 0);
+        fprintf(gen->fptr, ") %s 0;\n", operators[code->ops[index]]);
+        return;
+    }
+    ValueClass class = class_b == REAL_VALUE || class_c == REAL_VALUE ? REAL_VALUE : INT_VALUE;
+    write_c_value(gen, b, class, 0);
+    fprintf(gen->fptr, " %s ", operators[code->ops[index]]);
+    write_c_value(gen, c, class, 0);
+    fprintf(gen->fptr, ";\n");
+}
+
+void generate_c_unary(CGenerator *gen, int index) { // Logic, negation and copies
+    const TacArray *code = gen->code;
+    TacOp op = code->ops[index];
+    Operand a = code->a[index], b = code->b[index];
+    ValueClass class = value_class(operand_type(code, a));
+    write_c_assignment(gen, a);
+    switch (op) {
+        case TAC_AND: case TAC_OR:
+            write_c_value(gen, b, INT_VALUE, 0);
+            fprintf(gen->fptr, " != 0 %s ", op == TAC_AND ? "&&" : "||");
+            write_c_value(gen, code->c[index], INT_VALUE, 0);
+            fprintf(gen->fptr, " != 0;\n");
+            return;
+        case TAC_NOT:
+            write_c_value(gen, b, INT_VALUE, 0);
+            fprintf(gen->fptr, " == 0;\n");
+            return;
+        case TAC_NEG:
+            fprintf(gen->fptr, class == REAL_VALUE ? "-" : "PAS_NEG(");
+            write_c_value(gen, b, class, 0);
+            fprintf(gen->fptr, class == REAL_VALUE ? ";\n" : ");\n");
+            return;
+        default: // Copies keep strings made from characters
+            write_c_value(gen, b, class, 1);
+            fprintf(gen->fptr, ";\n");
+            return;
+    }
+}
+
+void generate_c_print(CGenerator *gen, int index) { // The value, its width then the decimals of a real
+    const TacArray *code = gen->code;
+    TokenType type = operand_type(code, code->a[index]);
+    const char *function = type == REAL_TOKEN ? "real" : type == STRING_TOKEN ? "string" : type == BOOL_TOKEN ? "boolean"
+                         : type == CHAR_TOKEN ? "char" : "int";
+    fprintf(gen->fptr, "    pas_print_%s(", function);
+    write_c_operand(gen, code->a[index]);
+    fprintf(gen->fptr, ", ");
+    if (code->b[index] != NO_OPERAND)
+        write_c_operand(gen, code->b[index]);
+    else
+        fprintf(gen->fptr, "0");
+    if (type == REAL_TOKEN) {
+        fprintf(gen->fptr, ", ");
+        if (code->c[index] != NO_OPERAND)
+            write_c_operand(gen, code->c[index]);
+        else
+            fprintf(gen->fptr, "%d", NO_WRITE_PRECISION);
+    }
+    fprintf(gen->fptr, ");\n");
+}
+
+void generate_c_call(CGenerator *gen, int index) { // The arguments are the instructions right before the call
+    const TacArray *code = gen->code;
+    const Symbol *routine = operand_symbol(code, code->b[index]);
+    int arg_count = 0;
+    while (index - arg_count - 1 >= 0 && code->ops[index - arg_count - 1] == TAC_ARG)
+        arg_count++;
+    if (code->a[index] != NO_OPERAND)
+        write_c_assignment(gen, code->a[index]);
+    else
+        fprintf(gen->fptr, "    ");
+    fprintf(gen->fptr, "pas_%s(", routine->name);
+    const ParamType *param = routine->param_list;
+    for (int arg = index - arg_count; arg < index; arg++, param = param != NULL ? param->next : NULL) {
+        Operand operand = code->a[arg];
+        if (arg > index - arg_count)
+            fprintf(gen->fptr, ", ");
+        if (param != NULL && param->ref_pass) {
+            const ParamType *own_param = find_param(gen, operand_symbol(code, operand));
+            if (own_param != NULL && own_param->ref_pass) // Passes on the address it was given
+                fprintf(gen->fptr, "p_%s", own_param->param_symbol->name);
+            else if (operand_kind(operand) == TEMP_OPERAND || is_c_literal(gen, operand)) {
+                fprintf(gen->ctx->log_fptr, "Error: an argument passed by reference has no address\n");
+                fprintf(gen->fptr, "NULL");
+            }
+            else {
+                fprintf(gen->fptr, "&");
+                write_c_operand(gen, operand);
+            }
+        }
+        else if (param != NULL)
+            write_c_value(gen, operand, value_class(value_type(param->param_symbol->token_type)), 1);
+        else
+            write_c_operand(gen, operand);
+    }
+    fprintf(gen->fptr, ");\n");
+}
+
+void generate_c_instruction(CGenerator *gen, int index) {
+    const TacArray *code = gen->code;
+    switch (code->ops[index]) {
+        case TAC_ADD: case TAC_SUB: case TAC_MULT: case TAC_DIV: case TAC_MOD:
+            generate_c_arithmetic(gen, index);
+            break;
+        case TAC_LT: case TAC_GT: case TAC_NEQ: case TAC_LTE: case TAC_GTE: case TAC_EQ:
+            generate_c_comparison(gen, index);
+            break;
+        case TAC_AND: case TAC_OR: case TAC_NOT: case TAC_NEG: case TAC_POS: case TAC_CPY:
+            generate_c_unary(gen, index);
+            break;
+        case TAC_GOTO:
+            fprintf(gen->fptr, "    goto L%d;\n", operand_index(code->a[index]));
+            break;
+        case TAC_IFZ: case TAC_IFNZ:
+            fprintf(gen->fptr, "    if (");
+            write_c_value(gen, code->b[index], INT_VALUE, 0);
+            fprintf(gen->fptr, " %s 0)\n        goto L%d;\n", code->ops[index] == TAC_IFZ ? "==" : "!=", operand_index(code->a[index]));
+            break;
+        case TAC_LABEL:
+            fprintf(gen->fptr, "L%d: ;\n", operand_index(code->a[index]));
+            break;
+        case TAC_PRINT:
+            generate_c_print(gen, index);
+            break;
+        case TAC_PRINTLN:
+            fprintf(gen->fptr, "    pas_print_line();\n");
+            break;
+        case TAC_READ: {
+            TokenType type = operand_type(code, code->a[index]);
+            write_c_assignment(gen, code->a[index]);
+            fprintf(gen->fptr, "pas_read_%s();\n", type == REAL_TOKEN ? "real" : type == STRING_TOKEN ? "string" : type == CHAR_TOKEN ? "char" : "int");
+            break;
+        }
+        case TAC_READLN:
+            fprintf(gen->fptr, "    pas_read_line();\n");
+            break;
+        case TAC_CALL:
+            generate_c_call(gen, index);
+            break;
+        case TAC_ENDFUNC:
+            fprintf(gen->fptr, "    return ");
+            write_c_operand(gen, code->a[index]);
+            fprintf(gen->fptr, ";\n");
+            break;
+        case TAC_ENDPROG:
+            fprintf(gen->fptr, "    return 0;\n");
+            break;
+        default: // Arguments are written by their call, declarations come first
+            break;
+    }
+}
+
+void generate_c_signature(CGenerator *gen, int start, int end) {
+    const TacArray *code = gen->code;
+    const Symbol *routine = operand_symbol(code, code->a[start]);
+    if (code->ops[start] == TAC_BEGINPROG) {
+        fprintf(gen->fptr, "int main(void)");
+        return;
+    }
+    fprintf(gen->fptr, "static %spas_%s(", code->ops[start] == TAC_BEGINFUNC ? c_type(operand_type(code, code->a[end])) : "void ",
+            routine->name);
+    if (routine->param_list == NULL)
+        fprintf(gen->fptr, "void");
+    for (const ParamType *param = routine->param_list; param != NULL; param = param->next)
+        fprintf(gen->fptr, "%s%sp_%s%s", c_type(param->param_symbol->token_type), param->ref_pass ? "*" : "",
+                param->param_symbol->name, param->next != NULL ? ", " : "");
+    fprintf(gen->fptr, ")");
+}
+
+void declare_c_temp(CGenerator *gen, Operand operand, int routine) {
+    if (operand_kind(operand) != TEMP_OPERAND || gen->declared_temps[operand_index(operand)] == routine)
+        return;
+    TokenType type = gen->code->temp_types[operand_index(operand)];
+    gen->declared_temps[operand_index(operand)] = routine;
+    fprintf(gen->fptr, "    %st%d = %s;\n", c_type(type), operand_index(operand), c_initial_value(type));
+}
+
+void generate_c_routine(CGenerator *gen, int start, int end, int routine) {
+    // Local variables and temporaries are declared first and start zeroed, the labels may jump over any statement
+    const TacArray *code = gen->code;
+    const Symbol *symb = operand_symbol(code, code->a[start]);
+    gen->params = symb != NULL ? symb->param_list : NULL;
+    fprintf(gen->fptr, "\n");
+    generate_c_signature(gen, start, end);
+    fprintf(gen->fptr, " {\n");
+    for (int i = start + 1; i < end; i++) {
+        if (code->ops[i] == TAC_VAR) {
+            const Symbol *var = operand_symbol(code, code->a[i]);
+            gen->locals[operand_index(code->a[i])] = 1;
+            fprintf(gen->fptr, "    %sl_%s = %s;\n", c_type(var->token_type), var->name, c_initial_value(var->token_type));
+        }
+        else {
+            declare_c_temp(gen, code->a[i], routine);
+            declare_c_temp(gen, code->b[i], routine);
+            declare_c_temp(gen, code->c[i], routine);
+        }
+    }
+    for (int i = start + 1; i <= end; i++)
+        generate_c_instruction(gen, i);
+    fprintf(gen->fptr, "}\n");
+    for (int i = start + 1; i < end; i++) {
+        if (code->ops[i] == TAC_VAR)
+            gen->locals[operand_index(code->a[i])] = 0;
+    }
+}
+
+int generate_c_code(CompilerContext *ctx, const TacArray *code, FILE *fptr) {
+    CGenerator gen;
+    gen.ctx = ctx;
+    gen.fptr = fptr;
+    gen.code = code;
+    gen.params = NULL;
+    gen.locals = calloc(code->symbol_count + 1, sizeof(uint8_t));
+    gen.declared_temps = malloc((code->temp_count + 1) * sizeof(int));
+    if (gen.locals == NULL || gen.declared_temps == NULL) {
+        fprintf(ctx->log_fptr, "Error: failed to allocate memory for the C generator\n");
+        free(gen.locals);
+        free(gen.declared_temps);
+        return 0;
+    }
+    for (int t = 0; t < code->temp_count; t++)
+        gen.declared_temps[t] = -1;
+    fprintf(fptr, "%s\n", c_prelude);
+
+    // Global variables, strings start empty, then the prototypes so the routines can call each other in any order
+    int start, end;
+    for (int i = 0; i < code->tac_count && code->ops[i] != TAC_BEGINFUNC && code->ops[i] != TAC_BEGINPROC && code->ops[i] != TAC_BEGINPROG; i++) {
+        if (code->ops[i] == TAC_VAR) {
+            const Symbol *var = operand_symbol(code, code->a[i]);
+            fprintf(fptr, "static %sg_%s = %s;\n", c_type(var->token_type), var->name, c_initial_value(var->token_type));
+        }
+    }
+    fprintf(fptr, "\n");
+    for (int from = 0; next_routine(code, from, &start, &end); from = end + 1) {
+        if (code->ops[start] != TAC_BEGINPROG) {
+            generate_c_signature(&gen, start, end);
+            fprintf(fptr, ";\n");
+        }
+    }
+    int routine = 0;
+    for (int from = 0; next_routine(code, from, &start, &end); from = end + 1, routine++)
+        generate_c_routine(&gen, start, end, routine);
+    free(gen.locals);
+    free(gen.declared_temps);
+    return 1;
+}
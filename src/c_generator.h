@@ -0,0 +1,11 @@
+#ifndef C_GENERATOR_H
+#define C_GENERATOR_H
+
+#include <stdio.h>
+
+#include "tac_array.h"
+#include "compiler_context.h"
+
+int generate_c_code(CompilerContext *, const TacArray *, FILE *);
+
+#endif
@@ -1,46 +1,790 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include "scanner.h"
+#include "symbol_table.h"
 #include "tac.h"
+#include "tac_array.h"
+#include "control_flow.h"
+#include "liveness.h"
+#include "register_allocator.h"
+#include "write_format.h"
+#include "write_runtime.h"
+#include "read_runtime.h"
+#include "compiler_context.h"
 #include "code_generator.h"
 
-void process_instruction(Tac *tac) {
-    switch (tac->op) {
-        case TAC_UNDEF: {
+// x86-64 assembly for the System V ABI in the GNU as syntax. Integers, characters and booleans are 32 bit values, reals
+// are single precision floats and strings are pointers to null terminated characters. Instructions work on rax, rcx, rdx,
+// xmm14 and xmm15, r10 and r11 hold the addresses of the parameters passed by reference, the variables stay in the
+// registers or the stack slots the allocator gave them. Routines are named pas_<mangled name>, global variables var.<name>.
+
+#define INT_ARG_REGISTERS 6
+#define FLOAT_ARG_REGISTERS 8
+#define CHAR_BUFFER_COUNT 2 // Stack buffers turning a character into a string for the runtime
+
+struct _CodeGenerator {
+    CompilerContext *ctx;
+    FILE *fptr;
+    TacArray *code;
+    const RegisterAllocation *alloc;
+    const ParamType *params; // Parameters of the routine being translated
+    int *param_offsets; // Frame offset of each parameter, it holds the address of the ones passed by reference
+    int param_count;
+    int saved_size; // Bytes of callee saved registers pushed under the frame pointer
+    int pushed_count; // Arguments pushed for the next call
+    uint8_t *used_constants; // Real and string literals referenced by the code by pool index, emitted with the read only data
+    int constant_count;
+    int label_base; // Labels used by the code generated before, a streamed program is generated in several parts
+    char *location; // Text of the last operand location
+    size_t location_size;
+    int uses_concat;
+    int uses_write; // The runtime of write and writeln comes after the program
+    int uses_read; // So does the one of read and readln, with the one of write
+};
+
+const char *int_register_names[] = { "ebx", "r12d", "r13d", "r14d", "r15d", "esi", "edi", "r8d", "r9d" };
+const char *int_arg_registers[INT_ARG_REGISTERS] = { "rdi", "rsi", "rdx", "rcx", "r8", "r9" };
+
+ValueClass value_class(TokenType type) {
+    return type == REAL_TOKEN ? REAL_VALUE : type == STRING_TOKEN ? STRING_VALUE : INT_VALUE;
+}
+
+ValueClass operand_class(const CodeGenerator *gen, Operand operand) {
+    return value_class(operand_type(gen->code, operand));
+}
+
+int is_literal_operand(const CodeGenerator *gen, Operand operand) { // Literals, constants, true and false
+    const Symbol *symb = operand_symbol(gen->code, operand);
+    return symb != NULL && (is_constant_symbol(symb) || symbol_builtin_lookup(symb->name) == symb);
+}
+
+int param_location(const ParamType *param, int *int_count, int *float_count, int *stack_count) {
+    // Argument register of a parameter (0 to 5 for rdi to r9, 6 to 13 for xmm0 to xmm7), -1 - its position on the stack
+    if (!param->ref_pass && value_type(param->param_symbol->token_type) == REAL_TOKEN)
+        return *float_count < FLOAT_ARG_REGISTERS ? INT_ARG_REGISTERS + (*float_count)++ : -1 - (*stack_count)++;
+    return *int_count < INT_ARG_REGISTERS ? (*int_count)++ : -1 - (*stack_count)++;
+}
+
+int param_index(const CodeGenerator *gen, const Symbol *symb) {
+    int index = 0;
+    for (const ParamType *param = gen->params; param != NULL; param = param->next, index++) {
+        if (param->param_symbol == symb)
+            return index;
+    }
+    return -1;
+}
+
+int slot_offset(const CodeGenerator *gen, int slot) { // Stack slots come right under the saved registers
+    return -(gen->saved_size + 8 * (slot + 1));
+}
+
+int char_buffer_offset(const CodeGenerator *gen, int buffer) {
+    return slot_offset(gen, gen->alloc->slot_count + buffer);
+}
+
+const char* var_register(const CodeGenerator *gen, Operand operand) { // Register holding the variable, NULL if it has none
+    int var = liveness_var(gen->alloc->live, operand);
+    if (var < 0 || gen->alloc->registers[var] == NO_REGISTER)
+        return NULL;
+    int reg = gen->alloc->registers[var];
+    if (is_float_register(reg) || operand_class(gen, operand) == STRING_VALUE)
+        return register_name(reg);
+    return int_register_names[reg];
+}
+
+const char* operand_location(CodeGenerator *gen, Operand operand, const char *pointer) {
+    // Assembly operand of the value (valid until the next call), the address of a parameter passed by reference is first
+    // loaded in the pointer register
+    char *text = gen->location;
+    const Symbol *symb = operand_symbol(gen->code, operand);
+    if (is_literal_operand(gen, operand)) {
+        TokenType type = operand_type(gen->code, operand);
+        if (type == REAL_TOKEN || type == STRING_TOKEN) {
+            int index = constant_index(&gen->ctx->constants, symb);
+            gen->used_constants[index] = 1;
+            sprintf(text, ".L%c%d(%%rip)", type == REAL_TOKEN ? 'C' : 'S', index);
+        }
+        else
+            sprintf(text, "$%d", type == CHAR_TOKEN ? (unsigned char) symb->values->c : symb->values->i);
+        return text;
+    }
+    int var = liveness_var(gen->alloc->live, operand);
+    if (var >= 0) {
+        if (gen->alloc->registers[var] != NO_REGISTER)
+            sprintf(text, "%%%s", var_register(gen, operand));
+        else
+            sprintf(text, "%d(%%rbp)", slot_offset(gen, gen->alloc->slots[var]));
+        return text;
+    }
+    int index = param_index(gen, symb);
+    if (index >= 0) { // Passed by reference
+        fprintf(gen->fptr, "    movq %d(%%rbp), %%%s\n", gen->param_offsets[index], pointer);
+        sprintf(text, "(%%%s)", pointer);
+        return text;
+    }
+    const char *name = symb != NULL ? symb->name : "undefined";
+    if (strlen(name) + 16 > gen->location_size) { // Global variable names have no length limit
+        char *location = realloc(gen->location, strlen(name) + 16);
+        if (location == NULL) {
+            fprintf(gen->ctx->log_fptr, "Error: failed to reallocate more memory to an assembly operand\n");
+            return "0";
+        }
+        gen->location = location;
+        gen->location_size = strlen(name) + 16;
+    }
+    sprintf(gen->location, "var.%s(%%rip)", name);
+    return gen->location;
+}
+
+void load_int(CodeGenerator *gen, Operand operand, const char *reg) { // reg is a 32 bit register
+    if (operand_class(gen, operand) == REAL_VALUE) {
+        fprintf(gen->fptr, "    cvttss2si %s, %%%s\n", operand_location(gen, operand, "r11"), reg);
+        return;
+    }
+    const char *location = operand_location(gen, operand, "r11");
+    if (location[0] != '%' || strcmp(location + 1, reg))
+        fprintf(gen->fptr, "    movl %s, %%%s\n", location, reg);
+}
+
+void load_real(CodeGenerator *gen, Operand operand, const char *reg) {
+    if (operand_class(gen, operand) != REAL_VALUE) {
+        if (is_literal_operand(gen, operand)) { // No conversion from an immediate
+            fprintf(gen->fptr, "    movl %s, %%r10d\n", operand_location(gen, operand, "r11"));
+            fprintf(gen->fptr, "    cvtsi2ssl %%r10d, %%%s\n", reg);
+        }
+        else
+            fprintf(gen->fptr, "    cvtsi2ssl %s, %%%s\n", operand_location(gen, operand, "r11"), reg);
+        return;
+    }
+    const char *location = operand_location(gen, operand, "r11");
+    if (location[0] != '%' || strcmp(location + 1, reg))
+        fprintf(gen->fptr, "    movss %s, %%%s\n", location, reg);
+}
+
+void load_string(CodeGenerator *gen, Operand operand, const char *reg, int buffer) { // reg is a 64 bit register
+    const char *location = operand_location(gen, operand, "r11");
+    if (operand_type(gen->code, operand) == CHAR_TOKEN) { // Written with its null terminator in a stack buffer
+        int offset = char_buffer_offset(gen, buffer);
+        fprintf(gen->fptr, "    movl %s, %%r10d\n", location);
+        fprintf(gen->fptr, "    movw %%r10w, %d(%%rbp)\n", offset);
+        fprintf(gen->fptr, "    leaq %d(%%rbp), %%%s\n", offset, reg);
+    }
+    else if (is_literal_operand(gen, operand))
+        fprintf(gen->fptr, "    leaq %s, %%%s\n", location, reg);
+    else if (location[0] != '%' || strcmp(location + 1, reg))
+        fprintf(gen->fptr, "    movq %s, %%%s\n", location, reg);
+}
+
+void load_address(CodeGenerator *gen, Operand operand, const char *reg) { // Variable passed by reference
+    const Symbol *symb = operand_symbol(gen->code, operand);
+    int var = liveness_var(gen->alloc->live, operand);
+    int index = param_index(gen, symb);
+    if (var >= 0 && gen->alloc->slots[var] >= 0)
+        fprintf(gen->fptr, "    leaq %d(%%rbp), %%%s\n", slot_offset(gen, gen->alloc->slots[var]), reg);
+    else if (var < 0 && index >= 0)
+        fprintf(gen->fptr, "    movq %d(%%rbp), %%%s\n", gen->param_offsets[index], reg);
+    else if (var < 0 && symb != NULL && !is_literal_operand(gen, operand))
+        fprintf(gen->fptr, "    leaq var.%s(%%rip), %%%s\n", symb->name, reg);
+    else
+        fprintf(gen->ctx->log_fptr, "Error: an argument passed by reference has no address\n");
+}
+
+void store_value(CodeGenerator *gen, Operand operand, const char *reg) { // reg holds a value of the operand's class
+    const char *location = operand_location(gen, operand, "r11");
+    if (location[0] == '%' && !strcmp(location + 1, reg))
+        return;
+    ValueClass class = operand_class(gen, operand);
+    fprintf(gen->fptr, "    %s %%%s, %s\n", class == REAL_VALUE ? "movss" : class == STRING_VALUE ? "movq" : "movl", reg, location);
+}
+
+const char* result_register(const CodeGenerator *gen, Operand operand, const char *scratch) {
+    // Register the variable is computed in, its own one when it has one so that no store is needed
+    const char *reg = var_register(gen, operand);
+    return reg != NULL ? reg : scratch;
+}
+
+void call_runtime(CodeGenerator *gen, const char *name) { // Keeps the stack aligned on 16 bytes around the call
+    if (gen->pushed_count % 2)
+        fprintf(gen->fptr, "    subq $8, %%rsp\n");
+    fprintf(gen->fptr, "    call %s\n", name);
+    if (gen->pushed_count % 2)
+        fprintf(gen->fptr, "    addq $8, %%rsp\n");
+}
+
+void concat_strings(CodeGenerator *gen, Operand b, Operand c) { // The joined string is left in rax
+    load_string(gen, b, "rax", 0);
+    if (c != NO_OPERAND)
+        load_string(gen, c, "rsi", 1);
+    else
+        fprintf(gen->fptr, "    leaq .Lempty(%%rip), %%rsi\n");
+    fprintf(gen->fptr, "    movq %%rax, %%rdi\n");
+    call_runtime(gen, "pas_concat");
+    gen->uses_concat = 1;
+}
+
+void generate_copy(CodeGenerator *gen, Operand a, Operand b) {
+    switch (operand_class(gen, a)) {
+        case REAL_VALUE: {
+            const char *reg = result_register(gen, a, "xmm14");
+            load_real(gen, b, reg);
+            store_value(gen, a, reg);
             break;
         }
-        case TAC_ADD: {
+        case STRING_VALUE: {
+            if (operand_type(gen->code, b) == CHAR_TOKEN) { // A new string, the character buffer is reused
+                concat_strings(gen, b, NO_OPERAND);
+                store_value(gen, a, "rax");
+                break;
+            }
+            const char *reg = result_register(gen, a, "rax");
+            load_string(gen, b, reg, 0);
+            store_value(gen, a, reg);
             break;
         }
-        case TAC_SUB: {
+        default: {
+            const char *reg = result_register(gen, a, "eax");
+            load_int(gen, b, reg);
+            store_value(gen, a, reg);
             break;
         }
-        case TAC_MULT: {
+    }
+}
+
+void generate_arithmetic(CodeGenerator *gen, int index) {
+    TacArray *code = gen->code;
+    TacOp op = code->ops[index];
+    Operand a = code->a[index], b = code->b[index], c = code->c[index];
+    switch (operand_class(gen, a)) {
+        case STRING_VALUE: {
+            concat_strings(gen, b, c);
+            store_value(gen, a, "rax");
             break;
         }
-        case TAC_DIV: {
+        case REAL_VALUE: {
+            const char *names[] = { [TAC_ADD] = "addss", [TAC_SUB] = "subss", [TAC_MULT] = "mulss", [TAC_DIV] = "divss" };
+            load_real(gen, b, "xmm14");
+            load_real(gen, c, "xmm15");
+            fprintf(gen->fptr, "    %s %%xmm15, %%xmm14\n", op <= TAC_DIV ? names[op] : "divss");
+            store_value(gen, a, "xmm14");
             break;
         }
         default: {
+            load_int(gen, b, "eax");
+            if (op == TAC_DIV || op == TAC_MOD) {
+                load_int(gen, c, "ecx");
+                fprintf(gen->fptr, "    cltd\n    idivl %%ecx\n");
+                store_value(gen, a, op == TAC_DIV ? "eax" : "edx");
+                break;
+            }
+            const char *location = operand_location(gen, c, "r11");
+            fprintf(gen->fptr, "    %s %s, %%eax\n", op == TAC_ADD ? "addl" : op == TAC_SUB ? "subl" : "imull", location);
+            store_value(gen, a, "eax");
             break;
         }
     }
 }
 
-void generate_code(Tac *head_tac) {
-    if (head_tac != NULL) {
-        Tac *next = NULL;
-        Tac *prev = head_tac;
+void generate_comparison(CodeGenerator *gen, int index) {
+    TacArray *code = gen->code;
+    TacOp op = code->ops[index];
+    Operand a = code->a[index], b = code->b[index], c = code->c[index];
+    const char *conditions[] = { [TAC_LT] = "l", [TAC_GT] = "g", [TAC_NEQ] = "ne", [TAC_LTE] = "le", [TAC_GTE] = "ge", [TAC_EQ] = "e" };
+    ValueClass class_b = operand_class(gen, b), class_c = operand_class(gen, c);
+    if (class_b == STRING_VALUE || class_c == STRING_VALUE) {
+        load_string(gen, b, "rax", 0);
+        load_string(gen, c, "rsi", 1);
+        fprintf(gen->fptr, "    movq %%rax, %%rdi\n");
+        call_runtime(gen, "strcmp@PLT");
+        fprintf(gen->fptr, "    cmpl $0, %%eax\n    set%s %%al\n", conditions[op]);
+    }
+    else if (class_b == REAL_VALUE || class_c == REAL_VALUE) { // Unordered operands (NaN) compare false but for <>
+        load_real(gen, b, "xmm14");
+        load_real(gen, c, "xmm15");
+        if (op == TAC_LT || op == TAC_LTE)
+            fprintf(gen->fptr, "    ucomiss %%xmm14, %%xmm15\n    set%s %%al\n", op == TAC_LT ? "a" : "ae");
+        else if (op == TAC_GT || op == TAC_GTE)
+            fprintf(gen->fptr, "    ucomiss %%xmm15, %%xmm14\n    set%s %%al\n", op == TAC_GT ? "a" : "ae");
+        else if (op == TAC_EQ)
+            fprintf(gen->fptr, "    ucomiss %%xmm15, %%xmm14\n    sete %%al\n    setnp %%cl\n    andb %%cl, %%al\n");
+        else
+            fprintf(gen->fptr, "    ucomiss %%xmm15, %%xmm14\n    setne %%al\n    setp %%cl\n    orb %%cl, %%al\n");
+    }
+    else {
+        load_int(gen, b, "eax");
+        fprintf(gen->fptr, "    cmpl %s, %%eax\n    set%s %%al\n", operand_location(gen, c, "r11"), conditions[op]);
+    }
+    fprintf(gen->fptr, "    movzbl %%al, %%eax\n");
+    store_value(gen, a, "eax");
+}
+
+void generate_logic(CodeGenerator *gen, int index) { // Both operands are tested, the result is 0 or 1
+    TacArray *code = gen->code;
+    TacOp op = code->ops[index];
+    load_int(gen, code->b[index], "eax");
+    fprintf(gen->fptr, "    testl %%eax, %%eax\n    set%s %%al\n", op == TAC_NOT ? "e" : "ne");
+    if (op != TAC_NOT) {
+        load_int(gen, code->c[index], "ecx");
+        fprintf(gen->fptr, "    testl %%ecx, %%ecx\n    setne %%cl\n    %s %%cl, %%al\n", op == TAC_AND ? "andb" : "orb");
+    }
+    fprintf(gen->fptr, "    movzbl %%al, %%eax\n");
+    store_value(gen, code->a[index], "eax");
+}
+
+void generate_negation(CodeGenerator *gen, int index) {
+    Operand a = gen->code->a[index], b = gen->code->b[index];
+    if (operand_class(gen, a) == REAL_VALUE) { // Flips the sign bit
+        load_real(gen, b, "xmm14");
+        fprintf(gen->fptr, "    movl $0x80000000, %%r10d\n    movd %%r10d, %%xmm15\n    xorps %%xmm15, %%xmm14\n");
+        store_value(gen, a, "xmm14");
+    }
+    else {
+        load_int(gen, b, "eax");
+        fprintf(gen->fptr, "    negl %%eax\n");
+        store_value(gen, a, "eax");
+    }
+}
+
+void generate_jump(CodeGenerator *gen, int index) {
+    TacArray *code = gen->code;
+    TacOp op = code->ops[index];
+    if (op != TAC_GOTO) {
+        if (is_literal_operand(gen, code->b[index])) {
+            load_int(gen, code->b[index], "eax");
+            fprintf(gen->fptr, "    testl %%eax, %%eax\n");
+        }
+        else
+            fprintf(gen->fptr, "    cmpl $0, %s\n", operand_location(gen, code->b[index], "r11"));
+    }
+    fprintf(gen->fptr, "    %s .L%d\n", op == TAC_GOTO ? "jmp" : op == TAC_IFZ ? "je" : "jne", gen->label_base + operand_index(code->a[index]));
+}
+
+void load_write_argument(CodeGenerator *gen, Operand operand, const char *reg, int absent) { // Width or precision
+    if (operand == NO_OPERAND)
+        fprintf(gen->fptr, "    movl $%d, %%%s\n", absent, reg);
+    else
+        load_int(gen, operand, reg);
+}
+
+void generate_print(CodeGenerator *gen, int index) {
+    // The width (and precision of a real) are loaded first in eax (and ecx), the value could sit in their argument register
+    TacArray *code = gen->code;
+    Operand operand = code->a[index];
+    TokenType type = operand_type(code, operand);
+    load_write_argument(gen, code->b[index], "eax", 0);
+    switch (type) {
+        case REAL_TOKEN:
+            load_write_argument(gen, code->c[index], "ecx", NO_WRITE_PRECISION);
+            load_real(gen, operand, "xmm0");
+            fprintf(gen->fptr, "    movl %%eax, %%edi\n    movl %%ecx, %%esi\n");
+            call_runtime(gen, "pas.write_real");
+            break;
+        case STRING_TOKEN:
+            load_string(gen, operand, "rdi", 0);
+            fprintf(gen->fptr, "    movl %%eax, %%esi\n");
+            call_runtime(gen, "pas.write_string");
+            break;
+        case BOOL_TOKEN:
+            load_int(gen, operand, "ecx");
+            fprintf(gen->fptr, "    leaq .Ltrue(%%rip), %%rdi\n    leaq .Lfalse(%%rip), %%rdx\n    testl %%ecx, %%ecx\n");
+            fprintf(gen->fptr, "    cmove %%rdx, %%rdi\n    movl %%eax, %%esi\n");
+            call_runtime(gen, "pas.write_string");
+            break;
+        default:
+            load_int(gen, operand, "edi");
+            fprintf(gen->fptr, "    movl %%eax, %%esi\n");
+            call_runtime(gen, type == CHAR_TOKEN ? "pas.write_char" : "pas.write_int");
+            break;
+    }
+    gen->uses_write = 1;
+}
+
+void generate_read(CodeGenerator *gen, int index) { // The runtime returns the value in eax, xmm0 or rax
+    Operand operand = gen->code->a[index];
+    TokenType type = operand_type(gen->code, operand);
+    call_runtime(gen, type == REAL_TOKEN ? "pas.read_real" : type == STRING_TOKEN ? "pas.read_string"
+                      : type == CHAR_TOKEN ? "pas.read_char" : "pas.read_int");
+    store_value(gen, operand, type == REAL_TOKEN ? "xmm0" : type == STRING_TOKEN ? "rax" : "eax");
+    gen->uses_read = 1;
+}
+
+void generate_arg(CodeGenerator *gen, int index) { // Every argument is pushed, the call moves them to their registers
+    Operand operand = gen->code->a[index];
+    const ParamType *param = arg_param(gen->code, index);
+    ValueClass class = param != NULL ? value_class(value_type(param->param_symbol->token_type)) : operand_class(gen, operand);
+    if (param != NULL && param->ref_pass)
+        load_address(gen, operand, "rax");
+    else if (class == REAL_VALUE) {
+        load_real(gen, operand, "xmm14");
+        fprintf(gen->fptr, "    movd %%xmm14, %%eax\n");
+    }
+    else if (class == STRING_VALUE && operand_type(gen->code, operand) == CHAR_TOKEN)
+        concat_strings(gen, operand, NO_OPERAND);
+    else if (class == STRING_VALUE)
+        load_string(gen, operand, "rax", 0);
+    else
+        load_int(gen, operand, "eax");
+    fprintf(gen->fptr, "    pushq %%rax\n");
+    gen->pushed_count++;
+}
+
+void generate_call(CodeGenerator *gen, int index) {
+    TacArray *code = gen->code;
+    const Symbol *routine = operand_symbol(code, code->b[index]);
+    int arg_count = 0;
+    while (index - arg_count - 1 >= 0 && code->ops[index - arg_count - 1] == TAC_ARG)
+        arg_count++;
+    int int_count = 0, float_count = 0, stack_count = 0;
+    int *locations = malloc((arg_count + 1) * sizeof(int));
+    if (locations == NULL) {
+        fprintf(gen->ctx->log_fptr, "Error: failed to allocate memory for the arguments of a call\n");
+        return;
+    }
+    const ParamType *param = routine->param_list;
+    for (int i = 0; i < arg_count && param != NULL; i++, param = param->next) {
+        locations[i] = param_location(param, &int_count, &float_count, &stack_count);
+        int offset = 8 * (arg_count - 1 - i);
+        if (locations[i] >= INT_ARG_REGISTERS)
+            fprintf(gen->fptr, "    movss %d(%%rsp), %%xmm%d\n", offset, locations[i] - INT_ARG_REGISTERS);
+        else if (locations[i] >= 0)
+            fprintf(gen->fptr, "    movq %d(%%rsp), %%%s\n", offset, int_arg_registers[locations[i]]);
+    }
+    // The arguments left on the stack are pushed again in order, the first one ends at the lowest address
+    int padding = (gen->pushed_count + stack_count) % 2, repushed = 0;
+    if (padding)
+        fprintf(gen->fptr, "    subq $8, %%rsp\n");
+    for (int i = arg_count - 1; i >= 0; i--) {
+        if (locations[i] < 0) {
+            fprintf(gen->fptr, "    pushq %d(%%rsp)\n", 8 * (arg_count - 1 - i + padding + repushed));
+            repushed++;
+        }
+    }
+    fprintf(gen->fptr, "    call pas_%s\n", routine->name);
+    if (arg_count + stack_count + padding > 0)
+        fprintf(gen->fptr, "    addq $%d, %%rsp\n", 8 * (arg_count + stack_count + padding));
+    gen->pushed_count -= arg_count;
+    Operand a = code->a[index];
+    if (a != NO_OPERAND) {
+        ValueClass class = operand_class(gen, a);
+        store_value(gen, a, class == REAL_VALUE ? "xmm0" : class == STRING_VALUE ? "rax" : "eax");
+    }
+    free(locations);
+}
+
+int generate_prologue(CodeGenerator *gen, int start) {
+    // Saves the callee saved registers, reserves the stack slots then moves the parameters to their variables
+    TacArray *code = gen->code;
+    const Symbol *routine = operand_symbol(code, code->a[start]);
+    const RegisterAllocation *alloc = gen->alloc;
+    if (code->ops[start] == TAC_BEGINPROG)
+        fprintf(gen->fptr, "\n    .globl main\n    .type main, @function\nmain:\n");
+    else
+        fprintf(gen->fptr, "\n    .type pas_%s, @function\npas_%s:\n", routine->name, routine->name);
+    fprintf(gen->fptr, "    pushq %%rbp\n    movq %%rsp, %%rbp\n");
+    gen->saved_size = 0;
+    for (int reg = 0; reg < REGISTER_COUNT; reg++) {
+        if (is_callee_saved(reg) && (alloc->used_registers & (1u << reg))) {
+            fprintf(gen->fptr, "    pushq %%%s\n", register_name(reg));
+            gen->saved_size += 8;
+        }
+    }
+    gen->params = routine != NULL ? routine->param_list : NULL;
+    gen->param_count = 0;
+    for (const ParamType *param = gen->params; param != NULL; param = param->next)
+        gen->param_count++;
+    gen->param_offsets = malloc((gen->param_count + 1) * sizeof(int));
+    if (gen->param_offsets == NULL) {
+        fprintf(gen->ctx->log_fptr, "Error: failed to allocate memory for the parameters of a routine\n");
+        return 0;
+    }
 
-        while (prev != NULL) {
-            prev->next = next;
-            next = prev;
-            prev = prev->prev;
+    // Parameters passed in registers are stored under the slots and the character buffers
+    int int_count = 0, float_count = 0, stack_count = 0, stored_count = 0, index = 0;
+    int locations[INT_ARG_REGISTERS + FLOAT_ARG_REGISTERS];
+    for (const ParamType *param = gen->params; param != NULL; param = param->next, index++) {
+        int location = param_location(param, &int_count, &float_count, &stack_count);
+        if (location < 0)
+            gen->param_offsets[index] = 16 + 8 * (-1 - location);
+        else {
+            locations[stored_count] = location;
+            gen->param_offsets[index] = slot_offset(gen, alloc->slot_count + CHAR_BUFFER_COUNT + stored_count++);
+        }
+    }
+    int frame_size = 8 * (alloc->slot_count + CHAR_BUFFER_COUNT + stored_count);
+    frame_size += (gen->saved_size + frame_size) % 16;
+    fprintf(gen->fptr, "    subq $%d, %%rsp\n", frame_size);
+    index = stored_count = 0;
+    for (const ParamType *param = gen->params; param != NULL; param = param->next, index++) {
+        if (gen->param_offsets[index] > 0)
+            continue;
+        int location = locations[stored_count++];
+        if (location >= INT_ARG_REGISTERS)
+            fprintf(gen->fptr, "    movss %%xmm%d, %d(%%rbp)\n", location - INT_ARG_REGISTERS, gen->param_offsets[index]);
+        else
+            fprintf(gen->fptr, "    movq %%%s, %d(%%rbp)\n", int_arg_registers[location], gen->param_offsets[index]);
+    }
+    const Liveness *live = alloc->live;
+    for (int var = 0; var < live->var_count; var++) { // Value parameters read by the routine
+        const Symbol *symb = operand_symbol(code, live->vars[var]);
+        int param = symb != NULL && !is_constant_symbol(symb) && symb->declaration_type == CONST_TOKEN ? param_index(gen, symb) : -1;
+        if (param < 0 || live->intervals[var].start < 0)
+            continue;
+        ValueClass class = operand_class(gen, live->vars[var]);
+        const char *reg = result_register(gen, live->vars[var], class == REAL_VALUE ? "xmm14" : class == STRING_VALUE ? "rax" : "eax");
+        fprintf(gen->fptr, "    %s %d(%%rbp), %%%s\n", class == REAL_VALUE ? "movss" : class == STRING_VALUE ? "movq" : "movl",
+                gen->param_offsets[param], reg);
+        store_value(gen, live->vars[var], reg);
+    }
+    gen->pushed_count = 0;
+    return 1;
+}
+
+void generate_epilogue(CodeGenerator *gen, int end) {
+    TacArray *code = gen->code;
+    if (code->ops[end] == TAC_ENDFUNC) {
+        ValueClass class = operand_class(gen, code->a[end]);
+        if (class == REAL_VALUE)
+            load_real(gen, code->a[end], "xmm0");
+        else if (class == STRING_VALUE)
+            load_string(gen, code->a[end], "rax", 0);
+        else
+            load_int(gen, code->a[end], "eax");
+    }
+    else if (code->ops[end] == TAC_ENDPROG) { // The main block comes last, once every write has been generated
+        if (gen->uses_write)
+            call_runtime(gen, "pas.flush");
+        fprintf(gen->fptr, "    xorl %%eax, %%eax\n");
+    }
+    if (gen->saved_size > 0)
+        fprintf(gen->fptr, "    leaq %d(%%rbp), %%rsp\n", -gen->saved_size);
+    for (int reg = REGISTER_COUNT - 1; reg >= 0; reg--) {
+        if (is_callee_saved(reg) && (gen->alloc->used_registers & (1u << reg)))
+            fprintf(gen->fptr, "    popq %%%s\n", register_name(reg));
+    }
+    fprintf(gen->fptr, gen->saved_size > 0 ? "    popq %%rbp\n    ret\n" : "    leave\n    ret\n");
+}
+
+void process_instruction(CodeGenerator *gen, int index) {
+    TacArray *code = gen->code;
+    switch (code->ops[index]) {
+        case TAC_ADD: case TAC_SUB: case TAC_MULT: case TAC_DIV: case TAC_MOD: {
+            generate_arithmetic(gen, index);
+            break;
+        }
+        case TAC_LT: case TAC_GT: case TAC_NEQ: case TAC_LTE: case TAC_GTE: case TAC_EQ: {
+            generate_comparison(gen, index);
+            break;
+        }
+        case TAC_AND: case TAC_OR: case TAC_NOT: {
+            generate_logic(gen, index);
+            break;
+        }
+        case TAC_NEG: {
+            generate_negation(gen, index);
+            break;
+        }
+        case TAC_POS: case TAC_CPY: {
+            generate_copy(gen, code->a[index], code->b[index]);
+            break;
+        }
+        case TAC_GOTO: case TAC_IFZ: case TAC_IFNZ: {
+            generate_jump(gen, index);
+            break;
+        }
+        case TAC_LABEL: {
+            fprintf(gen->fptr, ".L%d:\n", gen->label_base + operand_index(code->a[index]));
+            break;
+        }
+        case TAC_PRINT: {
+            generate_print(gen, index);
+            break;
+        }
+        case TAC_PRINTLN: {
+            call_runtime(gen, "pas.write_line");
+            gen->uses_write = 1;
+            break;
+        }
+        case TAC_READ: {
+            generate_read(gen, index);
+            break;
         }
+        case TAC_READLN: {
+            call_runtime(gen, "pas.read_line");
+            gen->uses_read = 1;
+            break;
+        }
+        case TAC_ARG: {
+            generate_arg(gen, index);
+            break;
+        }
+        case TAC_CALL: {
+            generate_call(gen, index);
+            break;
+        }
+        case TAC_ENDFUNC: case TAC_ENDPROC: case TAC_ENDPROG: {
+            generate_epilogue(gen, index);
+            break;
+        }
+        default: { // Variables have their registers or slots, removed instructions produce nothing
+            break;
+        }
+    }
+}
+
+int generate_routine(CodeGenerator *gen, int start, int end) {
+    // Variables of the routine get their registers or stack slots before its instructions are translated
+    ControlFlowGraph *cfg = build_cfg(gen->code, start, end);
+    if (cfg == NULL)
+        return 0;
+    RegisterAllocation *alloc = allocate_registers(cfg);
+    if (alloc == NULL) {
+        free_cfg(cfg);
+        return 0;
+    }
+    if (gen->ctx->options.list_allocation)
+        print_allocation_stats(gen->ctx->log_fptr, gen->code, start, alloc);
+    gen->alloc = alloc;
+    gen->param_offsets = NULL;
+    int result = 1;
+    if (gen->fptr != NULL && (result = generate_prologue(gen, start))) {
+        for (int i = start + 1; i <= end; i++)
+            process_instruction(gen, i);
+        const Symbol *routine = operand_symbol(gen->code, gen->code->a[start]);
+        if (routine != NULL)
+            fprintf(gen->fptr, "    .size pas_%s, .-pas_%s\n", routine->name, routine->name);
+        else
+            fprintf(gen->fptr, "    .size main, .-main\n");
+    }
+    free(gen->param_offsets);
+    free_allocation(alloc);
+    free_cfg(cfg);
+    return result;
+}
 
-        Tac *current_tac = next->next;
-        while (current_tac != NULL) {
-            process_instruction(current_tac);
-            current_tac = current_tac->next;
+void generate_string_literal(FILE *fptr, const char *str) { // GNU as string with its escapes
+    fprintf(fptr, "    .string \"");
+    for (; *str != '\0'; str++) {
+        unsigned char ch = *str;
+        if (ch == '"' || ch == '\\')
+            fprintf(fptr, "\\%c", ch);
+        else if (ch < 32 || ch >= 127)
+            fprintf(fptr, "\\%03o", ch);
+        else
+            fputc(ch, fptr);
+    }
+    fprintf(fptr, "\"\n");
+}
+
+void generate_literals(CodeGenerator *gen) { // Real and string literals used by the code, each written once
+    const ConstantPool *pool = &gen->ctx->constants;
+    for (int index = 0; index < gen->constant_count; index++) {
+        if (!gen->used_constants[index])
+            continue;
+        const Symbol *symb = pool->constants[index];
+        if (symb->token_type == REAL_TOKEN) {
+            uint32_t bits;
+            memcpy(&bits, &symb->values->f, sizeof(bits));
+            fprintf(gen->fptr, ".LC%d:\n    .long 0x%08x\n", index, bits);
+        }
+        else {
+            fprintf(gen->fptr, ".LS%d:\n", index);
+            generate_string_literal(gen->fptr, symb->values->str);
         }
     }
-}
\ No newline at end of file
+}
+
+void generate_data(CodeGenerator *gen) {
+    // Global variables (strings start empty), the literals then the runtime
+    TacArray *code = gen->code;
+    fprintf(gen->fptr, "\n    .data\n    .balign 8\n");
+    for (int i = 0; i < code->tac_count && code->ops[i] != TAC_BEGINFUNC && code->ops[i] != TAC_BEGINPROC && code->ops[i] != TAC_BEGINPROG; i++) {
+        if (code->ops[i] == TAC_VAR)
+            fprintf(gen->fptr, "var.%s:\n    .quad %s\n", operand_symbol(code, code->a[i])->name,
+                    operand_class(gen, code->a[i]) == STRING_VALUE ? ".Lempty" : "0");
+    }
+    fprintf(gen->fptr, "\n    .section .rodata\n");
+    fprintf(gen->fptr, ".Ltrue:\n    .string \"TRUE\"\n.Lfalse:\n    .string \"FALSE\"\n.Lempty:\n    .string \"\"\n");
+    fprintf(gen->fptr, "    .balign 4\n");
+    generate_literals(gen);
+    if (gen->uses_concat) { // Joins two strings in a new heap block, never freed: the registers holding strings are not tracked
+        fprintf(gen->fptr, "\n    .text\n    .type pas_concat, @function\npas_concat:\n");
+        fprintf(gen->fptr, "    pushq %%rbx\n    pushq %%r12\n    pushq %%r13\n    movq %%rdi, %%rbx\n    movq %%rsi, %%r12\n");
+        fprintf(gen->fptr, "    call strlen@PLT\n    movq %%rax, %%r13\n    movq %%r12, %%rdi\n    call strlen@PLT\n");
+        fprintf(gen->fptr, "    leaq 1(%%r13,%%rax), %%rdi\n    call malloc@PLT\n    movq %%rax, %%rdi\n    movq %%rbx, %%rsi\n");
+        fprintf(gen->fptr, "    call strcpy@PLT\n    movq %%rax, %%rdi\n    movq %%r12, %%rsi\n    call strcat@PLT\n");
+        fprintf(gen->fptr, "    popq %%r13\n    popq %%r12\n    popq %%rbx\n    ret\n    .size pas_concat, .-pas_concat\n");
+    }
+    if (gen->uses_write || gen->uses_read)
+        fprintf(gen->fptr, "\n%s", write_runtime_assembly);
+    if (gen->uses_read)
+        fprintf(gen->fptr, "\n%s", read_runtime_assembly);
+    fprintf(gen->fptr, "\n    .section .note.GNU-stack,\"\",@progbits\n");
+}
+
+CodeGenerator* make_code_generator(CompilerContext *ctx, FILE *fptr) {
+    // With no file only the register allocation is listed
+    CodeGenerator *gen = calloc(1, sizeof(CodeGenerator));
+    if (gen != NULL) {
+        gen->location_size = 64;
+        gen->location = malloc(gen->location_size);
+    }
+    if (gen == NULL || gen->location == NULL) {
+        fprintf(ctx->log_fptr, "Error: failed to allocate memory for the code generator\n");
+        free(gen);
+        return NULL;
+    }
+    gen->ctx = ctx;
+    gen->fptr = fptr;
+    if (fptr != NULL)
+        fprintf(fptr, "    .text\n");
+    return gen;
+}
+
+void free_code_generator(CodeGenerator *gen) {
+    if (gen != NULL) {
+        free(gen->used_constants);
+        free(gen->location);
+        free(gen);
+    }
+}
+
+int generate_routines(CodeGenerator *gen, TacArray *code) { // Translates every routine of the code
+    int constant_count = gen->ctx->constants.count; // The pool grows with each part of a streamed program
+    uint8_t *used_constants = realloc(gen->used_constants, constant_count + 1);
+    if (used_constants == NULL) {
+        fprintf(gen->ctx->log_fptr, "Error: failed to allocate memory for the code generator\n");
+        return 0;
+    }
+    memset(used_constants + gen->constant_count, 0, constant_count + 1 - gen->constant_count);
+    gen->used_constants = used_constants;
+    gen->constant_count = constant_count;
+    gen->code = code;
+    int result = 1, start, end;
+    for (int from = 0; result && next_routine(code, from, &start, &end); from = end + 1)
+        result = generate_routine(gen, start, end);
+    return result;
+}
+
+int generate_code_part(CodeGenerator *gen, TacArray *code) {
+    // Routines of a part of the program generated on its own, the literals it used are written with the last part
+    if (!generate_routines(gen, code))
+        return 0;
+    gen->label_base += code->label_count;
+    return 1;
+}
+
+int finish_code(CodeGenerator *gen, TacArray *code) {
+    // Last part of the program, its global variables are declared at its start, the generator is freed
+    int result = generate_routines(gen, code);
+    if (result && gen->fptr != NULL)
+        generate_data(gen);
+    free_code_generator(gen);
+    return result;
+}
+
+int generate_code(CompilerContext *ctx, TacArray *code, FILE *fptr) {
+    // Writes the assembly of the whole program to fptr, with no file only the register allocation is listed
+    CodeGenerator *gen = make_code_generator(ctx, fptr);
+    return gen != NULL && finish_code(gen, code);
+}
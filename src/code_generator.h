@@ -1,6 +1,22 @@
 #ifndef CODE_GENERATOR_H
 #define CODE_GENERATOR_H
 
-void generate_code(Tac*);
+#include <stdio.h>
+
+#include "tac_array.h"
+#include "compiler_context.h"
+
+typedef enum { // Machine representation of the values: integers, characters and booleans are integers
+    INT_VALUE, REAL_VALUE, STRING_VALUE
+} ValueClass;
+
+typedef struct _CodeGenerator CodeGenerator; // Defined in code_generator.c
+
+ValueClass value_class(TokenType);
+CodeGenerator* make_code_generator(CompilerContext *, FILE *);
+void free_code_generator(CodeGenerator *);
+int generate_code_part(CodeGenerator *, TacArray *);
+int finish_code(CodeGenerator *, TacArray *);
+int generate_code(CompilerContext *, TacArray *, FILE *);
 
 #endif
\ No newline at end of file
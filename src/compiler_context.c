@@ -0,0 +1,352 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "scanner.h"
+#include "symbol_table.h"
+#include "parser.h"
+#include "tac.h"
+#include "tac_array.h"
+#include "compiler_context.h"
+#include "optimizer.h"
+#include "code_generator.h"
+#include "elf_writer.h"
+#include "c_generator.h"
+#include "interpreter.h"
+#include "bytecode.h"
+#include "jit.h"
+
+uint32_t make_hash_seed(const CompilerContext *ctx) {
+    // Mixes the clock and the context address so that concurrent contexts don't need a shared random generator
+    uint32_t seed = (uint32_t) time(0) ^ (uint32_t) clock() ^ (uint32_t) (uintptr_t) ctx;
+    seed ^= seed >> 16;
+    seed *= 0x85ebca6b;
+    seed ^= seed >> 13;
+    return seed != 0 ? seed : 0x5bd1e995;
+}
+
+void default_options(CompileOptions *options) {
+    options->list_tokens = 0;
+    options->syntax_only = 0;
+    options->list_tac = 0;
+    options->list_allocation = 0;
+    options->emit_assembly = 0;
+    options->emit_object = 0;
+    options->emit_executable = 0;
+    options->emit_c = 0;
+    options->emit_bytecode = 0;
+    options->run_program = 0;
+    options->jit_program = 0;
+    options->optimize = 2;
+}
+
+CompilerContext* make_context() {
+    CompilerContext *ctx = malloc(sizeof(CompilerContext));
+    if (ctx == NULL) {
+        printf("Error: failed to allocate memory for the compiler context\n");
+        return NULL;
+    }
+    ctx->log_fptr = stdout;
+    default_options(&ctx->options);
+
+    ctx->target_fptr = NULL;
+    ctx->current_token = NULL;
+    ctx->stocked_token = NULL;
+    ctx->line_count = 1;
+    ctx->char_count = 1;
+    ctx->token_record = NULL;
+    ctx->token_replay = NULL;
+
+    ctx->main_table = NULL;
+    ctx->current_table = NULL;
+    ctx->hash_seed = make_hash_seed(ctx);
+
+    ctx->program_tac = empty_tac();
+    ctx->tac_blocks = NULL;
+    ctx->ir_symbols = NULL;
+    memset(&ctx->constants, 0, sizeof(ConstantPool));
+    ctx->temp_types = NULL;
+    ctx->temp_count = ctx->temp_capacity = 0;
+    ctx->label_idx = 0;
+    ctx->tac_failed = 0;
+    ctx->generator = NULL;
+    ctx->assembly_output = NULL;
+    return ctx;
+}
+
+void reset_context(CompilerContext *ctx) { // Frees everything a compilation produced, the context can then be used for a new compilation
+    close_target_file(ctx);
+    SymbolTable *table = ctx->main_table;
+    while (table != NULL) { // Function/procedure tables are chained to the main table through their child pointer
+        SymbolTable *child = table->child;
+        clean_table(table);
+        table = child;
+    }
+    ctx->main_table = NULL;
+    ctx->current_table = NULL;
+    free_tac(ctx);
+    ctx->line_count = 1;
+    ctx->char_count = 1;
+}
+
+void free_context(CompilerContext *ctx) {
+    if (ctx != NULL) {
+        reset_context(ctx);
+        free(ctx);
+    }
+}
+
+const char* executable_extension(const char *source_path) { // Executables drop the .pas extension, other names get .out
+    int length = strlen(source_path);
+    return length > 4 && !strcmp(source_path + length - 4, ".pas") ? "" : ".out";
+}
+
+char* output_path(CompilerContext *ctx, const char *source_path, const char *extension) {
+    // Path of an output next to the source file, its .pas extension replaced
+    int length = strlen(source_path);
+    if (length > 4 && !strcmp(source_path + length - 4, ".pas"))
+        length -= 4;
+    char *path = malloc(length + strlen(extension) + 1);
+    if (path == NULL) {
+        fprintf(ctx->log_fptr, "Error: failed to allocate memory for an output file path\n");
+        return NULL;
+    }
+    memcpy(path, source_path, length);
+    strcpy(path + length, extension);
+    return path;
+}
+
+FILE* open_output_file(CompilerContext *ctx, const char *source_path, const char *extension) {
+    char *path = output_path(ctx, source_path, extension);
+    if (path == NULL)
+        return NULL;
+    FILE *fptr = fopen(path, "wb");
+    if (fptr == NULL)
+        fprintf(ctx->log_fptr, "Error: failed to create output file at path \"%s\"\n", path);
+    free(path);
+    return fptr;
+}
+
+int run_bytecode_file(CompilerContext *ctx, const char *path) {
+    Program *program = load_bytecode(ctx, path);
+    int result = program != NULL && (ctx->options.jit_program ? run_jit(ctx, program, NULL) : run_program(ctx, program));
+    free_program(program);
+    return result;
+}
+
+struct _AssemblyOutput { // Where the code generator writes the assembly of the program
+    FILE *fptr; // The .s file with -S alone, otherwise a buffer holding the text generated since the last flush
+    char *text;
+    size_t length;
+    FILE *asm_fptr; // .s file the buffer is copied to (-S with -c or -static)
+    char *asm_path; // Removed when the compilation fails
+    Assembler *object, *executable; // Built-in assemblers of the .o file (-c) and of the static executable (-static)
+};
+
+int close_assembly_output(CompilerContext *, AssemblyOutput *, const char *, int);
+
+AssemblyOutput* open_assembly_output(CompilerContext *ctx, const char *path) {
+    AssemblyOutput *output = calloc(1, sizeof(AssemblyOutput));
+    if (output == NULL) {
+        fprintf(ctx->log_fptr, "Error: failed to allocate memory for the assembly text\n");
+        return NULL;
+    }
+    int result = 1;
+    if (ctx->options.emit_assembly) {
+        output->asm_path = output_path(ctx, path, ".s");
+        output->asm_fptr = output->asm_path != NULL ? fopen(output->asm_path, "wb") : NULL;
+        if (output->asm_path != NULL && output->asm_fptr == NULL)
+            fprintf(ctx->log_fptr, "Error: failed to create output file at path \"%s\"\n", output->asm_path);
+        result = output->asm_fptr != NULL;
+    }
+    if (result && !ctx->options.emit_object && !ctx->options.emit_executable)
+        output->fptr = output->asm_fptr; // Nothing to assemble, straight to the file
+    else if (result) {
+#ifndef _WIN32
+        output->fptr = open_memstream(&output->text, &output->length);
+#else
+        output->fptr = tmpfile(); // Read back at each flush without open_memstream
+#endif
+        if (output->fptr == NULL)
+            fprintf(ctx->log_fptr, "Error: failed to allocate memory for the assembly text\n");
+        result = output->fptr != NULL;
+        if (result && ctx->options.emit_object)
+            result = (output->object = start_assembly(ctx)) != NULL;
+        if (result && ctx->options.emit_executable)
+            result = (output->executable = start_assembly(ctx)) != NULL;
+    }
+    if (!result) {
+        close_assembly_output(ctx, output, path, 0);
+        return NULL;
+    }
+    return output;
+}
+
+int flush_assembly_output(CompilerContext *ctx, AssemblyOutput *output) {
+    // Hands the text generated since the last flush to the .s file and to the assemblers, the buffer is then reused so
+    // that it never holds more than a routine
+    if (output->object == NULL && output->executable == NULL)
+        return 1; // Written to the .s file already
+#ifndef _WIN32
+    int result = fflush(output->fptr) == 0;
+#else
+    long size = ftell(output->fptr);
+    char *text = size >= 0 ? realloc(output->text, size + 1) : NULL;
+    if (text != NULL)
+        output->text = text;
+    int result = text != NULL && fflush(output->fptr) == 0 && fseek(output->fptr, 0, SEEK_SET) == 0
+        && fread(text, 1, size, output->fptr) == (size_t) size;
+    output->length = result ? size : 0;
+#endif
+    if (!result)
+        fprintf(ctx->log_fptr, "Error: failed to allocate memory for the assembly text\n");
+    if (result && output->asm_fptr != NULL && fwrite(output->text, 1, output->length, output->asm_fptr) != output->length) {
+        fprintf(ctx->log_fptr, "Error: failed to write an output file\n");
+        result = 0;
+    }
+    if (result && output->object != NULL)
+        result = assemble_part(output->object, output->text, output->length);
+    if (result && output->executable != NULL)
+        result = assemble_part(output->executable, output->text, output->length);
+    return result && fseek(output->fptr, 0, SEEK_SET) == 0;
+}
+
+int close_assembly_output(CompilerContext *ctx, AssemblyOutput *output, const char *path, int result) {
+    // Flushes the end of the text and writes the binary files when result is set, frees the output either way
+    result = result && flush_assembly_output(ctx, output);
+    if (output->fptr != NULL && output->fptr != output->asm_fptr)
+        fclose(output->fptr);
+    if (output->asm_fptr != NULL && fclose(output->asm_fptr) != 0 && result) {
+        fprintf(ctx->log_fptr, "Error: failed to write an output file\n");
+        result = 0;
+    }
+    if (result)
+        result = write_binary_files(ctx, path, output->object, output->executable);
+    else {
+        if (output->object != NULL)
+            free_assembly(finish_assembly(output->object));
+        if (output->executable != NULL)
+            free_assembly(finish_assembly(output->executable));
+    }
+    if (!result && output->asm_path != NULL)
+        remove(output->asm_path); // Left incomplete
+    free(output->asm_path);
+    free(output->text);
+    free(output);
+    return result;
+}
+
+int streams_routines(const CompileOptions *options) {
+    // Only the native code generator works one routine at a time, the other outputs need the whole program
+    return !options->syntax_only && !options->list_tac && !options->emit_c && !options->emit_bytecode && !options->run_program
+        && !options->jit_program && (options->emit_assembly || options->emit_object || options->emit_executable || options->list_allocation);
+}
+
+void release_routine_table(CompilerContext *ctx, const Symbol *routine) {
+    // Frees the table of the routine parsed last but its parameters, which the calls still check
+    SymbolTable *table = ctx->main_table->child; // Tables are chained from the last one
+    ctx->main_table->child = table->child;
+    Symbol *params = clean_routine_table(table, routine->param_list);
+    while (params != NULL) {
+        Symbol *param = params;
+        params = param->next;
+        register_symbol(ctx, param);
+    }
+}
+
+int stream_routine(CompilerContext *ctx, TacList globals, TacList routine, TacMark mark) {
+    // Optimizes and translates the routine parsed last (with the global variables declared before it), then frees its
+    // code, literals, labels and table and reuses its temporary numbers; the code allocated before the mark is kept
+    const Symbol *symb = routine.head->a.symb;
+    TacArray *code = flatten_tac(ctx, join_tac(globals, routine), ctx->temp_types, ctx->temp_count);
+    int result = code != NULL;
+    if (result) {
+        if (ctx->options.optimize)
+            optimize_code(ctx, code);
+        result = generate_code_part(ctx->generator, code);
+        if (result && ctx->assembly_output != NULL)
+            result = flush_assembly_output(ctx, ctx->assembly_output);
+        free_tac_array(code);
+    }
+    release_tac(ctx, mark);
+    release_routine_table(ctx, symb);
+    return result;
+}
+
+int compile_file(CompilerContext *ctx, const char *path) { // Runs a whole compilation, the context is reset and ready for reuse afterwards
+    int length = strlen(path);
+    if (length > 4 && !strcmp(path + length - 4, ".pbc")) // Compiled already, only runs
+        return run_bytecode_file(ctx, path);
+    int writes_assembly = ctx->options.emit_assembly || ctx->options.emit_object || ctx->options.emit_executable;
+    AssemblyOutput *output = NULL;
+    if (streams_routines(&ctx->options)) {
+        // Each routine goes to the .s file and the assemblers as soon as it is parsed, with neither only the register
+        // allocation is listed
+        output = writes_assembly ? open_assembly_output(ctx, path) : NULL;
+        ctx->generator = writes_assembly && output == NULL ? NULL : make_code_generator(ctx, output != NULL ? output->fptr : NULL);
+        if (ctx->generator == NULL) {
+            if (output != NULL)
+                close_assembly_output(ctx, output, path, 0);
+            reset_context(ctx);
+            return 0;
+        }
+        ctx->assembly_output = output;
+    }
+    int result = parse_file(ctx, path);
+    if (result && !ctx->options.syntax_only) {
+        TacArray *code = flatten_tac(ctx, ctx->program_tac, ctx->temp_types, ctx->temp_count);
+        free_tac_blocks(ctx); // Passes and the code generator work on the array
+        if (code == NULL)
+            result = 0;
+        else {
+            if (ctx->options.optimize)
+                optimize_code(ctx, code);
+            if (ctx->options.list_tac)
+                print_tac_array(ctx->log_fptr, code);
+            if (ctx->generator != NULL) { // Main program and global data
+                result = finish_code(ctx->generator, code);
+                ctx->generator = NULL;
+            }
+            else if (writes_assembly) {
+                output = open_assembly_output(ctx, path);
+                result = output != NULL && generate_code(ctx, code, output->fptr);
+            }
+            else if (ctx->options.list_allocation)
+                result = generate_code(ctx, code, NULL);
+            if (output != NULL) {
+                result = close_assembly_output(ctx, output, path, result);
+                output = ctx->assembly_output = NULL;
+            }
+            if (result && ctx->options.emit_c) {
+                FILE *c_fptr = open_output_file(ctx, path, ".c");
+                result = c_fptr != NULL && generate_c_code(ctx, code, c_fptr);
+                if (c_fptr != NULL)
+                    fclose(c_fptr);
+            }
+            if (result && (ctx->options.run_program || ctx->options.jit_program || ctx->options.emit_bytecode)) {
+                Program *program = decode_program(ctx, code);
+                result = program != NULL;
+                if (result && ctx->options.emit_bytecode) {
+                    FILE *bytecode_fptr = open_output_file(ctx, path, ".pbc");
+                    result = bytecode_fptr != NULL && write_bytecode(ctx, program, bytecode_fptr);
+                    if (bytecode_fptr != NULL)
+                        fclose(bytecode_fptr);
+                }
+                if (result && ctx->options.jit_program)
+                    result = run_jit(ctx, program, code);
+                else if (result && ctx->options.run_program)
+                    result = run_program(ctx, program);
+                free_program(program);
+            }
+            free_tac_array(code);
+        }
+    }
+    free_code_generator(ctx->generator); // Left when the parsing failed
+    ctx->generator = NULL;
+    if (output != NULL)
+        close_assembly_output(ctx, output, path, 0);
+    ctx->assembly_output = NULL;
+    reset_context(ctx);
+    return result;
+}
@@ -0,0 +1,70 @@
+#ifndef COMPILER_CONTEXT_H
+#define COMPILER_CONTEXT_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "scanner.h"
+#include "symbol_table.h"
+#include "tac.h"
+
+typedef struct _CompileOptions {
+    int list_tokens;
+    int syntax_only; // Stops after the syntax and semantic checks (no intermediate code, no code generation)
+    int list_tac; // Lists the intermediate code of the program
+    int list_allocation; // Lists the register allocation statistics of each routine
+    int emit_assembly; // Writes the x86-64 assembly of the program next to its source file (.s)
+    int emit_object; // Writes an ELF relocatable object of the program next to its source file (.o)
+    int emit_executable; // Writes a static ELF executable of the program next to its source file (no extension)
+    int emit_c; // Writes a C translation of the program next to its source file (.c)
+    int emit_bytecode; // Writes the decoded program of the interpreter next to its source file (.pbc)
+    int run_program; // Runs the program with the interpreter once it is compiled
+    int jit_program; // Runs the program as machine code generated in memory once it is compiled
+    int optimize; // Optimization level, 0 for none, 1 numbers the values of each block on its own, 2 (default) over the dominator tree and optimizes the loops
+} CompileOptions;
+
+typedef struct _AssemblyOutput AssemblyOutput; // Defined in compiler_context.c
+
+struct _CompilerContext { // Whole state of a single compilation, contexts only share the read-only builtin symbols so they can be used from different threads
+    // Options
+    FILE *log_fptr; // Where diagnostics (and the token listing) are written, stdout by default
+    CompileOptions options;
+
+    // Scanner state
+    FILE *target_fptr;
+    TokenData *current_token;
+    TokenData *stocked_token;
+    int line_count, char_count;
+    TokenStream *token_record; // When set, every scanned token is appended to it
+    TokenStream *token_replay; // When set, tokens are read from it instead of the source file
+
+    // Semantic analysis state
+    SymbolTable *main_table;
+    SymbolTable *current_table;
+    uint32_t hash_seed;
+
+    // Intermediate code state
+    TacList program_tac;
+    TacBlock *tac_blocks; // Every instruction of the compilation
+    Symbol *ir_symbols; // Labels and the parameters of the streamed routines, chained through their next pointer
+    ConstantPool constants;
+    TokenType *temp_types; // Type of each temporary, by number
+    int temp_count, temp_capacity;
+    int label_idx;
+    int tac_failed; // Set when an instruction, label or temporary could not be allocated, the linked code is then incomplete
+    struct _CodeGenerator *generator; // Set when each routine is translated as soon as it is parsed, then freed
+    struct _AssemblyOutput *assembly_output; // Where the generator's text goes after each routine, NULL when it has none
+};
+
+void default_options(CompileOptions *);
+CompilerContext* make_context();
+void reset_context(CompilerContext *);
+void free_context(CompilerContext *);
+const char* executable_extension(const char *);
+char* output_path(CompilerContext *, const char *, const char *);
+FILE* open_output_file(CompilerContext *, const char *, const char *);
+void release_routine_table(CompilerContext *, const Symbol *);
+int stream_routine(CompilerContext *, TacList, TacList, TacMark);
+int compile_file(CompilerContext *, const char *);
+
+#endif
@@ -0,0 +1,340 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "scanner.h"
+#include "tac.h"
+#include "tac_array.h"
+#include "control_flow.h"
+
+int next_routine(const TacArray *code, int from, int *start, int *end) {
+    // Finds the first routine starting at or after from, returns 0 once there is none left
+    for (int i = from; i < code->tac_count; i++) {
+        TacOp op = code->ops[i];
+        if (op == TAC_BEGINFUNC || op == TAC_BEGINPROC || op == TAC_BEGINPROG) {
+            TacOp end_op = op == TAC_BEGINFUNC ? TAC_ENDFUNC : op == TAC_BEGINPROC ? TAC_ENDPROC : TAC_ENDPROG;
+            for (int j = i + 1; j < code->tac_count; j++) {
+                if (code->ops[j] == end_op) {
+                    *start = i;
+                    *end = j;
+                    return 1;
+                }
+            }
+            return 0;
+        }
+    }
+    return 0;
+}
+
+int is_jump(TacOp op) {
+    return op == TAC_GOTO || op == TAC_IFZ || op == TAC_IFNZ;
+}
+
+int instruction_block(const ControlFlowGraph *cfg, int index) {
+    return cfg->block_of[index - cfg->routine_start - 1];
+}
+
+int label_block(const ControlFlowGraph *cfg, Operand label) {
+    return instruction_block(cfg, cfg->code->labels[operand_index(label)]);
+}
+
+int last_instruction(const ControlFlowGraph *cfg, const BasicBlock *block) { // Skips removed instructions, -1 for an empty block
+    for (int i = block->end - 1; i >= block->start; i--) {
+        if (cfg->code->ops[i] != TAC_UNDEF)
+            return i;
+    }
+    return -1;
+}
+
+int split_blocks(ControlFlowGraph *cfg) { // A block starts at a label or right after a jump
+    int body_count = cfg->routine_end - cfg->routine_start - 1;
+    int block_count = 0;
+    for (int i = 0; i < body_count; i++) {
+        TacOp op = cfg->code->ops[cfg->routine_start + 1 + i];
+        if (i == 0 || op == TAC_LABEL || is_jump(cfg->code->ops[cfg->routine_start + i]))
+            block_count++;
+        cfg->block_of[i] = block_count - 1;
+    }
+    if (block_count == 0) // Empty routine
+        block_count = 1;
+    cfg->blocks = malloc(block_count * sizeof(BasicBlock));
+    if (cfg->blocks == NULL)
+        return 0;
+    cfg->block_count = block_count;
+    for (int b = 0; b < block_count; b++) {
+        cfg->blocks[b].start = cfg->routine_end;
+        cfg->blocks[b].end = cfg->routine_start + 1;
+    }
+    for (int i = 0; i < body_count; i++) {
+        BasicBlock *block = &cfg->blocks[cfg->block_of[i]];
+        if (block->start > cfg->routine_start + 1 + i)
+            block->start = cfg->routine_start + 1 + i;
+        block->end = cfg->routine_start + 2 + i;
+    }
+    if (body_count == 0)
+        cfg->blocks[0].start = cfg->blocks[0].end = cfg->routine_start + 1;
+    return 1;
+}
+
+int link_blocks(ControlFlowGraph *cfg) {
+    int *pred_counts = calloc(cfg->block_count, sizeof(int));
+    if (pred_counts == NULL)
+        return 0;
+    for (int b = 0; b < cfg->block_count; b++) {
+        BasicBlock *block = &cfg->blocks[b];
+        int last = last_instruction(cfg, block);
+        TacOp op = last < 0 ? TAC_UNDEF : cfg->code->ops[last];
+        block->succ_count = 0;
+        if (op != TAC_GOTO && b + 1 < cfg->block_count)
+            block->succs[block->succ_count++] = b + 1;
+        if (is_jump(op)) {
+            int target = label_block(cfg, cfg->code->a[last]);
+            if (block->succ_count == 0 || block->succs[0] != target)
+                block->succs[block->succ_count++] = target;
+        }
+        for (int s = 0; s < block->succ_count; s++)
+            pred_counts[block->succs[s]]++;
+    }
+    int pred_total = 0;
+    for (int b = 0; b < cfg->block_count; b++) {
+        cfg->blocks[b].pred_start = pred_total;
+        cfg->blocks[b].pred_count = 0;
+        pred_total += pred_counts[b];
+    }
+    cfg->preds = malloc((pred_total > 0 ? pred_total : 1) * sizeof(int));
+    if (cfg->preds == NULL) {
+        free(pred_counts);
+        return 0;
+    }
+    for (int b = 0; b < cfg->block_count; b++) {
+        for (int s = 0; s < cfg->blocks[b].succ_count; s++) {
+            BasicBlock *succ = &cfg->blocks[cfg->blocks[b].succs[s]];
+            cfg->preds[succ->pred_start + succ->pred_count++] = b;
+        }
+    }
+    free(pred_counts);
+    return 1;
+}
+
+int order_blocks(ControlFlowGraph *cfg) { // Depth first search from the entry block without recursion
+    int *stack = malloc(cfg->block_count * sizeof(int));
+    int *next_succ = calloc(cfg->block_count, sizeof(int));
+    int *post_order = malloc(cfg->block_count * sizeof(int));
+    cfg->rpo = malloc(cfg->block_count * sizeof(int));
+    if (stack == NULL || next_succ == NULL || post_order == NULL || cfg->rpo == NULL) {
+        free(stack);
+        free(next_succ);
+        free(post_order);
+        return 0;
+    }
+    int stack_count = 0, post_count = 0;
+    for (int b = 0; b < cfg->block_count; b++)
+        cfg->blocks[b].rpo_index = -1;
+    stack[stack_count++] = 0;
+    cfg->blocks[0].rpo_index = 0; // Marks the block as visited until the real index is known
+    while (stack_count > 0) {
+        int b = stack[stack_count - 1];
+        if (next_succ[b] < cfg->blocks[b].succ_count) {
+            int succ = cfg->blocks[b].succs[next_succ[b]++];
+            if (cfg->blocks[succ].rpo_index == -1) {
+                cfg->blocks[succ].rpo_index = 0;
+                stack[stack_count++] = succ;
+            }
+        }
+        else {
+            post_order[post_count++] = b;
+            stack_count--;
+        }
+    }
+    cfg->rpo_count = post_count;
+    for (int i = 0; i < post_count; i++) {
+        cfg->rpo[i] = post_order[post_count - 1 - i];
+        cfg->blocks[cfg->rpo[i]].rpo_index = i;
+    }
+    free(stack);
+    free(next_succ);
+    free(post_order);
+    return 1;
+}
+
+int intersect(const ControlFlowGraph *cfg, int b1, int b2) {
+    while (b1 != b2) {
+        while (cfg->blocks[b1].rpo_index > cfg->blocks[b2].rpo_index)
+            b1 = cfg->blocks[b1].idom;
+        while (cfg->blocks[b2].rpo_index > cfg->blocks[b1].rpo_index)
+            b2 = cfg->blocks[b2].idom;
+    }
+    return b1;
+}
+
+int compute_dominators(ControlFlowGraph *cfg) {
+    // Iterative algorithm of Cooper, Harvey and Kennedy over the reverse post order
+    for (int b = 0; b < cfg->block_count; b++)
+        cfg->blocks[b].idom = -1;
+    cfg->blocks[0].idom = 0;
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = 1; i < cfg->rpo_count; i++) {
+            BasicBlock *block = &cfg->blocks[cfg->rpo[i]];
+            int new_idom = -1;
+            for (int p = 0; p < block->pred_count; p++) {
+                int pred = cfg->preds[block->pred_start + p];
+                if (cfg->blocks[pred].idom == -1) // Not processed yet or unreachable
+                    continue;
+                new_idom = new_idom == -1 ? pred : intersect(cfg, pred, new_idom);
+            }
+            if (block->idom != new_idom) {
+                block->idom = new_idom;
+                changed = 1;
+            }
+        }
+    }
+    cfg->blocks[0].idom = -1;
+
+    for (int b = 0; b < cfg->block_count; b++)
+        cfg->blocks[b].dom_child_count = 0;
+    for (int b = 0; b < cfg->block_count; b++) {
+        if (cfg->blocks[b].idom != -1)
+            cfg->blocks[cfg->blocks[b].idom].dom_child_count++;
+    }
+    int child_total = 0;
+    for (int b = 0; b < cfg->block_count; b++) {
+        cfg->blocks[b].dom_child_start = child_total;
+        child_total += cfg->blocks[b].dom_child_count;
+        cfg->blocks[b].dom_child_count = 0;
+    }
+    cfg->dom_children = malloc((child_total > 0 ? child_total : 1) * sizeof(int));
+    if (cfg->dom_children == NULL)
+        return 0;
+    for (int b = 0; b < cfg->block_count; b++) {
+        if (cfg->blocks[b].idom != -1) {
+            BasicBlock *parent = &cfg->blocks[cfg->blocks[b].idom];
+            cfg->dom_children[parent->dom_child_start + parent->dom_child_count++] = b;
+        }
+    }
+    return 1;
+}
+
+int dominates(const ControlFlowGraph *cfg, int dominator, int b) { // A block dominates itself
+    if (cfg->blocks[b].rpo_index == -1 || cfg->blocks[dominator].rpo_index == -1)
+        return 0;
+    while (b != -1 && cfg->blocks[b].rpo_index >= cfg->blocks[dominator].rpo_index) { // A dominator comes first in the reverse post order
+        if (b == dominator)
+            return 1;
+        b = cfg->blocks[b].idom;
+    }
+    return 0;
+}
+
+int compare_loops(const void *loop_1, const void *loop_2) { // Bigger loops first, a loop is bigger than the loops it contains
+    return ((const Loop *) loop_2)->block_count - ((const Loop *) loop_1)->block_count;
+}
+
+int find_loops(ControlFlowGraph *cfg) {
+    int *in_loop = malloc(cfg->block_count * sizeof(int)); // Last loop a block was added to
+    int *worklist = malloc(cfg->block_count * sizeof(int));
+    int loop_capacity = 0, failed = 0;
+    if (in_loop == NULL || worklist == NULL) {
+        free(in_loop);
+        free(worklist);
+        return 0;
+    }
+    for (int b = 0; b < cfg->block_count; b++)
+        in_loop[b] = -1;
+    for (int i = 0; i < cfg->rpo_count; i++) {
+        int header = cfg->rpo[i];
+        const BasicBlock *header_block = &cfg->blocks[header];
+        int worklist_count = 0;
+        for (int p = 0; p < header_block->pred_count; p++) { // Back edges to the header
+            int pred = cfg->preds[header_block->pred_start + p];
+            if (dominates(cfg, header, pred))
+                worklist[worklist_count++] = pred;
+        }
+        if (worklist_count == 0)
+            continue;
+        if (cfg->loop_count >= loop_capacity) {
+            loop_capacity = loop_capacity == 0 ? 4 : loop_capacity * 2;
+            Loop *loops = realloc(cfg->loops, loop_capacity * sizeof(Loop));
+            if (loops == NULL) {
+                failed = 1;
+                break;
+            }
+            cfg->loops = loops;
+        }
+        Loop *loop = &cfg->loops[cfg->loop_count];
+        loop->header = header;
+        loop->blocks = malloc(cfg->block_count * sizeof(int));
+        if (loop->blocks == NULL) {
+            failed = 1;
+            break;
+        }
+        loop->block_count = 0;
+        loop->blocks[loop->block_count++] = header;
+        in_loop[header] = cfg->loop_count;
+        while (worklist_count > 0) { // Walks the predecessors back from the back edges up to the header
+            int b = worklist[--worklist_count];
+            if (in_loop[b] == cfg->loop_count)
+                continue;
+            in_loop[b] = cfg->loop_count;
+            loop->blocks[loop->block_count++] = b;
+            for (int p = 0; p < cfg->blocks[b].pred_count; p++) {
+                int pred = cfg->preds[cfg->blocks[b].pred_start + p];
+                if (in_loop[pred] != cfg->loop_count && cfg->blocks[pred].rpo_index != -1)
+                    worklist[worklist_count++] = pred;
+            }
+        }
+        cfg->loop_count++;
+    }
+    free(worklist);
+    free(in_loop);
+    if (failed)
+        return 0;
+
+    if (cfg->loop_count > 1)
+        qsort(cfg->loops, cfg->loop_count, sizeof(Loop), compare_loops);
+    for (int b = 0; b < cfg->block_count; b++)
+        cfg->blocks[b].loop = -1;
+    for (int l = 0; l < cfg->loop_count; l++) { // Smaller loops come later and take over the blocks they contain
+        Loop *loop = &cfg->loops[l];
+        loop->parent = cfg->blocks[loop->header].loop;
+        loop->depth = loop->parent == -1 ? 1 : cfg->loops[loop->parent].depth + 1;
+        for (int i = 0; i < loop->block_count; i++)
+            cfg->blocks[loop->blocks[i]].loop = l;
+    }
+    return 1;
+}
+
+ControlFlowGraph* build_cfg(TacArray *code, int routine_start, int routine_end) {
+    // Builds the graph of the routine between the given begin and end instructions, NULL when out of memory
+    ControlFlowGraph *cfg = calloc(1, sizeof(ControlFlowGraph));
+    if (cfg == NULL) {
+        fprintf(code->log_fptr, "Error: failed to allocate memory for the control flow graph\n");
+        return NULL;
+    }
+    cfg->code = code;
+    cfg->routine_start = routine_start;
+    cfg->routine_end = routine_end;
+    int body_count = routine_end - routine_start - 1;
+    cfg->block_of = malloc((body_count > 0 ? body_count : 1) * sizeof(int));
+    if (cfg->block_of == NULL || !split_blocks(cfg) || !link_blocks(cfg) || !order_blocks(cfg) || !compute_dominators(cfg)
+        || !find_loops(cfg)) {
+        fprintf(code->log_fptr, "Error: failed to allocate memory for the control flow graph\n");
+        free_cfg(cfg);
+        return NULL;
+    }
+    return cfg;
+}
+
+void free_cfg(ControlFlowGraph *cfg) {
+    if (cfg != NULL) {
+        for (int l = 0; l < cfg->loop_count; l++)
+            free(cfg->loops[l].blocks);
+        free(cfg->loops);
+        free(cfg->blocks);
+        free(cfg->block_of);
+        free(cfg->preds);
+        free(cfg->rpo);
+        free(cfg->dom_children);
+        free(cfg);
+    }
+}
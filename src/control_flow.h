@@ -0,0 +1,46 @@
+#ifndef CONTROL_FLOW_H
+#define CONTROL_FLOW_H
+
+#include "tac_array.h"
+
+typedef struct _BasicBlock {
+    int start, end; // Instructions [start, end) of the block
+    int succs[2]; // Fall through (or jump) target first, the branch target of a conditional jump second
+    int succ_count;
+    int pred_start, pred_count; // Predecessors are stored in ControlFlowGraph.preds
+    int idom; // Immediate dominator, -1 for the entry block and unreachable blocks
+    int dom_child_start, dom_child_count; // Children in the dominator tree, stored in ControlFlowGraph.dom_children
+    int rpo_index; // Position in the reverse post order, -1 when the block is unreachable
+    int loop; // Innermost loop containing the block, -1 when it isn't in a loop
+} BasicBlock;
+
+typedef struct _Loop { // Natural loop, all the back edges to the same header are merged into one loop
+    int header;
+    int parent; // Innermost enclosing loop, -1 for an outermost loop
+    int depth; // 1 for an outermost loop
+    int *blocks; // Header first
+    int block_count;
+} Loop;
+
+typedef struct _ControlFlowGraph { // Basic blocks of a single routine (function, procedure or main block)
+    TacArray *code;
+    int routine_start, routine_end; // Indices of the begin and end instructions of the routine
+    BasicBlock *blocks; // Block 0 is the entry block
+    int block_count;
+    int *block_of; // Block of each instruction of the routine, indexed from routine_start + 1
+    int *preds;
+    int *rpo; // Reachable blocks in reverse post order
+    int rpo_count;
+    int *dom_children;
+    Loop *loops; // Outer loops come before the loops they contain
+    int loop_count;
+} ControlFlowGraph;
+
+int next_routine(const TacArray *, int, int *, int *);
+ControlFlowGraph* build_cfg(TacArray *, int, int);
+void free_cfg(ControlFlowGraph *);
+int instruction_block(const ControlFlowGraph *, int);
+int label_block(const ControlFlowGraph *, Operand);
+int dominates(const ControlFlowGraph *, int, int);
+
+#endif
@@ -0,0 +1,358 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+#include "compiler_context.h"
+#include "assembler.h"
+#include "runtime.h"
+#include "elf_writer.h"
+
+// Constants of the ELF specification
+#define ET_REL 1
+#define ET_EXEC 2
+#define EM_X86_64 62
+#define SHT_PROGBITS 1
+#define SHT_SYMTAB 2
+#define SHT_STRTAB 3
+#define SHT_RELA 4
+#define SHT_NOBITS 8
+#define SHF_WRITE 0x1
+#define SHF_ALLOC 0x2
+#define SHF_EXECINSTR 0x4
+#define SHF_INFO_LINK 0x40
+#define STB_LOCAL 0
+#define STB_GLOBAL 1
+#define STT_NOTYPE 0
+#define STT_FUNC 2
+#define STT_SECTION 3
+#define PT_LOAD 1
+#define PT_GNU_STACK 0x6474e551
+#define PF_X 0x1
+#define PF_W 0x2
+#define PF_R 0x4
+#define R_X86_64_64 1
+#define R_X86_64_PC32 2
+#define R_X86_64_PLT32 4
+
+// Section headers of the objects, in the order they are written
+#define RELA_SECTION(section) (1 + SECTION_COUNT + (section))
+#define NOTE_SECTION (1 + 2 * SECTION_COUNT)
+#define SYMTAB_SECTION (NOTE_SECTION + 1)
+#define STRTAB_SECTION (NOTE_SECTION + 2)
+#define SHSTRTAB_SECTION (NOTE_SECTION + 3)
+#define OBJECT_SECTION_COUNT (NOTE_SECTION + 4)
+
+#define align_to(value, alignment) (((value) + (alignment) - 1) / (alignment) * (alignment))
+
+typedef struct _StringTable {
+    char *text;
+    size_t size, capacity;
+} StringTable;
+
+const char *section_names[SECTION_COUNT] = { ".text", ".data", ".rodata", ".bss" };
+const uint64_t section_flags[SECTION_COUNT] = { SHF_ALLOC | SHF_EXECINSTR, SHF_ALLOC | SHF_WRITE, SHF_ALLOC, SHF_ALLOC | SHF_WRITE };
+
+uint32_t add_string(StringTable *table, const char *str) { // Offset of the string, 0 (the empty string) on failure
+    size_t length = strlen(str) + 1;
+    if (table->size + length > table->capacity) {
+        size_t capacity = table->capacity == 0 ? 1024 : table->capacity;
+        while (capacity < table->size + length)
+            capacity *= 2;
+        char *text = realloc(table->text, capacity);
+        if (text == NULL)
+            return 0;
+        table->text = text;
+        table->capacity = capacity;
+    }
+    memcpy(table->text + table->size, str, length);
+    table->size += length;
+    return table->size - length;
+}
+
+int write_padding(FILE *fptr, size_t *offset, size_t alignment) {
+    for (; *offset % alignment != 0; (*offset)++) {
+        if (fputc(0, fptr) == EOF)
+            return 0;
+    }
+    return 1;
+}
+
+int write_block(FILE *fptr, size_t *offset, const void *data, size_t size) {
+    *offset += size;
+    return size == 0 || fwrite(data, 1, size, fptr) == size;
+}
+
+void init_elf_header(ElfHeader *header, uint16_t type) {
+    memset(header, 0, sizeof(ElfHeader));
+    memcpy(header->ident, "\x7f" "ELF", 4);
+    header->ident[4] = 2; // 64 bit
+    header->ident[5] = 1; // Little endian
+    header->ident[6] = 1; // Version
+    header->type = type;
+    header->machine = EM_X86_64;
+    header->version = 1;
+    header->header_size = sizeof(ElfHeader);
+    header->section_header_size = sizeof(ElfSectionHeader);
+}
+
+int is_local_label(const AsmSymbol *symb) { // .L labels stay out of the symbol tables like with GNU as
+    return !strncmp(symb->name, ".L", 2);
+}
+
+int write_object_file(CompilerContext *ctx, const Assembly *as, FILE *fptr) {
+    // Section contents, relocations, symbols and strings then the section headers, locals come first in the symbol table
+    StringTable strings = { NULL, 0, 0 }, section_strings = { NULL, 0, 0 };
+    ElfSymbol *symbols = calloc(as->symbol_count + SECTION_COUNT + 1, sizeof(ElfSymbol));
+    int *indexes = malloc((as->symbol_count + 1) * sizeof(int));
+    ElfRelocation *relocations[SECTION_COUNT] = { NULL };
+    int result = symbols != NULL && indexes != NULL;
+    for (int s = 0; result && s < SECTION_COUNT; s++) {
+        relocations[s] = malloc((as->sections[s].relocation_count + 1) * sizeof(ElfRelocation));
+        result = relocations[s] != NULL;
+    }
+    if (!result) {
+        fprintf(ctx->log_fptr, "Error: failed to allocate memory for the object file\n");
+        free(symbols);
+        free(indexes);
+        for (int s = 0; s < SECTION_COUNT; s++)
+            free(relocations[s]);
+        return 0;
+    }
+    add_string(&strings, ""); // Offset 0 of both string tables
+    add_string(&section_strings, "");
+
+    int symbol_count = 1, first_global = 0;
+    for (int s = 0; s < SECTION_COUNT; s++) {
+        symbols[symbol_count].info = STB_LOCAL << 4 | STT_SECTION;
+        symbols[symbol_count++].section = 1 + s;
+    }
+    for (int pass = 0; pass < 2; pass++) { // Locals then globals and the undefined symbols
+        if (pass == 1)
+            first_global = symbol_count;
+        for (int s = 0; s < as->symbol_count; s++) {
+            const AsmSymbol *symb = &as->symbols[s];
+            int global = symb->global || symb->section < 0;
+            indexes[s] = -1;
+            if (global != pass || (!global && is_local_label(symb)))
+                continue;
+            ElfSymbol *elf_symbol = &symbols[symbol_count];
+            elf_symbol->name = add_string(&strings, symb->name);
+            elf_symbol->info = (global ? STB_GLOBAL : STB_LOCAL) << 4 | (symb->function ? STT_FUNC : STT_NOTYPE);
+            elf_symbol->section = symb->section >= 0 ? 1 + symb->section : 0;
+            elf_symbol->value = symb->section >= 0 ? symb->offset : 0;
+            elf_symbol->size = symb->size;
+            result = result && elf_symbol->name != 0;
+            indexes[s] = symbol_count++;
+        }
+    }
+    for (int s = 0; s < SECTION_COUNT; s++) { // References to local symbols go through their section
+        for (int r = 0; r < as->sections[s].relocation_count; r++) {
+            const AsmRelocation *relocation = &as->sections[s].relocations[r];
+            const AsmSymbol *symb = &as->symbols[relocation->symbol];
+            int local = !symb->global && symb->section >= 0;
+            uint32_t type = relocation->kind == RELOCATION_64 ? R_X86_64_64
+                            : relocation->kind == RELOCATION_PLT32 ? R_X86_64_PLT32 : R_X86_64_PC32;
+            uint64_t symbol = local ? 1 + symb->section : indexes[relocation->symbol];
+            relocations[s][r].offset = relocation->offset;
+            relocations[s][r].info = symbol << 32 | type;
+            relocations[s][r].addend = relocation->addend + (local ? (int64_t) symb->offset : 0);
+        }
+    }
+    if (!result)
+        fprintf(ctx->log_fptr, "Error: failed to allocate memory for the object file symbol names\n");
+
+    ElfSectionHeader headers[OBJECT_SECTION_COUNT];
+    memset(headers, 0, sizeof(headers));
+    ElfHeader header;
+    init_elf_header(&header, ET_REL);
+    header.section_header_count = OBJECT_SECTION_COUNT;
+    header.section_name_index = SHSTRTAB_SECTION;
+    size_t offset = 0;
+    result = result && write_block(fptr, &offset, &header, sizeof(header));
+    for (int s = 0; result && s < SECTION_COUNT; s++) {
+        const AsmSection *section = &as->sections[s];
+        char rela_name[16];
+        snprintf(rela_name, sizeof(rela_name), ".rela%s", section_names[s]);
+        headers[1 + s].name = add_string(&section_strings, section_names[s]);
+        headers[RELA_SECTION(s)].name = add_string(&section_strings, rela_name);
+        result = headers[1 + s].name != 0 && headers[RELA_SECTION(s)].name != 0;
+        headers[1 + s].type = s == BSS_SECTION ? SHT_NOBITS : SHT_PROGBITS;
+        headers[1 + s].flags = section_flags[s];
+        headers[1 + s].alignment = section->alignment;
+        result = result && write_padding(fptr, &offset, section->alignment);
+        headers[1 + s].offset = offset;
+        headers[1 + s].size = section->size;
+        if (s != BSS_SECTION)
+            result = result && write_block(fptr, &offset, section->bytes, section->size);
+    }
+    for (int s = 0; result && s < SECTION_COUNT; s++) {
+        ElfSectionHeader *rela = &headers[RELA_SECTION(s)];
+        rela->type = SHT_RELA;
+        rela->flags = SHF_INFO_LINK;
+        rela->link = SYMTAB_SECTION;
+        rela->info = 1 + s;
+        rela->alignment = 8;
+        rela->entry_size = sizeof(ElfRelocation);
+        result = write_padding(fptr, &offset, 8);
+        rela->offset = offset;
+        rela->size = as->sections[s].relocation_count * sizeof(ElfRelocation);
+        result = result && write_block(fptr, &offset, relocations[s], rela->size);
+    }
+    if (result) { // Marks the stack non-executable
+        headers[NOTE_SECTION].name = add_string(&section_strings, ".note.GNU-stack");
+        headers[NOTE_SECTION].type = SHT_PROGBITS;
+        headers[NOTE_SECTION].offset = offset;
+        headers[NOTE_SECTION].alignment = 1;
+        headers[SYMTAB_SECTION].name = add_string(&section_strings, ".symtab");
+        headers[SYMTAB_SECTION].type = SHT_SYMTAB;
+        headers[SYMTAB_SECTION].link = STRTAB_SECTION;
+        headers[SYMTAB_SECTION].info = first_global;
+        headers[SYMTAB_SECTION].alignment = 8;
+        headers[SYMTAB_SECTION].entry_size = sizeof(ElfSymbol);
+        result = write_padding(fptr, &offset, 8);
+        headers[SYMTAB_SECTION].offset = offset;
+        headers[SYMTAB_SECTION].size = symbol_count * sizeof(ElfSymbol);
+        result = result && write_block(fptr, &offset, symbols, headers[SYMTAB_SECTION].size);
+        headers[STRTAB_SECTION].name = add_string(&section_strings, ".strtab");
+        headers[STRTAB_SECTION].type = SHT_STRTAB;
+        headers[STRTAB_SECTION].alignment = 1;
+        headers[STRTAB_SECTION].offset = offset;
+        headers[STRTAB_SECTION].size = strings.size;
+        result = result && write_block(fptr, &offset, strings.text, strings.size);
+        headers[SHSTRTAB_SECTION].name = add_string(&section_strings, ".shstrtab");
+        headers[SHSTRTAB_SECTION].type = SHT_STRTAB;
+        headers[SHSTRTAB_SECTION].alignment = 1;
+        headers[SHSTRTAB_SECTION].offset = offset;
+        headers[SHSTRTAB_SECTION].size = section_strings.size;
+        result = result && headers[NOTE_SECTION].name != 0 && headers[SYMTAB_SECTION].name != 0
+                 && headers[STRTAB_SECTION].name != 0 && headers[SHSTRTAB_SECTION].name != 0
+                 && write_block(fptr, &offset, section_strings.text, section_strings.size) && write_padding(fptr, &offset, 8);
+        header.section_header_offset = offset;
+        result = result && write_block(fptr, &offset, headers, sizeof(headers)) && fseek(fptr, 0, SEEK_SET) == 0
+                 && fwrite(&header, sizeof(header), 1, fptr) == 1;
+        if (!result)
+            fprintf(ctx->log_fptr, "Error: failed to write the object file\n");
+    }
+    for (int s = 0; s < SECTION_COUNT; s++)
+        free(relocations[s]);
+    free(strings.text);
+    free(section_strings.text);
+    free(symbols);
+    free(indexes);
+    return result;
+}
+
+int write_executable(CompilerContext *ctx, Assembly *as, FILE *fptr) {
+    // Text and read-only data share the first segment after the headers, the data starts on the next page and the
+    // zeroed data follows it in memory only
+    uint64_t offsets[SECTION_COUNT];
+    size_t header_size = sizeof(ElfHeader) + 3 * sizeof(ElfProgramHeader);
+    offsets[TEXT_SECTION] = align_to(header_size, as->sections[TEXT_SECTION].alignment);
+    offsets[RODATA_SECTION] = align_to(offsets[TEXT_SECTION] + as->sections[TEXT_SECTION].size,
+                                       as->sections[RODATA_SECTION].alignment);
+    uint64_t code_end = offsets[RODATA_SECTION] + as->sections[RODATA_SECTION].size;
+    offsets[DATA_SECTION] = align_to(code_end, ELF_PAGE_SIZE);
+    offsets[BSS_SECTION] = align_to(offsets[DATA_SECTION] + as->sections[DATA_SECTION].size, as->sections[BSS_SECTION].alignment);
+
+    for (int s = 0; s < SECTION_COUNT; s++) {
+        AsmSection *section = &as->sections[s];
+        for (int r = 0; r < section->relocation_count; r++) {
+            const AsmRelocation *relocation = &section->relocations[r];
+            const AsmSymbol *symb = &as->symbols[relocation->symbol];
+            if (symb->section < 0) {
+                fprintf(ctx->log_fptr, "Error: undefined symbol \"%s\" in the static executable\n", symb->name);
+                return 0;
+            }
+            uint64_t target = EXECUTABLE_BASE + offsets[symb->section] + symb->offset + relocation->addend;
+            uint64_t place = EXECUTABLE_BASE + offsets[s] + relocation->offset;
+            uint64_t value = relocation->kind == RELOCATION_64 ? target : target - place;
+            int size = relocation->kind == RELOCATION_64 ? 8 : 4;
+            if (size == 4 && ((int64_t) value < INT32_MIN || (int64_t) value > INT32_MAX)) {
+                fprintf(ctx->log_fptr, "Error: relocation to \"%s\" out of range in the static executable\n", symb->name);
+                return 0;
+            }
+            for (int n = 0; n < size; n++)
+                section->bytes[relocation->offset + n] = (value >> (8 * n)) & 0xff;
+        }
+    }
+    int start = find_symbol(as, "_start");
+    if (start < 0 || as->symbols[start].section != TEXT_SECTION) {
+        fprintf(ctx->log_fptr, "Error: the static executable has no entry point\n");
+        return 0;
+    }
+
+    ElfHeader header;
+    init_elf_header(&header, ET_EXEC);
+    header.entry = EXECUTABLE_BASE + offsets[TEXT_SECTION] + as->symbols[start].offset;
+    header.program_header_offset = sizeof(ElfHeader);
+    header.program_header_size = sizeof(ElfProgramHeader);
+    header.program_header_count = 3;
+    ElfProgramHeader segments[3];
+    memset(segments, 0, sizeof(segments));
+    segments[0].type = PT_LOAD;
+    segments[0].flags = PF_R | PF_X;
+    segments[0].address = segments[0].physical_address = EXECUTABLE_BASE;
+    segments[0].file_size = segments[0].memory_size = code_end;
+    segments[0].alignment = ELF_PAGE_SIZE;
+    segments[1].type = PT_LOAD;
+    segments[1].flags = PF_R | PF_W;
+    segments[1].offset = offsets[DATA_SECTION];
+    segments[1].address = segments[1].physical_address = EXECUTABLE_BASE + offsets[DATA_SECTION];
+    segments[1].file_size = as->sections[DATA_SECTION].size;
+    segments[1].memory_size = offsets[BSS_SECTION] + as->sections[BSS_SECTION].size - offsets[DATA_SECTION];
+    segments[1].alignment = ELF_PAGE_SIZE;
+    segments[2].type = PT_GNU_STACK;
+    segments[2].flags = PF_R | PF_W;
+    segments[2].alignment = 16;
+
+    size_t offset = 0;
+    int result = write_block(fptr, &offset, &header, sizeof(header)) && write_block(fptr, &offset, segments, sizeof(segments));
+    const int order[] = { TEXT_SECTION, RODATA_SECTION, DATA_SECTION };
+    for (int n = 0; result && n < 3; n++) {
+        const AsmSection *section = &as->sections[order[n]];
+        while (result && offset < offsets[order[n]])
+            result = write_block(fptr, &offset, "", 1);
+        result = result && write_block(fptr, &offset, section->bytes, section->size);
+    }
+    if (!result)
+        fprintf(ctx->log_fptr, "Error: failed to write the static executable\n");
+    return result;
+}
+
+int write_binary_files(CompilerContext *ctx, const char *source_path, Assembler *object, Assembler *executable) {
+    // Finishes the assemblies the program was fed to into <source>.o (-c) and the executable <source> (-static), the
+    // runtime is added to the second one; both assemblers are freed, either can be NULL
+    Assembly *object_as = object != NULL ? finish_assembly(object) : NULL;
+    int result = object == NULL || object_as != NULL;
+    if (result && object != NULL) {
+        FILE *object_fptr = open_output_file(ctx, source_path, ".o");
+        result = object_fptr != NULL && write_object_file(ctx, object_as, object_fptr);
+        if (object_fptr != NULL)
+            fclose(object_fptr);
+    }
+    free_assembly(object_as);
+    if (executable == NULL)
+        return result;
+    if (result) // The runtime comes after the program, in the same assembly
+        assemble_part(executable, runtime_assembly, strlen(runtime_assembly));
+    Assembly *as = finish_assembly(executable);
+    if (result && as != NULL) {
+        FILE *executable_fptr = open_output_file(ctx, source_path, executable_extension(source_path));
+        result = executable_fptr != NULL && write_executable(ctx, as, executable_fptr);
+#ifndef _WIN32
+        if (result && fchmod(fileno(executable_fptr), 0755) != 0) {
+            fprintf(ctx->log_fptr, "Error: failed to make the static executable runnable\n");
+            result = 0;
+        }
+#endif
+        if (executable_fptr != NULL)
+            fclose(executable_fptr);
+    }
+    else
+        result = 0;
+    free_assembly(as);
+    return result;
+}
@@ -0,0 +1,54 @@
+#ifndef ELF_WRITER_H
+#define ELF_WRITER_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "compiler_context.h"
+#include "assembler.h"
+
+// ELF64 output of the built-in assembler: relocatable objects (-c) for the system linker, and static executables
+// (-static) linked here with the bundled runtime so that no external tool runs at all.
+
+#define EXECUTABLE_BASE 0x400000
+#define ELF_PAGE_SIZE 0x1000
+
+typedef struct _ElfHeader {
+    uint8_t ident[16];
+    uint16_t type, machine;
+    uint32_t version;
+    uint64_t entry, program_header_offset, section_header_offset;
+    uint32_t flags;
+    uint16_t header_size, program_header_size, program_header_count;
+    uint16_t section_header_size, section_header_count, section_name_index;
+} ElfHeader;
+
+typedef struct _ElfSectionHeader {
+    uint32_t name, type;
+    uint64_t flags, address, offset, size;
+    uint32_t link, info;
+    uint64_t alignment, entry_size;
+} ElfSectionHeader;
+
+typedef struct _ElfProgramHeader {
+    uint32_t type, flags;
+    uint64_t offset, address, physical_address, file_size, memory_size, alignment;
+} ElfProgramHeader;
+
+typedef struct _ElfSymbol {
+    uint32_t name;
+    uint8_t info, other;
+    uint16_t section;
+    uint64_t value, size;
+} ElfSymbol;
+
+typedef struct _ElfRelocation {
+    uint64_t offset, info;
+    int64_t addend;
+} ElfRelocation;
+
+int write_object_file(CompilerContext *, const Assembly *, FILE *);
+int write_executable(CompilerContext *, Assembly *, FILE *);
+int write_binary_files(CompilerContext *, const char *, Assembler *, Assembler *);
+
+#endif
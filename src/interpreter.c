@@ -0,0 +1,845 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "scanner.h"
+#include "symbol_table.h"
+#include "tac.h"
+#include "tac_array.h"
+#include "control_flow.h"
+#include "ssa.h"
+#include "compiler_context.h"
+#include "code_generator.h"
+#include "interpreter.h"
+#include "bytecode.h"
+#include "write_format.h"
+#include "read_format.h"
+
+#define UNSET_SLOT -1
+#define MAX_LOOP_SINK 8 // Instructions a loop counter increment can move past to reach the jump back to the loop test
+
+typedef struct _Decoder {
+    CompilerContext *ctx;
+    const TacArray *code;
+    Program *program;
+    int *symbol_slots; // Operand of each symbol once it has a slot, the symbols of a routine are only used in it
+    int *temp_slots;
+    int *temp_uses; // Instructions reading each temporary
+    int *label_targets; // Instruction of each label
+    int *routine_entries; // First instruction of each routine, by the index of its symbol
+    const ParamType *params; // Parameters of the routine being decoded
+    int param_count;
+    int frame_size;
+    int *frame_fixups; // Arguments and calls of the routine, they need its final frame size
+    int fixup_count, fixup_capacity;
+    int no_width_slot, no_precision_slot; // Literals written for the width and the decimals that aren't given
+} Decoder;
+
+char empty_string[] = "";
+
+int push_instruction(Decoder *dec, Opcode opcode, int a, int b, int c) { // Returns the index of the instruction, -1 on failure
+    Program *program = dec->program;
+    if (program->instruction_count >= program->instruction_capacity) {
+        int capacity = program->instruction_capacity == 0 ? 256 : program->instruction_capacity * 2;
+        Instruction *instructions = realloc(program->instructions, capacity * sizeof(Instruction));
+        if (instructions == NULL) {
+            fprintf(dec->ctx->log_fptr, "Error: failed to reallocate more memory to the decoded instructions\n");
+            return -1;
+        }
+        program->instructions = instructions;
+        program->instruction_capacity = capacity;
+    }
+    Instruction *instruction = &program->instructions[program->instruction_count];
+    instruction->handler = NULL;
+    instruction->opcode = opcode;
+    instruction->a = a;
+    instruction->b = b;
+    instruction->c = c;
+    return program->instruction_count++;
+}
+
+int push_static(Decoder *dec, Value value, ValueClass class) { // Returns the operand of the new static slot
+    Program *program = dec->program;
+    if (program->static_count >= program->static_capacity) {
+        int capacity = program->static_capacity == 0 ? 64 : program->static_capacity * 2;
+        Value *statics = realloc(program->statics, capacity * sizeof(Value));
+        if (statics != NULL)
+            program->statics = statics;
+        uint8_t *classes = realloc(program->static_classes, capacity * sizeof(uint8_t));
+        if (classes != NULL)
+            program->static_classes = classes;
+        if (statics == NULL || classes == NULL) {
+            fprintf(dec->ctx->log_fptr, "Error: failed to reallocate more memory to the static values\n");
+            return slot_operand(STATIC_BASE, 0);
+        }
+        program->static_capacity = capacity;
+    }
+    program->statics[program->static_count] = value;
+    program->static_classes[program->static_count] = class;
+    return slot_operand(STATIC_BASE, program->static_count++);
+}
+
+int add_frame_fixup(Decoder *dec, int instruction) {
+    if (dec->fixup_count >= dec->fixup_capacity) {
+        int capacity = dec->fixup_capacity == 0 ? 64 : dec->fixup_capacity * 2;
+        int *fixups = realloc(dec->frame_fixups, capacity * sizeof(int));
+        if (fixups == NULL) {
+            fprintf(dec->ctx->log_fptr, "Error: failed to reallocate more memory to the frame fixups\n");
+            return 0;
+        }
+        dec->frame_fixups = fixups;
+        dec->fixup_capacity = capacity;
+    }
+    dec->frame_fixups[dec->fixup_count++] = instruction;
+    return 1;
+}
+
+int decode_slot(Decoder *dec, Operand operand, int *by_reference) {
+    // Slot operand of a variable, temporary or literal, the slot of a parameter passed by reference holds its address
+    *by_reference = 0;
+    if (operand_kind(operand) == TEMP_OPERAND) {
+        int *slot = &dec->temp_slots[operand_index(operand)];
+        if (*slot == UNSET_SLOT)
+            *slot = slot_operand(FRAME_BASE, dec->frame_size++);
+        return *slot;
+    }
+    const Symbol *symb = operand_symbol(dec->code, operand);
+    int *slot = &dec->symbol_slots[operand_index(operand)];
+    int index = 0;
+    for (const ParamType *param = dec->params; param != NULL; param = param->next, index++) {
+        if (param->param_symbol == symb) {
+            *by_reference = param->ref_pass;
+            return slot_operand(FRAME_BASE, index);
+        }
+    }
+    if (*slot != UNSET_SLOT)
+        return *slot;
+    Value value;
+    value.p = NULL;
+    if (is_constant_symbol(symb) || symbol_builtin_lookup(symb->name) == symb) {
+        TokenType type = value_type(symb->token_type);
+        if (type == REAL_TOKEN)
+            value.f = symb->values->f;
+        else if (type == STRING_TOKEN)
+            value.s = symb->values->str;
+        else if (type == CHAR_TOKEN)
+            value.i = (unsigned char) symb->values->c;
+        else
+            value.i = symb->values->i;
+        *slot = push_static(dec, value, value_class(type));
+    }
+    else // Local variables and function results, the global variables got their slots first
+        *slot = slot_operand(FRAME_BASE, dec->frame_size++);
+    return *slot;
+}
+
+int load_slot(Decoder *dec, Operand operand, ValueClass class, int scratch) {
+    // Slot holding the value of the operand as the class, through a scratch slot when it is converted or passed by reference
+    int by_reference;
+    int slot = decode_slot(dec, operand, &by_reference);
+    int scratch_slot = slot_operand(FRAME_BASE, dec->param_count + scratch);
+    if (by_reference) {
+        push_instruction(dec, OP_LOAD_REF, scratch_slot, slot, 0);
+        slot = scratch_slot;
+    }
+    TokenType type = operand_type(dec->code, operand);
+    if (class == REAL_VALUE && value_class(type) == INT_VALUE)
+        push_instruction(dec, OP_I2F, scratch_slot, slot, 0);
+    else if (class == INT_VALUE && value_class(type) == REAL_VALUE)
+        push_instruction(dec, OP_F2I, scratch_slot, slot, 0);
+    else if (class == STRING_VALUE && type == CHAR_TOKEN)
+        push_instruction(dec, OP_C2S, scratch_slot, slot, 0);
+    else
+        return slot;
+    return scratch_slot;
+}
+
+int store_slot(Decoder *dec, Operand operand, int *reference) {
+    // Slot an instruction writes, a parameter passed by reference is written through the last scratch slot
+    int slot = decode_slot(dec, operand, reference);
+    if (!*reference) {
+        *reference = -1;
+        return slot;
+    }
+    *reference = slot;
+    return slot_operand(FRAME_BASE, dec->param_count + SCRATCH_COUNT - 1);
+}
+
+void finish_store(Decoder *dec, int reference) {
+    if (reference >= 0)
+        push_instruction(dec, OP_STORE_REF, reference, slot_operand(FRAME_BASE, dec->param_count + SCRATCH_COUNT - 1), 0);
+}
+
+int is_int_literal(const Decoder *dec, Operand operand) {
+    const Symbol *symb = operand_symbol(dec->code, operand);
+    return is_constant_symbol(symb) && value_type(symb->token_type) == INT_TOKEN;
+}
+
+void decode_operation(Decoder *dec, int index) { // Arithmetic, comparisons and logic
+    const TacArray *code = dec->code;
+    TacOp op = code->ops[index];
+    Operand a = code->a[index], b = code->b[index], c = code->c[index];
+    ValueClass class = value_class(operand_type(code, a));
+    Opcode opcode;
+    if (op >= TAC_LT && op <= TAC_EQ) { // Strings compare as strings, any real makes a real comparison
+        ValueClass class_b = value_class(operand_type(code, b)), class_c = value_class(operand_type(code, c));
+        class = class_b == STRING_VALUE || class_c == STRING_VALUE ? STRING_VALUE
+              : class_b == REAL_VALUE || class_c == REAL_VALUE ? REAL_VALUE : INT_VALUE;
+        opcode = (class == STRING_VALUE ? OP_LT_S : class == REAL_VALUE ? OP_LT_F : OP_LT_I) + (op - TAC_LT);
+    }
+    else if (op == TAC_AND || op == TAC_OR) {
+        class = INT_VALUE;
+        opcode = op == TAC_AND ? OP_AND : OP_OR;
+    }
+    else if (class == STRING_VALUE)
+        opcode = OP_CONCAT;
+    else if (op == TAC_MOD)
+        opcode = OP_MOD_I;
+    else
+        opcode = (class == REAL_VALUE ? OP_ADD_F : OP_ADD_I) + (op - TAC_ADD);
+    if (opcode == OP_ADD_I && is_int_literal(dec, b) && !is_int_literal(dec, c)) { // Literal on the right for add-immediate
+        Operand operand = b;
+        b = c;
+        c = operand;
+    }
+    if ((opcode == OP_ADD_I || opcode == OP_SUB_I) && is_int_literal(dec, c)) {
+        int value = operand_symbol(dec->code, c)->values->i;
+        int slot_b = load_slot(dec, b, class, 0);
+        int reference;
+        int slot_a = store_slot(dec, a, &reference);
+        push_instruction(dec, OP_ADDI, slot_a, slot_b, op == TAC_SUB ? -value : value);
+        finish_store(dec, reference);
+        return;
+    }
+    int slot_b = load_slot(dec, b, class, 0);
+    int slot_c = load_slot(dec, c, class, 1);
+    int reference;
+    int slot_a = store_slot(dec, a, &reference);
+    push_instruction(dec, opcode, slot_a, slot_b, slot_c);
+    finish_store(dec, reference);
+}
+
+void decode_unary(Decoder *dec, int index) { // Negation, not and copies
+    const TacArray *code = dec->code;
+    TacOp op = code->ops[index];
+    Operand a = code->a[index];
+    ValueClass class = op == TAC_NOT ? INT_VALUE : value_class(operand_type(code, a));
+    int slot_b = load_slot(dec, code->b[index], class, 0);
+    int reference;
+    int slot_a = store_slot(dec, a, &reference);
+    Opcode opcode = op == TAC_NOT ? OP_NOT : op == TAC_NEG ? (class == REAL_VALUE ? OP_NEG_F : OP_NEG_I) : OP_COPY;
+    push_instruction(dec, opcode, slot_a, slot_b, 0);
+    finish_store(dec, reference);
+}
+
+int fuse_branch(Decoder *dec, int index) {
+    // An integer comparison only read by the conditional jump right after it becomes a compare and branch
+    const int inverse_conditions[] = { 4, 3, 5, 1, 0, 2 }; // LT GT NEQ LTE GTE EQ to GTE LTE EQ GT LT NEQ
+    const TacArray *code = dec->code;
+    Program *program = dec->program;
+    Operand b = code->b[index];
+    if (index == 0 || operand_kind(b) != TEMP_OPERAND || dec->temp_uses[operand_index(b)] != 1 || code->a[index - 1] != b
+        || code->ops[index - 1] < TAC_LT || code->ops[index - 1] > TAC_EQ || program->instruction_count == 0)
+        return 0;
+    Instruction *last = &program->instructions[program->instruction_count - 1];
+    if (last->opcode < OP_LT_I || last->opcode > OP_EQ_I || last->a != dec->temp_slots[operand_index(b)])
+        return 0;
+    int condition = last->opcode - OP_LT_I;
+    last->opcode = OP_JLT_I + (code->ops[index] == TAC_IFZ ? inverse_conditions[condition] : condition);
+    last->a = operand_index(code->a[index]);
+    return 1;
+}
+
+int write_option_slot(Decoder *dec, Operand operand, int *absent_slot, int absent, int scratch) {
+    // Slot of the width or the decimals of a written value, a shared literal when they aren't given
+    if (operand != NO_OPERAND)
+        return load_slot(dec, operand, INT_VALUE, scratch);
+    if (*absent_slot == UNSET_SLOT) {
+        Value value;
+        value.p = NULL;
+        value.i = absent;
+        *absent_slot = push_static(dec, value, INT_VALUE);
+    }
+    return *absent_slot;
+}
+
+void decode_print(Decoder *dec, int index) { // The value in a, its width in b and the decimals of a real in c
+    const TacArray *code = dec->code;
+    TokenType type = operand_type(code, code->a[index]);
+    Opcode opcode = type == REAL_TOKEN ? OP_PRINT_F : type == STRING_TOKEN ? OP_PRINT_S : type == CHAR_TOKEN ? OP_PRINT_C
+                  : type == BOOL_TOKEN ? OP_PRINT_B : OP_PRINT_I;
+    int value = load_slot(dec, code->a[index], value_class(type), 0);
+    int width = write_option_slot(dec, code->b[index], &dec->no_width_slot, 0, 1);
+    int precision = write_option_slot(dec, code->c[index], &dec->no_precision_slot, NO_WRITE_PRECISION, 2);
+    push_instruction(dec, opcode, value, width, type == REAL_TOKEN ? precision : 0);
+}
+
+void decode_read(Decoder *dec, int index) { // The variable read in a
+    const TacArray *code = dec->code;
+    TokenType type = operand_type(code, code->a[index]);
+    int reference;
+    int slot = store_slot(dec, code->a[index], &reference);
+    push_instruction(dec, type == REAL_TOKEN ? OP_READ_F : type == STRING_TOKEN ? OP_READ_S : type == CHAR_TOKEN ? OP_READ_C : OP_READ_I,
+        slot, 0, 0);
+    finish_store(dec, reference);
+}
+
+void decode_arg(Decoder *dec, int index) { // Written in the frame of the call, fixed up once the frame size is known
+    const TacArray *code = dec->code;
+    const ParamType *param = arg_param(code, index);
+    int position = 0;
+    for (int i = index - 1; i >= 0 && code->ops[i] == TAC_ARG; i--)
+        position++;
+    int instruction;
+    if (param != NULL && param->ref_pass) {
+        int by_reference;
+        int slot = decode_slot(dec, code->a[index], &by_reference);
+        instruction = push_instruction(dec, by_reference ? OP_ARG : OP_ARG_REF, slot, position, 0);
+    }
+    else {
+        ValueClass class = value_class(param != NULL ? value_type(param->param_symbol->token_type) : operand_type(code, code->a[index]));
+        instruction = push_instruction(dec, OP_ARG, load_slot(dec, code->a[index], class, 0), position, 0);
+    }
+    if (instruction >= 0)
+        add_frame_fixup(dec, instruction);
+}
+
+int decode_routine(Decoder *dec, int start, int end) {
+    const TacArray *code = dec->code;
+    const Symbol *routine = operand_symbol(code, code->a[start]);
+    dec->params = routine != NULL ? routine->param_list : NULL;
+    dec->param_count = 0;
+    for (const ParamType *param = dec->params; param != NULL; param = param->next)
+        dec->param_count++;
+    dec->frame_size = dec->param_count + SCRATCH_COUNT;
+    dec->fixup_count = 0;
+    int enter = push_instruction(dec, OP_ENTER, 0, 0, 0);
+    if (enter < 0)
+        return 0;
+    if (routine != NULL)
+        dec->routine_entries[operand_index(code->a[start])] = enter;
+    else
+        dec->program->entry = enter;
+    for (int i = start + 1; i <= end; i++) {
+        switch (code->ops[i]) {
+            case TAC_ADD: case TAC_SUB: case TAC_MULT: case TAC_DIV: case TAC_MOD: case TAC_AND: case TAC_OR:
+            case TAC_LT: case TAC_GT: case TAC_NEQ: case TAC_LTE: case TAC_GTE: case TAC_EQ: {
+                decode_operation(dec, i);
+                break;
+            }
+            case TAC_POS: case TAC_NEG: case TAC_NOT: case TAC_CPY: {
+                decode_unary(dec, i);
+                break;
+            }
+            case TAC_GOTO: { // Jumps hold label indexes until every label has its instruction
+                push_instruction(dec, OP_GOTO, operand_index(code->a[i]), 0, 0);
+                break;
+            }
+            case TAC_IFZ: case TAC_IFNZ: {
+                if (fuse_branch(dec, i))
+                    break;
+                int slot = load_slot(dec, code->b[i], INT_VALUE, 0);
+                push_instruction(dec, code->ops[i] == TAC_IFZ ? OP_IFZ : OP_IFNZ, operand_index(code->a[i]), slot, 0);
+                break;
+            }
+            case TAC_LABEL: {
+                dec->label_targets[operand_index(code->a[i])] = dec->program->instruction_count;
+                break;
+            }
+            case TAC_PRINT: {
+                decode_print(dec, i);
+                break;
+            }
+            case TAC_PRINTLN: {
+                push_instruction(dec, OP_PRINTLN, 0, 0, 0);
+                break;
+            }
+            case TAC_READ: {
+                decode_read(dec, i);
+                break;
+            }
+            case TAC_READLN: {
+                push_instruction(dec, OP_READLN, 0, 0, 0);
+                break;
+            }
+            case TAC_ARG: {
+                decode_arg(dec, i);
+                break;
+            }
+            case TAC_CALL: { // The callee is found by its symbol once every routine has its entry
+                int by_reference;
+                int slot = code->a[i] != NO_OPERAND ? decode_slot(dec, code->a[i], &by_reference) : -1;
+                int instruction = push_instruction(dec, OP_CALL, slot, operand_index(code->b[i]), 0);
+                if (instruction >= 0)
+                    add_frame_fixup(dec, instruction);
+                break;
+            }
+            case TAC_ENDFUNC: {
+                push_instruction(dec, OP_RET, load_slot(dec, code->a[i], value_class(operand_type(code, code->a[i])), 0), 0, 0);
+                break;
+            }
+            case TAC_ENDPROC: {
+                push_instruction(dec, OP_RET_VOID, 0, 0, 0);
+                break;
+            }
+            case TAC_ENDPROG: {
+                push_instruction(dec, OP_HALT, 0, 0, 0);
+                break;
+            }
+            default: {
+                break;
+            }
+        }
+    }
+    Instruction *instructions = dec->program->instructions;
+    instructions[enter].a = dec->frame_size;
+    for (int f = 0; f < dec->fixup_count; f++) {
+        Instruction *instruction = &instructions[dec->frame_fixups[f]];
+        if (instruction->opcode == OP_ARG || instruction->opcode == OP_ARG_REF) {
+            instruction->b += dec->frame_size;
+            if (instruction->b >= instructions[enter].a) // The arguments are written before the callee checks its frame
+                instructions[enter].a = instruction->b + 1;
+        }
+        else
+            instruction->c = dec->frame_size;
+    }
+    return 1;
+}
+
+int is_jump_opcode(int opcode) {
+    return opcode == OP_GOTO || opcode == OP_IFZ || opcode == OP_IFNZ || (opcode >= OP_JLT_I && opcode <= OP_JEQ_I);
+}
+
+int is_movable_opcode(int opcode) { // Instructions that never fail nor jump, a loop counter increment can move past them
+    return (opcode >= OP_ADD_I && opcode <= OP_MUL_I) || (opcode >= OP_ADD_F && opcode <= OP_DIV_F) || (opcode >= OP_LT_I && opcode <= OP_EQ_F)
+           || (opcode >= OP_AND && opcode <= OP_F2I) || opcode == OP_ADDI;
+}
+
+int reads_or_writes(const Instruction *instruction, int slot) {
+    int binary = instruction->opcode != OP_ADDI && instruction->opcode != OP_NOT && instruction->opcode != OP_NEG_I
+                 && instruction->opcode != OP_NEG_F && instruction->opcode != OP_COPY && instruction->opcode != OP_I2F
+                 && instruction->opcode != OP_F2I;
+    return instruction->a == slot || instruction->b == slot || (binary && instruction->c == slot);
+}
+
+int fuse_loops(CompilerContext *ctx, Program *program) {
+    // The increment of a for loop counter followed by the jump back to the loop test becomes an increment-and-loop. The
+    // increment may first move down past a few instructions that don't touch the counter and aren't jump targets.
+    Instruction *instructions = program->instructions;
+    uint8_t *targets = calloc(program->instruction_count + 1, sizeof(uint8_t));
+    if (targets == NULL) {
+        fprintf(ctx->log_fptr, "Error: failed to allocate memory for the jump targets\n");
+        return 0;
+    }
+    for (int n = 0; n < program->instruction_count; n++) {
+        if (is_jump_opcode(instructions[n].opcode))
+            targets[instructions[n].a] = 1;
+        else if (instructions[n].opcode == OP_CALL)
+            targets[n + 1] = 1; // Return address
+    }
+    for (int k = 1; k < program->instruction_count; k++) {
+        const Instruction *test = &instructions[instructions[k].a];
+        if (instructions[k].opcode != OP_GOTO || (test->opcode != OP_JGT_I && test->opcode != OP_JLT_I))
+            continue;
+        int step = test->opcode == OP_JGT_I ? 1 : -1, counter = test->b;
+        int p = k - 1;
+        for (; p >= 0 && p >= k - MAX_LOOP_SINK; p--) {
+            const Instruction *instruction = &instructions[p];
+            if (instruction->opcode == OP_ADDI && instruction->a == counter && instruction->b == counter && instruction->c == step)
+                break;
+            if (!is_movable_opcode(instruction->opcode) || reads_or_writes(instruction, counter) || targets[p])
+                p = -1;
+        }
+        if (p < 0 || p < k - MAX_LOOP_SINK)
+            continue;
+        Instruction increment = instructions[p];
+        memmove(&instructions[p], &instructions[p + 1], (k - 1 - p) * sizeof(Instruction));
+        increment.opcode = step > 0 ? OP_INC_LOOP : OP_DEC_LOOP;
+        increment.b = test->c;
+        increment.c = instructions[k].a;
+        instructions[k - 1] = increment;
+    }
+    free(targets);
+    return 1;
+}
+
+Program* decode_program(CompilerContext *ctx, const TacArray *code) {
+    Program *program = malloc(sizeof(Program));
+    if (program == NULL) {
+        fprintf(ctx->log_fptr, "Error: failed to allocate memory for the decoded program\n");
+        return NULL;
+    }
+    program->instructions = NULL;
+    program->statics = NULL;
+    program->static_classes = NULL;
+    program->mapping = NULL;
+    program->mapping_size = 0;
+    program->instruction_count = program->instruction_capacity = program->static_count = program->static_capacity = 0;
+    program->entry = -1;
+    Decoder dec;
+    dec.ctx = ctx;
+    dec.code = code;
+    dec.program = program;
+    dec.symbol_slots = malloc((code->symbol_count + 1) * sizeof(int));
+    dec.temp_slots = malloc((code->temp_count + 1) * sizeof(int));
+    dec.label_targets = malloc((code->label_count + 1) * sizeof(int));
+    dec.routine_entries = malloc((code->symbol_count + 1) * sizeof(int));
+    dec.temp_uses = calloc(code->temp_count + 1, sizeof(int));
+    dec.frame_fixups = NULL;
+    dec.fixup_count = dec.fixup_capacity = 0;
+    dec.no_width_slot = dec.no_precision_slot = UNSET_SLOT;
+    int result = dec.symbol_slots != NULL && dec.temp_slots != NULL && dec.label_targets != NULL && dec.routine_entries != NULL
+                 && dec.temp_uses != NULL;
+    if (!result)
+        fprintf(ctx->log_fptr, "Error: failed to allocate memory for the program decoder\n");
+    for (int s = 0; result && s < code->symbol_count; s++)
+        dec.symbol_slots[s] = dec.routine_entries[s] = UNSET_SLOT;
+    for (int t = 0; result && t < code->temp_count; t++)
+        dec.temp_slots[t] = UNSET_SLOT;
+    for (int n = 0; result && n < code->tac_count; n++) {
+        Operand *slots[MAX_USED_OPERANDS];
+        int count = used_operands((TacArray *) code, n, slots);
+        for (int u = 0; u < count; u++) {
+            if (operand_kind(*slots[u]) == TEMP_OPERAND)
+                dec.temp_uses[operand_index(*slots[u])]++;
+        }
+    }
+
+    // Global variables come first in the static area, strings start empty
+    int i = 0;
+    for (; result && i < code->tac_count && code->ops[i] != TAC_BEGINFUNC && code->ops[i] != TAC_BEGINPROC && code->ops[i] != TAC_BEGINPROG; i++) {
+        if (code->ops[i] == TAC_VAR) {
+            Value value;
+            value.p = NULL;
+            if (operand_type(code, code->a[i]) == STRING_TOKEN)
+                value.s = empty_string;
+            dec.symbol_slots[operand_index(code->a[i])] = push_static(&dec, value, value_class(operand_type(code, code->a[i])));
+        }
+    }
+    int start, end;
+    for (int from = i; result && next_routine(code, from, &start, &end); from = end + 1)
+        result = decode_routine(&dec, start, end);
+
+    // Jumps and calls get their target instructions
+    for (int n = 0; result && n < program->instruction_count; n++) {
+        Instruction *instruction = &program->instructions[n];
+        if (is_jump_opcode(instruction->opcode))
+            instruction->a = dec.label_targets[instruction->a];
+        else if (instruction->opcode == OP_CALL && (instruction->b = dec.routine_entries[instruction->b]) < 0) {
+            fprintf(ctx->log_fptr, "Error: call to a routine that has no code\n");
+            result = 0;
+        }
+    }
+    if (result && program->entry < 0) {
+        fprintf(ctx->log_fptr, "Error: the program has no main block to run\n");
+        result = 0;
+    }
+    if (result)
+        result = fuse_loops(ctx, program);
+    free(dec.symbol_slots);
+    free(dec.temp_slots);
+    free(dec.label_targets);
+    free(dec.routine_entries);
+    free(dec.temp_uses);
+    free(dec.frame_fixups);
+    if (!result) {
+        free_program(program);
+        return NULL;
+    }
+    return program;
+}
+
+void free_program(Program *program) {
+    if (program != NULL) {
+        if (program->mapping != NULL)
+            unmap_bytecode(program->mapping, program->mapping_size);
+        else {
+            free(program->instructions);
+            free(program->statics);
+            free(program->static_classes);
+        }
+        free(program);
+    }
+}
+
+typedef struct _CallRecord {
+    const Instruction *return_pc; // Instruction after the call, the call itself gives the destination of the result
+    Value *frame;
+} CallRecord;
+
+void init_strings(StringHeap *heap, const Value *statics, int static_count, const Value *stack, Value *const *stack_top) {
+    memset(heap, 0, sizeof(*heap));
+    heap->limit = MIN_STRING_LIMIT;
+    heap->statics = statics;
+    heap->static_count = static_count;
+    heap->stack = stack;
+    heap->stack_top = stack_top;
+}
+
+int compare_addresses(const void *p1, const void *p2) {
+    uintptr_t address_1 = (uintptr_t) *(char *const *) p1, address_2 = (uintptr_t) *(char *const *) p2;
+    return (address_1 > address_2) - (address_1 < address_2);
+}
+
+void mark_strings(StringHeap *heap, const Value *slot, const Value *end) {
+    // Sets the low bit of the strings the slots point to (sorted, malloc aligns them), an integer or a real that looks
+    // like the address of a string only keeps it until the next collection
+    uintptr_t lowest = (uintptr_t) heap->strings[0] & ~(uintptr_t) 1;
+    uintptr_t highest = (uintptr_t) heap->strings[heap->count - 1] & ~(uintptr_t) 1;
+    for (; slot < end; slot++) {
+        uintptr_t address = (uintptr_t) slot->s;
+        if (address < lowest || address > highest)
+            continue;
+        int low = 0, high = heap->count - 1;
+        while (low <= high) {
+            int middle = (low + high) / 2;
+            uintptr_t string = (uintptr_t) heap->strings[middle] & ~(uintptr_t) 1;
+            if (string == address) {
+                heap->strings[middle] = (char *) (string | 1);
+                break;
+            }
+            if (string < address)
+                low = middle + 1;
+            else
+                high = middle - 1;
+        }
+    }
+}
+
+void collect_strings(StringHeap *heap) { // Frees the strings no static or stack slot points to
+    if (heap->count == 0)
+        return;
+    qsort(heap->strings, heap->count, sizeof(char *), compare_addresses);
+    mark_strings(heap, heap->statics, heap->statics + heap->static_count);
+    mark_strings(heap, heap->stack, *heap->stack_top);
+    int kept = 0;
+    heap->size = 0;
+    for (int s = 0; s < heap->count; s++) {
+        uintptr_t address = (uintptr_t) heap->strings[s];
+        if (address & 1) {
+            heap->strings[kept] = (char *) (address & ~(uintptr_t) 1);
+            heap->size += strlen(heap->strings[kept++]) + 1;
+        }
+        else
+            free(heap->strings[s]);
+    }
+    heap->count = kept;
+    // The next collection waits for as many bytes as are kept, or as the slots scanned, so that it stays amortized
+    size_t scanned = (heap->static_count + (*heap->stack_top - heap->stack)) * sizeof(Value);
+    size_t growth = heap->size > scanned ? heap->size : scanned;
+    heap->limit = heap->size + (growth > MIN_STRING_LIMIT ? growth : MIN_STRING_LIMIT);
+}
+
+char* add_heap_string(StringHeap *heap, char *str, size_t size) { // NULL (and freed) on failure
+    if (heap->size + size > heap->limit)
+        collect_strings(heap);
+    if (heap->count >= heap->capacity) {
+        int capacity = heap->capacity == 0 ? 64 : heap->capacity * 2;
+        char **strings = realloc(heap->strings, capacity * sizeof(char *));
+        if (strings == NULL) {
+            free(str);
+            return NULL;
+        }
+        heap->strings = strings;
+        heap->capacity = capacity;
+    }
+    heap->strings[heap->count++] = str;
+    heap->size += size;
+    return str;
+}
+
+char* keep_string(StringHeap *heap, char *str) { // Frees the allocated string with the heap, NULL (and freed) on failure
+    return str == NULL ? NULL : add_heap_string(heap, str, strlen(str) + 1);
+}
+
+char* make_string(StringHeap *heap, const char *s1, const char *s2) { // Joins the two strings in a new one, NULL on failure
+    int length_1 = strlen(s1), length_2 = strlen(s2);
+    char *str = malloc(length_1 + length_2 + 1);
+    if (str == NULL)
+        return NULL;
+    memcpy(str, s1, length_1);
+    memcpy(str + length_1, s2, length_2 + 1);
+    return add_heap_string(heap, str, length_1 + length_2 + 1);
+}
+
+void free_strings(StringHeap *heap) {
+    for (int s = 0; s < heap->count; s++)
+        free(heap->strings[s]);
+    free(heap->strings);
+}
+
+#define VALUE(operand) (bases[(operand) & 1][(operand) >> 1])
+#define OPCODE_HANDLER(op) [op] = &&op##_HANDLER,
+#define DISPATCH() goto *pc->handler
+#define NEXT() do { pc++; DISPATCH(); } while (0)
+#define RUNTIME_ERROR(message) do { error = message; goto runtime_error; } while (0)
+
+int run_program(CompilerContext *ctx, Program *program) {
+    // Direct threaded interpreter, each instruction jumps to the handler of the next one
+    static const void *handlers[OPCODE_COUNT] = { OPCODES(OPCODE_HANDLER) };
+    for (int n = 0; n < program->instruction_count; n++)
+        program->instructions[n].handler = handlers[program->instructions[n].opcode];
+    FILE *out = ctx->log_fptr;
+    InputBuffer in;
+    int input_ready = init_input(&in, 0, out);
+    Value *stack = calloc(STACK_SIZE, sizeof(Value));
+    CallRecord *calls = malloc(MAX_CALL_DEPTH * sizeof(CallRecord));
+    if (stack == NULL || calls == NULL || !input_ready) {
+        fprintf(ctx->log_fptr, "Error: failed to allocate memory for the interpreter stack\n");
+        free(stack);
+        free(calls);
+        free_input(&in);
+        return 0;
+    }
+    Value *stack_top = stack; // End of the highest frame entered, the slots above it were never written
+    StringHeap heap;
+    init_strings(&heap, program->statics, program->static_count, stack, &stack_top);
+    char buffer[2] = { 0, 0 };
+    char text[WRITE_BUFFER_SIZE]; // Formatted numbers
+    const char *error = NULL;
+    int depth = 0, result = 1;
+    Value *bases[2] = { program->statics, stack };
+    const Instruction *instructions = program->instructions;
+    const Instruction *pc = &instructions[program->entry];
+    DISPATCH();
+
+    OP_ADD_I_HANDLER: VALUE(pc->a).i = VALUE(pc->b).i + VALUE(pc->c).i; NEXT();
+    OP_SUB_I_HANDLER: VALUE(pc->a).i = VALUE(pc->b).i - VALUE(pc->c).i; NEXT();
+    OP_MUL_I_HANDLER: VALUE(pc->a).i = VALUE(pc->b).i * VALUE(pc->c).i; NEXT();
+    OP_DIV_I_HANDLER:
+        if (VALUE(pc->c).i == 0)
+            RUNTIME_ERROR("division by zero");
+        if (VALUE(pc->c).i == -1 && VALUE(pc->b).i == INT32_MIN) // Traps like a division by zero on x86-64
+            RUNTIME_ERROR("division overflow");
+        VALUE(pc->a).i = VALUE(pc->b).i / VALUE(pc->c).i;
+        NEXT();
+    OP_MOD_I_HANDLER:
+        if (VALUE(pc->c).i == 0)
+            RUNTIME_ERROR("division by zero");
+        if (VALUE(pc->c).i == -1 && VALUE(pc->b).i == INT32_MIN) // Traps like a division by zero on x86-64
+            RUNTIME_ERROR("division overflow");
+        VALUE(pc->a).i = VALUE(pc->b).i % VALUE(pc->c).i;
+        NEXT();
+    OP_ADD_F_HANDLER: VALUE(pc->a).f = VALUE(pc->b).f + VALUE(pc->c).f; NEXT();
+    OP_SUB_F_HANDLER: VALUE(pc->a).f = VALUE(pc->b).f - VALUE(pc->c).f; NEXT();
+    OP_MUL_F_HANDLER: VALUE(pc->a).f = VALUE(pc->b).f * VALUE(pc->c).f; NEXT();
+    OP_DIV_F_HANDLER: VALUE(pc->a).f = VALUE(pc->b).f / VALUE(pc->c).f; NEXT();
+    OP_CONCAT_HANDLER:
+        if ((VALUE(pc->a).s = make_string(&heap, VALUE(pc->b).s, VALUE(pc->c).s)) == NULL)
+            RUNTIME_ERROR("out of memory for the strings");
+        NEXT();
+    OP_LT_I_HANDLER: VALUE(pc->a).i = VALUE(pc->b).i < VALUE(pc->c).i; NEXT();
+    OP_GT_I_HANDLER: VALUE(pc->a).i = VALUE(pc->b).i > VALUE(pc->c).i; NEXT();
+    OP_NEQ_I_HANDLER: VALUE(pc->a).i = VALUE(pc->b).i != VALUE(pc->c).i; NEXT();
+    OP_LTE_I_HANDLER: VALUE(pc->a).i = VALUE(pc->b).i <= VALUE(pc->c).i; NEXT();
+    OP_GTE_I_HANDLER: VALUE(pc->a).i = VALUE(pc->b).i >= VALUE(pc->c).i; NEXT();
+    OP_EQ_I_HANDLER: VALUE(pc->a).i = VALUE(pc->b).i == VALUE(pc->c).i; NEXT();
+    OP_LT_F_HANDLER: VALUE(pc->a).i = VALUE(pc->b).f < VALUE(pc->c).f; NEXT();
+    OP_GT_F_HANDLER: VALUE(pc->a).i = VALUE(pc->b).f > VALUE(pc->c).f; NEXT();
+    OP_NEQ_F_HANDLER: VALUE(pc->a).i = VALUE(pc->b).f != VALUE(pc->c).f; NEXT();
+    OP_LTE_F_HANDLER: VALUE(pc->a).i = VALUE(pc->b).f <= VALUE(pc->c).f; NEXT();
+    OP_GTE_F_HANDLER: VALUE(pc->a).i = VALUE(pc->b).f >= VALUE(pc->c).f; NEXT();
+    OP_EQ_F_HANDLER: VALUE(pc->a).i = VALUE(pc->b).f == VALUE(pc->c).f; NEXT();
+    OP_LT_S_HANDLER: VALUE(pc->a).i = strcmp(VALUE(pc->b).s, VALUE(pc->c).s) < 0; NEXT();
+    OP_GT_S_HANDLER: VALUE(pc->a).i = strcmp(VALUE(pc->b).s, VALUE(pc->c).s) > 0; NEXT();
+    OP_NEQ_S_HANDLER: VALUE(pc->a).i = strcmp(VALUE(pc->b).s, VALUE(pc->c).s) != 0; NEXT();
+    OP_LTE_S_HANDLER: VALUE(pc->a).i = strcmp(VALUE(pc->b).s, VALUE(pc->c).s) <= 0; NEXT();
+    OP_GTE_S_HANDLER: VALUE(pc->a).i = strcmp(VALUE(pc->b).s, VALUE(pc->c).s) >= 0; NEXT();
+    OP_EQ_S_HANDLER: VALUE(pc->a).i = strcmp(VALUE(pc->b).s, VALUE(pc->c).s) == 0; NEXT();
+    OP_AND_HANDLER: VALUE(pc->a).i = VALUE(pc->b).i && VALUE(pc->c).i; NEXT();
+    OP_OR_HANDLER: VALUE(pc->a).i = VALUE(pc->b).i || VALUE(pc->c).i; NEXT();
+    OP_NOT_HANDLER: VALUE(pc->a).i = VALUE(pc->b).i == 0; NEXT();
+    OP_NEG_I_HANDLER: VALUE(pc->a).i = -VALUE(pc->b).i; NEXT();
+    OP_NEG_F_HANDLER: VALUE(pc->a).f = -VALUE(pc->b).f; NEXT();
+    OP_COPY_HANDLER: VALUE(pc->a) = VALUE(pc->b); NEXT();
+    OP_I2F_HANDLER: VALUE(pc->a).f = (float) VALUE(pc->b).i; NEXT();
+    OP_F2I_HANDLER: VALUE(pc->a).i = (int32_t) VALUE(pc->b).f; NEXT();
+    OP_C2S_HANDLER:
+        buffer[0] = (char) VALUE(pc->b).i;
+        if ((VALUE(pc->a).s = make_string(&heap, buffer, "")) == NULL)
+            RUNTIME_ERROR("out of memory for the strings");
+        NEXT();
+    OP_GOTO_HANDLER: pc = &instructions[pc->a]; DISPATCH();
+    OP_IFZ_HANDLER: pc = VALUE(pc->b).i == 0 ? &instructions[pc->a] : pc + 1; DISPATCH();
+    OP_IFNZ_HANDLER: pc = VALUE(pc->b).i != 0 ? &instructions[pc->a] : pc + 1; DISPATCH();
+    OP_ADDI_HANDLER: VALUE(pc->a).i = VALUE(pc->b).i + pc->c; NEXT();
+    OP_JLT_I_HANDLER: pc = VALUE(pc->b).i < VALUE(pc->c).i ? &instructions[pc->a] : pc + 1; DISPATCH();
+    OP_JGT_I_HANDLER: pc = VALUE(pc->b).i > VALUE(pc->c).i ? &instructions[pc->a] : pc + 1; DISPATCH();
+    OP_JNEQ_I_HANDLER: pc = VALUE(pc->b).i != VALUE(pc->c).i ? &instructions[pc->a] : pc + 1; DISPATCH();
+    OP_JLTE_I_HANDLER: pc = VALUE(pc->b).i <= VALUE(pc->c).i ? &instructions[pc->a] : pc + 1; DISPATCH();
+    OP_JGTE_I_HANDLER: pc = VALUE(pc->b).i >= VALUE(pc->c).i ? &instructions[pc->a] : pc + 1; DISPATCH();
+    OP_JEQ_I_HANDLER: pc = VALUE(pc->b).i == VALUE(pc->c).i ? &instructions[pc->a] : pc + 1; DISPATCH();
+    OP_INC_LOOP_HANDLER: { // Skips the loop test, it is done here
+        const Instruction *test = &instructions[pc->c];
+        pc = ++VALUE(pc->a).i <= VALUE(pc->b).i ? test + 1 : &instructions[test->a];
+        DISPATCH();
+    }
+    OP_DEC_LOOP_HANDLER: {
+        const Instruction *test = &instructions[pc->c];
+        pc = --VALUE(pc->a).i >= VALUE(pc->b).i ? test + 1 : &instructions[test->a];
+        DISPATCH();
+    }
+    OP_PRINT_I_HANDLER: write_padded(out, text, format_int(text, VALUE(pc->a).i), VALUE(pc->b).i); NEXT();
+    OP_PRINT_F_HANDLER: write_padded(out, text, format_real(text, VALUE(pc->a).f, VALUE(pc->c).i), VALUE(pc->b).i); NEXT();
+    OP_PRINT_C_HANDLER:
+        text[0] = (char) VALUE(pc->a).i;
+        write_padded(out, text, 1, VALUE(pc->b).i);
+        NEXT();
+    OP_PRINT_S_HANDLER: write_padded(out, VALUE(pc->a).s, strlen(VALUE(pc->a).s), VALUE(pc->b).i); NEXT();
+    OP_PRINT_B_HANDLER:
+        write_padded(out, VALUE(pc->a).i ? "TRUE" : "FALSE", VALUE(pc->a).i ? 4 : 5, VALUE(pc->b).i);
+        NEXT();
+    OP_PRINTLN_HANDLER: fputc('\n', out); NEXT();
+    OP_READ_I_HANDLER: VALUE(pc->a).i = read_int(&in); NEXT();
+    OP_READ_F_HANDLER: VALUE(pc->a).f = read_real(&in); NEXT();
+    OP_READ_C_HANDLER: VALUE(pc->a).i = read_char(&in); NEXT();
+    OP_READ_S_HANDLER:
+        if ((VALUE(pc->a).s = keep_string(&heap, read_string(&in))) == NULL)
+            RUNTIME_ERROR("out of memory for the strings");
+        NEXT();
+    OP_READLN_HANDLER: read_line(&in); NEXT();
+    OP_LOAD_REF_HANDLER: VALUE(pc->a) = *VALUE(pc->b).p; NEXT();
+    OP_STORE_REF_HANDLER: *VALUE(pc->a).p = VALUE(pc->b); NEXT();
+    OP_ARG_HANDLER: bases[FRAME_BASE][pc->b] = VALUE(pc->a); NEXT();
+    OP_ARG_REF_HANDLER: bases[FRAME_BASE][pc->b].p = &VALUE(pc->a); NEXT();
+    OP_CALL_HANDLER:
+        if (depth >= MAX_CALL_DEPTH)
+            RUNTIME_ERROR("too many nested calls");
+        calls[depth].return_pc = pc + 1;
+        calls[depth++].frame = bases[FRAME_BASE];
+        bases[FRAME_BASE] += pc->c;
+        pc = &instructions[pc->b];
+        DISPATCH();
+    OP_ENTER_HANDLER:
+        if (bases[FRAME_BASE] + pc->a > stack_top) {
+            if (bases[FRAME_BASE] + pc->a > stack + STACK_SIZE)
+                RUNTIME_ERROR("stack overflow");
+            stack_top = bases[FRAME_BASE] + pc->a;
+        }
+        NEXT();
+    OP_RET_HANDLER: {
+        Value value = VALUE(pc->a);
+        pc = calls[--depth].return_pc;
+        bases[FRAME_BASE] = calls[depth].frame;
+        if (pc[-1].a >= 0)
+            VALUE(pc[-1].a) = value;
+        DISPATCH();
+    }
+    OP_RET_VOID_HANDLER:
+        pc = calls[--depth].return_pc;
+        bases[FRAME_BASE] = calls[depth].frame;
+        DISPATCH();
+    OP_HALT_HANDLER:
+        goto finish;
+
+runtime_error:
+    fflush(out);
+    fprintf(ctx->log_fptr, "Error: %s while running the program\n", error);
+    result = 0;
+finish:
+    free_strings(&heap);
+    free_input(&in);
+    free(stack);
+    free(calls);
+    return result;
+}
@@ -0,0 +1,87 @@
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+
+#include <stdint.h>
+
+#include "tac_array.h"
+#include "compiler_context.h"
+
+// Pre-decoded program run by --run: instructions are typed (the operand types of the intermediate code pick the integer,
+// real or string variant) and their operands are slots, either in the static area (global variables and literals) or in
+// the frame of the running routine. A frame holds the parameters, 3 scratch slots for the conversions then the local
+// variables and temporaries, the frame of a call starts right after the one of its caller. OP_ENTER checks that the frame
+// and the arguments of its calls fit in the stack.
+// Superinstructions fuse the common sequences: OP_ADDI adds an immediate (c), OP_J<cond>_I jumps to a when the comparison
+// of b and c holds, OP_INC_LOOP and OP_DEC_LOOP step the counter a of a for loop whose test (OP_JGT_I or OP_JLT_I against
+// b) is the instruction c, then jump to the loop body or to the loop exit.
+
+#define OPCODES(X) \
+    X(OP_ADD_I) X(OP_SUB_I) X(OP_MUL_I) X(OP_DIV_I) X(OP_MOD_I) X(OP_ADD_F) X(OP_SUB_F) X(OP_MUL_F) X(OP_DIV_F) X(OP_CONCAT) \
+    X(OP_LT_I) X(OP_GT_I) X(OP_NEQ_I) X(OP_LTE_I) X(OP_GTE_I) X(OP_EQ_I) \
+    X(OP_LT_F) X(OP_GT_F) X(OP_NEQ_F) X(OP_LTE_F) X(OP_GTE_F) X(OP_EQ_F) \
+    X(OP_LT_S) X(OP_GT_S) X(OP_NEQ_S) X(OP_LTE_S) X(OP_GTE_S) X(OP_EQ_S) \
+    X(OP_AND) X(OP_OR) X(OP_NOT) X(OP_NEG_I) X(OP_NEG_F) X(OP_COPY) X(OP_I2F) X(OP_F2I) X(OP_C2S) \
+    X(OP_GOTO) X(OP_IFZ) X(OP_IFNZ) \
+    X(OP_ADDI) X(OP_JLT_I) X(OP_JGT_I) X(OP_JNEQ_I) X(OP_JLTE_I) X(OP_JGTE_I) X(OP_JEQ_I) X(OP_INC_LOOP) X(OP_DEC_LOOP) \
+    X(OP_PRINT_I) X(OP_PRINT_F) X(OP_PRINT_C) X(OP_PRINT_S) X(OP_PRINT_B) X(OP_PRINTLN) \
+    X(OP_READ_I) X(OP_READ_F) X(OP_READ_C) X(OP_READ_S) X(OP_READLN) \
+    X(OP_LOAD_REF) X(OP_STORE_REF) X(OP_ARG) X(OP_ARG_REF) X(OP_CALL) X(OP_ENTER) X(OP_RET) X(OP_RET_VOID) X(OP_HALT)
+
+#define OPCODE_ENUM(op) op,
+typedef enum {
+    OPCODES(OPCODE_ENUM)
+    OPCODE_COUNT
+} Opcode;
+
+#define STATIC_BASE 0
+#define FRAME_BASE 1
+#define slot_operand(base, slot) (((slot) << 1) | (base)) // Operands select their base with the low bit
+#define SCRATCH_COUNT 3
+#define STACK_SIZE (1 << 20) // Values of all the frames
+#define MAX_CALL_DEPTH (1 << 16)
+
+typedef union _Value {
+    int32_t i; // Integers, characters and booleans
+    float f;
+    char *s;
+    union _Value *p; // Address of a variable passed by reference
+} Value;
+
+typedef struct _Instruction {
+    const void *handler; // Set by the interpreter before running (direct threading)
+    int32_t opcode;
+    int32_t a, b, c; // Slot operands (destination first), instruction indexes for the jumps and calls
+} Instruction;
+
+typedef struct _Program {
+    Instruction *instructions;
+    int instruction_count, instruction_capacity;
+    Value *statics; // Global variables then literals
+    uint8_t *static_classes; // ValueClass of each static, the strings are written to the bytecode files by value
+    int static_count, static_capacity;
+    int entry; // First instruction of the main program
+    void *mapping; // Bytecode file the arrays point into when the program was loaded, NULL otherwise
+    size_t mapping_size;
+} Program;
+
+#define MIN_STRING_LIMIT (1 << 20) // Bytes of strings made before the first collection
+
+typedef struct _StringHeap { // Strings made while running, the ones no slot points to are freed when they pass the limit
+    char **strings;
+    int count, capacity;
+    size_t size, limit; // Bytes of the strings and the size starting the next collection
+    const Value *statics, *stack; // Slots looked for strings, the stack up to the highest frame end reached
+    Value *const *stack_top;
+    int static_count;
+} StringHeap;
+
+Program* decode_program(CompilerContext *, const TacArray *);
+void free_program(Program *);
+int run_program(CompilerContext *, Program *);
+void init_strings(StringHeap *, const Value *, int, const Value *, Value *const *);
+void collect_strings(StringHeap *);
+char* keep_string(StringHeap *, char *);
+char* make_string(StringHeap *, const char *, const char *);
+void free_strings(StringHeap *);
+
+#endif
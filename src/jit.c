@@ -0,0 +1,634 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#if defined(__x86_64__) && !defined(_WIN32)
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#include "symbol_table.h"
+#include "tac.h"
+#include "tac_array.h"
+#include "control_flow.h"
+#include "compiler_context.h"
+#include "interpreter.h"
+#include "jit.h"
+#include "write_format.h"
+
+#if defined(__x86_64__) && !defined(_WIN32)
+
+// Register numbers of the encodings, the ones from 8 up need a REX prefix
+#define RAX 0
+#define RCX 1
+#define RDX 2
+#define RBX 3
+#define RSP 4
+#define RSI 6
+#define RDI 7
+#define R13 13
+#define R14 14
+#define XMM0 0
+
+// Condition codes of jcc and setcc
+#define CC_P 0xA
+#define CC_NP 0xB
+#define CC_B 0x2
+#define CC_AE 0x3
+#define CC_E 0x4
+#define CC_NE 0x5
+#define CC_A 0x7
+#define CC_L 0xC
+#define CC_GE 0xD
+#define CC_LE 0xE
+#define CC_G 0xF
+
+#define stub_target(status) (-1 - (status))
+
+const char *jit_status_messages[JIT_STATUS_COUNT] = {
+    NULL, "division by zero", "division overflow", "stack overflow", "too many nested calls", "out of memory for the strings"
+};
+
+// Condition codes of the comparisons, in the order of their opcodes (LT GT NEQ LTE GTE EQ)
+const uint8_t int_conditions[] = { CC_L, CC_G, CC_NE, CC_LE, CC_GE, CC_E };
+
+typedef struct _JitFixup { // rel32 field to patch once every instruction has its code
+    int position;
+    int target; // Instruction, or a stub when below 0
+} JitFixup;
+
+typedef struct _JitCompiler {
+    CompilerContext *ctx;
+    const Program *program;
+    uint8_t *code;
+    size_t size, capacity;
+    int failed;
+    int *offsets; // Code of each instruction
+    int stubs[JIT_STATUS_COUNT];
+    JitFixup *fixups;
+    int fixup_count, fixup_capacity;
+} JitCompiler;
+
+// Runtime helpers called by the generated code
+
+void jit_print_int(JitState *state, Value *value, Value *width) {
+    char text[WRITE_BUFFER_SIZE];
+    write_padded(state->out, text, format_int(text, value->i), width->i);
+}
+
+void jit_print_real(JitState *state, Value *value, Value *width, Value *precision) {
+    char text[WRITE_BUFFER_SIZE];
+    write_padded(state->out, text, format_real(text, value->f, precision->i), width->i);
+}
+
+void jit_print_char(JitState *state, Value *value, Value *width) {
+    char text = (char) value->i;
+    write_padded(state->out, &text, 1, width->i);
+}
+
+void jit_print_string(JitState *state, Value *value, Value *width) {
+    write_padded(state->out, value->s, strlen(value->s), width->i);
+}
+
+void jit_print_boolean(JitState *state, Value *value, Value *width) {
+    write_padded(state->out, value->i ? "TRUE" : "FALSE", value->i ? 4 : 5, width->i);
+}
+
+void jit_print_line(JitState *state) {
+    fputc('\n', state->out);
+}
+
+void jit_read_int(JitState *state, Value *a) {
+    a->i = read_int(&state->in);
+}
+
+void jit_read_real(JitState *state, Value *a) {
+    a->f = read_real(&state->in);
+}
+
+void jit_read_char(JitState *state, Value *a) {
+    a->i = read_char(&state->in);
+}
+
+int jit_read_string(JitState *state, Value *a) { // 0 when out of memory
+    return (a->s = keep_string(&state->heap, read_string(&state->in))) != NULL;
+}
+
+void jit_read_line(JitState *state) {
+    read_line(&state->in);
+}
+
+int jit_concat(JitState *state, Value *a, Value *b, Value *c) { // 0 when out of memory
+    return (a->s = make_string(&state->heap, b->s, c->s)) != NULL;
+}
+
+int jit_char_to_string(JitState *state, Value *a, Value *b) {
+    char buffer[2] = { (char) b->i, 0 };
+    return (a->s = make_string(&state->heap, buffer, "")) != NULL;
+}
+
+int jit_compare_strings(Value *b, Value *c) {
+    return strcmp(b->s, c->s);
+}
+
+// Encoding
+
+void emit_byte(JitCompiler *jit, uint8_t byte) {
+    if (jit->size >= jit->capacity) {
+        size_t capacity = jit->capacity == 0 ? 4096 : jit->capacity * 2;
+        uint8_t *code = realloc(jit->code, capacity);
+        if (code == NULL) {
+            jit->failed = 1;
+            return;
+        }
+        jit->code = code;
+        jit->capacity = capacity;
+    }
+    jit->code[jit->size++] = byte;
+}
+
+void emit_bytes(JitCompiler *jit, const uint8_t *bytes, int count) {
+    for (int n = 0; n < count; n++)
+        emit_byte(jit, bytes[n]);
+}
+
+void emit_int32(JitCompiler *jit, int32_t value) {
+    for (int n = 0; n < 4; n++)
+        emit_byte(jit, (uint8_t) ((uint32_t) value >> (8 * n)));
+}
+
+void emit_int64(JitCompiler *jit, uint64_t value) {
+    for (int n = 0; n < 8; n++)
+        emit_byte(jit, (uint8_t) (value >> (8 * n)));
+}
+
+void emit_memory(JitCompiler *jit, uint8_t prefix, int wide, uint32_t opcode, int reg, int base, int32_t displacement) {
+    // prefix (0 for none), REX, opcode (1 to 3 bytes, high byte first) then [base + disp32]
+    if (prefix != 0)
+        emit_byte(jit, prefix);
+    if (wide || reg >= 8 || base >= 8)
+        emit_byte(jit, 0x40 | (wide << 3) | ((reg >= 8) << 2) | (base >= 8));
+    if (opcode > 0xFFFF)
+        emit_byte(jit, opcode >> 16);
+    if (opcode > 0xFF)
+        emit_byte(jit, (opcode >> 8) & 0xFF);
+    emit_byte(jit, opcode & 0xFF);
+    emit_byte(jit, 0x80 | ((reg & 7) << 3) | (base & 7));
+    if ((base & 7) == RSP)
+        emit_byte(jit, 0x24); // SIB without index
+    emit_int32(jit, displacement);
+}
+
+void emit_slot(JitCompiler *jit, uint8_t prefix, int wide, uint32_t opcode, int reg, int operand) {
+    emit_memory(jit, prefix, wide, opcode, reg, (operand & 1) == FRAME_BASE ? R13 : RBX, (operand >> 1) * (int32_t) sizeof(Value));
+}
+
+void add_fixup(JitCompiler *jit, int target) { // The rel32 field comes next
+    if (jit->fixup_count >= jit->fixup_capacity) {
+        int capacity = jit->fixup_capacity == 0 ? 64 : jit->fixup_capacity * 2;
+        JitFixup *fixups = realloc(jit->fixups, capacity * sizeof(JitFixup));
+        if (fixups == NULL) {
+            jit->failed = 1;
+            return;
+        }
+        jit->fixups = fixups;
+        jit->fixup_capacity = capacity;
+    }
+    jit->fixups[jit->fixup_count].position = jit->size;
+    jit->fixups[jit->fixup_count++].target = target;
+    emit_int32(jit, 0);
+}
+
+void emit_jump(JitCompiler *jit, int target) {
+    emit_byte(jit, 0xE9);
+    add_fixup(jit, target);
+}
+
+void emit_branch(JitCompiler *jit, int condition, int target) {
+    emit_byte(jit, 0x0F);
+    emit_byte(jit, 0x80 | condition);
+    add_fixup(jit, target);
+}
+
+void emit_set_condition(JitCompiler *jit, int condition, int reg) { // setcc on al or cl
+    emit_byte(jit, 0x0F);
+    emit_byte(jit, 0x90 | condition);
+    emit_byte(jit, 0xC0 | reg);
+}
+
+void emit_store_flag(JitCompiler *jit, int operand) { // movzx eax, al then the 32 bit store
+    emit_bytes(jit, (const uint8_t[]) { 0x0F, 0xB6, 0xC0 }, 3);
+    emit_slot(jit, 0, 0, 0x89, RAX, operand);
+}
+
+void emit_call_helper(JitCompiler *jit, const void *helper) { // mov rax, imm64 then call rax
+    emit_bytes(jit, (const uint8_t[]) { 0x48, 0xB8 }, 2);
+    emit_int64(jit, (uint64_t) (uintptr_t) helper);
+    emit_bytes(jit, (const uint8_t[]) { 0xFF, 0xD0 }, 2);
+}
+
+void emit_helper_arguments(JitCompiler *jit, int with_state, int operand_count, const Instruction *instruction) {
+    // rdi gets the state when asked, the following argument registers the addresses of the slot operands
+    const int registers[] = { RDI, RSI, RDX, RCX };
+    int next = 0;
+    if (with_state) {
+        emit_bytes(jit, (const uint8_t[]) { 0x4C, 0x89, 0xF7 }, 3); // mov rdi, r14
+        next++;
+    }
+    const int32_t operands[] = { instruction->a, instruction->b, instruction->c };
+    for (int n = 0; n < operand_count; n++)
+        emit_slot(jit, 0, 1, 0x8D, registers[next++], operands[n]); // lea
+}
+
+void emit_status_check(JitCompiler *jit, JitStatus status) { // Stops the run when the helper returned 0
+    emit_bytes(jit, (const uint8_t[]) { 0x85, 0xC0 }, 2); // test eax, eax
+    emit_branch(jit, CC_E, stub_target(status));
+}
+
+void emit_int_operation(JitCompiler *jit, const Instruction *instruction) {
+    emit_slot(jit, 0, 0, 0x8B, RAX, instruction->b);
+    switch (instruction->opcode) {
+        case OP_ADD_I: emit_slot(jit, 0, 0, 0x03, RAX, instruction->c); break;
+        case OP_SUB_I: emit_slot(jit, 0, 0, 0x2B, RAX, instruction->c); break;
+        default: emit_slot(jit, 0, 0, 0x0FAF, RAX, instruction->c); break; // imul
+    }
+    emit_slot(jit, 0, 0, 0x89, RAX, instruction->a);
+}
+
+void emit_division(JitCompiler *jit, const Instruction *instruction) {
+    emit_slot(jit, 0, 0, 0x83, 7, instruction->c); // cmp dword [c], 0
+    emit_byte(jit, 0);
+    emit_branch(jit, CC_E, stub_target(JIT_DIVISION_BY_ZERO));
+    emit_slot(jit, 0, 0, 0x8B, RAX, instruction->b);
+    emit_slot(jit, 0, 0, 0x8B, RCX, instruction->c); // INT_MIN / -1 traps too, (b ^ INT_MIN) | (c + 1) is 0 only then
+    emit_bytes(jit, (const uint8_t[]) { 0xFF, 0xC1, 0x89, 0xC2, 0x81, 0xF2, 0x00, 0x00, 0x00, 0x80, 0x09, 0xCA }, 12); // inc ecx, mov edx, eax, xor edx, INT_MIN, or edx, ecx
+    emit_branch(jit, CC_E, stub_target(JIT_DIVISION_OVERFLOW));
+    emit_byte(jit, 0x99); // cdq
+    emit_slot(jit, 0, 0, 0xF7, 7, instruction->c); // idiv
+    emit_slot(jit, 0, 0, 0x89, instruction->opcode == OP_DIV_I ? RAX : RDX, instruction->a);
+}
+
+void emit_real_operation(JitCompiler *jit, const Instruction *instruction) {
+    const uint8_t operations[] = { 0x58, 0x5C, 0x59, 0x5E }; // addss subss mulss divss
+    emit_slot(jit, 0xF3, 0, 0x0F10, XMM0, instruction->b);
+    emit_slot(jit, 0xF3, 0, 0x0F00 | operations[instruction->opcode - OP_ADD_F], XMM0, instruction->c);
+    emit_slot(jit, 0xF3, 0, 0x0F11, XMM0, instruction->a);
+}
+
+void emit_real_comparison(JitCompiler *jit, const Instruction *instruction) {
+    // ucomiss sets the flags of an unsigned comparison, the less than tests swap their operands to stay false on NaN
+    int condition = instruction->opcode - OP_LT_F;
+    int swapped = condition == 0 || condition == 3;
+    emit_slot(jit, 0xF3, 0, 0x0F10, XMM0, swapped ? instruction->c : instruction->b);
+    emit_slot(jit, 0, 0, 0x0F2E, XMM0, swapped ? instruction->b : instruction->c);
+    switch (instruction->opcode) {
+        case OP_LT_F: case OP_GT_F: emit_set_condition(jit, CC_A, RAX); break;
+        case OP_LTE_F: case OP_GTE_F: emit_set_condition(jit, CC_AE, RAX); break;
+        case OP_EQ_F:
+            emit_set_condition(jit, CC_E, RAX);
+            emit_set_condition(jit, CC_NP, RCX);
+            emit_bytes(jit, (const uint8_t[]) { 0x20, 0xC8 }, 2); // and al, cl
+            break;
+        default:
+            emit_set_condition(jit, CC_NE, RAX);
+            emit_set_condition(jit, CC_P, RCX);
+            emit_bytes(jit, (const uint8_t[]) { 0x08, 0xC8 }, 2); // or al, cl
+            break;
+    }
+    emit_store_flag(jit, instruction->a);
+}
+
+void emit_logic(JitCompiler *jit, const Instruction *instruction) { // Both operands become 0 or 1 first
+    emit_slot(jit, 0, 0, 0x8B, RAX, instruction->b);
+    emit_slot(jit, 0, 0, 0x8B, RCX, instruction->c);
+    emit_bytes(jit, (const uint8_t[]) { 0x85, 0xC0 }, 2); // test eax, eax
+    emit_set_condition(jit, CC_NE, RAX);
+    emit_bytes(jit, (const uint8_t[]) { 0x85, 0xC9 }, 2); // test ecx, ecx
+    emit_set_condition(jit, CC_NE, RCX);
+    emit_bytes(jit, (const uint8_t[]) { instruction->opcode == OP_AND ? 0x20 : 0x08, 0xC8 }, 2);
+    emit_store_flag(jit, instruction->a);
+}
+
+void emit_step_loop(JitCompiler *jit, const Instruction *instruction) { // Steps the counter then tests it like the loop head
+    const Instruction *test = &jit->program->instructions[instruction->c];
+    emit_slot(jit, 0, 0, 0x8B, RAX, instruction->a);
+    emit_byte(jit, 0x05); // add eax, imm32
+    emit_int32(jit, instruction->opcode == OP_INC_LOOP ? 1 : -1);
+    emit_slot(jit, 0, 0, 0x89, RAX, instruction->a);
+    emit_slot(jit, 0, 0, 0x3B, RAX, instruction->b);
+    emit_branch(jit, instruction->opcode == OP_INC_LOOP ? CC_LE : CC_GE, instruction->c + 1);
+    emit_jump(jit, test->a);
+}
+
+void emit_call(JitCompiler *jit, const Instruction *instruction) {
+    emit_memory(jit, 0, 1, 0x3B, RSP, R14, offsetof(JitState, call_limit)); // cmp rsp, [r14 + call_limit]
+    emit_branch(jit, CC_B, stub_target(JIT_NESTED_CALLS));
+    emit_bytes(jit, (const uint8_t[]) { 0x49, 0x81, 0xC5 }, 3); // add r13, imm32
+    emit_int32(jit, instruction->c * (int32_t) sizeof(Value));
+    emit_byte(jit, 0xE8);
+    add_fixup(jit, instruction->b);
+    emit_bytes(jit, (const uint8_t[]) { 0x49, 0x81, 0xED }, 3); // sub r13, imm32
+    emit_int32(jit, instruction->c * (int32_t) sizeof(Value));
+    if (instruction->a >= 0) // The result comes back in rax
+        emit_slot(jit, 0, 1, 0x89, RAX, instruction->a);
+}
+
+void compile_instruction(JitCompiler *jit, const Instruction *instruction) {
+    switch (instruction->opcode) {
+        case OP_ADD_I: case OP_SUB_I: case OP_MUL_I:
+            emit_int_operation(jit, instruction);
+            break;
+        case OP_DIV_I: case OP_MOD_I:
+            emit_division(jit, instruction);
+            break;
+        case OP_ADD_F: case OP_SUB_F: case OP_MUL_F: case OP_DIV_F:
+            emit_real_operation(jit, instruction);
+            break;
+        case OP_CONCAT:
+            emit_helper_arguments(jit, 1, 3, instruction);
+            emit_call_helper(jit, (const void *) jit_concat);
+            emit_status_check(jit, JIT_OUT_OF_MEMORY);
+            break;
+        case OP_LT_I: case OP_GT_I: case OP_NEQ_I: case OP_LTE_I: case OP_GTE_I: case OP_EQ_I:
+            emit_slot(jit, 0, 0, 0x8B, RAX, instruction->b);
+            emit_slot(jit, 0, 0, 0x3B, RAX, instruction->c);
+            emit_set_condition(jit, int_conditions[instruction->opcode - OP_LT_I], RAX);
+            emit_store_flag(jit, instruction->a);
+            break;
+        case OP_LT_F: case OP_GT_F: case OP_NEQ_F: case OP_LTE_F: case OP_GTE_F: case OP_EQ_F:
+            emit_real_comparison(jit, instruction);
+            break;
+        case OP_LT_S: case OP_GT_S: case OP_NEQ_S: case OP_LTE_S: case OP_GTE_S: case OP_EQ_S: {
+            Instruction operands = { NULL, 0, instruction->b, instruction->c, 0 };
+            emit_helper_arguments(jit, 0, 2, &operands);
+            emit_call_helper(jit, (const void *) jit_compare_strings);
+            emit_bytes(jit, (const uint8_t[]) { 0x83, 0xF8, 0x00 }, 3); // cmp eax, 0
+            emit_set_condition(jit, int_conditions[instruction->opcode - OP_LT_S], RAX);
+            emit_store_flag(jit, instruction->a);
+            break;
+        }
+        case OP_AND: case OP_OR:
+            emit_logic(jit, instruction);
+            break;
+        case OP_NOT:
+            emit_slot(jit, 0, 0, 0x83, 7, instruction->b); // cmp dword [b], 0
+            emit_byte(jit, 0);
+            emit_set_condition(jit, CC_E, RAX);
+            emit_store_flag(jit, instruction->a);
+            break;
+        case OP_NEG_I:
+            emit_slot(jit, 0, 0, 0x8B, RAX, instruction->b);
+            emit_bytes(jit, (const uint8_t[]) { 0xF7, 0xD8 }, 2); // neg eax
+            emit_slot(jit, 0, 0, 0x89, RAX, instruction->a);
+            break;
+        case OP_NEG_F: // Flips the sign bit
+            emit_slot(jit, 0, 0, 0x8B, RAX, instruction->b);
+            emit_byte(jit, 0x35); // xor eax, imm32
+            emit_int32(jit, INT32_MIN);
+            emit_slot(jit, 0, 0, 0x89, RAX, instruction->a);
+            break;
+        case OP_COPY:
+            emit_slot(jit, 0, 1, 0x8B, RAX, instruction->b);
+            emit_slot(jit, 0, 1, 0x89, RAX, instruction->a);
+            break;
+        case OP_I2F:
+            emit_slot(jit, 0xF3, 0, 0x0F2A, XMM0, instruction->b); // cvtsi2ss
+            emit_slot(jit, 0xF3, 0, 0x0F11, XMM0, instruction->a);
+            break;
+        case OP_F2I:
+            emit_slot(jit, 0xF3, 0, 0x0F2C, RAX, instruction->b); // cvttss2si
+            emit_slot(jit, 0, 0, 0x89, RAX, instruction->a);
+            break;
+        case OP_C2S:
+            emit_helper_arguments(jit, 1, 2, instruction);
+            emit_call_helper(jit, (const void *) jit_char_to_string);
+            emit_status_check(jit, JIT_OUT_OF_MEMORY);
+            break;
+        case OP_GOTO:
+            emit_jump(jit, instruction->a);
+            break;
+        case OP_IFZ: case OP_IFNZ:
+            emit_slot(jit, 0, 0, 0x83, 7, instruction->b);
+            emit_byte(jit, 0);
+            emit_branch(jit, instruction->opcode == OP_IFZ ? CC_E : CC_NE, instruction->a);
+            break;
+        case OP_ADDI:
+            emit_slot(jit, 0, 0, 0x8B, RAX, instruction->b);
+            emit_byte(jit, 0x05);
+            emit_int32(jit, instruction->c);
+            emit_slot(jit, 0, 0, 0x89, RAX, instruction->a);
+            break;
+        case OP_JLT_I: case OP_JGT_I: case OP_JNEQ_I: case OP_JLTE_I: case OP_JGTE_I: case OP_JEQ_I:
+            emit_slot(jit, 0, 0, 0x8B, RAX, instruction->b);
+            emit_slot(jit, 0, 0, 0x3B, RAX, instruction->c);
+            emit_branch(jit, int_conditions[instruction->opcode - OP_JLT_I], instruction->a);
+            break;
+        case OP_INC_LOOP: case OP_DEC_LOOP:
+            emit_step_loop(jit, instruction);
+            break;
+        case OP_PRINT_I: case OP_PRINT_F: case OP_PRINT_C: case OP_PRINT_S: case OP_PRINT_B: {
+            const void *helpers[] = {
+                (const void *) jit_print_int, (const void *) jit_print_real, (const void *) jit_print_char,
+                (const void *) jit_print_string, (const void *) jit_print_boolean
+            };
+            emit_helper_arguments(jit, 1, instruction->opcode == OP_PRINT_F ? 3 : 2, instruction); // The decimals only for a real
+            emit_call_helper(jit, helpers[instruction->opcode - OP_PRINT_I]);
+            break;
+        }
+        case OP_PRINTLN:
+            emit_helper_arguments(jit, 1, 0, instruction);
+            emit_call_helper(jit, (const void *) jit_print_line);
+            break;
+        case OP_READ_I: case OP_READ_F: case OP_READ_C: {
+            const void *helpers[] = { (const void *) jit_read_int, (const void *) jit_read_real, (const void *) jit_read_char };
+            emit_helper_arguments(jit, 1, 1, instruction);
+            emit_call_helper(jit, helpers[instruction->opcode - OP_READ_I]);
+            break;
+        }
+        case OP_READ_S:
+            emit_helper_arguments(jit, 1, 1, instruction);
+            emit_call_helper(jit, (const void *) jit_read_string);
+            emit_status_check(jit, JIT_OUT_OF_MEMORY);
+            break;
+        case OP_READLN:
+            emit_helper_arguments(jit, 1, 0, instruction);
+            emit_call_helper(jit, (const void *) jit_read_line);
+            break;
+        case OP_LOAD_REF:
+            emit_slot(jit, 0, 1, 0x8B, RAX, instruction->b);
+            emit_memory(jit, 0, 1, 0x8B, RAX, RAX, 0);
+            emit_slot(jit, 0, 1, 0x89, RAX, instruction->a);
+            break;
+        case OP_STORE_REF:
+            emit_slot(jit, 0, 1, 0x8B, RAX, instruction->a);
+            emit_slot(jit, 0, 1, 0x8B, RCX, instruction->b);
+            emit_memory(jit, 0, 1, 0x89, RCX, RAX, 0);
+            break;
+        case OP_ARG: case OP_ARG_REF: // The frame of the callee starts later, b is its slot from the current frame
+            emit_slot(jit, 0, 1, instruction->opcode == OP_ARG ? 0x8B : 0x8D, RAX, instruction->a);
+            emit_memory(jit, 0, 1, 0x89, RAX, R13, instruction->b * (int32_t) sizeof(Value));
+            break;
+        case OP_CALL:
+            emit_call(jit, instruction);
+            break;
+        case OP_ENTER: // Keeps rsp 16 bytes aligned for the helpers, checks the frame fits in the stack then raises stack_top
+            emit_bytes(jit, (const uint8_t[]) { 0x48, 0x83, 0xEC, 0x08 }, 4); // sub rsp, 8
+            emit_memory(jit, 0, 1, 0x8D, RAX, R13, instruction->a * (int32_t) sizeof(Value));
+            emit_memory(jit, 0, 1, 0x3B, RAX, R14, offsetof(JitState, stack_end));
+            emit_branch(jit, CC_A, stub_target(JIT_STACK_OVERFLOW));
+            emit_memory(jit, 0, 1, 0x3B, RAX, R14, offsetof(JitState, stack_top));
+            emit_bytes(jit, (const uint8_t[]) { 0x76, 0x07 }, 2); // jbe over the 7 byte store
+            emit_memory(jit, 0, 1, 0x89, RAX, R14, offsetof(JitState, stack_top));
+            break;
+        case OP_RET: case OP_RET_VOID:
+            if (instruction->opcode == OP_RET)
+                emit_slot(jit, 0, 1, 0x8B, RAX, instruction->a);
+            emit_bytes(jit, (const uint8_t[]) { 0x48, 0x83, 0xC4, 0x08, 0xC3 }, 5); // add rsp, 8 then ret
+            break;
+        default: // OP_HALT
+            emit_jump(jit, stub_target(JIT_OK));
+            break;
+    }
+}
+
+void compile_entry(JitCompiler *jit) {
+    // int entry(JitState *state, Value *statics, Value *stack): saves the registers kept by the generated code, calls the
+    // main program, whose end and runtime errors land on the finish stub returning the status
+    emit_bytes(jit, (const uint8_t[]) { 0x53, 0x41, 0x55, 0x41, 0x56 }, 5); // push rbx, r13, r14
+    emit_bytes(jit, (const uint8_t[]) { 0x49, 0x89, 0xFE, 0x48, 0x89, 0xF3, 0x49, 0x89, 0xD5 }, 9); // r14 = rdi, rbx = rsi, r13 = rdx
+    emit_memory(jit, 0, 1, 0x89, RSP, R14, offsetof(JitState, saved_rsp));
+    emit_memory(jit, 0, 1, 0x8D, RAX, RSP, -MAX_CALL_DEPTH * 16); // Each call takes 16 bytes of native stack
+    emit_memory(jit, 0, 1, 0x89, RAX, R14, offsetof(JitState, call_limit));
+    emit_byte(jit, 0xE8);
+    add_fixup(jit, jit->program->entry);
+    jit->stubs[JIT_OK] = jit->size;
+    emit_memory(jit, 0, 1, 0x8B, RSP, R14, offsetof(JitState, saved_rsp));
+    emit_memory(jit, 0, 0, 0x8B, RAX, R14, offsetof(JitState, status));
+    emit_bytes(jit, (const uint8_t[]) { 0x41, 0x5E, 0x41, 0x5D, 0x5B, 0xC3 }, 6); // pop r14, r13, rbx then ret
+    for (int status = JIT_OK + 1; status < JIT_STATUS_COUNT; status++) {
+        jit->stubs[status] = jit->size;
+        emit_memory(jit, 0, 0, 0xC7, 0, R14, offsetof(JitState, status)); // mov dword [r14 + status], imm32
+        emit_int32(jit, status);
+        emit_jump(jit, stub_target(JIT_OK));
+    }
+}
+
+void write_perf_map(const JitCompiler *jit, const uint8_t *code, const TacArray *tac) {
+    // One line per routine, "<start> <size> <name>" in hexadecimal, routines come in the order of the intermediate code
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/perf-%d.map", (int) getpid());
+    FILE *fptr = fopen(path, "a");
+    if (fptr == NULL)
+        return;
+    const Program *program = jit->program;
+    int start, end = -1, routine = 0;
+    for (int n = 0; n < program->instruction_count; n++) {
+        if (program->instructions[n].opcode != OP_ENTER)
+            continue;
+        int last = n + 1;
+        while (last < program->instruction_count && program->instructions[last].opcode != OP_ENTER)
+            last++;
+        const Symbol *symb = tac != NULL && next_routine(tac, end + 1, &start, &end) ? operand_symbol(tac, tac->a[start]) : NULL;
+        fprintf(fptr, "%lx %x ", (unsigned long) (uintptr_t) (code + jit->offsets[n]), jit->offsets[last] - jit->offsets[n]);
+        if (n == program->entry)
+            fprintf(fptr, "main\n");
+        else if (symb != NULL)
+            fprintf(fptr, "pas_%s\n", symb->name);
+        else // Loaded from a bytecode file, the names are gone
+            fprintf(fptr, "pas_routine_%d\n", routine);
+        routine++;
+    }
+    fclose(fptr);
+}
+
+uint8_t* compile_program(JitCompiler *jit, size_t *mapping_size) { // Executable copy of the code, NULL on failure
+    const Program *program = jit->program;
+    compile_entry(jit);
+    for (int n = 0; n < program->instruction_count; n++) {
+        jit->offsets[n] = jit->size;
+        compile_instruction(jit, &program->instructions[n]);
+    }
+    jit->offsets[program->instruction_count] = jit->size;
+    if (jit->failed) {
+        fprintf(jit->ctx->log_fptr, "Error: failed to allocate memory for the machine code\n");
+        return NULL;
+    }
+    for (int f = 0; f < jit->fixup_count; f++) {
+        int target = jit->fixups[f].target;
+        int32_t offset = target >= 0 ? jit->offsets[target] : jit->stubs[-1 - target];
+        int32_t relative = offset - (jit->fixups[f].position + 4);
+        memcpy(&jit->code[jit->fixups[f].position], &relative, sizeof(relative));
+    }
+
+    // Written while the pages are only writable, then only executable
+    long page_size = sysconf(_SC_PAGESIZE);
+    *mapping_size = (jit->size + page_size - 1) / page_size * page_size;
+    uint8_t *code = mmap(NULL, *mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == MAP_FAILED) {
+        fprintf(jit->ctx->log_fptr, "Error: failed to map memory for the machine code\n");
+        return NULL;
+    }
+    memcpy(code, jit->code, jit->size);
+    if (mprotect(code, *mapping_size, PROT_READ | PROT_EXEC) != 0) {
+        fprintf(jit->ctx->log_fptr, "Error: failed to make the machine code executable\n");
+        munmap(code, *mapping_size);
+        return NULL;
+    }
+    return code;
+}
+
+int run_jit(CompilerContext *ctx, const Program *program, const TacArray *tac) {
+    JitCompiler jit;
+    memset(&jit, 0, sizeof(jit));
+    jit.ctx = ctx;
+    jit.program = program;
+    jit.offsets = malloc((program->instruction_count + 1) * sizeof(int));
+    Value *stack = calloc(STACK_SIZE, sizeof(Value));
+    if (jit.offsets == NULL || stack == NULL) {
+        fprintf(ctx->log_fptr, "Error: failed to allocate memory for the JIT compiler\n");
+        free(jit.offsets);
+        free(stack);
+        return 0;
+    }
+    size_t mapping_size = 0;
+    uint8_t *code = compile_program(&jit, &mapping_size);
+    JitState state;
+    memset(&state, 0, sizeof(state));
+    int result = code != NULL;
+    if (result && !init_input(&state.in, 0, ctx->log_fptr)) {
+        fprintf(ctx->log_fptr, "Error: failed to allocate memory for the input buffer\n");
+        munmap(code, mapping_size);
+        result = 0;
+    }
+    if (result) {
+        write_perf_map(&jit, code, tac);
+        state.stack_end = stack + STACK_SIZE;
+        state.stack_top = stack;
+        init_strings(&state.heap, program->statics, program->static_count, stack, &state.stack_top);
+        state.out = ctx->log_fptr;
+        int (*entry)(JitState *, Value *, Value *) = (int (*)(JitState *, Value *, Value *)) (void *) code;
+        int status = entry(&state, program->statics, stack);
+        if (status != JIT_OK) {
+            fflush(ctx->log_fptr);
+            fprintf(ctx->log_fptr, "Error: %s while running the program\n", jit_status_messages[status]);
+            result = 0;
+        }
+        free_strings(&state.heap);
+        munmap(code, mapping_size);
+    }
+    free_input(&state.in);
+    free(jit.code);
+    free(jit.offsets);
+    free(jit.fixups);
+    free(stack);
+    return result;
+}
+
+#else
+
+int run_jit(CompilerContext *ctx, const Program *program, const TacArray *tac) {
+    fprintf(ctx->log_fptr, "Error: the JIT compiler only targets x86-64 with POSIX memory mapping\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "tac_array.h"
+#include "compiler_context.h"
+#include "interpreter.h"
+#include "read_format.h"
+
+// --jit translates the decoded program of the interpreter to x86-64 machine code, one routine after the other, in a
+// buffer mapped writable then switched to executable before it runs (never both). rbx holds the statics, r13 the frame of
+// the running routine and r14 the JitState, the slots stay in memory and each instruction works on them through rax, rcx
+// and rdx (xmm0 for the reals). Strings, input and output go through small C helpers.
+// Every routine is listed in /tmp/perf-<pid>.map so perf can name the generated code.
+
+typedef enum {
+    JIT_OK, JIT_DIVISION_BY_ZERO, JIT_DIVISION_OVERFLOW, JIT_STACK_OVERFLOW, JIT_NESTED_CALLS, JIT_OUT_OF_MEMORY,
+    JIT_STATUS_COUNT
+} JitStatus;
+
+typedef struct _JitState { // Read by the generated code at fixed offsets
+    Value *stack_end;
+    Value *stack_top; // End of the highest frame entered, where the strings stop being looked for
+    void *call_limit; // Lowest native stack pointer a call may start from
+    void *saved_rsp; // Native stack pointer to return to when the program stops
+    int32_t status;
+    FILE *out;
+    StringHeap heap;
+    InputBuffer in;
+} JitState;
+
+int run_jit(CompilerContext *, const Program *, const TacArray *);
+
+#endif
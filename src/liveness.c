@@ -0,0 +1,268 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "scanner.h"
+#include "symbol_table.h"
+#include "tac.h"
+#include "tac_array.h"
+#include "control_flow.h"
+#include "ssa.h"
+#include "liveness.h"
+
+#define MEMORY_VAR -2 // Global variables, parameters passed by reference and literals
+
+uint32_t live_operand_hash(Operand operand) {
+    return ((uint32_t) operand_index(operand) << 2) | operand_kind(operand);
+}
+
+uint32_t find_live_slot(const Liveness *live, Operand operand) {
+    uint32_t slot = live_operand_hash(operand) & live->var_mask;
+    while (live->var_keys[slot] != NO_OPERAND && live->var_keys[slot] != operand)
+        slot = (slot + 1) & live->var_mask;
+    return slot;
+}
+
+int liveness_var(const Liveness *live, Operand operand) { // Variable of the operand, -1 when it lives in memory
+    if (operand_kind(operand) != SYMBOL_OPERAND && operand_kind(operand) != TEMP_OPERAND)
+        return -1;
+    uint32_t slot = find_live_slot(live, operand);
+    return live->var_keys[slot] == operand && live->var_slots[slot] >= 0 ? live->var_slots[slot] : -1;
+}
+
+int is_call_instruction(const TacArray *code, int index) { // Instructions that call a routine or the runtime
+    TacOp op = code->ops[index];
+    if (op == TAC_CALL || op == TAC_PRINT || op == TAC_PRINTLN || op == TAC_READ || op == TAC_READLN)
+        return 1;
+    if (op == TAC_ADD || op == TAC_CPY) // Strings are joined (or made from a character) by the runtime
+        return operand_type(code, code->a[index]) == STRING_TOKEN;
+    if (op == TAC_LT || op == TAC_GT || op == TAC_NEQ || op == TAC_LTE || op == TAC_GTE || op == TAC_EQ) // Compared by strcmp
+        return operand_type(code, code->b[index]) == STRING_TOKEN || operand_type(code, code->c[index]) == STRING_TOKEN;
+    if (op == TAC_ARG && operand_type(code, code->a[index]) == CHAR_TOKEN) { // A character passed as a string is copied first
+        const ParamType *param = arg_param(code, index);
+        return param != NULL && value_type(param->param_symbol->token_type) == STRING_TOKEN;
+    }
+    return 0;
+}
+
+int add_live_var(Liveness *live, Operand operand, const ParamType *params) {
+    OperandKind kind = operand_kind(operand);
+    if (kind != SYMBOL_OPERAND && kind != TEMP_OPERAND)
+        return -1;
+    uint32_t slot = find_live_slot(live, operand);
+    if (live->var_keys[slot] == operand)
+        return live->var_slots[slot] >= 0 ? live->var_slots[slot] : -1;
+    live->var_keys[slot] = operand;
+    if (kind == SYMBOL_OPERAND) {
+        const Symbol *symb = operand_symbol(live->cfg->code, operand);
+        if (symbol_builtin_lookup(symb->name) == symb) { // true and false
+            live->var_slots[slot] = MEMORY_VAR;
+            return -1;
+        }
+        int value_param = symb->declaration_type == CONST_TOKEN && !is_constant_symbol(symb);
+        if (!value_param && ((symb->declaration_type != VAR_TOKEN && symb->declaration_type != FUNCTION_TOKEN)
+                             || is_ref_param(params, symb))) {
+            live->var_slots[slot] = MEMORY_VAR;
+            return -1;
+        }
+    }
+    live->var_slots[slot] = live->var_count;
+    live->vars[live->var_count] = operand;
+    live->intervals[live->var_count].start = live->intervals[live->var_count].end = -1;
+    live->intervals[live->var_count].crosses_call = live->intervals[live->var_count].addressed = 0;
+    return live->var_count++;
+}
+
+void extend_interval(LiveInterval *interval, int start, int end) {
+    if (interval->start < 0 || start < interval->start)
+        interval->start = start;
+    if (end > interval->end)
+        interval->end = end;
+}
+
+void explore_liveness(Liveness *live, int var, int *worklist, int worklist_count, int *live_in, int *live_out, const int *defines) {
+    // Walks back from the blocks where the variable is live on entry until the blocks defining it
+    const ControlFlowGraph *cfg = live->cfg;
+    LiveInterval *interval = &live->intervals[var];
+    while (worklist_count > 0) {
+        const BasicBlock *block = &cfg->blocks[worklist[--worklist_count]];
+        extend_interval(interval, block->start, block->start);
+        for (int p = 0; p < block->pred_count; p++) {
+            int pred = cfg->preds[block->pred_start + p];
+            if (live_out[pred] == var)
+                continue;
+            live_out[pred] = var;
+            extend_interval(interval, cfg->blocks[pred].end - 1, cfg->blocks[pred].end - 1);
+            if (defines[pred] != var && live_in[pred] != var) {
+                live_in[pred] = var;
+                worklist[worklist_count++] = pred;
+            }
+        }
+    }
+}
+
+Liveness* compute_liveness(const ControlFlowGraph *cfg) {
+    // Live intervals over the instruction order of the routine, a variable live across a loop covers the whole loop
+    TacArray *code = cfg->code;
+    int base = cfg->routine_start + 1;
+    int body_count = cfg->routine_end - base;
+    Liveness *live = malloc(sizeof(Liveness));
+    if (live == NULL) {
+        fprintf(cfg->code->log_fptr, "Error: failed to allocate memory for the liveness analysis\n");
+        return NULL;
+    }
+    int global_count = 0;
+    for (int i = 0; i < code->tac_count && code->ops[i] != TAC_BEGINFUNC && code->ops[i] != TAC_BEGINPROC && code->ops[i] != TAC_BEGINPROG; i++)
+        global_count += code->ops[i] == TAC_VAR;
+    uint32_t map_size = 16;
+    while (map_size < 2 * (uint32_t) (OPERAND_SLOTS * body_count + global_count + 1))
+        map_size *= 2;
+    live->cfg = cfg;
+    live->var_count = 0;
+    live->var_keys = calloc(map_size, sizeof(Operand));
+    live->var_slots = malloc(map_size * sizeof(int));
+    live->var_mask = map_size - 1;
+    live->vars = malloc((OPERAND_SLOTS * body_count + 1) * sizeof(Operand));
+    live->intervals = malloc((OPERAND_SLOTS * body_count + 1) * sizeof(LiveInterval));
+    int *operand_vars = malloc((OPERAND_SLOTS * body_count + 1) * sizeof(int)); // Variables of the used and the defined operands
+    int *call_counts = malloc((body_count + 1) * sizeof(int)); // Calls before each instruction
+    if (live->var_keys == NULL || live->var_slots == NULL || live->vars == NULL || live->intervals == NULL
+        || operand_vars == NULL || call_counts == NULL) {
+        fprintf(cfg->code->log_fptr, "Error: failed to allocate memory for the liveness analysis\n");
+        free(operand_vars);
+        free(call_counts);
+        free_liveness(live);
+        return NULL;
+    }
+    for (int i = 0; i < code->tac_count && code->ops[i] != TAC_BEGINFUNC && code->ops[i] != TAC_BEGINPROC && code->ops[i] != TAC_BEGINPROG; i++) {
+        if (code->ops[i] == TAC_VAR) {
+            uint32_t slot = find_live_slot(live, code->a[i]);
+            live->var_keys[slot] = code->a[i];
+            live->var_slots[slot] = MEMORY_VAR;
+        }
+    }
+
+    const Symbol *routine = operand_symbol(code, code->a[cfg->routine_start]);
+    const ParamType *params = routine != NULL ? routine->param_list : NULL;
+    call_counts[0] = 0;
+    for (int i = base; i < cfg->routine_end; i++) {
+        int *vars = &operand_vars[OPERAND_SLOTS * (i - base)];
+        for (int k = 0; k < OPERAND_SLOTS; k++)
+            vars[k] = -1;
+        call_counts[i - base + 1] = call_counts[i - base] + is_call_instruction(code, i);
+        if (code->ops[i] == TAC_UNDEF)
+            continue;
+        Operand *slots[MAX_USED_OPERANDS];
+        int use_count = used_operands(code, i, slots);
+        for (int k = 0; k < use_count; k++) {
+            vars[k] = add_live_var(live, *slots[k], params);
+            if (vars[k] >= 0)
+                extend_interval(&live->intervals[vars[k]], i, i);
+        }
+        vars[MAX_USED_OPERANDS] = add_live_var(live, defined_operand(code, i), params);
+        if (vars[MAX_USED_OPERANDS] >= 0)
+            extend_interval(&live->intervals[vars[MAX_USED_OPERANDS]], i, i);
+        if (code->ops[i] == TAC_ARG && vars[0] >= 0 && is_ref_arg(code, i))
+            live->intervals[vars[0]].addressed = 1;
+    }
+    int result_var = code->ops[cfg->routine_end] == TAC_ENDFUNC ? add_live_var(live, code->a[cfg->routine_end], params) : -1;
+    if (result_var >= 0)
+        extend_interval(&live->intervals[result_var], cfg->routine_end, cfg->routine_end);
+
+    // Blocks defining each variable and blocks where a use comes before any definition
+    int *def_start = calloc(live->var_count + 1, sizeof(int));
+    int *use_start = calloc(live->var_count + 1, sizeof(int));
+    int *def_blocks = NULL, *use_blocks = NULL;
+    int *defined_in = malloc((live->var_count + 1) * sizeof(int));
+    int *used_in = malloc((live->var_count + 1) * sizeof(int));
+    for (int pass = 0; pass < 2; pass++) {
+        for (int var = 0; var < live->var_count; var++)
+            defined_in[var] = used_in[var] = -1;
+        int *def_counts = pass == 0 ? def_start : calloc(live->var_count + 1, sizeof(int));
+        int *use_counts = pass == 0 ? use_start : calloc(live->var_count + 1, sizeof(int));
+        for (int b = 0; b < cfg->block_count; b++) {
+            for (int i = cfg->blocks[b].start; i < cfg->blocks[b].end; i++) {
+                const int *vars = &operand_vars[OPERAND_SLOTS * (i - base)];
+                for (int k = 0; k < MAX_USED_OPERANDS; k++) {
+                    int var = vars[k];
+                    if (var < 0 || defined_in[var] == b || used_in[var] == b)
+                        continue;
+                    used_in[var] = b;
+                    if (pass == 0)
+                        use_counts[var + 1]++;
+                    else
+                        use_blocks[use_start[var] + use_counts[var]++] = b;
+                }
+                int var = vars[MAX_USED_OPERANDS];
+                if (var >= 0 && defined_in[var] != b) {
+                    defined_in[var] = b;
+                    if (pass == 0)
+                        def_counts[var + 1]++;
+                    else
+                        def_blocks[def_start[var] + def_counts[var]++] = b;
+                }
+            }
+        }
+        if (pass == 0) {
+            for (int var = 0; var < live->var_count; var++) {
+                def_start[var + 1] += def_start[var];
+                use_start[var + 1] += use_start[var];
+            }
+            def_blocks = malloc((def_start[live->var_count] + 1) * sizeof(int));
+            use_blocks = malloc((use_start[live->var_count] + 1) * sizeof(int));
+        }
+        else {
+            free(def_counts);
+            free(use_counts);
+        }
+    }
+
+    int *live_in = malloc(cfg->block_count * sizeof(int)), *live_out = malloc(cfg->block_count * sizeof(int));
+    int *defines = malloc(cfg->block_count * sizeof(int)), *worklist = malloc(cfg->block_count * sizeof(int));
+    for (int b = 0; b < cfg->block_count; b++)
+        live_in[b] = live_out[b] = defines[b] = -1;
+    for (int var = 0; var < live->var_count; var++) {
+        int worklist_count = 0;
+        for (int d = def_start[var]; d < def_start[var + 1]; d++)
+            defines[def_blocks[d]] = var;
+        for (int u = use_start[var]; u < use_start[var + 1]; u++) {
+            live_in[use_blocks[u]] = var;
+            worklist[worklist_count++] = use_blocks[u];
+        }
+        int last = cfg->block_count - 1;
+        if (var == result_var) { // The end of the function reads its result after the last block
+            live_out[last] = var;
+            extend_interval(&live->intervals[var], cfg->blocks[last].end - 1, cfg->routine_end);
+            if (defines[last] != var && live_in[last] != var) {
+                live_in[last] = var;
+                worklist[worklist_count++] = last;
+            }
+        }
+        explore_liveness(live, var, worklist, worklist_count, live_in, live_out, defines);
+        LiveInterval *interval = &live->intervals[var];
+        if (interval->start >= 0 && interval->end > interval->start + 1)
+            interval->crosses_call = call_counts[interval->end - base] - call_counts[interval->start + 1 - base] > 0;
+    }
+    free(live_in);
+    free(live_out);
+    free(defines);
+    free(worklist);
+    free(def_start);
+    free(use_start);
+    free(def_blocks);
+    free(use_blocks);
+    free(defined_in);
+    free(used_in);
+    free(operand_vars);
+    free(call_counts);
+    return live;
+}
+
+void free_liveness(Liveness *live) {
+    if (live != NULL) {
+        free(live->vars);
+        free(live->var_keys);
+        free(live->var_slots);
+        free(live->intervals);
+        free(live);
+    }
+}
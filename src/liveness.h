@@ -0,0 +1,33 @@
+#ifndef LIVENESS_H
+#define LIVENESS_H
+
+#include <stdint.h>
+
+#include "tac_array.h"
+#include "control_flow.h"
+
+// Live intervals of the variables a routine owns: its temporaries, local variables, function result and value parameters.
+// Global variables and parameters passed by reference live in memory and aren't part of them.
+
+typedef struct _LiveInterval {
+    int start, end; // First and last instruction where the variable is live, both included
+    uint8_t crosses_call; // A call (a print or a string operation too) happens strictly inside the interval, it clobbers the caller saved registers
+    uint8_t addressed; // The variable is passed by reference, it needs a stack home
+} LiveInterval;
+
+typedef struct _Liveness {
+    const ControlFlowGraph *cfg;
+    Operand *vars;
+    int var_count;
+    Operand *var_keys; // Open addressing map from the operands of the routine to their variable
+    int *var_slots;
+    uint32_t var_mask;
+    LiveInterval *intervals; // Interval of each variable, start is -1 for a variable that is never used
+} Liveness;
+
+Liveness* compute_liveness(const ControlFlowGraph *);
+void free_liveness(Liveness *);
+int liveness_var(const Liveness *, Operand);
+int is_call_instruction(const TacArray *, int);
+
+#endif
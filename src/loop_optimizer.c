@@ -0,0 +1,355 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "scanner.h"
+#include "symbol_table.h"
+#include "tac.h"
+#include "tac_array.h"
+#include "control_flow.h"
+#include "ssa.h"
+#include "loop_optimizer.h"
+
+// Loop invariant instructions move to a preheader, the place right before the loop header that only the entry of the loop
+// goes through. A multiplication of an induction variable (a variable only written by i = i + c in the loop) by a literal
+// becomes a copy of a new temporary, set before the loop and increased along with the variable.
+
+typedef struct _Reduction {
+    int var; // Induction variable and the literal it is multiplied by
+    int factor;
+    Operand temp; // Temporary equal to var * factor all along the loop
+} Reduction;
+
+typedef struct _LoopOptimizer {
+    CompilerContext *ctx;
+    SsaForm *ssa;
+    int *hoisted_to; // Loop each instruction moves out of, -1 when it stays
+    int *hoisted; // Moved instructions, grouped by loop in their order of execution
+    int *hoist_start; // Instructions moved out of loop l are hoisted[hoist_start[l]] to hoisted[hoist_start[l + 1] - 1]
+    int *preheader_loop; // Loop whose preheader goes right before each instruction, -1 otherwise
+    int *replacement; // Pushed instruction replacing each instruction, -1 when it is kept
+    int *first_update; // Pushed instructions following each instruction, linked through next_update
+    int *next_update;
+    int *inits; // Pushed instructions of the preheaders, grouped by loop like the moved ones
+    int *init_start;
+    int pushed_start;
+    int *def_counts; // Definitions of each variable in the current loop, valid where def_stamps is the loop
+    int *def_stamps;
+    int *phi_stamps; // Set to the current loop for the variables with a phi at its header
+    int *increments; // Definition of each induction variable of the current loop
+} LoopOptimizer;
+
+int loop_contains(const ControlFlowGraph *cfg, int l, int b) {
+    for (int m = cfg->blocks[b].loop; m != -1; m = cfg->loops[m].parent) {
+        if (m == l)
+            return 1;
+    }
+    return 0;
+}
+
+int has_preheader(const ControlFlowGraph *cfg, int l) {
+    // The header needs a single predecessor outside the loop, the block right before it that falls through into it
+    int header = cfg->loops[l].header;
+    const BasicBlock *block = &cfg->blocks[header];
+    int outside_count = 0;
+    for (int p = 0; p < block->pred_count; p++) {
+        int pred = cfg->preds[block->pred_start + p];
+        if (loop_contains(cfg, l, pred))
+            continue;
+        if (pred != header - 1)
+            return 0;
+        outside_count++;
+    }
+    if (outside_count != 1) // The entry block has no predecessor to put the preheader after
+        return 0;
+    const BasicBlock *pred = &cfg->blocks[header - 1];
+    return pred->succs[0] == header && (pred->succ_count == 1 || pred->succs[1] != header);
+}
+
+int is_invariant(const LoopOptimizer *opt, int l, int index, int k, Operand operand) {
+    // Operand holding the same value all along the loop: defined outside of it, or by an instruction moved out of it
+    const SsaForm *ssa = opt->ssa;
+    const ControlFlowGraph *cfg = ssa->cfg;
+    int base = cfg->routine_start + 1;
+    int value = ssa->uses[MAX_USED_OPERANDS * (index - base) + k];
+    if (value < 0) { // Literals and value parameters are never written
+        const Symbol *symb = operand_symbol(cfg->code, operand);
+        return symb != NULL && symb->declaration_type == CONST_TOKEN;
+    }
+    const SsaValue *ssa_value = &ssa->values[value];
+    if (ssa_value->phi >= 0)
+        return !loop_contains(cfg, l, ssa->phis[ssa_value->phi].block);
+    if (ssa_value->instruction < 0)
+        return 1;
+    if (!loop_contains(cfg, l, instruction_block(cfg, ssa_value->instruction)))
+        return 1;
+    return opt->hoisted_to[ssa_value->instruction - base] >= 0 && ssa->defs[ssa_value->instruction - base] == value;
+}
+
+int literal_int(const TacArray *code, Operand operand, int *number) {
+    const Symbol *symb = operand_symbol(code, operand);
+    if (!is_constant_symbol(symb) || symb->token_type != INT_TOKEN)
+        return 0;
+    *number = symb->values->i;
+    return 1;
+}
+
+int can_hoist(const LoopOptimizer *opt, int l, int index) {
+    const SsaForm *ssa = opt->ssa;
+    const TacArray *code = ssa->cfg->code;
+    int base = ssa->cfg->routine_start + 1;
+    TacOp op = code->ops[index];
+    int value = ssa->defs[index - base];
+    if (!is_pure_instruction(op) || value < 0 || opt->hoisted_to[index - base] >= 0)
+        return 0;
+    int var = ssa->values[value].var;
+    // The result must only live in the loop: no phi at the header and a single definition in the loop
+    if (ssa->global_vars[var] || opt->phi_stamps[var] == l || opt->def_counts[var] != 1)
+        return 0;
+    if (op == TAC_DIV || op == TAC_MOD) { // A moved division by zero would also run for loops that are never entered
+        const Symbol *symb = operand_symbol(code, code->c[index]);
+        if (!is_constant_symbol(symb) || (symb->token_type == INT_TOKEN ? symb->values->i == 0 : symb->values->f == 0))
+            return 0;
+    }
+    Operand *slots[MAX_USED_OPERANDS];
+    int use_count = used_operands((TacArray *) code, index, slots);
+    for (int k = 0; k < use_count; k++) {
+        if (!is_invariant(opt, l, index, k, *slots[k]))
+            return 0;
+    }
+    return 1;
+}
+
+void count_def(LoopOptimizer *opt, int l, int value, int increment) {
+    int var = opt->ssa->values[value].var;
+    if (opt->def_stamps[var] != l) {
+        opt->def_stamps[var] = l;
+        opt->def_counts[var] = 0;
+    }
+    opt->def_counts[var]++;
+    opt->increments[var] = increment;
+}
+
+void count_defs(LoopOptimizer *opt, int l) { // Definitions and header phis of the variables in the loop
+    const SsaForm *ssa = opt->ssa;
+    const ControlFlowGraph *cfg = ssa->cfg;
+    const Loop *loop = &cfg->loops[l];
+    int base = cfg->routine_start + 1;
+    for (int p = ssa->block_phis[loop->header]; p < ssa->block_phis[loop->header + 1]; p++)
+        opt->phi_stamps[ssa->values[ssa->phis[p].value].var] = l;
+    for (int n = 0; n < loop->block_count; n++) {
+        const BasicBlock *block = &cfg->blocks[loop->blocks[n]];
+        for (int i = block->start; i < block->end; i++) {
+            if (ssa->defs[i - base] >= 0)
+                count_def(opt, l, ssa->defs[i - base], i);
+            for (int c = ssa->clobber_start[i - base]; c < ssa->clobber_start[i - base + 1]; c++)
+                count_def(opt, l, ssa->clobbers[c], -1);
+        }
+    }
+}
+
+void hoist_invariants(LoopOptimizer *opt, int l, int *hoist_count) { // Moves the invariant instructions until none is left
+    const SsaForm *ssa = opt->ssa;
+    const ControlFlowGraph *cfg = ssa->cfg;
+    const Loop *loop = &cfg->loops[l];
+    int base = cfg->routine_start + 1;
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int n = 0; n < loop->block_count; n++) {
+            const BasicBlock *block = &cfg->blocks[loop->blocks[n]];
+            for (int i = block->start; i < block->end; i++) {
+                if (cfg->code->ops[i] != TAC_UNDEF && can_hoist(opt, l, i)) {
+                    opt->hoisted_to[i - base] = l;
+                    opt->hoisted[(*hoist_count)++] = i;
+                    changed = 1;
+                }
+            }
+        }
+    }
+}
+
+int increment_of(const LoopOptimizer *opt, int var) {
+    // Increment of an induction variable written once in the loop by i = i + c or i = i - c, 0 when it isn't one
+    const SsaForm *ssa = opt->ssa;
+    const TacArray *code = ssa->cfg->code;
+    int index = opt->increments[var];
+    if (index < 0 || opt->def_counts[var] != 1 || opt->phi_stamps[var] != opt->def_stamps[var]
+        || operand_type(code, code->a[index]) != INT_TOKEN || opt->hoisted_to[index - ssa->cfg->routine_start - 1] >= 0)
+        return 0;
+    int step;
+    TacOp op = code->ops[index];
+    if (op == TAC_ADD && code->b[index] == code->a[index] && literal_int(code, code->c[index], &step))
+        return step;
+    if (op == TAC_ADD && code->c[index] == code->a[index] && literal_int(code, code->b[index], &step))
+        return step;
+    if (op == TAC_SUB && code->b[index] == code->a[index] && literal_int(code, code->c[index], &step) && step != INT32_MIN)
+        return -step;
+    return 0;
+}
+
+Operand int_literal(LoopOptimizer *opt, int number) {
+    return add_symbol(opt->ssa->cfg->code, make_number(opt->ctx, INT_TOKEN, number, 0));
+}
+
+int push_update(LoopOptimizer *opt, int after, TacOp op, Operand a, Operand b, Operand c) {
+    int base = opt->ssa->cfg->routine_start + 1;
+    int pushed = push_tac(opt->ssa->cfg->code, op, a, b, c);
+    if (pushed < 0)
+        return 0;
+    opt->next_update[pushed - opt->pushed_start] = opt->first_update[after - base];
+    opt->first_update[after - base] = pushed;
+    return 1;
+}
+
+int reduce_strength(LoopOptimizer *opt, int l, int *init_count) {
+    // Replaces the multiplications of induction variables by literals, returns 0 when the code can't grow
+    SsaForm *ssa = opt->ssa;
+    const ControlFlowGraph *cfg = ssa->cfg;
+    TacArray *code = cfg->code;
+    const Loop *loop = &cfg->loops[l];
+    int base = cfg->routine_start + 1;
+    Reduction reductions[8];
+    int reduction_count = 0;
+    for (int n = 0; n < loop->block_count; n++) {
+        const BasicBlock *block = &cfg->blocks[loop->blocks[n]];
+        for (int i = block->start; i < block->end; i++) {
+            if (code->ops[i] != TAC_MULT || opt->replacement[i - base] >= 0 || operand_type(code, code->a[i]) != INT_TOKEN)
+                continue;
+            int factor, k = 0;
+            if (!literal_int(code, code->c[i], &factor)) {
+                k = 1;
+                if (!literal_int(code, code->b[i], &factor))
+                    continue;
+            }
+            int value = ssa->uses[MAX_USED_OPERANDS * (i - base) + k];
+            int var = value < 0 ? -1 : ssa->values[value].var;
+            int step = var < 0 || opt->def_stamps[var] != l ? 0 : increment_of(opt, var);
+            int64_t update = (int64_t) step * factor;
+            if (step == 0 || update < INT32_MIN || update > INT32_MAX)
+                continue;
+            int r = 0;
+            while (r < reduction_count && (reductions[r].var != var || reductions[r].factor != factor))
+                r++;
+            if (r == reduction_count) {
+                if (reduction_count == sizeof(reductions) / sizeof(Reduction))
+                    continue;
+                Operand temp = add_temp(code, INT_TOKEN);
+                Operand var_operand = ssa->vars[var];
+                int init = push_tac(code, TAC_MULT, temp, var_operand, int_literal(opt, factor));
+                if (init < 0 || !push_update(opt, opt->increments[var], TAC_ADD, temp, temp, int_literal(opt, (int) update)))
+                    return 0;
+                opt->inits[(*init_count)++] = init;
+                reductions[reduction_count].var = var;
+                reductions[reduction_count].factor = factor;
+                reductions[reduction_count++].temp = temp;
+            }
+            int copy = push_tac(code, TAC_CPY, code->a[i], reductions[r].temp, NO_OPERAND);
+            if (copy < 0)
+                return 0;
+            opt->replacement[i - base] = copy;
+        }
+    }
+    return 1;
+}
+
+int emit_order(const LoopOptimizer *opt, int *order) { // New order of the routine instructions, returns their count
+    const ControlFlowGraph *cfg = opt->ssa->cfg;
+    int base = cfg->routine_start + 1;
+    int count = 0;
+    for (int i = base; i < cfg->routine_end; i++) {
+        int l = opt->preheader_loop[i - base];
+        if (l >= 0) {
+            for (int h = opt->hoist_start[l]; h < opt->hoist_start[l + 1]; h++) {
+                int hoisted = opt->hoisted[h];
+                order[count++] = opt->replacement[hoisted - base] >= 0 ? opt->replacement[hoisted - base] : hoisted;
+            }
+            for (int n = opt->init_start[l]; n < opt->init_start[l + 1]; n++)
+                order[count++] = opt->inits[n];
+        }
+        if (opt->hoisted_to[i - base] < 0)
+            order[count++] = opt->replacement[i - base] >= 0 ? opt->replacement[i - base] : i;
+        for (int u = opt->first_update[i - base]; u >= 0; u = opt->next_update[u - opt->pushed_start])
+            order[count++] = u;
+    }
+    return count;
+}
+
+int optimize_loops(CompilerContext *ctx, TacArray *code, int start, int *end) {
+    // Moves the invariant instructions out of the loops of the routine and reduces the multiplications of their
+    // induction variables, the outer loops first so an instruction goes as far out as it can; returns the change count
+    ControlFlowGraph *cfg = build_cfg(code, start, *end);
+    if (cfg == NULL)
+        return 0;
+    SsaForm *ssa = cfg->loop_count > 0 ? build_ssa(cfg) : NULL;
+    if (ssa == NULL) {
+        free_cfg(cfg);
+        return 0;
+    }
+    LoopOptimizer opt;
+    int body_count = *end - start - 1;
+    int size = body_count > 0 ? body_count : 1;
+    int var_size = ssa->var_count > 0 ? ssa->var_count : 1;
+    opt.ctx = ctx;
+    opt.ssa = ssa;
+    opt.pushed_start = code->tac_count;
+    opt.hoisted_to = malloc(size * sizeof(int));
+    opt.hoisted = malloc(size * sizeof(int));
+    opt.hoist_start = malloc((cfg->loop_count + 1) * sizeof(int));
+    opt.preheader_loop = malloc(size * sizeof(int));
+    opt.replacement = malloc(size * sizeof(int));
+    opt.first_update = malloc(size * sizeof(int));
+    opt.next_update = malloc(3 * size * sizeof(int)); // At most a copy, an update and an initialization per multiplication
+    opt.inits = malloc(size * sizeof(int));
+    opt.init_start = malloc((cfg->loop_count + 1) * sizeof(int));
+    opt.def_counts = malloc(var_size * sizeof(int));
+    opt.def_stamps = malloc(var_size * sizeof(int));
+    opt.phi_stamps = malloc(var_size * sizeof(int));
+    opt.increments = malloc(var_size * sizeof(int));
+    int *order = malloc(4 * size * sizeof(int));
+    int change_count = 0;
+    if (opt.hoisted_to == NULL || opt.hoisted == NULL || opt.hoist_start == NULL || opt.preheader_loop == NULL
+        || opt.replacement == NULL || opt.first_update == NULL || opt.next_update == NULL || opt.inits == NULL
+        || opt.init_start == NULL || opt.def_counts == NULL || opt.def_stamps == NULL || opt.phi_stamps == NULL
+        || opt.increments == NULL || order == NULL)
+        fprintf(code->log_fptr, "Error: failed to allocate memory for the loop optimization\n");
+    else {
+        for (int i = 0; i < body_count; i++)
+            opt.hoisted_to[i] = opt.preheader_loop[i] = opt.replacement[i] = opt.first_update[i] = -1;
+        for (int var = 0; var < ssa->var_count; var++)
+            opt.def_stamps[var] = opt.phi_stamps[var] = -1;
+        int hoist_count = 0, init_count = 0, grown = 1;
+        for (int l = 0; l < cfg->loop_count; l++) {
+            opt.hoist_start[l] = hoist_count;
+            opt.init_start[l] = init_count;
+            if (!grown || !has_preheader(cfg, l))
+                continue;
+            opt.preheader_loop[cfg->blocks[cfg->loops[l].header].start - start - 1] = l;
+            count_defs(&opt, l);
+            hoist_invariants(&opt, l, &hoist_count);
+            grown = reduce_strength(&opt, l, &init_count);
+        }
+        opt.hoist_start[cfg->loop_count] = hoist_count;
+        opt.init_start[cfg->loop_count] = init_count;
+        change_count = hoist_count + (code->tac_count - opt.pushed_start);
+        if (change_count > 0)
+            *end = splice_code(code, start, *end, opt.pushed_start, order, emit_order(&opt, order));
+    }
+    free(opt.hoisted_to);
+    free(opt.hoisted);
+    free(opt.hoist_start);
+    free(opt.preheader_loop);
+    free(opt.replacement);
+    free(opt.first_update);
+    free(opt.next_update);
+    free(opt.inits);
+    free(opt.init_start);
+    free(opt.def_counts);
+    free(opt.def_stamps);
+    free(opt.phi_stamps);
+    free(opt.increments);
+    free(order);
+    free_ssa(ssa);
+    free_cfg(cfg);
+    return change_count;
+}
@@ -0,0 +1,8 @@
+#ifndef LOOP_OPTIMIZER_H
+#define LOOP_OPTIMIZER_H
+
+#include "tac_array.h"
+
+int optimize_loops(CompilerContext *, TacArray *, int, int *);
+
+#endif
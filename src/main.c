@@ -1,10 +1,29 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "scanner.h"
 #include "parser.h"
 #include "tac.h"
+#include "tac_array.h"
+#include "compiler_context.h"
 #include "code_generator.h"
+#include "batch.h"
+#include "server.h"
+
+int add_path(char ***paths, int *path_count, int *path_capacity, char *path) {
+    if (*path_count >= *path_capacity) {
+        *path_capacity = *path_capacity == 0 ? BUFFER_SIZE : *path_capacity * 2;
+        char **new_paths = realloc(*paths, *path_capacity * sizeof(char *));
+        if (new_paths == NULL) {
+            printf("Error: failed to reallocate more memory to the source file paths\n");
+            return 0;
+        }
+        *paths = new_paths;
+    }
+    (*paths)[(*path_count)++] = path;
+    return 1;
+}
 
 int main(int argc, char **argv) {
     if (argc < 2) {
@@ -12,23 +31,97 @@ int main(int argc, char **argv) {
         return EXIT_FAILURE;
     }
 
-    char *file_path = NULL;
+    char **paths = NULL, **response_paths = NULL; // The paths read from response files are owned by response_paths
+    int path_count = 0, path_capacity = 0, response_count = 0, response_capacity = 0;
+    int thread_count = 0;
+    CompileOptions options;
+    default_options(&options);
+    int server_mode = 0, client_mode = 0, stop_server = 0;
+    const char *socket_path = DEFAULT_SOCKET_PATH;
     for (int i = 1; i < argc; i++) {
-        if (argv[i][0] != '-') {
-            if (file_path == NULL) {
-                file_path = argv[i];
+        if (argv[i][0] == '@') { // Response file listing source file paths
+            int file_path_count = 0;
+            char **file_paths = read_response_file(stdout, argv[i] + 1, &file_path_count);
+            if (file_paths == NULL) {
+                return EXIT_FAILURE;
+            }
+            for (int j = 0; j < file_path_count; j++) {
+                if (!add_path(&response_paths, &response_count, &response_capacity, file_paths[j])
+                    || !add_path(&paths, &path_count, &path_capacity, file_paths[j])) {
+                    return EXIT_FAILURE;
+                }
+            }
+            free(file_paths);
+        }
+        else if (argv[i][0] != '-') {
+            if (!add_path(&paths, &path_count, &path_capacity, argv[i])) {
+                return EXIT_FAILURE;
+            }
+        }
+        else if (argv[i][1] == '-') { // Compile server options
+            if (!strcmp(argv[i], "--server")) { // Stays resident and compiles the source files sent by clients
+                server_mode = 1;
+            }
+            else if (!strcmp(argv[i], "--client")) { // Sends the source files to a running compile server
+                client_mode = 1;
+            }
+            else if (!strcmp(argv[i], "--run")) { // Runs each program with the interpreter after compiling it
+                options.run_program = 1;
+            }
+            else if (!strcmp(argv[i], "--jit")) { // Runs each program as machine code generated in memory after compiling it
+                options.jit_program = 1;
+            }
+            else if (!strcmp(argv[i], "--stop-server")) {
+                client_mode = stop_server = 1;
+            }
+            else if (!strcmp(argv[i], "--socket") && i + 1 < argc) {
+                socket_path = argv[++i];
             }
             else {
-                printf("Warning: only one source file compilation is supported, compiling source file at first given path \"%s\"\n",
-                    file_path);
+                printf("Error: illegal parameter: %s\n", argv[i]);
+                return EXIT_FAILURE;
             }
         }
         else if (argv[i][1] != '\0') {
-            if (argv[i][1] == 't' && argv[i][2] == '\0') { // Add an option '-t' for listing tokens and token types (To-Do)
-                
+            if (argv[i][1] == 't' && argv[i][2] == '\0') { // Option '-t' for listing tokens and token types
+                options.list_tokens = 1;
+            }
+            else if (!strcmp(argv[i], "-tac")) { // Option '-tac' for listing the intermediate code
+                options.list_tac = 1;
+            }
+            else if (argv[i][1] == 'S' && argv[i][2] == '\0') { // Option '-S' for writing the x86-64 assembly of each source file
+                options.emit_assembly = 1;
+            }
+            else if (argv[i][1] == 'c' && argv[i][2] == '\0') { // Option '-c' for writing an ELF object of each source file
+                options.emit_object = 1;
+            }
+            else if (!strcmp(argv[i], "-static")) { // Option '-static' for writing a static executable of each program, linked with the bundled runtime
+                options.emit_executable = 1;
+            }
+            else if (argv[i][1] == 'C' && argv[i][2] == '\0') { // Option '-C' for writing a C translation of each source file
+                options.emit_c = 1;
+            }
+            else if (!strcmp(argv[i], "-pbc")) { // Option '-pbc' for writing the bytecode of each program, run later with 'pcomp <file>.pbc'
+                options.emit_bytecode = 1;
+            }
+            else if (!strcmp(argv[i], "-regalloc")) { // Option '-regalloc' for listing the registers and spills of each routine
+                options.list_allocation = 1;
+            }
+            else if (argv[i][1] == 'O' && argv[i][2] >= '0' && argv[i][2] <= '2' && argv[i][3] == '\0') { // Options '-O0' to '-O2' for the optimization level
+                options.optimize = argv[i][2] - '0';
+            }
+            else if (!strcmp(argv[i], "-fsyntax-only")) { // Only runs the syntax and semantic checks
+                options.syntax_only = 1;
             }
             else if (argv[i][1] == 's' && argv[i][2] == 't' && argv[i][3] == '\0') { // Add an option '-st' for listing symbols and their attributes (To-Do)
-                
+
+            }
+            else if (argv[i][1] == 'j' && argv[i][2] == '\0') { // Option '-j N' for the number of worker threads of a batch compilation
+                if (i + 1 >= argc || (thread_count = atoi(argv[i+1])) <= 0) {
+                    printf("Error: option -j expects a positive number of threads\n");
+                    return EXIT_FAILURE;
+                }
+                i++;
             }
             else {
                 printf("Error: illegal parameter: %s\n", argv[i]);
@@ -39,15 +132,34 @@ int main(int argc, char **argv) {
             printf("Error: illegal parameter: %s\n", argv[i]);
             return EXIT_FAILURE;
         }
-    } 
-
-    // scan_file() -> tests the lexical analyser only
-    // parse_file() -> tests the lexical, syntax and semantic analysers
+    }
 
-    if (!parse_file(file_path)) {
+    if (server_mode) {
+        free(paths);
+        free_paths(response_paths, response_count);
+        return run_server(socket_path) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (client_mode) {
+        int failure_count = run_client(socket_path, paths, path_count, &options, stop_server);
+        free(paths);
+        free_paths(response_paths, response_count);
+        return failure_count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (path_count == 0) {
+        printf("Error: no target source file path specified\n");
         return EXIT_FAILURE;
     }
-    generate_code(program_tac);
+    if (thread_count == 0) {
+        thread_count = default_thread_count();
+    }
+
+    // scan_file() -> tests the lexical analyser only
+    // compile_file() -> runs the lexical, syntax and semantic analysers then the code generator on a single source file
+    // compile_batch() -> compiles every given source file, concurrently when there are many
+
+    int failure_count = compile_batch(paths, path_count, thread_count, &options);
+    free(paths);
+    free_paths(response_paths, response_count);
 
-    return EXIT_FAILURE;
-}
\ No newline at end of file
+    return failure_count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
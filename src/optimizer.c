@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tac.h"
+#include "tac_array.h"
+#include "control_flow.h"
+#include "ssa.h"
+#include "value_numbering.h"
+#include "loop_optimizer.h"
+#include "compiler_context.h"
+#include "optimizer.h"
+
+int next_instruction(const TacArray *code, int index, int end) { // Next instruction that wasn't removed, end when there is none
+    for (index++; index < end && code->ops[index] == TAC_UNDEF; index++);
+    return index;
+}
+
+int remove_jumps(TacArray *code, int start, int end) {
+    // Removes the jumps to a label that directly follows them, the condition of a removed conditional jump becomes dead
+    int change_count = 0;
+    for (int i = start + 1; i < end; i++) {
+        TacOp op = code->ops[i];
+        if (op != TAC_GOTO && op != TAC_IFZ && op != TAC_IFNZ)
+            continue;
+        for (int j = next_instruction(code, i, end); j < end && code->ops[j] == TAC_LABEL; j = next_instruction(code, j, end)) {
+            if (code->a[j] == code->a[i]) {
+                code->ops[i] = TAC_UNDEF;
+                change_count++;
+                break;
+            }
+        }
+    }
+    return change_count;
+}
+
+int remove_labels(TacArray *code, int start, int end) { // Removes the labels no jump goes to, their blocks merge with the previous ones
+    int *jump_counts = calloc(code->label_count > 0 ? code->label_count : 1, sizeof(int));
+    int change_count = 0;
+    for (int i = start + 1; i < end; i++) {
+        if (code->ops[i] == TAC_GOTO || code->ops[i] == TAC_IFZ || code->ops[i] == TAC_IFNZ)
+            jump_counts[operand_index(code->a[i])]++;
+    }
+    for (int i = start + 1; i < end; i++) {
+        if (code->ops[i] == TAC_LABEL && jump_counts[operand_index(code->a[i])] == 0) {
+            code->ops[i] = TAC_UNDEF;
+            change_count++;
+        }
+    }
+    free(jump_counts);
+    return change_count;
+}
+
+void compact_code(TacArray *code) { // Drops the removed instructions and moves the labels with their instructions
+    int count = 0;
+    for (int i = 0; i < code->tac_count; i++) {
+        if (code->ops[i] == TAC_UNDEF)
+            continue;
+        if (code->ops[i] == TAC_LABEL)
+            code->labels[operand_index(code->a[i])] = count;
+        code->ops[count] = code->ops[i];
+        code->a[count] = code->a[i];
+        code->b[count] = code->b[i];
+        code->c[count] = code->c[i];
+        count++;
+    }
+    code->tac_count = count;
+}
+
+#define MAX_CLEANUP_ROUNDS 4
+
+void clean_up_routine(CompilerContext *ctx, TacArray *code, int start, int end, int change_count) {
+    // Emptied branches leave jumps to the next instruction behind and removed stores can free more copies,
+    // the passes run again as long as the dead code elimination or the jump cleanup change something
+    change_count += remove_jumps(code, start, end) + remove_labels(code, start, end);
+    for (int round = 0; round < MAX_CLEANUP_ROUNDS && (round == 0 || change_count > 0); round++) {
+        ControlFlowGraph *cfg = build_cfg(code, start, end);
+        if (cfg == NULL)
+            return;
+        SsaForm *ssa = build_ssa(cfg);
+        change_count = 0;
+        if (ssa != NULL) {
+            coalesce_copies(ssa); // Before the numbering, that adds uses the def-use chains don't list
+            number_values(ssa, ctx->options.optimize >= 2);
+            propagate_copies(ssa);
+            change_count = eliminate_dead_code(ssa);
+        }
+        free_ssa(ssa);
+        free_cfg(cfg);
+        change_count += remove_jumps(code, start, end) + remove_labels(code, start, end);
+    }
+}
+
+void fold_routine_constants(CompilerContext *ctx, TacArray *code, int start, int end) {
+    ControlFlowGraph *cfg = build_cfg(code, start, end);
+    if (cfg == NULL)
+        return;
+    SsaForm *ssa = build_ssa(cfg);
+    if (ssa != NULL)
+        propagate_constants(ctx, ssa);
+    free_ssa(ssa);
+    free_cfg(cfg);
+}
+
+int optimize_routine(CompilerContext *ctx, TacArray *code, int start, int end) { // Returns the new end of the routine
+    // Constant propagation first, its removed branches give the copy and dead code passes a simpler graph
+    fold_routine_constants(ctx, code, start, end);
+    clean_up_routine(ctx, code, start, end, 0);
+
+    // The loop preheaders start the reduced temporaries from the known values of the induction variables
+    if (ctx->options.optimize >= 2 && optimize_loops(ctx, code, start, &end) > 0) {
+        fold_routine_constants(ctx, code, start, end);
+        clean_up_routine(ctx, code, start, end, 1);
+    }
+    return end;
+}
+
+void optimize_code(CompilerContext *ctx, TacArray *code) { // Runs the optimization passes on each routine in turn
+    int start, end;
+    for (int from = 0; next_routine(code, from, &start, &end); from = end + 1)
+        end = optimize_routine(ctx, code, start, end);
+    compact_code(code);
+}
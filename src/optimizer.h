@@ -0,0 +1,8 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "tac_array.h"
+
+void optimize_code(CompilerContext *, TacArray *);
+
+#endif
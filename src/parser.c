@@ -6,11 +6,10 @@
 #include "scanner.h"
 #include "symbol_table.h"
 #include "tac.h"
+#include "compiler_context.h"
 
-SymbolTable *current_table = NULL;
-
-void syntax_error(const TokenType expected_type) {
-    if (current_token != NULL) {
+void syntax_error(CompilerContext *ctx, const TokenType expected_type) {
+    if (ctx->current_token != NULL) {
         const char *expected;
         if (expected_type <= KEYWORD_COUNT + SPECIAL_COUNT)
             expected = (expected_type <= KEYWORD_COUNT) ? keywords[expected_type - 1] : specials[expected_type - KEYWORD_COUNT - 1];
@@ -23,26 +22,26 @@ void syntax_error(const TokenType expected_type) {
         else if (expected_type == EOF_TOKEN)
             expected = "eof";
         const char *received;
-        received = current_token->token;
-        if (current_token->type == ID_TOKEN)
+        received = ctx->current_token->token;
+        if (ctx->current_token->type == ID_TOKEN)
             received = "identifier";
-        else if (current_token->type == INUM_TOKEN)
+        else if (ctx->current_token->type == INUM_TOKEN)
             received = "integer number";
-        else if (current_token->type == RNUM_TOKEN)
+        else if (ctx->current_token->type == RNUM_TOKEN)
             received = "real number";
-        else if (current_token->type == SVAL_TOKEN)
+        else if (ctx->current_token->type == SVAL_TOKEN)
             received = "string literal";
-        else if (current_token->type == CVAL_TOKEN)
+        else if (ctx->current_token->type == CVAL_TOKEN)
             received = "character";
-        else if (current_token->type == EOF_TOKEN)
+        else if (ctx->current_token->type == EOF_TOKEN)
             received = "eof";
-        printf("Error: expected token %s but got %s at line %d, char %d\n",
-            expected, received, current_token->start_ln, current_token->start_col);
+        fprintf(ctx->log_fptr, "Error: expected token %s but got %s at line %d, char %d\n",
+            expected, received, ctx->current_token->start_ln, ctx->current_token->start_col);
     }
 }
 
-void type_mismatch_error(const TokenType expected_type, const TokenType received_type) {
-    if (current_token != NULL) {
+void type_mismatch_error(CompilerContext *ctx, const TokenType expected_type, const TokenType received_type) {
+    if (ctx->current_token != NULL) {
         const char *expected;
         if (expected_type == INUM_TOKEN || expected_type == declaration_value_map(INUM_TOKEN))
             expected = "integer number";
@@ -61,8 +60,8 @@ void type_mismatch_error(const TokenType expected_type, const TokenType received
             received = "character";
         else if (received_type == SVAL_TOKEN || received_type == declaration_value_map(SVAL_TOKEN))
             received = "string literal";
-        printf("Error: expected type %s but got %s at line %d, char %d\n",
-            expected, received, current_token->start_ln, current_token->start_col);
+        fprintf(ctx->log_fptr, "Error: expected type %s but got %s at line %d, char %d\n",
+            expected, received, ctx->current_token->start_ln, ctx->current_token->start_col);
     }
 }
 
@@ -84,8 +83,8 @@ int type_check(const TokenType expected_type, const TokenType received_type) {
     return 1;
 }
 
-int match(const TokenType type_to_match) {
-    if (current_token != NULL && current_token->type == type_to_match)
+int match(CompilerContext *ctx, const TokenType type_to_match) {
+    if (ctx->current_token != NULL && ctx->current_token->type == type_to_match)
         return 1;
     return 0;
 }
@@ -128,26 +127,32 @@ TokenData *copy_token_data(const TokenData *data) {
     return cpy_data;
 }
 
-int is_value_type() {
-    return (match(INUM_TOKEN) || match(RNUM_TOKEN) || match(SVAL_TOKEN) || match(CVAL_TOKEN));
+int is_value_type(CompilerContext *ctx) {
+    return (match(ctx, INUM_TOKEN) || match(ctx, RNUM_TOKEN) || match(ctx, SVAL_TOKEN) || match(ctx, CVAL_TOKEN));
 }
 
-int is_variable_type() {
-    return (match(INT_TOKEN) || match(REAL_TOKEN) || match(STRING_TOKEN) || match(CHAR_TOKEN) || match(BOOL_TOKEN));
+int is_variable_type(CompilerContext *ctx) {
+    return (match(ctx, INT_TOKEN) || match(ctx, REAL_TOKEN) || match(ctx, STRING_TOKEN) || match(ctx, CHAR_TOKEN) || match(ctx, BOOL_TOKEN));
 }
 
-int is_logical_op() {
-    return (match(PLUS_TOKEN) || match(MINUS_TOKEN) || match(MULT_TOKEN) || match(RDIV_TOKEN));
+int is_logical_op(CompilerContext *ctx) {
+    return (match(ctx, PLUS_TOKEN) || match(ctx, MINUS_TOKEN) || match(ctx, MULT_TOKEN) || match(ctx, RDIV_TOKEN));
 }
 
-int is_condition_op() {
-    return (match(EQ_TOKEN) || match(LESS_TOKEN) || match(LEQ_TOKEN) || match(BIGGER_TOKEN) || match(BEQ_TOKEN) || match(DIFF_TOKEN));
+int is_condition_op(CompilerContext *ctx) {
+    return (match(ctx, EQ_TOKEN) || match(ctx, LESS_TOKEN) || match(ctx, LEQ_TOKEN) || match(ctx, BIGGER_TOKEN) || match(ctx, BEQ_TOKEN) || match(ctx, DIFF_TOKEN));
 }
 
-Symbol* function_call_check(const TokenData *token_data, const TokenType expected_type) {
-    // Same as procedures. Already points on the next token without checking semi-colons
-    if (!match(OP_TOKEN)) {
-        syntax_error(OP_TOKEN);
+ExprNode* value_node(CompilerContext *ctx) { // Literal of the current value token
+    if (ctx->options.syntax_only)
+        return NULL;
+    return make_node(ctx, make_constant(ctx, ctx->current_token->type, ctx->current_token->token));
+}
+
+Symbol* function_call_check(CompilerContext *ctx, const TokenData *token_data, const TokenType expected_type, ExprNode **call) {
+    // Same as procedures. Already points on the next token without checking semi-colons, the code of the call is returned through call
+    if (!match(ctx, OP_TOKEN)) {
+        syntax_error(ctx, OP_TOKEN);
         return NULL;
     }
     int param_count = 0;
@@ -156,18 +161,20 @@ Symbol* function_call_check(const TokenData *token_data, const TokenType expecte
     strcpy(token, token_data->token);
     ParamType *head_param = NULL;
     ParamType **current_param = &head_param;
+    ExprNode *args = NULL;
+    ExprNode **current_arg = &args;
     do {
-        next_token();
-        if (match(ID_TOKEN)) {
-            TokenData *cpy_token = copy_token_data(current_token);
-            next_token();
-            if (match(OP_TOKEN)) {
+        next_token(ctx);
+        if (match(ctx, ID_TOKEN)) {
+            TokenData *cpy_token = copy_token_data(ctx->current_token);
+            next_token(ctx);
+            if (match(ctx, OP_TOKEN)) {
                 Symbol *symbol = NULL;
-                if ((symbol = function_call_check(cpy_token, -1)) == NULL) {
+                if ((symbol = function_call_check(ctx, cpy_token, -1, current_arg)) == NULL) {
                     return NULL;
                 }
                 if (!name_mangle(&token, &token_len, symbol->token_type, cpy_token->token)) {
-                    printf("Error: invalid parameter type at line %d, char %d\n", cpy_token->start_ln, cpy_token->start_col);
+                    fprintf(ctx->log_fptr, "Error: invalid parameter type at line %d, char %d\n", cpy_token->start_ln, cpy_token->start_col);
                     return NULL;
                 }
                 *current_param = malloc(sizeof(ParamType));
@@ -176,15 +183,16 @@ Symbol* function_call_check(const TokenData *token_data, const TokenType expecte
                 current_param = &(*current_param)->next;
             }
             else {
-                Symbol *symbol = symbol_deep_lookup(cpy_token->token);
+                Symbol *symbol = symbol_deep_lookup(ctx, cpy_token->token);
                 if (symbol == NULL) {
-                    printf("Error: identifier not previously declared at line %d, char %d\n",
+                    fprintf(ctx->log_fptr, "Error: identifier not previously declared at line %d, char %d\n",
                         cpy_token->start_ln, cpy_token->start_col);
                     return NULL;
                 }
-                // printf("Symbol declaration type: %s\nSymbol token type: %s\n", token_type_map[symbol->declaration_type - 1], token_type_map[symbol->token_type - 1]);
+                // fprintf(ctx->log_fptr, "Symbol declaration type: %s\nSymbol token type: %s\n", token_type_map[symbol->declaration_type - 1], token_type_map[symbol->token_type - 1]);
+                *current_arg = make_node(ctx, symbol);
                 if (!name_mangle(&token, &token_len, symbol->token_type, cpy_token->token)) {
-                    printf("Error: invalid parameter type at line %d, char %d\n", cpy_token->start_ln, cpy_token->start_col);
+                    fprintf(ctx->log_fptr, "Error: invalid parameter type at line %d, char %d\n", cpy_token->start_ln, cpy_token->start_col);
                     return NULL;
                 }
                 *current_param = malloc(sizeof(ParamType));
@@ -194,32 +202,35 @@ Symbol* function_call_check(const TokenData *token_data, const TokenType expecte
             }
         }
         else {
-            if (!is_value_type()) {
-                syntax_error(VTYPE_TOKEN);
+            if (!is_value_type(ctx)) {
+                syntax_error(ctx, VTYPE_TOKEN);
                 return NULL;
             }
-            if (!name_mangle(&token, &token_len, current_token->type, current_token->token)) {
-                printf("Error: invalid parameter type at line %d, char %d\n", current_token->start_ln, current_token->start_col);
+            if (!name_mangle(&token, &token_len, ctx->current_token->type, ctx->current_token->token)) {
+                fprintf(ctx->log_fptr, "Error: invalid parameter type at line %d, char %d\n", ctx->current_token->start_ln, ctx->current_token->start_col);
                 return NULL;
             }
             *current_param = malloc(sizeof(ParamType));
-            (*current_param)->param_symbol = make_symbol(current_token->token, CONST_TOKEN, current_token->type,
-                                                    current_token->start_ln, current_token->start_col, 1, NULL, NULL);
+            (*current_param)->param_symbol = make_symbol(ctx->current_token->token, CONST_TOKEN, ctx->current_token->type,
+                                                    ctx->current_token->start_ln, ctx->current_token->start_col, 1, NULL, NULL);
             current_param = &(*current_param)->next;
-            next_token();
+            *current_arg = value_node(ctx);
+            next_token(ctx);
         }
+        if (*current_arg != NULL)
+            current_arg = &(*current_arg)->next;
         param_count++;
-    } while (match(COMMA_TOKEN));
-    if (!match(CP_TOKEN)) {
-        syntax_error(CP_TOKEN);
+    } while (match(ctx, COMMA_TOKEN));
+    if (!match(ctx, CP_TOKEN)) {
+        syntax_error(ctx, CP_TOKEN);
         return NULL;
     }
     if (param_count == 0) {
         name_mangle(&token, &token_len, -1, NULL);
     }
     Symbol *assign_symb = NULL;
-    if ((assign_symb = symbol_deep_lookup(token)) == NULL) {
-        printf("Error: function/procedure with given parameters not previously declared at line %d, char %d\n", token_data->start_ln,
+    if ((assign_symb = symbol_deep_lookup(ctx, token)) == NULL) {
+        fprintf(ctx->log_fptr, "Error: function/procedure with given parameters not previously declared at line %d, char %d\n", token_data->start_ln,
             token_data->start_col);
         return NULL;
     }
@@ -228,10 +239,10 @@ Symbol* function_call_check(const TokenData *token_data, const TokenType expecte
     while (param_list != NULL) {
         if (param_list->param_symbol != NULL) {
             TokenType param_type = param_list->param_symbol->declaration_type;
-            // printf("\n%s | %s | expected type : %d | given type : %d\n\n", param_list->param_symbol->name, (*current_param)->param_symbol->name,
+            // fprintf(ctx->log_fptr, "\n%s | %s | expected type : %d | given type : %d\n\n", param_list->param_symbol->name, (*current_param)->param_symbol->name,
             //         param_type, (*current_param)->param_symbol->declaration_type);
             if (param_type == VAR_TOKEN && (*current_param)->param_symbol->declaration_type == CONST_TOKEN) {
-                printf("Error: expected a variable identifier at line %d, char %d\n", (*current_param)->param_symbol->line,
+                fprintf(ctx->log_fptr, "Error: expected a variable identifier at line %d, char %d\n", (*current_param)->param_symbol->line,
                     (*current_param)->param_symbol->col);
                 return NULL;
             }
@@ -241,176 +252,155 @@ Symbol* function_call_check(const TokenData *token_data, const TokenType expecte
     }
     if ((int)expected_type > 0) {
         if (assign_symb->declaration_type == PROCEDURE_TOKEN) {
-            printf("Error: cannot assign procedure to a variable or call it as an argument at line %d, char %d\n",
+            fprintf(ctx->log_fptr, "Error: cannot assign procedure to a variable or call it as an argument at line %d, char %d\n",
                 token_data->start_ln, token_data->start_col);
             return NULL;
         }
         if (!type_check(expected_type, assign_symb->token_type)) {
-            type_mismatch_error(expected_type, assign_symb->token_type);
+            type_mismatch_error(ctx, expected_type, assign_symb->token_type);
             return NULL;
         }
     }
-    next_token();
+    *call = tac_call(ctx, assign_symb, args);
+    next_token(ctx);
     return assign_symb;
 }
 
-int parse_program();
-int parse_used_libraries();
-int parse_constants();
-int parse_declarations();
-int parse_functions();
-int parse_procedures();
-int parse_begin(int);
-int parse_statement();
+typedef enum { // States of the top level section loop (a program is a sequence of sections ended by the main block)
+    USES_SECTION = 1, CONST_SECTION, VAR_SECTION, FUNCTION_SECTION, PROCEDURE_SECTION, BEGIN_SECTION, ERROR_SECTION
+} SectionState;
+
+int parse_program(CompilerContext *);
+int parse_sections(CompilerContext *);
+int parse_used_libraries(CompilerContext *);
+int parse_constants(CompilerContext *);
+int parse_declarations(CompilerContext *, TacList *, TacList *);
+int parse_functions(CompilerContext *, TacList *);
+int parse_procedures(CompilerContext *, TacList *);
+int parse_begin(CompilerContext *, int, TacList *);
+int parse_statement(CompilerContext *, TacList *);
 
-int rvalue_statement(TokenType);
-int condition_statement();
-int assign_statement(const Symbol *);
-int if_statement();
-int while_statement();
-int for_statement();
-int write_statement();
-int read_statement();
+int rvalue_statement(CompilerContext *, TokenType, ExprNode **);
+int condition_statement(CompilerContext *, ExprNode **);
+int assign_statement(CompilerContext *, Symbol *, TacList *);
+int if_statement(CompilerContext *, TacList *);
+int while_statement(CompilerContext *, TacList *);
+int for_statement(CompilerContext *, TacList *);
+int write_argument(CompilerContext *, TacList *);
+int write_statement(CompilerContext *, TacList *);
+int read_argument(CompilerContext *, TacList *);
+int read_statement(CompilerContext *, TacList *);
 
-int parse_program() {
-    next_token();
-    if (current_token != NULL) {
-        if (!match(PROGRAM_TOKEN)) {
-            syntax_error(PROGRAM_TOKEN);
+int parse_program(CompilerContext *ctx) {
+    next_token(ctx);
+    if (ctx->current_token != NULL) {
+        if (!match(ctx, PROGRAM_TOKEN)) {
+            syntax_error(ctx, PROGRAM_TOKEN);
             return 0;
         }
-        init_main_table(); // Initialize main symbol table
-        current_table = main_table;
-        next_token();
-        if (!match(ID_TOKEN)) {
-            syntax_error(ID_TOKEN);
+        init_main_table(ctx); // Initialize main symbol table
+        ctx->current_table = ctx->main_table;
+        next_token(ctx);
+        if (!match(ctx, ID_TOKEN)) {
+            syntax_error(ctx, ID_TOKEN);
             return 0;
         }
-        // Symbol *program_id_symb = make_symbol(current_token->token, PROGRAM_TOKEN, 0, current_token->start_ln, current_token->start_col, 0, NULL, NULL);
-        next_token();
-        if (match(OP_TOKEN)) {
+        // Symbol *program_id_symb = make_symbol(ctx->current_token->token, PROGRAM_TOKEN, 0, ctx->current_token->start_ln, ctx->current_token->start_col, 0, NULL, NULL);
+        next_token(ctx);
+        if (match(ctx, OP_TOKEN)) {
             do {
-                next_token();
-                if (!match(ID_TOKEN)) {
-                    syntax_error(ID_TOKEN);
+                next_token(ctx);
+                if (!match(ctx, ID_TOKEN)) {
+                    syntax_error(ctx, ID_TOKEN);
                     return 0;
                 }
-                next_token();
-            } while (match(COMMA_TOKEN));
-            if (!match(CP_TOKEN)) {
-                syntax_error(CP_TOKEN);
+                next_token(ctx);
+            } while (match(ctx, COMMA_TOKEN));
+            if (!match(ctx, CP_TOKEN)) {
+                syntax_error(ctx, CP_TOKEN);
                 return 0;
             }
-            next_token();
+            next_token(ctx);
         }
-        if (!match(SC_TOKEN)) {
-            syntax_error(SC_TOKEN);
+        if (!match(ctx, SC_TOKEN)) {
+            syntax_error(ctx, SC_TOKEN);
             return 0;
         }
-        next_token();
-        return parse_used_libraries();
+        next_token(ctx);
+        return parse_sections(ctx);
     }
 
     return 0;
 }
 
-int parse_used_libraries() {
-    if (!match(USES_TOKEN)) {
-        if (match(CONST_TOKEN)) {
-            return parse_constants();
-        }
-        else if (match(VAR_TOKEN)) {
-            return parse_declarations();
-        }
-        else if (match(FUNCTION_TOKEN)) {
-            return parse_functions();
-        }
-        else if (match(PROCEDURE_TOKEN)) {
-            return parse_procedures();
-        }
-        else if (match(BEGIN_TOKEN)) {
-            return parse_begin(0);
-        }
-        else {
-            syntax_error(BEGIN_TOKEN);
-            return 0;
-        }
+int parse_used_libraries(CompilerContext *ctx) {
+    if (!match(ctx, USES_TOKEN)) {
+        syntax_error(ctx, USES_TOKEN);
+        return 0;
     }
     do {
-        next_token();
-        if (!match(ID_TOKEN)) {
-            syntax_error(ID_TOKEN);
+        next_token(ctx);
+        if (!match(ctx, ID_TOKEN)) {
+            syntax_error(ctx, ID_TOKEN);
             return 0;
         }
-        int start_col = current_token->start_col;
-        Symbol *symb = make_symbol(current_token->token, CONST_TOKEN, SVAL_TOKEN, current_token->start_ln, current_token->start_col, 1, NULL, NULL);
-        if (symbol_lookup_insert(main_table, symb) == 1) { // Case where constant already exists in main table
-            printf("Error: duplicate library identifier at line %d, char %d\n", symb->line, start_col);
+        int start_col = ctx->current_token->start_col;
+        Symbol *symb = make_symbol(ctx->current_token->token, CONST_TOKEN, SVAL_TOKEN, ctx->current_token->start_ln, ctx->current_token->start_col, 1, NULL, NULL);
+        if (symbol_builtin_lookup(symb->name) != NULL || symbol_lookup_insert(ctx->main_table, symb) == 1) { // Case where constant already exists in main table
+            fprintf(ctx->log_fptr, "Error: duplicate library identifier at line %d, char %d\n", symb->line, start_col);
             return 0;
         }
         // Saving the lib name as a string value is redundant ? (No current use, might remove)
-        symb->values = make_symbol_value(current_token->token, current_token->type);
-        next_token();
-    } while (match(COMMA_TOKEN));
-    if (!match(SC_TOKEN)) {
-        syntax_error(SC_TOKEN);
+        if (!ctx->options.syntax_only)
+            symb->values = make_symbol_value(ctx->current_token->token, ctx->current_token->type);
+        next_token(ctx);
+    } while (match(ctx, COMMA_TOKEN));
+    if (!match(ctx, SC_TOKEN)) {
+        syntax_error(ctx, SC_TOKEN);
         return 0;
     }
-    next_token();
-    return parse_constants();
+    next_token(ctx);
+    return 1;
 }
 
-int parse_constants() {
-    if (!match(CONST_TOKEN)) {
-        if (match(VAR_TOKEN)) {
-            return parse_declarations();
-        }
-        else if (match(FUNCTION_TOKEN)) {
-            return parse_functions();
-        }
-        else if (match(PROCEDURE_TOKEN)) {
-            return parse_procedures();
-        }
-        else if (match(BEGIN_TOKEN)) {
-            return parse_begin(0);
-        }
-        else {
-            syntax_error(BEGIN_TOKEN);
-            return 0;
-        }
+int parse_constants(CompilerContext *ctx) {
+    if (!match(ctx, CONST_TOKEN)) {
+        syntax_error(ctx, CONST_TOKEN);
+        return 0;
     }
-    next_token();
-    if (!match(ID_TOKEN)) {
-        syntax_error(ID_TOKEN);
+    next_token(ctx);
+    if (!match(ctx, ID_TOKEN)) {
+        syntax_error(ctx, ID_TOKEN);
         return 0;
     }
     do {
-        int start_col = current_token->start_col;
-        Symbol *symb = make_symbol(current_token->token, CONST_TOKEN, 0, current_token->start_ln, current_token->start_col, 1, NULL, NULL);
-        next_token();
-        if (!match(EQ_TOKEN)) {
-            syntax_error(EQ_TOKEN);
+        int start_col = ctx->current_token->start_col;
+        Symbol *symb = make_symbol(ctx->current_token->token, CONST_TOKEN, 0, ctx->current_token->start_ln, ctx->current_token->start_col, 1, NULL, NULL);
+        next_token(ctx);
+        if (!match(ctx, EQ_TOKEN)) {
+            syntax_error(ctx, EQ_TOKEN);
             return 0;
         }
-        next_token();
-        if (!is_value_type()) {
-            syntax_error(RVALUE_TOKEN);
+        next_token(ctx);
+        if (!is_value_type(ctx)) {
+            syntax_error(ctx, RVALUE_TOKEN);
             return 0;
         }
-        if (symbol_lookup_insert(main_table, symb) == 1) { // Constant already exists in main table
-            printf("Error: unallowed redefinition of a constant at line %d, char %d\n", symb->line, start_col);
+        if (symbol_builtin_lookup(symb->name) != NULL || symbol_lookup_insert(ctx->main_table, symb) == 1) { // Constant already exists in main table
+            fprintf(ctx->log_fptr, "Error: unallowed redefinition of a constant at line %d, char %d\n", symb->line, start_col);
             return 0;
         }
-        symb->token_type = declaration_value_map(current_token->type);
-        symb->values = make_symbol_value(current_token->token, current_token->type);
-        next_token();
-        if (!match(SC_TOKEN)) {
-            syntax_error(SC_TOKEN);
+        symb->token_type = declaration_value_map(ctx->current_token->type);
+        if (!ctx->options.syntax_only) // Constant values are only needed by the code generation
+            symb->values = make_symbol_value(ctx->current_token->token, ctx->current_token->type);
+        next_token(ctx);
+        if (!match(ctx, SC_TOKEN)) {
+            syntax_error(ctx, SC_TOKEN);
             return 0;
         }
-        next_token();
-    } while (match(ID_TOKEN));
-    return parse_declarations();
+        next_token(ctx);
+    } while (match(ctx, ID_TOKEN));
+    return 1;
 }
 
 struct SymbolList { // A linked list structure for the case where multiple variables are declared sharing the same type initialization
@@ -418,17 +408,17 @@ struct SymbolList { // A linked list structure for the case where multiple varia
     struct SymbolList *next;
 };
 
-int declaration_routine() {
-    if (match(VAR_TOKEN)) {
-        next_token();
-        if (!match(ID_TOKEN)) {
-            syntax_error(ID_TOKEN);
+int declaration_routine(CompilerContext *ctx, TacList *declarations, TacList *initializations) {
+    if (match(ctx, VAR_TOKEN)) {
+        next_token(ctx);
+        if (!match(ctx, ID_TOKEN)) {
+            syntax_error(ctx, ID_TOKEN);
             return 0;
         }
         int no_var_init = 0;
         struct SymbolList *list = NULL;
         struct SymbolList *head = NULL;
-        while (match(ID_TOKEN)) {
+        while (match(ctx, ID_TOKEN)) {
             if (list == NULL) {
                 list = malloc(sizeof(struct SymbolList));
             }
@@ -436,459 +426,497 @@ int declaration_routine() {
                 head = list;
             }
             list->next = NULL;
-            list->symb = make_symbol(current_token->token, VAR_TOKEN, 0, current_token->start_ln, current_token->start_col, 1, NULL, NULL);
-            if (symbol_lookup_insert(current_table, list->symb) == 1) {
-                printf("Error: duplicate identifier declaration at line %d, char %d\n", current_token->start_ln, current_token->start_col);
+            list->symb = make_symbol(ctx->current_token->token, VAR_TOKEN, 0, ctx->current_token->start_ln, ctx->current_token->start_col, 1, NULL, NULL);
+            if (symbol_lookup_insert(ctx->current_table, list->symb) == 1) {
+                fprintf(ctx->log_fptr, "Error: duplicate identifier declaration at line %d, char %d\n", ctx->current_token->start_ln, ctx->current_token->start_col);
                 return 0;
             }
-            next_token();
-            if (match(COMMA_TOKEN)) {
-                next_token();
-                if (!match(ID_TOKEN)) {
-                    syntax_error(ID_TOKEN);
+            next_token(ctx);
+            if (match(ctx, COMMA_TOKEN)) {
+                next_token(ctx);
+                if (!match(ctx, ID_TOKEN)) {
+                    syntax_error(ctx, ID_TOKEN);
                     return 0;
                 }
                 list->next = malloc(sizeof(struct SymbolList));
-                list->next->symb = make_symbol(current_token->token, VAR_TOKEN, 0, current_token->start_ln, current_token->start_col, 1, NULL, NULL);
+                list->next->symb = make_symbol(ctx->current_token->token, VAR_TOKEN, 0, ctx->current_token->start_ln, ctx->current_token->start_col, 1, NULL, NULL);
                 list = list->next;
                 no_var_init = 1;
                 continue;
             }
-            if (!match(COLON_TOKEN)) {
-                syntax_error(COLON_TOKEN);
+            if (!match(ctx, COLON_TOKEN)) {
+                syntax_error(ctx, COLON_TOKEN);
                 return 0;
             }
-            next_token();
-            if (!is_variable_type()) {
-                syntax_error(VTYPE_TOKEN);
+            next_token(ctx);
+            if (!is_variable_type(ctx)) {
+                syntax_error(ctx, VTYPE_TOKEN);
                 return 0;
             }
             Symbol *first_symb = head->symb;
             list = head;
             while (list != NULL) {
-                list->symb->token_type = current_token->type;
+                list->symb->token_type = ctx->current_token->type;
+                *declarations = join_tac(*declarations, tac_declare(ctx, list->symb));
                 struct SymbolList *tmp = list;
                 list = list->next;
                 free(tmp);
             }
             list = NULL; head = NULL;
-            next_token();
+            next_token(ctx);
             if (no_var_init) {
-                if (match(EQ_TOKEN)) {
-                    printf("Error: only one variable can be initialized at line %d, char %d\n",
-                        current_token->start_ln, current_token->start_col);
+                if (match(ctx, EQ_TOKEN)) {
+                    fprintf(ctx->log_fptr, "Error: only one variable can be initialized at line %d, char %d\n",
+                        ctx->current_token->start_ln, ctx->current_token->start_col);
                     return 0;
                 }
-                else if (!match(SC_TOKEN)) {
-                    syntax_error(SC_TOKEN);
+                else if (!match(ctx, SC_TOKEN)) {
+                    syntax_error(ctx, SC_TOKEN);
                     return 0;
                 }
             }
             else {
-                if (!match(EQ_TOKEN)) {
-                    if (!match(SC_TOKEN)) {
-                        syntax_error(SC_TOKEN);
+                if (!match(ctx, EQ_TOKEN)) {
+                    if (!match(ctx, SC_TOKEN)) {
+                        syntax_error(ctx, SC_TOKEN);
                         return 0;
                     }
                 }
                 else {
-                    next_token();
-                    if (!is_value_type()) {
-                        syntax_error(RVALUE_TOKEN);
+                    next_token(ctx);
+                    if (!is_value_type(ctx)) {
+                        syntax_error(ctx, RVALUE_TOKEN);
                         return 0;
                     }
-                    if (!type_check(declaration_value_map(first_symb->token_type), current_token->type)) {
-                        type_mismatch_error(declaration_value_map(first_symb->token_type), current_token->type);
+                    if (!type_check(declaration_value_map(first_symb->token_type), ctx->current_token->type)) {
+                        type_mismatch_error(ctx, declaration_value_map(first_symb->token_type), ctx->current_token->type);
                         return 0;
                     }
-                    first_symb->values = make_symbol_value(current_token->token, current_token->type);
-                    next_token();
-                    if (!match(SC_TOKEN)) {
-                        syntax_error(SC_TOKEN);
+                    if (!ctx->options.syntax_only)
+                        first_symb->values = make_symbol_value(ctx->current_token->token, ctx->current_token->type);
+                    *initializations = join_tac(*initializations, tac_assign(ctx, first_symb, value_node(ctx)));
+                    next_token(ctx);
+                    if (!match(ctx, SC_TOKEN)) {
+                        syntax_error(ctx, SC_TOKEN);
                         return 0;
                     }
                 }
             }
             no_var_init = 0;
-            next_token();
+            next_token(ctx);
         }
     }
     return 1; // Return 1 even if it doesn't match a VAR_TOKEN at the start (Tests on VAR_TOKEN should be done before calling this function)
 }
 
-int parse_declarations() {
-    if (!match(VAR_TOKEN)) {
-        if (match(CONST_TOKEN)) {
-            return parse_constants();
-        }
-        else if (match(FUNCTION_TOKEN)) {
-            return parse_functions();
-        }
-        else if (match(PROCEDURE_TOKEN)) {
-            return parse_procedures();
-        }
-        else if (match(BEGIN_TOKEN)) {
-            return parse_begin(0);
-        }
-        else {
-            syntax_error(BEGIN_TOKEN);
-            return 0;
-        }
-    }
-    if (!declaration_routine()) {
+int parse_declarations(CompilerContext *ctx, TacList *declarations, TacList *initializations) {
+    if (!match(ctx, VAR_TOKEN)) {
+        syntax_error(ctx, VAR_TOKEN);
         return 0;
     }
-    return parse_functions();
+    return declaration_routine(ctx, declarations, initializations);
 }
 
-int parse_functions() {
-    if (!match(FUNCTION_TOKEN)) {
-        if (match(CONST_TOKEN)) {
-            return parse_constants();
-        }
-        else if (match(VAR_TOKEN)) {
-            return parse_declarations();
-        }
-        else if (match(PROCEDURE_TOKEN)) {
-            return parse_procedures();
-        }
-        else if (match(BEGIN_TOKEN)) {
-            return parse_begin(0);
-        }
-        else {
-            syntax_error(BEGIN_TOKEN);
-            return 0;
-        }
+int parse_functions(CompilerContext *ctx, TacList *code) {
+    if (!match(ctx, FUNCTION_TOKEN)) {
+        syntax_error(ctx, FUNCTION_TOKEN);
+        return 0;
     }
-    next_token();
-    if (!match(ID_TOKEN)) {
-        syntax_error(ID_TOKEN);
+    next_token(ctx);
+    if (!match(ctx, ID_TOKEN)) {
+        syntax_error(ctx, ID_TOKEN);
         return 0;
     }
-    if (symbol_lookup(main_table, current_token->token) != NULL) {
-        printf("Error: identifier %s is not a function at line %d, char %d\n", current_token->token, current_token->start_ln, current_token->start_col);
+    if (symbol_lookup(ctx->main_table, ctx->current_token->token) != NULL || symbol_builtin_lookup(ctx->current_token->token) != NULL) {
+        fprintf(ctx->log_fptr, "Error: identifier %s is not a function at line %d, char %d\n", ctx->current_token->token, ctx->current_token->start_ln, ctx->current_token->start_col);
         return 0;
     }
-    Symbol *fid_symb  = make_symbol(current_token->token, FUNCTION_TOKEN, 0, current_token->start_ln, current_token->start_col, 0, NULL, NULL);
-    Symbol *copy_symb  = make_symbol(current_token->token, FUNCTION_TOKEN, 0, current_token->start_ln, current_token->start_col, 0, NULL, NULL);
-    int fid_length = strlen(current_token->token);
-    int start_col = current_token->start_col;
-    fid_symb->param_list = malloc(sizeof(ParamType));
+    Symbol *fid_symb  = make_symbol(ctx->current_token->token, FUNCTION_TOKEN, 0, ctx->current_token->start_ln, ctx->current_token->start_col, 0, NULL, NULL);
+    Symbol *copy_symb  = make_symbol(ctx->current_token->token, FUNCTION_TOKEN, 0, ctx->current_token->start_ln, ctx->current_token->start_col, 0, NULL, NULL);
+    int fid_length = strlen(ctx->current_token->token);
+    int start_col = ctx->current_token->start_col;
+    fid_symb->param_list = NULL;
     int param_count = 0;
     ParamType **head_param = &(fid_symb->param_list);
     ParamType **current_param = head_param;
-    current_table = make_table(current_table);
-    symbol_insert(current_table, copy_symb);
-    next_token();
-    if (match(OP_TOKEN)) {
+    SymbolTable *routine_tables = ctx->main_table->child;
+    ctx->current_table = make_table(ctx->main_table);
+    ctx->current_table->child = routine_tables; // Routine tables stay chained to the main table so they are freed with it
+    symbol_insert(ctx->current_table, copy_symb);
+    next_token(ctx);
+    if (match(ctx, OP_TOKEN)) {
         int id_found = 0, ref_pass = 0;
         do {
-            next_token();
-            if (match(VAR_TOKEN)) { // Case of passing an argument by reference
+            next_token(ctx);
+            if (match(ctx, VAR_TOKEN)) { // Case of passing an argument by reference
                 id_found = ref_pass = 1;
-                next_token();
+                next_token(ctx);
             }
-            if (id_found && !match(ID_TOKEN)) {
-                syntax_error(ID_TOKEN);
+            if (id_found && !match(ctx, ID_TOKEN)) {
+                syntax_error(ctx, ID_TOKEN);
                 return 0;
             }
-            if (match(ID_TOKEN)) {
+            if (match(ctx, ID_TOKEN)) {
                 id_found = 1;
                 param_count++;
                 TokenType param_type = ref_pass ? VAR_TOKEN : CONST_TOKEN;
-                Symbol *new_psymb = make_symbol(current_token->token, param_type, 0, current_token->start_ln, current_token->start_col, 1, NULL, NULL);
+                Symbol *new_psymb = make_symbol(ctx->current_token->token, param_type, 0, ctx->current_token->start_ln, ctx->current_token->start_col, 1, NULL, NULL);
                 if (*current_param == NULL) {
                     *current_param = malloc(sizeof(ParamType));
                 }
-                // printf("\n%s\n\n", current_param->param_symbol->name);
+                // fprintf(ctx->log_fptr, "\n%s\n\n", current_param->param_symbol->name);
                 (*current_param)->param_symbol = new_psymb;
                 (*current_param)->ref_pass = ref_pass;
                 (*current_param)->next = NULL;
-                if (symbol_lookup_insert(current_table, new_psymb) == 1) {
-                    printf("Error: duplicate parameter identifier at line %d, char %d\n", current_token->start_ln, current_token->start_col);
+                if (symbol_lookup_insert(ctx->current_table, new_psymb) == 1) {
+                    fprintf(ctx->log_fptr, "Error: duplicate parameter identifier at line %d, char %d\n", ctx->current_token->start_ln, ctx->current_token->start_col);
                     return 0;
                 }
-                next_token();
-                while (match(COMMA_TOKEN)) {
-                    next_token();
-                    if (!match(ID_TOKEN)) {
-                        syntax_error(ID_TOKEN);
+                next_token(ctx);
+                while (match(ctx, COMMA_TOKEN)) {
+                    next_token(ctx);
+                    if (!match(ctx, ID_TOKEN)) {
+                        syntax_error(ctx, ID_TOKEN);
                         return 0;
                     }
                     param_count++;
                     (*current_param)->next = malloc(sizeof(ParamType));
-                    new_psymb = make_symbol(current_token->token, param_type, 0, current_token->start_ln, current_token->start_col, 1, NULL, NULL);
+                    new_psymb = make_symbol(ctx->current_token->token, param_type, 0, ctx->current_token->start_ln, ctx->current_token->start_col, 1, NULL, NULL);
                     (*current_param)->next->param_symbol = new_psymb;
                     (*current_param)->next->ref_pass = ref_pass;
                     (*current_param)->next->next = NULL;
                     current_param = &(*current_param)->next;
-                    if (symbol_lookup_insert(current_table, new_psymb) == 1) {
-                        printf("Error: duplicate parameter identifier at line %d, char %d\n", current_token->start_ln, current_token->start_col);
+                    if (symbol_lookup_insert(ctx->current_table, new_psymb) == 1) {
+                        fprintf(ctx->log_fptr, "Error: duplicate parameter identifier at line %d, char %d\n", ctx->current_token->start_ln, ctx->current_token->start_col);
                         return 0;
                     }
-                    next_token();
+                    next_token(ctx);
                 }
                 current_param = &(*current_param)->next;
-                if (!match(COLON_TOKEN)) {
-                    syntax_error(COLON_TOKEN);
+                if (!match(ctx, COLON_TOKEN)) {
+                    syntax_error(ctx, COLON_TOKEN);
                     return 0;
                 }
-                next_token();
-                if (!is_variable_type()) {
-                    syntax_error(VTYPE_TOKEN);
+                next_token(ctx);
+                if (!is_variable_type(ctx)) {
+                    syntax_error(ctx, VTYPE_TOKEN);
                     return 0;
                 }
                 while (*head_param != NULL) {
-                    (*head_param)->param_symbol->token_type = current_token->type;
-                    if (!name_mangle(&(fid_symb->name), &fid_length, current_token->type, NULL)) {
+                    (*head_param)->param_symbol->token_type = ctx->current_token->type;
+                    if (!name_mangle(&(fid_symb->name), &fid_length, ctx->current_token->type, NULL)) {
                         return 0;
                     }
                     head_param = &(*head_param)->next;
                 }
                 ref_pass = 0;
-                next_token();
+                next_token(ctx);
             }
-        } while (id_found && match(SC_TOKEN));
-        if (!match(CP_TOKEN)) {
-            syntax_error(CP_TOKEN);
+        } while (id_found && match(ctx, SC_TOKEN));
+        if (!match(ctx, CP_TOKEN)) {
+            syntax_error(ctx, CP_TOKEN);
             return 0;
         }
-        next_token();
+        next_token(ctx);
     }
-    // printf("\n%s\n\n", fid_symb->name);
+    // fprintf(ctx->log_fptr, "\n%s\n\n", fid_symb->name);
     if (param_count == 0) {
         if (!name_mangle(&(fid_symb->name), &fid_length, -1, NULL)) {
             return 0;
         }
     }
-    if (symbol_lookup_insert(main_table, fid_symb) == 1) {
-        printf("Error: overloaded function has the same parameter list at line %d, char %d\n", fid_symb->line, start_col);
+    if (symbol_lookup_insert(ctx->main_table, fid_symb) == 1) {
+        fprintf(ctx->log_fptr, "Error: overloaded function has the same parameter list at line %d, char %d\n", fid_symb->line, start_col);
         return 0;
     }
-    if (!match(COLON_TOKEN)) {
-        syntax_error(COLON_TOKEN);
+    if (!match(ctx, COLON_TOKEN)) {
+        syntax_error(ctx, COLON_TOKEN);
         return 0;
     }
-    next_token();
-    if (!is_variable_type()) {
-        syntax_error(VTYPE_TOKEN);
+    next_token(ctx);
+    if (!is_variable_type(ctx)) {
+        syntax_error(ctx, VTYPE_TOKEN);
         return 0;
     }
-    fid_symb->token_type = current_token->type;
-    copy_symb->token_type = current_token->type;
+    fid_symb->token_type = ctx->current_token->type;
+    copy_symb->token_type = ctx->current_token->type;
     fid_symb->dimension = param_count;
     copy_symb->dimension = param_count;
-    next_token();
-    if (!match(SC_TOKEN)) {
-        syntax_error(SC_TOKEN);
+    next_token(ctx);
+    if (!match(ctx, SC_TOKEN)) {
+        syntax_error(ctx, SC_TOKEN);
         return 0;
     }
-    next_token();
-    if (!declaration_routine()) {
+    next_token(ctx);
+    TacList declarations = empty_tac(), initializations = empty_tac(), body = empty_tac();
+    if (!declaration_routine(ctx, &declarations, &initializations)) {
         return 0;
     }
-    if (!parse_begin(1)) {
+    if (!parse_begin(ctx, 1, &body)) {
         return 0;
     }
-    if (!match(END_TOKEN)) {
-        syntax_error(END_TOKEN);
+    if (!match(ctx, END_TOKEN)) {
+        syntax_error(ctx, END_TOKEN);
         return 0;
     }
-    next_token();
-    if (!match(SC_TOKEN)) {
-        syntax_error(SC_TOKEN);
+    next_token(ctx);
+    if (!match(ctx, SC_TOKEN)) {
+        syntax_error(ctx, SC_TOKEN);
         return 0;
     }
-    next_token();
-    return parse_functions();
+    next_token(ctx);
+    ctx->current_table = ctx->main_table;
+    if (ctx->options.syntax_only) // No code refers to the table
+        release_routine_table(ctx, fid_symb);
+    *code = tac_function(ctx, fid_symb, copy_symb, join_tac(declarations, initializations), body);
+    return 1;
 }
 
-int parse_procedures() {
-    if (!match(PROCEDURE_TOKEN)) {
-        if (match(CONST_TOKEN)) {
-            return parse_constants();
-        }
-        else if (match(VAR_TOKEN)) {
-            return parse_declarations();
-        }
-        else if (match(FUNCTION_TOKEN)) {
-            return parse_functions();
-        }
-        else if (match(BEGIN_TOKEN)) {
-            return parse_begin(0);
-        }
-        else {
-            syntax_error(BEGIN_TOKEN);
-            return 0;
-        }
+int parse_procedures(CompilerContext *ctx, TacList *code) {
+    if (!match(ctx, PROCEDURE_TOKEN)) {
+        syntax_error(ctx, PROCEDURE_TOKEN);
+        return 0;
     }
-    next_token();
-    if (!match(ID_TOKEN)) {
-        syntax_error(ID_TOKEN);
+    next_token(ctx);
+    if (!match(ctx, ID_TOKEN)) {
+        syntax_error(ctx, ID_TOKEN);
         return 0;
     }
-    if (symbol_lookup(main_table, current_token->token) != NULL) {
-        printf("Error: identifier %s is not a procedure at line %d, char %d\n", current_token->token, current_token->start_ln, current_token->start_col);
+    if (symbol_lookup(ctx->main_table, ctx->current_token->token) != NULL || symbol_builtin_lookup(ctx->current_token->token) != NULL) {
+        fprintf(ctx->log_fptr, "Error: identifier %s is not a procedure at line %d, char %d\n", ctx->current_token->token, ctx->current_token->start_ln, ctx->current_token->start_col);
         return 0;
     }
-    Symbol *pid_symb  = make_symbol(current_token->token, PROCEDURE_TOKEN, 0, current_token->start_ln, current_token->start_col, 0, NULL, NULL);
-    int pid_length = strlen(current_token->token);
-    int start_col = current_token->start_col;
+    Symbol *pid_symb  = make_symbol(ctx->current_token->token, PROCEDURE_TOKEN, 0, ctx->current_token->start_ln, ctx->current_token->start_col, 0, NULL, NULL);
+    int pid_length = strlen(ctx->current_token->token);
+    int start_col = ctx->current_token->start_col;
     pid_symb->param_list = NULL;
     int param_count = 0;
     ParamType **head_param = &(pid_symb->param_list);
     ParamType **current_param = head_param;
-    current_table = make_table(current_table);
-    next_token();
-    if (match(OP_TOKEN)) {
+    SymbolTable *routine_tables = ctx->main_table->child;
+    ctx->current_table = make_table(ctx->main_table);
+    ctx->current_table->child = routine_tables; // Routine tables stay chained to the main table so they are freed with it
+    next_token(ctx);
+    if (match(ctx, OP_TOKEN)) {
         int id_found = 0, ref_pass = 0;
         do {
-            next_token();
-            if (match(VAR_TOKEN)) { // Case of passing an argument by reference
+            next_token(ctx);
+            if (match(ctx, VAR_TOKEN)) { // Case of passing an argument by reference
                 id_found = ref_pass = 1;
-                next_token();
+                next_token(ctx);
             }
-            if (id_found && !match(ID_TOKEN)) {
-                syntax_error(ID_TOKEN);
+            if (id_found && !match(ctx, ID_TOKEN)) {
+                syntax_error(ctx, ID_TOKEN);
                 return 0;
             }
-            if (match(ID_TOKEN)) {
+            if (match(ctx, ID_TOKEN)) {
                 id_found = 1;
                 param_count++;
                 TokenType param_type = ref_pass ? VAR_TOKEN : CONST_TOKEN;
-                Symbol *new_psymb = make_symbol(current_token->token, param_type, 0, current_token->start_ln, current_token->start_col, 1, NULL, NULL);
+                Symbol *new_psymb = make_symbol(ctx->current_token->token, param_type, 0, ctx->current_token->start_ln, ctx->current_token->start_col, 1, NULL, NULL);
                 if (*current_param == NULL) {
                     *current_param = malloc(sizeof(ParamType));
                 }
-                // printf("\n%s\n\n", current_param->param_symbol->name);
+                // fprintf(ctx->log_fptr, "\n%s\n\n", current_param->param_symbol->name);
                 (*current_param)->param_symbol = new_psymb;
                 (*current_param)->ref_pass = ref_pass;
                 (*current_param)->next = NULL;
-                if (symbol_lookup_insert(current_table, new_psymb) == 1) {
-                    printf("Error: duplicate parameter identifier at line %d, char %d\n", current_token->start_ln, current_token->start_col);
+                if (symbol_lookup_insert(ctx->current_table, new_psymb) == 1) {
+                    fprintf(ctx->log_fptr, "Error: duplicate parameter identifier at line %d, char %d\n", ctx->current_token->start_ln, ctx->current_token->start_col);
                     return 0;
                 }
-                next_token();
-                while (match(COMMA_TOKEN)) {
-                    next_token();
-                    if (!match(ID_TOKEN)) {
-                        syntax_error(ID_TOKEN);
+                next_token(ctx);
+                while (match(ctx, COMMA_TOKEN)) {
+                    next_token(ctx);
+                    if (!match(ctx, ID_TOKEN)) {
+                        syntax_error(ctx, ID_TOKEN);
                         return 0;
                     }
                     param_count++;
                     (*current_param)->next = malloc(sizeof(ParamType));
-                    new_psymb = make_symbol(current_token->token, param_type, 0, current_token->start_ln, current_token->start_col, 1, NULL, NULL);
+                    new_psymb = make_symbol(ctx->current_token->token, param_type, 0, ctx->current_token->start_ln, ctx->current_token->start_col, 1, NULL, NULL);
                     (*current_param)->next->param_symbol = new_psymb;
                     (*current_param)->next->ref_pass = ref_pass;
                     (*current_param)->next->next = NULL;
                     current_param = &(*current_param)->next;
-                    if (symbol_lookup_insert(current_table, new_psymb) == 1) {
-                        printf("Error: duplicate parameter identifier at line %d, char %d\n", current_token->start_ln, current_token->start_col);
+                    if (symbol_lookup_insert(ctx->current_table, new_psymb) == 1) {
+                        fprintf(ctx->log_fptr, "Error: duplicate parameter identifier at line %d, char %d\n", ctx->current_token->start_ln, ctx->current_token->start_col);
                         return 0;
                     }
-                    next_token();
+                    next_token(ctx);
                 }
                 current_param = &(*current_param)->next;
-                if (!match(COLON_TOKEN)) {
-                    syntax_error(COLON_TOKEN);
+                if (!match(ctx, COLON_TOKEN)) {
+                    syntax_error(ctx, COLON_TOKEN);
                     return 0;
                 }
-                next_token();
-                if (!is_variable_type()) {
-                    syntax_error(VTYPE_TOKEN);
+                next_token(ctx);
+                if (!is_variable_type(ctx)) {
+                    syntax_error(ctx, VTYPE_TOKEN);
                     return 0;
                 }
                 while (*head_param != NULL) {
-                    (*head_param)->param_symbol->token_type = current_token->type;
-                    if (!name_mangle(&(pid_symb->name), &pid_length, current_token->type, NULL)) {
+                    (*head_param)->param_symbol->token_type = ctx->current_token->type;
+                    if (!name_mangle(&(pid_symb->name), &pid_length, ctx->current_token->type, NULL)) {
                         return 0;
                     }
                     head_param = &(*head_param)->next;
                 }
                 ref_pass = 0;
-                next_token();
+                next_token(ctx);
             }
-        } while (id_found && match(SC_TOKEN));
-        if (!match(CP_TOKEN)) {
-            syntax_error(CP_TOKEN);
+        } while (id_found && match(ctx, SC_TOKEN));
+        if (!match(ctx, CP_TOKEN)) {
+            syntax_error(ctx, CP_TOKEN);
             return 0;
         }
-        next_token();
+        next_token(ctx);
     }
-    // printf("\n%s\n\n", pid_symb->name);
+    // fprintf(ctx->log_fptr, "\n%s\n\n", pid_symb->name);
     if (param_count == 0) {
         if (!name_mangle(&(pid_symb->name), &pid_length, -1, NULL)) {
             return 0;
         }
     }
-    if (symbol_lookup_insert(main_table, pid_symb) == 1) {
-        printf("Error: overloaded procedure has the same parameter list at line %d, char %d\n", pid_symb->line, start_col);
+    if (symbol_lookup_insert(ctx->main_table, pid_symb) == 1) {
+        fprintf(ctx->log_fptr, "Error: overloaded procedure has the same parameter list at line %d, char %d\n", pid_symb->line, start_col);
         return 0;
     }
     pid_symb->dimension = param_count;
-    if (!match(SC_TOKEN)) {
-        syntax_error(SC_TOKEN);
+    if (!match(ctx, SC_TOKEN)) {
+        syntax_error(ctx, SC_TOKEN);
         return 0;
     }
-    next_token();
-    if (!declaration_routine()) {
+    next_token(ctx);
+    TacList declarations = empty_tac(), initializations = empty_tac(), body = empty_tac();
+    if (!declaration_routine(ctx, &declarations, &initializations)) {
         return 0;
     }
-    if (!parse_begin(1)) {
+    if (!parse_begin(ctx, 1, &body)) {
         return 0;
     }
-    if (!match(END_TOKEN)) {
-        syntax_error(END_TOKEN);
+    if (!match(ctx, END_TOKEN)) {
+        syntax_error(ctx, END_TOKEN);
         return 0;
     }
-    next_token();
-    if (!match(SC_TOKEN)) {
-        syntax_error(SC_TOKEN);
+    next_token(ctx);
+    if (!match(ctx, SC_TOKEN)) {
+        syntax_error(ctx, SC_TOKEN);
         return 0;
     }
-    next_token();
-    return parse_procedures();
+    next_token(ctx);
+    ctx->current_table = ctx->main_table;
+    if (ctx->options.syntax_only) // No code refers to the table
+        release_routine_table(ctx, pid_symb);
+    *code = tac_procedure(ctx, pid_symb, join_tac(declarations, initializations), body);
+    return 1;
 }
 
-int parse_begin(int no_end_check) {
-    if (!match(BEGIN_TOKEN)) {
-        syntax_error(BEGIN_TOKEN);
+SectionState next_section(CompilerContext *ctx, const int allow_uses) {
+    if (match(ctx, USES_TOKEN) && allow_uses)
+        return USES_SECTION;
+    if (match(ctx, CONST_TOKEN))
+        return CONST_SECTION;
+    if (match(ctx, VAR_TOKEN))
+        return VAR_SECTION;
+    if (match(ctx, FUNCTION_TOKEN))
+        return FUNCTION_SECTION;
+    if (match(ctx, PROCEDURE_TOKEN))
+        return PROCEDURE_SECTION;
+    if (match(ctx, BEGIN_TOKEN))
+        return BEGIN_SECTION;
+    return ERROR_SECTION;
+}
+
+int parse_sections(CompilerContext *ctx) {
+    // Sections are parsed one after the other in a loop instead of having each section parser call the next one,
+    // the stack depth stays the same no matter how many sections the source file has
+    SectionState state = next_section(ctx, 1); // Libraries can only be used before any other section
+    TacList declarations = empty_tac(), initializations = empty_tac(), routines = empty_tac(), body = empty_tac();
+    while (state != BEGIN_SECTION) {
+        int section_result = 0;
+        TacList routine = empty_tac();
+        TacMark mark = mark_tac(ctx); // What the routine allocates is released once it is translated
+        switch (state) {
+            case USES_SECTION:
+                section_result = parse_used_libraries(ctx);
+                break;
+            case CONST_SECTION:
+                section_result = parse_constants(ctx);
+                break;
+            case VAR_SECTION:
+                section_result = parse_declarations(ctx, &declarations, &initializations);
+                break;
+            case FUNCTION_SECTION:
+                section_result = parse_functions(ctx, &routine);
+                break;
+            case PROCEDURE_SECTION:
+                section_result = parse_procedures(ctx, &routine);
+                break;
+            default:
+                syntax_error(ctx, BEGIN_TOKEN);
+                return 0;
+        }
+        if (!section_result) {
+            return 0;
+        }
+        if (ctx->generator != NULL && routine.head != NULL) { // Translated right away, only the global code is kept
+            if (!stream_routine(ctx, declarations, routine, mark))
+                return 0;
+            routine = empty_tac();
+        }
+        routines = join_tac(routines, routine);
+        state = next_section(ctx, 0);
+    }
+    if (!parse_begin(ctx, 0, &body)) {
+        return 0;
+    }
+    // Global variables come first, then the functions/procedures and the main block which starts with the global initializations
+    ctx->program_tac = join_tac(join_tac(declarations, routines), tac_program(ctx, initializations, body));
+    return 1;
+}
+
+int parse_begin(CompilerContext *ctx, int no_end_check, TacList *code) {
+    if (!match(ctx, BEGIN_TOKEN)) {
+        syntax_error(ctx, BEGIN_TOKEN);
         return 0;
     }
-    next_token();
-    if (current_token == NULL) {
+    next_token(ctx);
+    if (ctx->current_token == NULL) {
         return 0;
     }
     int parse_result = 0;
-    while (!match(END_TOKEN) && (parse_result = parse_statement())) {
-        if (current_token == NULL) {
+    TacList statement;
+    while (!match(ctx, END_TOKEN) && (parse_result = parse_statement(ctx, &statement))) {
+        *code = join_tac(*code, statement);
+        if (ctx->current_token == NULL) {
             return 0;
         }
-        if (!match(SC_TOKEN)) {
-            if (!match(END_TOKEN)) {
-                syntax_error(SC_TOKEN);
+        if (!match(ctx, SC_TOKEN)) {
+            if (!match(ctx, END_TOKEN)) {
+                syntax_error(ctx, SC_TOKEN);
                 return 0;
             }
         }
         else {
-            next_token();
+            next_token(ctx);
         }
     }
     if (!no_end_check) {
-        if (match(END_TOKEN)) {
-            next_token();
-            if (!match(PERIOD_TOKEN)) {
-                syntax_error(PERIOD_TOKEN);
+        if (match(ctx, END_TOKEN)) {
+            next_token(ctx);
+            if (!match(ctx, PERIOD_TOKEN)) {
+                syntax_error(ctx, PERIOD_TOKEN);
                 return 0;
             }
-            next_token();
-            if (!match(EOF_TOKEN)) {
-                syntax_error(EOF_TOKEN);
+            next_token(ctx);
+            if (!match(ctx, EOF_TOKEN)) {
+                syntax_error(ctx, EOF_TOKEN);
                 return 0;
             }
         }
         else if (parse_result) {
-            syntax_error(END_TOKEN);
+            syntax_error(ctx, END_TOKEN);
             return 0;
         }
     }
@@ -898,429 +926,679 @@ int parse_begin(int no_end_check) {
     return 1;
 }
 
-int parse_statement() { // Doesn't include a semicolon check and already points on to the next token
-    if (match(ID_TOKEN)) {
-        TokenData *start_token = copy_token_data(current_token);
-        next_token();
-        if (match(ASSIGN_TOKEN)) {
+int parse_statement(CompilerContext *ctx, TacList *code) { // Doesn't include a semicolon check and already points on to the next token
+    *code = empty_tac();
+    if (match(ctx, ID_TOKEN)) {
+        TokenData *start_token = copy_token_data(ctx->current_token);
+        next_token(ctx);
+        if (match(ctx, ASSIGN_TOKEN)) {
             Symbol *assign_symb;
-            if ((assign_symb = symbol_deep_lookup(start_token->token)) == NULL) {
-                printf("Error: identifier \"%s\" not previously declared at line %d, char %d\n", current_token->token,
-                    current_token->start_ln, current_token->start_col);
+            if ((assign_symb = symbol_deep_lookup(ctx, start_token->token)) == NULL) {
+                fprintf(ctx->log_fptr, "Error: identifier \"%s\" not previously declared at line %d, char %d\n", ctx->current_token->token,
+                    ctx->current_token->start_ln, ctx->current_token->start_col);
                 free(start_token->token);
                 free(start_token);
                 return 0;
             }
             if (assign_symb->declaration_type == CONST_TOKEN) {
-                printf("Error: expected variable identifier but got constant at line %d, char %d\n", current_token->start_ln,
-                    current_token->start_col);
+                fprintf(ctx->log_fptr, "Error: expected variable identifier but got constant at line %d, char %d\n", ctx->current_token->start_ln,
+                    ctx->current_token->start_col);
                 free(start_token->token);
                 free(start_token);
                 return 0;
             }
-            return assign_statement(assign_symb);
+            return assign_statement(ctx, assign_symb, code);
         }
-        else if (match(OP_TOKEN)) {
-            return function_call_check(start_token, -1) != NULL ? 1 : 0;
+        else if (match(ctx, OP_TOKEN)) {
+            ExprNode *call = NULL;
+            if (function_call_check(ctx, start_token, -1, &call) == NULL)
+                return 0;
+            if (call != NULL) { // The result of a function called as a statement is dropped
+                *code = call->tac;
+                free_node(call);
+            }
+            return 1;
         }
         return 0;
     }
-    if (match(IF_TOKEN))
-        return if_statement();
-    if (match(WHILE_TOKEN))
-        return while_statement();
-    if (match(FOR_TOKEN))
-        return for_statement();
-    if (match(WRITE_TOKEN) || match(WRITELN_TOKEN))
-        return write_statement();
-    if (match(READ_TOKEN))
-        return read_statement();
-    if (!match(EOF_TOKEN))
-        printf("Error: illegal expression at line %d, char %d\n", current_token->start_ln, current_token->start_col);
+    if (match(ctx, IF_TOKEN))
+        return if_statement(ctx, code);
+    if (match(ctx, WHILE_TOKEN))
+        return while_statement(ctx, code);
+    if (match(ctx, FOR_TOKEN))
+        return for_statement(ctx, code);
+    if (match(ctx, WRITE_TOKEN) || match(ctx, WRITELN_TOKEN))
+        return write_statement(ctx, code);
+    if (match(ctx, READ_TOKEN) || match(ctx, READLN_TOKEN))
+        return read_statement(ctx, code);
+    if (!match(ctx, EOF_TOKEN))
+        fprintf(ctx->log_fptr, "Error: illegal expression at line %d, char %d\n", ctx->current_token->start_ln, ctx->current_token->start_col);
     return 0;
 }
 
-int rvalue_statement(const TokenType expected_type) {
+typedef struct _ExprBuilder { // Applies the operators precedence to a sequence of operands (* / and before + - or)
+    ExprNode *sum;
+    ExprNode *term;
+    TacOp sum_op; // Operator between the sum and the current term, 0 while there is no sum
+    TacOp next_op; // Operator read before the next operand, 0 before the first operand
+} ExprBuilder;
+
+void init_builder(ExprBuilder *builder) {
+    builder->sum = NULL;
+    builder->term = NULL;
+    builder->sum_op = 0;
+    builder->next_op = 0;
+}
+
+int is_term_op(const TacOp op) {
+    return op == TAC_MULT || op == TAC_DIV || op == TAC_AND;
+}
+
+TacOp operator_op(CompilerContext *ctx) {
+    if (match(ctx, PLUS_TOKEN))
+        return TAC_ADD;
+    if (match(ctx, MINUS_TOKEN))
+        return TAC_SUB;
+    if (match(ctx, MULT_TOKEN))
+        return TAC_MULT;
+    if (match(ctx, RDIV_TOKEN))
+        return TAC_DIV;
+    if (match(ctx, AND_TOKEN))
+        return TAC_AND;
+    if (match(ctx, OR_TOKEN))
+        return TAC_OR;
+    if (match(ctx, EQ_TOKEN))
+        return TAC_EQ;
+    if (match(ctx, LESS_TOKEN))
+        return TAC_LT;
+    if (match(ctx, LEQ_TOKEN))
+        return TAC_LTE;
+    if (match(ctx, BIGGER_TOKEN))
+        return TAC_GT;
+    if (match(ctx, BEQ_TOKEN))
+        return TAC_GTE;
+    if (match(ctx, DIFF_TOKEN))
+        return TAC_NEQ;
+    return 0;
+}
+
+void push_operand(CompilerContext *ctx, ExprBuilder *builder, ExprNode *operand) {
+    if (builder->next_op == 0)
+        builder->term = operand;
+    else if (is_term_op(builder->next_op))
+        builder->term = tac_binary_op(ctx, builder->next_op, builder->term, operand);
+    else {
+        builder->sum = builder->sum_op == 0 ? builder->term : tac_binary_op(ctx, builder->sum_op, builder->sum, builder->term);
+        builder->sum_op = builder->next_op;
+        builder->term = operand;
+    }
+    builder->next_op = 0;
+}
+
+ExprNode* finish_builder(CompilerContext *ctx, ExprBuilder *builder) {
+    if (builder->sum_op == 0)
+        return builder->term;
+    return tac_binary_op(ctx, builder->sum_op, builder->sum, builder->term);
+}
+
+int call_operand(CompilerContext *ctx, const TokenData *token_data, const TokenType expected_type, ExprNode **call) {
+    Symbol *routine = function_call_check(ctx, token_data, expected_type, call);
+    if (routine == NULL)
+        return 0;
+    if (routine->declaration_type == PROCEDURE_TOKEN) {
+        fprintf(ctx->log_fptr, "Error: cannot assign procedure to a variable or call it as an argument at line %d, char %d\n",
+            token_data->start_ln, token_data->start_col);
+        return 0;
+    }
+    return 1;
+}
+
+int rvalue_statement(CompilerContext *ctx, const TokenType expected_type, ExprNode **expr) {
+    // The value is returned through expr (which can be NULL when only the checks are needed)
     Symbol *tmp = NULL;
+    ExprBuilder builder;
+    init_builder(&builder);
     do {
-        next_token();
-        if (!match(ID_TOKEN)) {
-            if (match(OP_TOKEN)) {
+        builder.next_op = is_logical_op(ctx) ? operator_op(ctx) : 0; // No operator before the first operand
+        next_token(ctx);
+        if (!match(ctx, ID_TOKEN)) {
+            if (match(ctx, OP_TOKEN)) {
+                ExprBuilder group;
+                init_builder(&group);
                 do {
-                    next_token();
-                    if (match(ID_TOKEN)) {
-                        TokenData *token_data = copy_token_data(current_token);
-                        next_token();
-                        if (match(OP_TOKEN)) { // Case of a function/procedure call (Note: procedures cannot be assigned to a variable or called as an argument)
-                            if (!function_call_check(token_data, expected_type)) {
+                    group.next_op = is_logical_op(ctx) ? operator_op(ctx) : 0;
+                    next_token(ctx);
+                    if (match(ctx, ID_TOKEN)) {
+                        TokenData *token_data = copy_token_data(ctx->current_token);
+                        next_token(ctx);
+                        if (match(ctx, OP_TOKEN)) { // Case of a function/procedure call (Note: procedures cannot be assigned to a variable or called as an argument)
+                            ExprNode *call = NULL;
+                            if (!call_operand(ctx, token_data, expected_type, &call)) {
                                 free(token_data->token);
                                 free(token_data);
                                 return 0;
                             }
+                            push_operand(ctx, &group, call);
                         }
                         else {
-                            tmp = symbol_deep_lookup(token_data->token);
+                            tmp = symbol_deep_lookup(ctx, token_data->token);
                             if (tmp == NULL) {
-                                printf("Error: identifier \"%s\" not previously declared at line %d, char %d\n", token_data->token, 
+                                fprintf(ctx->log_fptr, "Error: identifier \"%s\" not previously declared at line %d, char %d\n", token_data->token, 
                                     token_data->start_ln, token_data->start_col);
                                 free(token_data->token);
                                 free(token_data);
                                 return 0;
                             }
                             if (!type_check(expected_type, tmp->token_type)) {
-                                type_mismatch_error(expected_type, tmp->token_type);
+                                type_mismatch_error(ctx, expected_type, tmp->token_type);
                                 free(token_data->token);
                                 free(token_data);
                                 return 0;
                             }
+                            push_operand(ctx, &group, make_node(ctx, tmp));
                         }
                         free(token_data->token);
                         free(token_data);
                     }
-                    else if (is_value_type()) {
-                        if (!type_check(expected_type, current_token->type)) {
-                            type_mismatch_error(expected_type, current_token->type);
+                    else if (is_value_type(ctx)) {
+                        if (!type_check(expected_type, ctx->current_token->type)) {
+                            type_mismatch_error(ctx, expected_type, ctx->current_token->type);
                             return 0;
                         }
-                        next_token();
+                        push_operand(ctx, &group, value_node(ctx));
+                        next_token(ctx);
                     }
                     else {
-                        printf("Error: expected token identifier or rvalue but got %s at line %d, char %d\n",
-                            current_token->token, current_token->start_ln, current_token->start_col);
+                        fprintf(ctx->log_fptr, "Error: expected token identifier or rvalue but got %s at line %d, char %d\n",
+                            ctx->current_token->token, ctx->current_token->start_ln, ctx->current_token->start_col);
                         return 0;
                     }
-                } while(is_logical_op());
-                if (!match(CP_TOKEN)) {
-                    syntax_error(CP_TOKEN);
+                } while(is_logical_op(ctx));
+                if (!match(ctx, CP_TOKEN)) {
+                    syntax_error(ctx, CP_TOKEN);
                     return 0;
                 }
+                push_operand(ctx, &builder, finish_builder(ctx, &group));
             }
-            else if (!is_value_type()) {
-                printf("Error: expected token identifier or rvalue but got %s at line %d, char %d\n",
-                    current_token->token, current_token->start_ln, current_token->start_col);
+            else if (!is_value_type(ctx)) {
+                fprintf(ctx->log_fptr, "Error: expected token identifier or rvalue but got %s at line %d, char %d\n",
+                    ctx->current_token->token, ctx->current_token->start_ln, ctx->current_token->start_col);
                 return 0;
             }
-            else if (!type_check(expected_type, current_token->type)) {
-                type_mismatch_error(expected_type, current_token->type);
+            else if (!type_check(expected_type, ctx->current_token->type)) {
+                type_mismatch_error(ctx, expected_type, ctx->current_token->type);
                 return 0;
             }
-            next_token();
+            else
+                push_operand(ctx, &builder, value_node(ctx));
+            next_token(ctx);
         }
         else { // Identifier token read
-            TokenData *token_data = copy_token_data(current_token);
-            next_token();
-            if (match(OP_TOKEN)) { // Function or procedure call
-                if (!function_call_check(token_data, expected_type)) {
+            TokenData *token_data = copy_token_data(ctx->current_token);
+            next_token(ctx);
+            if (match(ctx, OP_TOKEN)) { // Function or procedure call
+                ExprNode *call = NULL;
+                if (!call_operand(ctx, token_data, expected_type, &call)) {
                     free(token_data->token);
                     free(token_data);
                     return 0;
                 }
+                push_operand(ctx, &builder, call);
             }
             else {
-                tmp = symbol_deep_lookup(token_data->token);
+                tmp = symbol_deep_lookup(ctx, token_data->token);
                 if (tmp == NULL) {
-                    printf("Error: identifier \"%s\" not previously declared at line %d, char %d\n", token_data->token, 
+                    fprintf(ctx->log_fptr, "Error: identifier \"%s\" not previously declared at line %d, char %d\n", token_data->token, 
                         token_data->start_ln, token_data->start_col);
                     free(token_data->token);
                     free(token_data);
                     return 0;
                 }
                 if (!type_check(expected_type, tmp->token_type)) {
-                    type_mismatch_error(expected_type, tmp->token_type);
+                    type_mismatch_error(ctx, expected_type, tmp->token_type);
                     free(token_data->token);
                     free(token_data);
                     return 0;
                 }
+                push_operand(ctx, &builder, make_node(ctx, tmp));
             }
             free(token_data->token);
             free(token_data);
         }
-    } while (is_logical_op());
+    } while (is_logical_op(ctx));
+    ExprNode *result = finish_builder(ctx, &builder);
+    if (expr != NULL)
+        *expr = result;
+    else
+        free_node(result);
+    return 1;
+}
+
+int condition_operand(CompilerContext *ctx, ExprNode **node) { // Identifier or value of a condition, already points on the next token
+    if (!match(ctx, ID_TOKEN) && !is_value_type(ctx)) {
+        fprintf(ctx->log_fptr, "Error: expected token identifier or rvalue but got %s at line %d, char %d\n",
+            ctx->current_token->token, ctx->current_token->start_ln, ctx->current_token->start_col);
+        return 0;
+    }
+    if (match(ctx, ID_TOKEN)) {
+        Symbol *symb = symbol_deep_lookup(ctx, ctx->current_token->token);
+        if (symb == NULL) {
+            fprintf(ctx->log_fptr, "Error: identifier \"%s\" not previously declared at line %d, char %d\n", ctx->current_token->token,
+                ctx->current_token->start_ln, ctx->current_token->start_col);
+            return 0;
+        }
+        *node = make_node(ctx, symb);
+    }
+    else
+        *node = value_node(ctx);
+    next_token(ctx);
     return 1;
 }
 
-int condition_statement() {
-    if (!match(ID_TOKEN) && !is_value_type()) {
-        if (match(NOT_TOKEN))
-            next_token();
-        if (!match(OP_TOKEN)) {
-            printf("Error: expected condition statement but got %s at line %d, char %d\n",
-                current_token->token, current_token->start_ln, current_token->start_col);
+int condition_statement(CompilerContext *ctx, ExprNode **expr) {
+    ExprNode *left = NULL, *right = NULL;
+    if (!match(ctx, ID_TOKEN) && !is_value_type(ctx)) {
+        int negate = 0;
+        if (match(ctx, NOT_TOKEN)) {
+            negate = 1;
+            next_token(ctx);
+        }
+        if (!match(ctx, OP_TOKEN)) {
+            fprintf(ctx->log_fptr, "Error: expected condition statement but got %s at line %d, char %d\n",
+                ctx->current_token->token, ctx->current_token->start_ln, ctx->current_token->start_col);
             return 0;
         }
-        while (match(OP_TOKEN)) {
-            next_token();
-            if (!match(ID_TOKEN) && !is_value_type()) {
-                printf("Error: expected token identifier or rvalue but got %s at line %d, char %d\n",
-                    current_token->token, current_token->start_ln, current_token->start_col);
+        ExprBuilder builder;
+        init_builder(&builder);
+        while (match(ctx, OP_TOKEN)) {
+            next_token(ctx);
+            if (!condition_operand(ctx, &left))
                 return 0;
-            }
-            next_token();
-            if (!is_condition_op()) {
-                printf("Error: expected logical operator but got %s at line %d, char %d\n",
-                    current_token->token, current_token->start_ln, current_token->start_col);
+            if (!is_condition_op(ctx)) {
+                fprintf(ctx->log_fptr, "Error: expected logical operator but got %s at line %d, char %d\n",
+                    ctx->current_token->token, ctx->current_token->start_ln, ctx->current_token->start_col);
                 return 0;
             }
-            next_token();
-            if (!match(ID_TOKEN) && !is_value_type()) {
-                printf("Error: expected token identifier or rvalue but got %s at line %d, char %d\n",
-                    current_token->token, current_token->start_ln, current_token->start_col);
+            TacOp op = operator_op(ctx);
+            next_token(ctx);
+            if (!condition_operand(ctx, &right))
                 return 0;
-            }
-            next_token();
-            if (!match(CP_TOKEN)) {
-                syntax_error(CP_TOKEN);
+            if (!match(ctx, CP_TOKEN)) {
+                syntax_error(ctx, CP_TOKEN);
                 return 0;
             }
-            next_token();
-            if (match(AND_TOKEN) || match(OR_TOKEN))
-                next_token();
+            next_token(ctx);
+            ExprNode *relation = tac_relation_op(ctx, op, left, right);
+            if (negate) { // not only applies to the first parenthesized condition
+                relation = tac_unary_op(ctx, TAC_NOT, relation);
+                negate = 0;
+            }
+            push_operand(ctx, &builder, relation);
+            if (match(ctx, AND_TOKEN) || match(ctx, OR_TOKEN)) {
+                builder.next_op = operator_op(ctx);
+                next_token(ctx);
+            }
         }
+        *expr = finish_builder(ctx, &builder);
         return 1;
     }
-    next_token();
-    if (!is_condition_op()) {
-        printf("Error: expected logical operator but got %s at line %d, char %d\n",
-            current_token->token, current_token->start_ln, current_token->start_col);
+    if (!condition_operand(ctx, &left))
+        return 0;
+    if (!is_condition_op(ctx)) {
+        fprintf(ctx->log_fptr, "Error: expected logical operator but got %s at line %d, char %d\n",
+            ctx->current_token->token, ctx->current_token->start_ln, ctx->current_token->start_col);
         return 0;
     }
-    next_token();
-    if (!match(ID_TOKEN) && !is_value_type()) {
-        printf("Error: expected token identifier or number or string literal but got %s at line %d, char %d\n",
-            current_token->token, current_token->start_ln, current_token->start_col);
+    TacOp op = operator_op(ctx);
+    next_token(ctx);
+    if (!match(ctx, ID_TOKEN) && !is_value_type(ctx)) {
+        fprintf(ctx->log_fptr, "Error: expected token identifier or number or string literal but got %s at line %d, char %d\n",
+            ctx->current_token->token, ctx->current_token->start_ln, ctx->current_token->start_col);
         return 0;
     }
-    next_token();
+    if (!condition_operand(ctx, &right))
+        return 0;
+    *expr = tac_relation_op(ctx, op, left, right);
     return 1;
 }
 
-int assign_statement(const Symbol *assign_symb) {
-    if (!match(ASSIGN_TOKEN)) {
-        syntax_error(ASSIGN_TOKEN);
+int assign_statement(CompilerContext *ctx, Symbol *assign_symb, TacList *code) {
+    if (!match(ctx, ASSIGN_TOKEN)) {
+        syntax_error(ctx, ASSIGN_TOKEN);
         return 0;
     }
-    if (!rvalue_statement(assign_symb->token_type))
+    ExprNode *expr = NULL;
+    if (!rvalue_statement(ctx, assign_symb->token_type, &expr))
         return 0;
+    *code = tac_assign(ctx, assign_symb, expr);
     return 1;
 }
 
-int if_statement() {
-    if (!match(IF_TOKEN)) {
-        syntax_error(IF_TOKEN);
+int if_statement(CompilerContext *ctx, TacList *code) {
+    if (!match(ctx, IF_TOKEN)) {
+        syntax_error(ctx, IF_TOKEN);
         return 0;
     }
-    next_token();
-    if (!condition_statement())
+    next_token(ctx);
+    ExprNode *condition = NULL;
+    if (!condition_statement(ctx, &condition))
         return 0;
-    if (!match(THEN_TOKEN)) {
-        syntax_error(THEN_TOKEN);
+    if (!match(ctx, THEN_TOKEN)) {
+        syntax_error(ctx, THEN_TOKEN);
         return 0;
     }
-    next_token();
-    if (!match(BEGIN_TOKEN)) {
-        if (!parse_statement())
+    next_token(ctx);
+    TacList statement = empty_tac(), else_statement = empty_tac();
+    int has_else = 0;
+    if (!match(ctx, BEGIN_TOKEN)) {
+        if (!parse_statement(ctx, &statement))
             return 0;
-        if (match(ELSE_TOKEN)) {
-            next_token();
-            if (match(IF_TOKEN)) // Reminder that this is a case of an else if statement
-                if_statement();
-            else if (!parse_statement())
+        if (match(ctx, ELSE_TOKEN)) {
+            has_else = 1;
+            next_token(ctx);
+            if (match(ctx, IF_TOKEN)) { // Reminder that this is a case of an else if statement
+                if (!if_statement(ctx, &else_statement))
+                    return 0;
+            }
+            else if (!parse_statement(ctx, &else_statement))
                 return 0;
-            if (!match(SC_TOKEN)) {
-                if (!match(END_TOKEN)) { // else case is where we neglect semicolon at the last statement before and end token (OK in Pascal)
-                    syntax_error(SC_TOKEN);
+            if (!match(ctx, SC_TOKEN)) {
+                if (!match(ctx, END_TOKEN)) { // else case is where we neglect semicolon at the last statement before and end token (OK in Pascal)
+                    syntax_error(ctx, SC_TOKEN);
                     return 0;
                 }
             }
         }
-        else if (!match(SC_TOKEN)) {
-            if (!match(END_TOKEN)) { // else case is where we neglect semicolon at the last statement before and end token (OK in Pascal)
-                syntax_error(SC_TOKEN);
+        else if (!match(ctx, SC_TOKEN)) {
+            if (!match(ctx, END_TOKEN)) { // else case is where we neglect semicolon at the last statement before and end token (OK in Pascal)
+                syntax_error(ctx, SC_TOKEN);
                 return 0;
             }
         }
+        *code = has_else ? tac_if_else(ctx, condition, statement, else_statement) : tac_if(ctx, condition, statement);
         return 1;
     }
-    next_token();
-    while (!match(END_TOKEN) && parse_statement()) {
-        if (!match(SC_TOKEN)) {
-            if (!match(END_TOKEN)) { // else case is where we neglect semicolon at the last statement before and end token (OK in Pascal)
-                syntax_error(SC_TOKEN);
+    next_token(ctx);
+    TacList block_statement;
+    while (!match(ctx, END_TOKEN) && parse_statement(ctx, &block_statement)) {
+        statement = join_tac(statement, block_statement);
+        if (!match(ctx, SC_TOKEN)) {
+            if (!match(ctx, END_TOKEN)) { // else case is where we neglect semicolon at the last statement before and end token (OK in Pascal)
+                syntax_error(ctx, SC_TOKEN);
                 return 0;
             }
         }
         else
-            next_token();
+            next_token(ctx);
     }
-    if (!match(END_TOKEN)) {
-        syntax_error(END_TOKEN);
+    if (!match(ctx, END_TOKEN)) {
+        syntax_error(ctx, END_TOKEN);
         return 0;
     }
-    next_token();
-    if (match(ELSE_TOKEN)) {
-        next_token();
-        if (match(IF_TOKEN)) // Reminder that this is a case of an else if statement
-            if_statement();
-        else if (!parse_statement())
+    next_token(ctx);
+    if (match(ctx, ELSE_TOKEN)) {
+        has_else = 1;
+        next_token(ctx);
+        if (match(ctx, IF_TOKEN)) { // Reminder that this is a case of an else if statement
+            if (!if_statement(ctx, &else_statement))
+                return 0;
+        }
+        else if (!parse_statement(ctx, &else_statement))
             return 0;
-        if (!match(SC_TOKEN)) {
-            if (!match(END_TOKEN)) { // else case is where we neglect semicolon at the last statement before and end token (OK in Pascal)
-                syntax_error(SC_TOKEN);
+        if (!match(ctx, SC_TOKEN)) {
+            if (!match(ctx, END_TOKEN)) { // else case is where we neglect semicolon at the last statement before and end token (OK in Pascal)
+                syntax_error(ctx, SC_TOKEN);
                 return 0;
             }
         }
     }
-    else if (!match(SC_TOKEN)) {
-        if (!match(END_TOKEN)) { // else case is where we neglect semicolon at the last statement before and end token (OK in Pascal)
-            syntax_error(SC_TOKEN);
+    else if (!match(ctx, SC_TOKEN)) {
+        if (!match(ctx, END_TOKEN)) { // else case is where we neglect semicolon at the last statement before and end token (OK in Pascal)
+            syntax_error(ctx, SC_TOKEN);
             return 0;
         }
     }
+    *code = has_else ? tac_if_else(ctx, condition, statement, else_statement) : tac_if(ctx, condition, statement);
     return 1;
 }
 
-int while_statement() {
-    if (!match(WHILE_TOKEN)) {
-        syntax_error(WHILE_TOKEN);
+int while_statement(CompilerContext *ctx, TacList *code) {
+    if (!match(ctx, WHILE_TOKEN)) {
+        syntax_error(ctx, WHILE_TOKEN);
         return 0;
     }
-    next_token();
-    if (!condition_statement())
+    next_token(ctx);
+    ExprNode *condition = NULL;
+    if (!condition_statement(ctx, &condition))
         return 0;
-    if (!match(DO_TOKEN)) {
-        syntax_error(DO_TOKEN);
+    if (!match(ctx, DO_TOKEN)) {
+        syntax_error(ctx, DO_TOKEN);
         return 0;
     }
-    next_token();
-    if (!match(BEGIN_TOKEN)) {
-        if (!parse_statement())
+    next_token(ctx);
+    TacList statement = empty_tac();
+    if (!match(ctx, BEGIN_TOKEN)) {
+        if (!parse_statement(ctx, &statement))
             return 0;
-        if (!match(SC_TOKEN)) {
-            if (!match(END_TOKEN)) { // else case is where we neglect semicolon at the last statement before and end token (OK in Pascal)
-                syntax_error(SC_TOKEN);
+        if (!match(ctx, SC_TOKEN)) {
+            if (!match(ctx, END_TOKEN)) { // else case is where we neglect semicolon at the last statement before and end token (OK in Pascal)
+                syntax_error(ctx, SC_TOKEN);
                 return 0;
             }
         }
+        *code = tac_while(ctx, condition, statement);
         return 1;
     }
-    next_token();
-    while (!match(END_TOKEN) && parse_statement()) {
-        if (!match(SC_TOKEN)) {
-            if (!match(END_TOKEN)) { // else case is where we neglect semicolon at the last statement before and end token (OK in Pascal)
-                syntax_error(SC_TOKEN);
+    next_token(ctx);
+    TacList block_statement;
+    while (!match(ctx, END_TOKEN) && parse_statement(ctx, &block_statement)) {
+        statement = join_tac(statement, block_statement);
+        if (!match(ctx, SC_TOKEN)) {
+            if (!match(ctx, END_TOKEN)) { // else case is where we neglect semicolon at the last statement before and end token (OK in Pascal)
+                syntax_error(ctx, SC_TOKEN);
                 return 0;
             }
         }
         else
-            next_token();
+            next_token(ctx);
     }
-    if (!match(END_TOKEN)) {
-        syntax_error(END_TOKEN);
+    if (!match(ctx, END_TOKEN)) {
+        syntax_error(ctx, END_TOKEN);
         return 0;
     }
-    next_token();
-    if (!match(SC_TOKEN)) {
-        if (!match(END_TOKEN)) { // else case is where we neglect semicolon at the last statement before and end token (OK in Pascal)
-            syntax_error(SC_TOKEN);
+    next_token(ctx);
+    if (!match(ctx, SC_TOKEN)) {
+        if (!match(ctx, END_TOKEN)) { // else case is where we neglect semicolon at the last statement before and end token (OK in Pascal)
+            syntax_error(ctx, SC_TOKEN);
             return 0;
         }
     }
+    *code = tac_while(ctx, condition, statement);
     return 1;
 }
 
-int for_statement() {
-    if (!match(FOR_TOKEN)) {
-        syntax_error(FOR_TOKEN);
+int for_statement(CompilerContext *ctx, TacList *code) {
+    if (!match(ctx, FOR_TOKEN)) {
+        syntax_error(ctx, FOR_TOKEN);
         return 0;
     }
-    next_token();
-    if (!match(ID_TOKEN)) {
-        syntax_error(ID_TOKEN);
+    next_token(ctx);
+    if (!match(ctx, ID_TOKEN)) {
+        syntax_error(ctx, ID_TOKEN);
         return 0;
     }
-    Symbol *assign_symb = symbol_deep_lookup(current_token->token);
+    Symbol *assign_symb = symbol_deep_lookup(ctx, ctx->current_token->token);
     if (assign_symb == NULL) {
-        printf("Error: identifier not previously declared at line %d, char %d\n", current_token->start_ln, current_token->start_col);
+        fprintf(ctx->log_fptr, "Error: identifier not previously declared at line %d, char %d\n", ctx->current_token->start_ln, ctx->current_token->start_col);
         return 0;
     }
-    next_token();
-    if (!match(ASSIGN_TOKEN)) {
-        syntax_error(ASSIGN_TOKEN);
+    if (assign_symb->declaration_type == CONST_TOKEN) {
+        fprintf(ctx->log_fptr, "Error: expected variable identifier but got constant at line %d, char %d\n", ctx->current_token->start_ln,
+            ctx->current_token->start_col);
         return 0;
     }
-    if (!rvalue_statement(assign_symb->token_type))
+    next_token(ctx);
+    if (!match(ctx, ASSIGN_TOKEN)) {
+        syntax_error(ctx, ASSIGN_TOKEN);
         return 0;
-    if (!match(TO_TOKEN) && !match(DOWNTO_TOKEN)) {
-        syntax_error(TO_TOKEN);
+    }
+    ExprNode *start = NULL, *limit = NULL;
+    if (!rvalue_statement(ctx, assign_symb->token_type, &start))
+        return 0;
+    if (!match(ctx, TO_TOKEN) && !match(ctx, DOWNTO_TOKEN)) {
+        syntax_error(ctx, TO_TOKEN);
         return 0;
     }
-    if (!rvalue_statement(assign_symb->token_type))
+    int downto = match(ctx, DOWNTO_TOKEN);
+    if (!rvalue_statement(ctx, assign_symb->token_type, &limit))
         return 0;
-    if (!match(DO_TOKEN)) {
-        syntax_error(DO_TOKEN);
+    if (!match(ctx, DO_TOKEN)) {
+        syntax_error(ctx, DO_TOKEN);
         return 0;
     }
-    next_token();
-    if (!match(BEGIN_TOKEN)) {
-        if (!parse_statement())
+    next_token(ctx);
+    TacList statement = empty_tac();
+    if (!match(ctx, BEGIN_TOKEN)) {
+        if (!parse_statement(ctx, &statement))
             return 0;
-        if (!match(SC_TOKEN)) {
-            if (!match(END_TOKEN)) { // else case is where we neglect semicolon at the last statement before and end token (OK in Pascal)
-                syntax_error(SC_TOKEN);
+        if (!match(ctx, SC_TOKEN)) {
+            if (!match(ctx, END_TOKEN)) { // else case is where we neglect semicolon at the last statement before and end token (OK in Pascal)
+                syntax_error(ctx, SC_TOKEN);
                 return 0;
             }
         }
+        *code = tac_for(ctx, assign_symb, start, limit, downto, statement);
         return 1;
     }
-    next_token();
-    while (!match(END_TOKEN) && parse_statement()) {
-        if (!match(SC_TOKEN)) {
-            if (!match(END_TOKEN)) { // else case is where we neglect semicolon at the last statement before and end token (OK in Pascal)
-                syntax_error(SC_TOKEN);
+    next_token(ctx);
+    TacList block_statement;
+    while (!match(ctx, END_TOKEN) && parse_statement(ctx, &block_statement)) {
+        statement = join_tac(statement, block_statement);
+        if (!match(ctx, SC_TOKEN)) {
+            if (!match(ctx, END_TOKEN)) { // else case is where we neglect semicolon at the last statement before and end token (OK in Pascal)
+                syntax_error(ctx, SC_TOKEN);
                 return 0;
             }
         }
         else
-            next_token();
+            next_token(ctx);
     }
-    if (!match(END_TOKEN)) {
-        syntax_error(END_TOKEN);
+    if (!match(ctx, END_TOKEN)) {
+        syntax_error(ctx, END_TOKEN);
         return 0;
     }
-    next_token();
-    if (!match(SC_TOKEN)) {
-        if (!match(END_TOKEN)) { // else case is where we neglect semicolon at the last statement before and end token (OK in Pascal)
-            syntax_error(SC_TOKEN);
+    next_token(ctx);
+    if (!match(ctx, SC_TOKEN)) {
+        if (!match(ctx, END_TOKEN)) { // else case is where we neglect semicolon at the last statement before and end token (OK in Pascal)
+            syntax_error(ctx, SC_TOKEN);
             return 0;
         }
     }
+    *code = tac_for(ctx, assign_symb, start, limit, downto, statement);
     return 1;
 }
 
-int write_statement() {
-    if (!match(WRITE_TOKEN) && !match(WRITELN_TOKEN)) {
-        syntax_error(WRITE_TOKEN);
+int write_argument(CompilerContext *ctx, TacList *code) {
+    // value[:width[:decimals]], the current token is the one before the value and then the one after the argument
+    ExprNode *expr = NULL, *width = NULL, *precision = NULL;
+    if (!rvalue_statement(ctx, -1, &expr))
         return 0;
+    int result = 1;
+    if (match(ctx, COLON_TOKEN))
+        result = rvalue_statement(ctx, INUM_TOKEN, &width);
+    if (result && match(ctx, COLON_TOKEN)) {
+        if (expr != NULL && value_type(node_type(ctx, expr)) != REAL_TOKEN) {
+            fprintf(ctx->log_fptr, "Error: only reals are written with decimals at line %d, char %d\n",
+                ctx->current_token->start_ln, ctx->current_token->start_col);
+            result = 0;
+        }
+        else
+            result = rvalue_statement(ctx, INUM_TOKEN, &precision);
     }
-    if (!rvalue_statement(-1)) // I should check what types are compatible with the write and writeln functions
+    if (!result) {
+        free_node(expr);
+        free_node(width);
         return 0;
+    }
+    *code = join_tac(*code, tac_print(ctx, expr, width, precision));
     return 1;
 }
 
-int read_statement() {
-    if (!match(READ_TOKEN)) {
-        syntax_error(READ_TOKEN);
+int write_statement(CompilerContext *ctx, TacList *code) {
+    if (!match(ctx, WRITE_TOKEN) && !match(ctx, WRITELN_TOKEN)) {
+        syntax_error(ctx, WRITE_TOKEN);
         return 0;
     }
-    if (!rvalue_statement(-1)) // I should check what types are compatible with the read function
+    int new_line = match(ctx, WRITELN_TOKEN);
+    *code = empty_tac();
+    next_token(ctx);
+    if (match(ctx, OP_TOKEN)) { // The list of values is optional
+        do {
+            if (!write_argument(ctx, code))
+                return 0;
+        } while (match(ctx, COMMA_TOKEN));
+        if (!match(ctx, CP_TOKEN)) {
+            syntax_error(ctx, CP_TOKEN);
+            return 0;
+        }
+        next_token(ctx);
+    }
+    if (new_line)
+        *code = join_tac(*code, tac_println(ctx));
+    return 1;
+}
+
+int read_argument(CompilerContext *ctx, TacList *code) {
+    // An integer, real, character or string variable, the current token is the one before it and then the one after it
+    next_token(ctx);
+    if (!match(ctx, ID_TOKEN)) {
+        syntax_error(ctx, ID_TOKEN);
+        return 0;
+    }
+    Symbol *symb = symbol_deep_lookup(ctx, ctx->current_token->token);
+    if (symb == NULL) {
+        fprintf(ctx->log_fptr, "Error: identifier \"%s\" not previously declared at line %d, char %d\n", ctx->current_token->token,
+            ctx->current_token->start_ln, ctx->current_token->start_col);
+        return 0;
+    }
+    if ((symb->declaration_type != VAR_TOKEN && symb->declaration_type != FUNCTION_TOKEN) || value_type(symb->token_type) == BOOL_TOKEN) {
+        fprintf(ctx->log_fptr, "Error: expected an integer, real, character or string variable but got \"%s\" at line %d, char %d\n",
+            ctx->current_token->token, ctx->current_token->start_ln, ctx->current_token->start_col);
+        return 0;
+    }
+    *code = join_tac(*code, tac_read(ctx, symb));
+    next_token(ctx);
+    return 1;
+}
+
+int read_statement(CompilerContext *ctx, TacList *code) {
+    if (!match(ctx, READ_TOKEN) && !match(ctx, READLN_TOKEN)) {
+        syntax_error(ctx, READ_TOKEN);
         return 0;
+    }
+    int new_line = match(ctx, READLN_TOKEN);
+    *code = empty_tac();
+    next_token(ctx);
+    if (match(ctx, OP_TOKEN)) { // The list of variables is optional
+        do {
+            if (!read_argument(ctx, code))
+                return 0;
+        } while (match(ctx, COMMA_TOKEN));
+        if (!match(ctx, CP_TOKEN)) {
+            syntax_error(ctx, CP_TOKEN);
+            return 0;
+        }
+        next_token(ctx);
+    }
+    if (new_line)
+        *code = join_tac(*code, tac_readln(ctx));
     return 1;
 }
 
-int parse_file(const char *path) {
-    if (open_target_file(path)) {
-        int result = parse_program();
-        close_target_file();
+int parse_file(CompilerContext *ctx, const char *path) {
+    if (ctx->token_replay != NULL || open_target_file(ctx, path)) {
+        int result = parse_program(ctx);
+        close_target_file(ctx);
         return result;
     }
     return 0;
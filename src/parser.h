@@ -1,6 +1,8 @@
 #ifndef PARSER_H
 #define PARSER_H
 
-int parse_file(const char *);
+#include "scanner.h"
+
+int parse_file(CompilerContext *, const char *);
 
 #endif
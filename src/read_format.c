@@ -0,0 +1,332 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "read_format.h"
+
+#define MIN_POWER -65 // Below 10^-65 any 19 digits round to zero
+#define MAX_POWER 38 // Above 10^38 they overflow
+#define MANTISSA_BITS 23 // Stored bits of a float mantissa
+#define EXPONENT_BIAS 127
+#define MAX_EXACT_POWER 10 // 10^10 is the largest power of ten a float holds exactly
+#define MAX_EXACT_MANTISSA (1 << 24)
+
+const uint64_t five_powers[] = { // 5^q for q from -65 to 38 as 128 bits (high then low word) starting with a 1 bit, truncated
+    0x86ccbb52ea94baea, 0x98e947129fc2b4e9, 0xa87fea27a539e9a5, 0x3f2398d747b36224,
+    0xd29fe4b18e88640e, 0x8eec7f0d19a03aad, 0x83a3eeeef9153e89, 0x1953cf68300424ac,
+    0xa48ceaaab75a8e2b, 0x5fa8c3423c052dd7, 0xcdb02555653131b6, 0x3792f412cb06794d,
+    0x808e17555f3ebf11, 0xe2bbd88bbee40bd0, 0xa0b19d2ab70e6ed6, 0x5b6aceaeae9d0ec4,
+    0xc8de047564d20a8b, 0xf245825a5a445275, 0xfb158592be068d2e, 0xeed6e2f0f0d56712,
+    0x9ced737bb6c4183d, 0x55464dd69685606b, 0xc428d05aa4751e4c, 0xaa97e14c3c26b886,
+    0xf53304714d9265df, 0xd53dd99f4b3066a8, 0x993fe2c6d07b7fab, 0xe546a8038efe4029,
+    0xbf8fdb78849a5f96, 0xde98520472bdd033, 0xef73d256a5c0f77c, 0x963e66858f6d4440,
+    0x95a8637627989aad, 0xdde7001379a44aa8, 0xbb127c53b17ec159, 0x5560c018580d5d52,
+    0xe9d71b689dde71af, 0xaab8f01e6e10b4a6, 0x9226712162ab070d, 0xcab3961304ca70e8,
+    0xb6b00d69bb55c8d1, 0x3d607b97c5fd0d22, 0xe45c10c42a2b3b05, 0x8cb89a7db77c506a,
+    0x8eb98a7a9a5b04e3, 0x77f3608e92adb242, 0xb267ed1940f1c61c, 0x55f038b237591ed3,
+    0xdf01e85f912e37a3, 0x6b6c46dec52f6688, 0x8b61313bbabce2c6, 0x2323ac4b3b3da015,
+    0xae397d8aa96c1b77, 0xabec975e0a0d081a, 0xd9c7dced53c72255, 0x96e7bd358c904a21,
+    0x881cea14545c7575, 0x7e50d64177da2e54, 0xaa242499697392d2, 0xdde50bd1d5d0b9e9,
+    0xd4ad2dbfc3d07787, 0x955e4ec64b44e864, 0x84ec3c97da624ab4, 0xbd5af13bef0b113e,
+    0xa6274bbdd0fadd61, 0xecb1ad8aeacdd58e, 0xcfb11ead453994ba, 0x67de18eda5814af2,
+    0x81ceb32c4b43fcf4, 0x80eacf948770ced7, 0xa2425ff75e14fc31, 0xa1258379a94d028d,
+    0xcad2f7f5359a3b3e, 0x096ee45813a04330, 0xfd87b5f28300ca0d, 0x8bca9d6e188853fc,
+    0x9e74d1b791e07e48, 0x775ea264cf55347e, 0xc612062576589dda, 0x95364afe032a819e,
+    0xf79687aed3eec551, 0x3a83ddbd83f52205, 0x9abe14cd44753b52, 0xc4926a9672793543,
+    0xc16d9a0095928a27, 0x75b7053c0f178294, 0xf1c90080baf72cb1, 0x5324c68b12dd6339,
+    0x971da05074da7bee, 0xd3f6fc16ebca5e04, 0xbce5086492111aea, 0x88f4bb1ca6bcf585,
+    0xec1e4a7db69561a5, 0x2b31e9e3d06c32e6, 0x9392ee8e921d5d07, 0x3aff322e62439fd0,
+    0xb877aa3236a4b449, 0x09befeb9fad487c3, 0xe69594bec44de15b, 0x4c2ebe687989a9b4,
+    0x901d7cf73ab0acd9, 0x0f9d37014bf60a11, 0xb424dc35095cd80f, 0x538484c19ef38c95,
+    0xe12e13424bb40e13, 0x2865a5f206b06fba, 0x8cbccc096f5088cb, 0xf93f87b7442e45d4,
+    0xafebff0bcb24aafe, 0xf78f69a51539d749, 0xdbe6fecebdedd5be, 0xb573440e5a884d1c,
+    0x89705f4136b4a597, 0x31680a88f8953031, 0xabcc77118461cefc, 0xfdc20d2b36ba7c3e,
+    0xd6bf94d5e57a42bc, 0x3d32907604691b4d, 0x8637bd05af6c69b5, 0xa63f9a49c2c1b110,
+    0xa7c5ac471b478423, 0x0fcf80dc33721d54, 0xd1b71758e219652b, 0xd3c36113404ea4a9,
+    0x83126e978d4fdf3b, 0x645a1cac083126ea, 0xa3d70a3d70a3d70a, 0x3d70a3d70a3d70a4,
+    0xcccccccccccccccc, 0xcccccccccccccccd, 0x8000000000000000, 0x0000000000000000,
+    0xa000000000000000, 0x0000000000000000, 0xc800000000000000, 0x0000000000000000,
+    0xfa00000000000000, 0x0000000000000000, 0x9c40000000000000, 0x0000000000000000,
+    0xc350000000000000, 0x0000000000000000, 0xf424000000000000, 0x0000000000000000,
+    0x9896800000000000, 0x0000000000000000, 0xbebc200000000000, 0x0000000000000000,
+    0xee6b280000000000, 0x0000000000000000, 0x9502f90000000000, 0x0000000000000000,
+    0xba43b74000000000, 0x0000000000000000, 0xe8d4a51000000000, 0x0000000000000000,
+    0x9184e72a00000000, 0x0000000000000000, 0xb5e620f480000000, 0x0000000000000000,
+    0xe35fa931a0000000, 0x0000000000000000, 0x8e1bc9bf04000000, 0x0000000000000000,
+    0xb1a2bc2ec5000000, 0x0000000000000000, 0xde0b6b3a76400000, 0x0000000000000000,
+    0x8ac7230489e80000, 0x0000000000000000, 0xad78ebc5ac620000, 0x0000000000000000,
+    0xd8d726b7177a8000, 0x0000000000000000, 0x878678326eac9000, 0x0000000000000000,
+    0xa968163f0a57b400, 0x0000000000000000, 0xd3c21bcecceda100, 0x0000000000000000,
+    0x84595161401484a0, 0x0000000000000000, 0xa56fa5b99019a5c8, 0x0000000000000000,
+    0xcecb8f27f4200f3a, 0x0000000000000000, 0x813f3978f8940984, 0x4000000000000000,
+    0xa18f07d736b90be5, 0x5000000000000000, 0xc9f2c9cd04674ede, 0xa400000000000000,
+    0xfc6f7c4045812296, 0x4d00000000000000, 0x9dc5ada82b70b59d, 0xf020000000000000,
+    0xc5371912364ce305, 0x6c28000000000000, 0xf684df56c3e01bc6, 0xc732000000000000,
+    0x9a130b963a6c115c, 0x3c7f400000000000, 0xc097ce7bc90715b3, 0x4b9f100000000000,
+    0xf0bdc21abb48db20, 0x1e86d40000000000, 0x96769950b50d88f4, 0x1314448000000000
+};
+
+const float exact_powers[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+
+int init_input(InputBuffer *in, int fd, FILE *output) {
+    in->fd = fd;
+    in->data = malloc(READ_BUFFER_SIZE + READ_PADDING);
+    in->position = in->end = 0;
+    in->at_end = 0;
+    in->output = output;
+    if (in->data == NULL)
+        return 0;
+    in->data[0] = 0;
+    return 1;
+}
+
+void free_input(InputBuffer *in) {
+    free(in->data);
+}
+
+int fill_input(InputBuffer *in, int keep) {
+    // Moves the data from keep on to the start of the buffer and appends the next block, returns the count of new bytes
+    if (in->at_end)
+        return 0;
+    memmove(in->data, in->data + keep, in->end - keep);
+    in->position -= keep;
+    in->end -= keep;
+    if (in->end == READ_BUFFER_SIZE) // A value longer than the buffer is cut
+        return 0;
+    if (in->output != NULL)
+        fflush(in->output);
+    ssize_t count;
+    do
+        count = read(in->fd, in->data + in->end, READ_BUFFER_SIZE - in->end);
+    while (count < 0 && errno == EINTR);
+    if (count <= 0) {
+        in->at_end = 1;
+        count = 0;
+    }
+    in->end += count;
+    in->data[in->end] = 0;
+    return count;
+}
+
+void skip_input_blanks(InputBuffer *in) { // Spaces, tabs and line breaks before a number
+    for (;;) {
+        while (in->position < in->end && (unsigned char) in->data[in->position] <= ' ')
+            in->position++;
+        if (in->position < in->end || !fill_input(in, in->position))
+            return;
+    }
+}
+
+uint64_t load_word(const char *p) { // 8 bytes, the first one lowest
+    const unsigned char *bytes = (const unsigned char *) p;
+    return (uint64_t) bytes[0] | (uint64_t) bytes[1] << 8 | (uint64_t) bytes[2] << 16 | (uint64_t) bytes[3] << 24
+           | (uint64_t) bytes[4] << 32 | (uint64_t) bytes[5] << 40 | (uint64_t) bytes[6] << 48 | (uint64_t) bytes[7] << 56;
+}
+
+int is_eight_digits(uint64_t word) {
+    return (((word + 0x4646464646464646) | (word - 0x3030303030303030)) & 0x8080808080808080) == 0;
+}
+
+uint32_t eight_digits_value(uint64_t word) { // Pairs of digits, then pairs of pairs, then the two halves
+    word -= 0x3030303030303030;
+    word = word * 10 + (word >> 8);
+    return ((word & 0x000000FF000000FF) * 0x000F424000000064 + ((word >> 16) & 0x000000FF000000FF) * 0x0000271000000001) >> 32;
+}
+
+int is_digit(char c) {
+    return (unsigned) (c - '0') < 10;
+}
+
+void multiply_64(uint64_t x, uint64_t y, uint64_t *high, uint64_t *low) { // 128 bit product from 32 bit halves
+    uint64_t low_low = (x & 0xffffffff) * (y & 0xffffffff), high_low = (x >> 32) * (y & 0xffffffff);
+    uint64_t low_high = (x & 0xffffffff) * (y >> 32), high_high = (x >> 32) * (y >> 32);
+    uint64_t middle = (low_low >> 32) + (high_low & 0xffffffff) + low_high;
+    *low = middle << 32 | (low_low & 0xffffffff);
+    *high = high_high + (high_low >> 32) + (middle >> 32);
+}
+
+float float_from_bits(uint32_t bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+float decimal_to_float(uint64_t w, int q) { // Nearest float to w * 10^q, ties to even
+    if (w == 0 || q < MIN_POWER)
+        return 0.0f;
+    if (q > MAX_POWER)
+        return float_from_bits(0x7f800000);
+    if (w <= MAX_EXACT_MANTISSA && q >= -MAX_EXACT_POWER && q <= MAX_EXACT_POWER) // Both fit in a float, one rounding
+        return q < 0 ? (float) w / exact_powers[-q] : (float) w * exact_powers[q];
+    int zeros = 0;
+    for (int shift = 32; shift > 0; shift /= 2) { // The leading bit of w goes to bit 63
+        if (w >> (64 - shift) == 0) {
+            w <<= shift;
+            zeros += shift;
+        }
+    }
+    const uint64_t *power = &five_powers[2 * (q - MIN_POWER)];
+    uint64_t high, low;
+    multiply_64(w, power[0], &high, &low);
+    if ((high & 0x3fffffffff) == 0x3fffffffff) { // The bits under the rounding bit could carry, the low word of the power adds
+        uint64_t second_high, second_low;
+        multiply_64(w, power[1], &second_high, &second_low);
+        low += second_high;
+        high += second_high > low;
+    }
+    int upper = high >> 63;
+    int shift = upper + 64 - MANTISSA_BITS - 3;
+    uint64_t mantissa = high >> shift; // 25 bits, the last one to round
+    int exponent = ((217706 * q) >> 16) + 63 + upper - zeros + EXPONENT_BIAS; // floor(q * log2(10)) plus the product bits
+    if (exponent <= 0) { // Subnormal
+        if (-exponent + 1 >= 64)
+            return 0.0f;
+        mantissa >>= -exponent + 1;
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        return float_from_bits((uint32_t) mantissa | (mantissa < 1 << MANTISSA_BITS ? 0 : 1) << MANTISSA_BITS);
+    }
+    if (low <= 1 && q >= -17 && q <= 10 && (mantissa & 3) == 1 && mantissa << shift == high) // Exactly halfway, to even
+        mantissa &= ~(uint64_t) 1;
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= (uint64_t) 2 << MANTISSA_BITS) { // Rounded up to the next power of two
+        mantissa = 1 << MANTISSA_BITS;
+        exponent++;
+    }
+    if (exponent >= 0xff)
+        return float_from_bits(0x7f800000);
+    return float_from_bits((uint32_t) (mantissa & ((1 << MANTISSA_BITS) - 1)) | (uint32_t) exponent << MANTISSA_BITS);
+}
+
+int32_t read_int(InputBuffer *in) {
+    skip_input_blanks(in);
+    uint64_t n;
+    int negative, p, length;
+    do { // Parsed again from its start when it reaches the end of the data
+        const char *data = in->data;
+        p = in->position;
+        negative = data[p] == '-';
+        p += negative || data[p] == '+';
+        n = 0;
+        while (is_eight_digits(load_word(data + p))) {
+            n = n * 100000000 + eight_digits_value(load_word(data + p));
+            p += 8;
+        }
+        for (; is_digit(data[p]); p++)
+            n = n * 10 + (data[p] - '0');
+        length = p - in->position; // The data moves down even when no block follows
+    } while (p == in->end && fill_input(in, in->position));
+    in->position += length;
+    return (int32_t) (uint32_t) (negative ? 0 - n : n);
+}
+
+float read_real(InputBuffer *in) {
+    skip_input_blanks(in);
+    uint64_t w;
+    int exponent, negative, p, length;
+    do {
+        const char *data = in->data;
+        p = in->position;
+        negative = data[p] == '-';
+        p += negative || data[p] == '+';
+        w = 0;
+        exponent = 0;
+        int digits = 0; // Significant digits in w
+        while (data[p] == '0')
+            p++;
+        while (digits + 8 <= MAX_READ_DIGITS && is_eight_digits(load_word(data + p))) {
+            w = w * 100000000 + eight_digits_value(load_word(data + p));
+            digits += 8;
+            p += 8;
+        }
+        for (; is_digit(data[p]); p++) {
+            if (digits < MAX_READ_DIGITS) {
+                w = w * 10 + (data[p] - '0');
+                digits++;
+            }
+            else
+                exponent++;
+        }
+        if (data[p] == '.') {
+            p++;
+            if (digits == 0) {
+                for (; data[p] == '0'; p++)
+                    exponent--;
+            }
+            while (digits + 8 <= MAX_READ_DIGITS && is_eight_digits(load_word(data + p))) {
+                w = w * 100000000 + eight_digits_value(load_word(data + p));
+                digits += 8;
+                exponent -= 8;
+                p += 8;
+            }
+            for (; is_digit(data[p]); p++) {
+                if (digits < MAX_READ_DIGITS) {
+                    w = w * 10 + (data[p] - '0');
+                    digits++;
+                    exponent--;
+                }
+            }
+        }
+        if (data[p] == 'e' || data[p] == 'E') {
+            int e = p + 1, power = 0;
+            int negative_power = data[e] == '-';
+            e += negative_power || data[e] == '+';
+            if (is_digit(data[e]) || e == in->end) { // The exponent could be in the next block
+                for (; is_digit(data[e]); e++) {
+                    if (power < 100000)
+                        power = power * 10 + (data[e] - '0');
+                }
+                exponent += negative_power ? -power : power;
+                p = e;
+            }
+        }
+        length = p - in->position;
+    } while (p == in->end && fill_input(in, in->position));
+    in->position += length;
+    float value = decimal_to_float(w, exponent);
+    return negative ? -value : value;
+}
+
+int read_char(InputBuffer *in) { // #0 at the end of the input
+    if (in->position == in->end && !fill_input(in, in->position))
+        return 0;
+    return (unsigned char) in->data[in->position++];
+}
+
+char* read_string(InputBuffer *in) { // Rest of the line without its line break, NULL when out of memory
+    int length = 0;
+    for (;;) {
+        const char *line_break = memchr(in->data + in->position + length, '\n', in->end - in->position - length);
+        if (line_break != NULL) {
+            length = line_break - (in->data + in->position);
+            break;
+        }
+        length = in->end - in->position;
+        if (!fill_input(in, in->position))
+            break;
+    }
+    char *str = malloc(length + 1);
+    if (str != NULL) {
+        memcpy(str, in->data + in->position, length);
+        str[length] = 0;
+    }
+    in->position += length;
+    return str;
+}
+
+void read_line(InputBuffer *in) { // Skips the rest of the line and its line break
+    for (;;) {
+        const char *line_break = memchr(in->data + in->position, '\n', in->end - in->position);
+        if (line_break != NULL) {
+            in->position = line_break - in->data + 1;
+            return;
+        }
+        in->position = in->end;
+        if (!fill_input(in, in->position))
+            return;
+    }
+}
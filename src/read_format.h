@@ -0,0 +1,40 @@
+#ifndef READ_FORMAT_H
+#define READ_FORMAT_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Values read by read and readln for the interpreter and the JIT. The runtime of the native code and the prelude of the C
+// translation take the same steps so that every backend reads the same values. The input comes in blocks of
+// READ_BUFFER_SIZE bytes, a number that reaches the end of the block is parsed again once the next block is appended.
+// Integers take 8 digits at a time (SWAR), wrapping around like the arithmetic. Reals keep their first 19 significant
+// digits and are rounded to the nearest float: exactly by one float operation when the digits and the power of ten fit
+// in a float, else by the Eisel-Lemire method with 128 bit powers of five.
+// Numbers skip the blanks before them, a string takes the rest of the line (at most READ_BUFFER_SIZE bytes of it), a
+// character the next byte (#0 at the end of the input) and readln skips what is left of the line.
+
+#define READ_BUFFER_SIZE 65536
+#define READ_PADDING 16 // Bytes after the buffer, a word loaded before the end of the data stays inside
+#define MAX_READ_DIGITS 19 // Significant digits of a real that fit in 64 bits
+
+typedef struct _InputBuffer {
+    int fd;
+    char *data; // READ_BUFFER_SIZE bytes and the padding, a zero byte follows the data
+    int position, end; // Next byte and end of the data
+    int at_end; // Nothing left to read from the file
+    FILE *output; // Written out before waiting for input so that a prompt shows up, NULL when there is none
+} InputBuffer;
+
+extern const uint64_t five_powers[];
+
+int init_input(InputBuffer *, int, FILE *);
+void free_input(InputBuffer *);
+int fill_input(InputBuffer *, int);
+float decimal_to_float(uint64_t, int);
+int32_t read_int(InputBuffer *);
+float read_real(InputBuffer *);
+int read_char(InputBuffer *);
+char* read_string(InputBuffer *);
+void read_line(InputBuffer *);
+
+#endif
@@ -0,0 +1,647 @@
+#include "read_runtime.h"
+
+// Assembly of the runtime, its symbols start with pas. so that no routine of the program (pas_<name>) can clash with them
+const char *read_runtime_assembly =
+    "    .text\n"
+    "    .type pas.fill_input, @function\n"
+    "pas.fill_input:                      # Moves the data from rdi on to the start of the buffer and appends the next block, eax new bytes\n"
+    "    pushq %rbx\n"
+    "    xorl %eax, %eax\n"
+    "    cmpq $0, pas.in_eof(%rip)\n"
+    "    jne .Lpas_fill_input_done\n"
+    "    leaq pas.in_buffer(%rip), %rbx\n"
+    "    movq pas.in_end(%rip), %rcx\n"
+    "    subq %rdi, %rcx                 # Bytes kept\n"
+    "    subq %rdi, pas.in_position(%rip)\n"
+    "    movq %rcx, pas.in_end(%rip)\n"
+    "    leaq (%rbx,%rdi), %rsi\n"
+    "    xorl %edx, %edx\n"
+    ".Lpas_fill_input_move:               # 8 bytes at a time, forwards as the data moves down\n"
+    "    cmpq %rcx, %rdx\n"
+    "    jae .Lpas_fill_input_moved\n"
+    "    movq (%rsi,%rdx), %rax\n"
+    "    movq %rax, (%rbx,%rdx)\n"
+    "    addq $8, %rdx\n"
+    "    jmp .Lpas_fill_input_move\n"
+    ".Lpas_fill_input_moved:\n"
+    "    xorl %eax, %eax\n"
+    "    cmpq $65536, %rcx               # A value longer than the buffer is cut\n"
+    "    je .Lpas_fill_input_done\n"
+    "    call pas.flush                  # A prompt shows up before waiting for input\n"
+    ".Lpas_fill_input_read:\n"
+    "    xorl %edi, %edi\n"
+    "    movq pas.in_end(%rip), %rsi\n"
+    "    movl $65536, %edx\n"
+    "    subq %rsi, %rdx\n"
+    "    addq %rbx, %rsi\n"
+    "    xorl %eax, %eax                 # read\n"
+    "    syscall\n"
+    "    cmpq $-4, %rax                  # Interrupted\n"
+    "    je .Lpas_fill_input_read\n"
+    "    testq %rax, %rax\n"
+    "    jg .Lpas_fill_input_append\n"
+    "    movq $1, pas.in_eof(%rip)\n"
+    "    xorl %eax, %eax\n"
+    ".Lpas_fill_input_append:\n"
+    "    movq pas.in_end(%rip), %rcx\n"
+    "    addq %rax, %rcx\n"
+    "    movq %rcx, pas.in_end(%rip)\n"
+    "    movb $0, (%rbx,%rcx)            # Stops the digit loops at the end of the data\n"
+    ".Lpas_fill_input_done:\n"
+    "    popq %rbx\n"
+    "    ret\n"
+    "    .size pas.fill_input, .-pas.fill_input\n"
+    "\n"
+    "    .type pas.skip_blanks, @function\n"
+    "pas.skip_blanks:                     # Spaces, tabs and line breaks before a number\n"
+    "    subq $8, %rsp\n"
+    ".Lpas_skip_blanks_block:\n"
+    "    leaq pas.in_buffer(%rip), %rdx\n"
+    "    movq pas.in_position(%rip), %rax\n"
+    "    movq pas.in_end(%rip), %rcx\n"
+    ".Lpas_skip_blanks_byte:\n"
+    "    cmpq %rcx, %rax\n"
+    "    jae .Lpas_skip_blanks_fill\n"
+    "    cmpb $32, (%rdx,%rax)\n"
+    "    ja .Lpas_skip_blanks_done\n"
+    "    incq %rax\n"
+    "    jmp .Lpas_skip_blanks_byte\n"
+    ".Lpas_skip_blanks_fill:\n"
+    "    movq %rax, pas.in_position(%rip)\n"
+    "    movq %rax, %rdi\n"
+    "    call pas.fill_input\n"
+    "    testl %eax, %eax\n"
+    "    jne .Lpas_skip_blanks_block\n"
+    "    addq $8, %rsp\n"
+    "    ret\n"
+    ".Lpas_skip_blanks_done:\n"
+    "    movq %rax, pas.in_position(%rip)\n"
+    "    addq $8, %rsp\n"
+    "    ret\n"
+    "    .size pas.skip_blanks, .-pas.skip_blanks\n"
+    "\n"
+    "    .type pas.eight_digits, @function\n"
+    "pas.eight_digits:                    # Value of the 8 digits at rdi in rax, -1 when they aren't all digits\n"
+    "    movq (%rdi), %rax\n"
+    "    movq %rax, %rdx\n"
+    "    addq pas.digit_test(%rip), %rax\n"
+    "    subq pas.digit_zeros(%rip), %rdx\n"
+    "    orq %rdx, %rax\n"
+    "    movq pas.digit_tops(%rip), %rcx\n"
+    "    testq %rcx, %rax\n"
+    "    jne .Lpas_eight_digits_not\n"
+    "    leaq (%rdx,%rdx,4), %rax        # Pairs of digits\n"
+    "    addq %rax, %rax\n"
+    "    shrq $8, %rdx\n"
+    "    addq %rdx, %rax\n"
+    "    movq pas.digit_mask(%rip), %rcx # Pairs of pairs then the two halves\n"
+    "    movq %rax, %rdx\n"
+    "    andq %rcx, %rdx\n"
+    "    imulq pas.digit_scale_low(%rip), %rdx\n"
+    "    shrq $16, %rax\n"
+    "    andq %rcx, %rax\n"
+    "    imulq pas.digit_scale_high(%rip), %rax\n"
+    "    addq %rdx, %rax\n"
+    "    shrq $32, %rax\n"
+    "    ret\n"
+    ".Lpas_eight_digits_not:\n"
+    "    movq $-1, %rax\n"
+    "    ret\n"
+    "    .size pas.eight_digits, .-pas.eight_digits\n"
+    "\n"
+    "    .type pas.read_int, @function\n"
+    "pas.read_int:                        # Integer read in eax, wrapping around\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14                      # The value, kept across pas.fill_input\n"
+    "    subq $8, %rsp\n"
+    "    call pas.skip_blanks\n"
+    ".Lpas_read_int_parse:                # Parsed again from its start when it reaches the end of the data\n"
+    "    leaq pas.in_buffer(%rip), %rbx\n"
+    "    movq pas.in_position(%rip), %r12\n"
+    "    xorl %r13d, %r13d\n"
+    "    xorl %r14d, %r14d\n"
+    "    movzbl (%rbx,%r12), %eax\n"
+    "    cmpl $43, %eax\n"
+    "    je .Lpas_read_int_sign\n"
+    "    cmpl $45, %eax\n"
+    "    jne .Lpas_read_int_eight\n"
+    "    movl $1, %r13d\n"
+    ".Lpas_read_int_sign:\n"
+    "    incq %r12\n"
+    ".Lpas_read_int_eight:\n"
+    "    leaq (%rbx,%r12), %rdi\n"
+    "    call pas.eight_digits\n"
+    "    testq %rax, %rax\n"
+    "    js .Lpas_read_int_digit\n"
+    "    imulq $100000000, %r14, %r14\n"
+    "    addq %rax, %r14\n"
+    "    addq $8, %r12\n"
+    "    jmp .Lpas_read_int_eight\n"
+    ".Lpas_read_int_digit:\n"
+    "    movzbl (%rbx,%r12), %eax\n"
+    "    subl $48, %eax\n"
+    "    cmpl $9, %eax\n"
+    "    ja .Lpas_read_int_end\n"
+    "    imulq $10, %r14, %r14\n"
+    "    addq %rax, %r14\n"
+    "    incq %r12\n"
+    "    jmp .Lpas_read_int_digit\n"
+    ".Lpas_read_int_end:\n"
+    "    cmpq pas.in_end(%rip), %r12\n"
+    "    jne .Lpas_read_int_done\n"
+    "    movq pas.in_position(%rip), %rdi\n"
+    "    subq %rdi, %r12                 # Length of the number, the data moves down even when no block follows\n"
+    "    call pas.fill_input\n"
+    "    addq pas.in_position(%rip), %r12\n"
+    "    testl %eax, %eax\n"
+    "    jne .Lpas_read_int_parse\n"
+    ".Lpas_read_int_done:\n"
+    "    movq %r12, pas.in_position(%rip)\n"
+    "    movl %r14d, %eax\n"
+    "    testl %r13d, %r13d\n"
+    "    je .Lpas_read_int_return\n"
+    "    negl %eax\n"
+    ".Lpas_read_int_return:\n"
+    "    addq $8, %rsp\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    ret\n"
+    "    .size pas.read_int, .-pas.read_int\n"
+    "\n"
+    "    .type pas.decimal_to_float, @function\n"
+    "pas.decimal_to_float:                # Nearest float to rdi times 10^esi in xmm0, ties to even\n"
+    "    xorps %xmm0, %xmm0\n"
+    "    testq %rdi, %rdi\n"
+    "    je .Lpas_decimal_to_float_done\n"
+    "    cmpl $-65, %esi\n"
+    "    jl .Lpas_decimal_to_float_done\n"
+    "    cmpl $38, %esi\n"
+    "    jg .Lpas_decimal_to_float_infinity\n"
+    "    cmpq $16777216, %rdi            # Both fit in a float, one rounding\n"
+    "    ja .Lpas_decimal_to_float_wide\n"
+    "    cmpl $-10, %esi\n"
+    "    jl .Lpas_decimal_to_float_wide\n"
+    "    cmpl $10, %esi\n"
+    "    jg .Lpas_decimal_to_float_wide\n"
+    "    cvtsi2ssq %rdi, %xmm0\n"
+    "    leaq pas.exact_powers(%rip), %rax\n"
+    "    testl %esi, %esi\n"
+    "    js .Lpas_decimal_to_float_divide\n"
+    "    movslq %esi, %rcx\n"
+    "    mulss (%rax,%rcx,4), %xmm0\n"
+    "    ret\n"
+    ".Lpas_decimal_to_float_divide:\n"
+    "    negl %esi\n"
+    "    movslq %esi, %rcx\n"
+    "    divss (%rax,%rcx,4), %xmm0\n"
+    "    ret\n"
+    ".Lpas_decimal_to_float_wide:         # The leading bit of w goes to bit 63, r8d counts the zeros\n"
+    "    xorl %r8d, %r8d\n"
+    "    movl $32, %ecx\n"
+    ".Lpas_decimal_to_float_normalize:\n"
+    "    movl %ecx, %edx\n"
+    "    negl %ecx\n"
+    "    addl $64, %ecx\n"
+    "    movq %rdi, %rax\n"
+    "    shrq %cl, %rax\n"
+    "    movl %edx, %ecx\n"
+    "    testq %rax, %rax\n"
+    "    jne .Lpas_decimal_to_float_halve\n"
+    "    shlq %cl, %rdi\n"
+    "    addl %ecx, %r8d\n"
+    ".Lpas_decimal_to_float_halve:\n"
+    "    shrl $1, %ecx\n"
+    "    jne .Lpas_decimal_to_float_normalize\n"
+    "    leal 65(%rsi), %eax             # Power of five, 16 bytes each from 5^-65\n"
+    "    shll $4, %eax\n"
+    "    leaq pas.five_powers(%rip), %r9\n"
+    "    addq %rax, %r9\n"
+    "    movq %rdi, %rax\n"
+    "    mulq (%r9)\n"
+    "    movq %rdx, %r10                 # High word of the product\n"
+    "    movq %rax, %r11                 # Low word\n"
+    "    movq pas.precision_mask(%rip), %rcx\n"
+    "    movq %r10, %rax\n"
+    "    andq %rcx, %rax\n"
+    "    cmpq %rcx, %rax                 # The bits under the rounding bit could carry, the low word of the power adds\n"
+    "    jne .Lpas_decimal_to_float_product\n"
+    "    movq %rdi, %rax\n"
+    "    mulq 8(%r9)\n"
+    "    addq %rdx, %r11\n"
+    "    jnc .Lpas_decimal_to_float_product\n"
+    "    incq %r10\n"
+    ".Lpas_decimal_to_float_product:\n"
+    "    movq %r10, %rdx\n"
+    "    shrq $63, %rdx                  # 1 when the product reaches bit 127\n"
+    "    leal 38(%rdx), %ecx\n"
+    "    movq %r10, %rax\n"
+    "    shrq %cl, %rax                  # 25 bits, the last one to round\n"
+    "    movl %esi, %edi\n"
+    "    imull $217706, %esi, %esi       # floor(q * log2(10)) plus the product bits\n"
+    "    sarl $16, %esi\n"
+    "    addl %edx, %esi\n"
+    "    addl $190, %esi\n"
+    "    subl %r8d, %esi\n"
+    "    testl %esi, %esi\n"
+    "    jg .Lpas_decimal_to_float_normal\n"
+    "    movl $1, %ecx                   # Subnormal\n"
+    "    subl %esi, %ecx\n"
+    "    cmpl $64, %ecx\n"
+    "    jge .Lpas_decimal_to_float_done\n"
+    "    shrq %cl, %rax\n"
+    "    movq %rax, %rcx\n"
+    "    andl $1, %ecx\n"
+    "    addq %rcx, %rax\n"
+    "    shrq $1, %rax\n"
+    "    movd %eax, %xmm0\n"
+    "    ret\n"
+    ".Lpas_decimal_to_float_normal:\n"
+    "    cmpq $1, %r11                   # Exactly halfway, to even\n"
+    "    ja .Lpas_decimal_to_float_round\n"
+    "    cmpl $-17, %edi\n"
+    "    jl .Lpas_decimal_to_float_round\n"
+    "    cmpl $10, %edi\n"
+    "    jg .Lpas_decimal_to_float_round\n"
+    "    movq %rax, %rdx\n"
+    "    andl $3, %edx\n"
+    "    cmpl $1, %edx\n"
+    "    jne .Lpas_decimal_to_float_round\n"
+    "    movq %rax, %rdx\n"
+    "    shlq %cl, %rdx\n"
+    "    cmpq %r10, %rdx\n"
+    "    jne .Lpas_decimal_to_float_round\n"
+    "    andq $-2, %rax\n"
+    ".Lpas_decimal_to_float_round:\n"
+    "    movq %rax, %rcx\n"
+    "    andl $1, %ecx\n"
+    "    addq %rcx, %rax\n"
+    "    shrq $1, %rax\n"
+    "    cmpq $16777216, %rax            # Rounded up to the next power of two\n"
+    "    jb .Lpas_decimal_to_float_bits\n"
+    "    movl $8388608, %eax\n"
+    "    incl %esi\n"
+    ".Lpas_decimal_to_float_bits:\n"
+    "    cmpl $255, %esi\n"
+    "    jge .Lpas_decimal_to_float_infinity\n"
+    "    andl $8388607, %eax\n"
+    "    shll $23, %esi\n"
+    "    orl %esi, %eax\n"
+    "    movd %eax, %xmm0\n"
+    "    ret\n"
+    ".Lpas_decimal_to_float_infinity:\n"
+    "    movl $2139095040, %eax\n"
+    "    movd %eax, %xmm0\n"
+    ".Lpas_decimal_to_float_done:\n"
+    "    ret\n"
+    "    .size pas.decimal_to_float, .-pas.decimal_to_float\n"
+    "\n"
+    "    .type pas.read_real, @function\n"
+    "pas.read_real:                       # Real read in xmm0, its first 19 significant digits in r14 and their exponent in r15d\n"
+    "    pushq %rbx\n"
+    "    pushq %rbp\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    subq $8, %rsp\n"
+    "    call pas.skip_blanks\n"
+    ".Lpas_read_real_parse:               # Parsed again from its start when it reaches the end of the data\n"
+    "    leaq pas.in_buffer(%rip), %rbx\n"
+    "    movq pas.in_position(%rip), %r12\n"
+    "    xorl %r13d, %r13d\n"
+    "    xorl %r14d, %r14d\n"
+    "    xorl %r15d, %r15d\n"
+    "    xorl %ebp, %ebp                 # Significant digits\n"
+    "    movzbl (%rbx,%r12), %eax\n"
+    "    cmpl $43, %eax\n"
+    "    je .Lpas_read_real_sign\n"
+    "    cmpl $45, %eax\n"
+    "    jne .Lpas_read_real_zeros\n"
+    "    movl $1, %r13d\n"
+    ".Lpas_read_real_sign:\n"
+    "    incq %r12\n"
+    ".Lpas_read_real_zeros:\n"
+    "    cmpb $48, (%rbx,%r12)\n"
+    "    jne .Lpas_read_real_eight\n"
+    "    incq %r12\n"
+    "    jmp .Lpas_read_real_zeros\n"
+    ".Lpas_read_real_eight:               # 8 digits at a time while they fit in the 19\n"
+    "    cmpl $11, %ebp\n"
+    "    jg .Lpas_read_real_digit\n"
+    "    leaq (%rbx,%r12), %rdi\n"
+    "    call pas.eight_digits\n"
+    "    testq %rax, %rax\n"
+    "    js .Lpas_read_real_digit\n"
+    "    imulq $100000000, %r14, %r14\n"
+    "    addq %rax, %r14\n"
+    "    addl $8, %ebp\n"
+    "    addq $8, %r12\n"
+    "    jmp .Lpas_read_real_eight\n"
+    ".Lpas_read_real_digit:\n"
+    "    movzbl (%rbx,%r12), %eax\n"
+    "    subl $48, %eax\n"
+    "    cmpl $9, %eax\n"
+    "    ja .Lpas_read_real_point\n"
+    "    incq %r12\n"
+    "    cmpl $19, %ebp\n"
+    "    jge .Lpas_read_real_dropped\n"
+    "    imulq $10, %r14, %r14\n"
+    "    addq %rax, %r14\n"
+    "    incl %ebp\n"
+    "    jmp .Lpas_read_real_digit\n"
+    ".Lpas_read_real_dropped:\n"
+    "    incl %r15d\n"
+    "    jmp .Lpas_read_real_digit\n"
+    ".Lpas_read_real_point:\n"
+    "    cmpb $46, (%rbx,%r12)\n"
+    "    jne .Lpas_read_real_exponent\n"
+    "    incq %r12\n"
+    "    testl %ebp, %ebp\n"
+    "    jne .Lpas_read_real_fraction\n"
+    ".Lpas_read_real_fraction_zeros:\n"
+    "    cmpb $48, (%rbx,%r12)\n"
+    "    jne .Lpas_read_real_fraction\n"
+    "    incq %r12\n"
+    "    decl %r15d\n"
+    "    jmp .Lpas_read_real_fraction_zeros\n"
+    ".Lpas_read_real_fraction:\n"
+    "    cmpl $11, %ebp\n"
+    "    jg .Lpas_read_real_fraction_digit\n"
+    "    leaq (%rbx,%r12), %rdi\n"
+    "    call pas.eight_digits\n"
+    "    testq %rax, %rax\n"
+    "    js .Lpas_read_real_fraction_digit\n"
+    "    imulq $100000000, %r14, %r14\n"
+    "    addq %rax, %r14\n"
+    "    addl $8, %ebp\n"
+    "    subl $8, %r15d\n"
+    "    addq $8, %r12\n"
+    "    jmp .Lpas_read_real_fraction\n"
+    ".Lpas_read_real_fraction_digit:\n"
+    "    movzbl (%rbx,%r12), %eax\n"
+    "    subl $48, %eax\n"
+    "    cmpl $9, %eax\n"
+    "    ja .Lpas_read_real_exponent\n"
+    "    incq %r12\n"
+    "    cmpl $19, %ebp\n"
+    "    jge .Lpas_read_real_fraction_digit\n"
+    "    imulq $10, %r14, %r14\n"
+    "    addq %rax, %r14\n"
+    "    incl %ebp\n"
+    "    decl %r15d\n"
+    "    jmp .Lpas_read_real_fraction_digit\n"
+    ".Lpas_read_real_exponent:            # Taken when a digit follows or the data ends there\n"
+    "    movzbl (%rbx,%r12), %eax\n"
+    "    orl $32, %eax\n"
+    "    cmpl $101, %eax\n"
+    "    jne .Lpas_read_real_end\n"
+    "    leaq 1(%r12), %rcx\n"
+    "    xorl %edx, %edx\n"
+    "    movzbl (%rbx,%rcx), %eax\n"
+    "    cmpl $43, %eax\n"
+    "    je .Lpas_read_real_power_sign\n"
+    "    cmpl $45, %eax\n"
+    "    jne .Lpas_read_real_power_start\n"
+    "    movl $1, %edx\n"
+    ".Lpas_read_real_power_sign:\n"
+    "    incq %rcx\n"
+    ".Lpas_read_real_power_start:\n"
+    "    movzbl (%rbx,%rcx), %eax\n"
+    "    subl $48, %eax\n"
+    "    cmpl $9, %eax\n"
+    "    jbe .Lpas_read_real_power\n"
+    "    cmpq pas.in_end(%rip), %rcx\n"
+    "    jne .Lpas_read_real_end\n"
+    ".Lpas_read_real_power:\n"
+    "    xorl %esi, %esi\n"
+    ".Lpas_read_real_power_digit:\n"
+    "    movzbl (%rbx,%rcx), %eax\n"
+    "    subl $48, %eax\n"
+    "    cmpl $9, %eax\n"
+    "    ja .Lpas_read_real_power_done\n"
+    "    incq %rcx\n"
+    "    cmpl $100000, %esi\n"
+    "    jge .Lpas_read_real_power_digit\n"
+    "    imull $10, %esi, %esi\n"
+    "    addl %eax, %esi\n"
+    "    jmp .Lpas_read_real_power_digit\n"
+    ".Lpas_read_real_power_done:\n"
+    "    testl %edx, %edx\n"
+    "    je .Lpas_read_real_power_add\n"
+    "    negl %esi\n"
+    ".Lpas_read_real_power_add:\n"
+    "    addl %esi, %r15d\n"
+    "    movq %rcx, %r12\n"
+    ".Lpas_read_real_end:\n"
+    "    cmpq pas.in_end(%rip), %r12\n"
+    "    jne .Lpas_read_real_done\n"
+    "    movq pas.in_position(%rip), %rdi\n"
+    "    subq %rdi, %r12\n"
+    "    call pas.fill_input\n"
+    "    addq pas.in_position(%rip), %r12\n"
+    "    testl %eax, %eax\n"
+    "    jne .Lpas_read_real_parse\n"
+    ".Lpas_read_real_done:\n"
+    "    movq %r12, pas.in_position(%rip)\n"
+    "    movq %r14, %rdi\n"
+    "    movl %r15d, %esi\n"
+    "    call pas.decimal_to_float\n"
+    "    testl %r13d, %r13d\n"
+    "    je .Lpas_read_real_return\n"
+    "    movd %xmm0, %eax\n"
+    "    xorl $-2147483648, %eax\n"
+    "    movd %eax, %xmm0\n"
+    ".Lpas_read_real_return:\n"
+    "    addq $8, %rsp\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbp\n"
+    "    popq %rbx\n"
+    "    ret\n"
+    "    .size pas.read_real, .-pas.read_real\n"
+    "\n"
+    "    .type pas.read_char, @function\n"
+    "pas.read_char:                       # Next byte in eax, 0 at the end of the input\n"
+    "    subq $8, %rsp\n"
+    "    movq pas.in_position(%rip), %rdi\n"
+    "    cmpq pas.in_end(%rip), %rdi\n"
+    "    jb .Lpas_read_char_byte\n"
+    "    call pas.fill_input\n"
+    "    testl %eax, %eax\n"
+    "    je .Lpas_read_char_done\n"
+    "    movq pas.in_position(%rip), %rdi\n"
+    ".Lpas_read_char_byte:\n"
+    "    leaq pas.in_buffer(%rip), %rax\n"
+    "    movzbl (%rax,%rdi), %eax\n"
+    "    incq %rdi\n"
+    "    movq %rdi, pas.in_position(%rip)\n"
+    ".Lpas_read_char_done:\n"
+    "    addq $8, %rsp\n"
+    "    ret\n"
+    "    .size pas.read_char, .-pas.read_char\n"
+    "\n"
+    "    .type pas.read_string, @function\n"
+    "pas.read_string:                     # Rest of the line without its line break in a new string (rax)\n"
+    "    pushq %rbx\n"
+    "    xorl %ebx, %ebx                 # Length\n"
+    ".Lpas_read_string_block:\n"
+    "    leaq pas.in_buffer(%rip), %rdx\n"
+    "    movq pas.in_position(%rip), %rax\n"
+    "    movq pas.in_end(%rip), %rcx\n"
+    "    addq %rbx, %rax\n"
+    ".Lpas_read_string_byte:\n"
+    "    cmpq %rcx, %rax\n"
+    "    jae .Lpas_read_string_fill\n"
+    "    cmpb $10, (%rdx,%rax)\n"
+    "    je .Lpas_read_string_found\n"
+    "    incq %rax\n"
+    "    jmp .Lpas_read_string_byte\n"
+    ".Lpas_read_string_fill:\n"
+    "    movq %rax, %rbx\n"
+    "    movq pas.in_position(%rip), %rdi\n"
+    "    subq %rdi, %rbx\n"
+    "    call pas.fill_input\n"
+    "    testl %eax, %eax\n"
+    "    jne .Lpas_read_string_block\n"
+    "    jmp .Lpas_read_string_copy\n"
+    ".Lpas_read_string_found:\n"
+    "    subq pas.in_position(%rip), %rax\n"
+    "    movq %rax, %rbx\n"
+    ".Lpas_read_string_copy:\n"
+    "    leaq 1(%rbx), %rdi\n"
+    "    call malloc@PLT\n"
+    "    leaq pas.in_buffer(%rip), %rsi\n"
+    "    addq pas.in_position(%rip), %rsi\n"
+    "    xorl %ecx, %ecx\n"
+    ".Lpas_read_string_copy_byte:\n"
+    "    cmpq %rbx, %rcx\n"
+    "    jae .Lpas_read_string_copied\n"
+    "    movzbl (%rsi,%rcx), %edx\n"
+    "    movb %dl, (%rax,%rcx)\n"
+    "    incq %rcx\n"
+    "    jmp .Lpas_read_string_copy_byte\n"
+    ".Lpas_read_string_copied:\n"
+    "    movb $0, (%rax,%rbx)\n"
+    "    addq %rbx, pas.in_position(%rip)\n"
+    "    popq %rbx\n"
+    "    ret\n"
+    "    .size pas.read_string, .-pas.read_string\n"
+    "\n"
+    "    .type pas.read_line, @function\n"
+    "pas.read_line:                       # Skips the rest of the line and its line break\n"
+    "    subq $8, %rsp\n"
+    ".Lpas_read_line_block:\n"
+    "    leaq pas.in_buffer(%rip), %rdx\n"
+    "    movq pas.in_position(%rip), %rax\n"
+    "    movq pas.in_end(%rip), %rcx\n"
+    ".Lpas_read_line_byte:\n"
+    "    cmpq %rcx, %rax\n"
+    "    jae .Lpas_read_line_fill\n"
+    "    incq %rax\n"
+    "    cmpb $10, -1(%rdx,%rax)\n"
+    "    jne .Lpas_read_line_byte\n"
+    "    movq %rax, pas.in_position(%rip)\n"
+    "    addq $8, %rsp\n"
+    "    ret\n"
+    ".Lpas_read_line_fill:\n"
+    "    movq %rax, pas.in_position(%rip)\n"
+    "    movq %rax, %rdi\n"
+    "    call pas.fill_input\n"
+    "    testl %eax, %eax\n"
+    "    jne .Lpas_read_line_block\n"
+    "    addq $8, %rsp\n"
+    "    ret\n"
+    "    .size pas.read_line, .-pas.read_line\n"
+    "\n"
+    "    .section .rodata\n"
+    "    .balign 8\n"
+    "pas.digit_test:\n"
+    "    .quad 0x4646464646464646\n"
+    "pas.digit_zeros:\n"
+    "    .quad 0x3030303030303030\n"
+    "pas.digit_tops:\n"
+    "    .quad 0x8080808080808080\n"
+    "pas.digit_mask:\n"
+    "    .quad 0x000000ff000000ff\n"
+    "pas.digit_scale_low:\n"
+    "    .quad 0x000f424000000064\n"
+    "pas.digit_scale_high:\n"
+    "    .quad 0x0000271000000001\n"
+    "pas.precision_mask:\n"
+    "    .quad 0x0000003fffffffff\n"
+    "pas.exact_powers:                    # 10^0 to 10^10 as floats\n"
+    "    .long 0x3f800000, 0x41200000, 0x42c80000, 0x447a0000, 0x461c4000, 0x47c35000\n"
+    "    .long 0x49742400, 0x4b189680, 0x4cbebc20, 0x4e6e6b28, 0x501502f9\n"
+    "pas.five_powers:                     # 5^-65 to 5^38, 128 bits each (high word first) starting with a 1 bit\n"
+    "    .quad 0x86ccbb52ea94baea, 0x98e947129fc2b4e9, 0xa87fea27a539e9a5, 0x3f2398d747b36224\n"
+    "    .quad 0xd29fe4b18e88640e, 0x8eec7f0d19a03aad, 0x83a3eeeef9153e89, 0x1953cf68300424ac\n"
+    "    .quad 0xa48ceaaab75a8e2b, 0x5fa8c3423c052dd7, 0xcdb02555653131b6, 0x3792f412cb06794d\n"
+    "    .quad 0x808e17555f3ebf11, 0xe2bbd88bbee40bd0, 0xa0b19d2ab70e6ed6, 0x5b6aceaeae9d0ec4\n"
+    "    .quad 0xc8de047564d20a8b, 0xf245825a5a445275, 0xfb158592be068d2e, 0xeed6e2f0f0d56712\n"
+    "    .quad 0x9ced737bb6c4183d, 0x55464dd69685606b, 0xc428d05aa4751e4c, 0xaa97e14c3c26b886\n"
+    "    .quad 0xf53304714d9265df, 0xd53dd99f4b3066a8, 0x993fe2c6d07b7fab, 0xe546a8038efe4029\n"
+    "    .quad 0xbf8fdb78849a5f96, 0xde98520472bdd033, 0xef73d256a5c0f77c, 0x963e66858f6d4440\n"
+    "    .quad 0x95a8637627989aad, 0xdde7001379a44aa8, 0xbb127c53b17ec159, 0x5560c018580d5d52\n"
+    "    .quad 0xe9d71b689dde71af, 0xaab8f01e6e10b4a6, 0x9226712162ab070d, 0xcab3961304ca70e8\n"
+    "    .quad 0xb6b00d69bb55c8d1, 0x3d607b97c5fd0d22, 0xe45c10c42a2b3b05, 0x8cb89a7db77c506a\n"
+    "    .quad 0x8eb98a7a9a5b04e3, 0x77f3608e92adb242, 0xb267ed1940f1c61c, 0x55f038b237591ed3\n"
+    "    .quad 0xdf01e85f912e37a3, 0x6b6c46dec52f6688, 0x8b61313bbabce2c6, 0x2323ac4b3b3da015\n"
+    "    .quad 0xae397d8aa96c1b77, 0xabec975e0a0d081a, 0xd9c7dced53c72255, 0x96e7bd358c904a21\n"
+    "    .quad 0x881cea14545c7575, 0x7e50d64177da2e54, 0xaa242499697392d2, 0xdde50bd1d5d0b9e9\n"
+    "    .quad 0xd4ad2dbfc3d07787, 0x955e4ec64b44e864, 0x84ec3c97da624ab4, 0xbd5af13bef0b113e\n"
+    "    .quad 0xa6274bbdd0fadd61, 0xecb1ad8aeacdd58e, 0xcfb11ead453994ba, 0x67de18eda5814af2\n"
+    "    .quad 0x81ceb32c4b43fcf4, 0x80eacf948770ced7, 0xa2425ff75e14fc31, 0xa1258379a94d028d\n"
+    "    .quad 0xcad2f7f5359a3b3e, 0x096ee45813a04330, 0xfd87b5f28300ca0d, 0x8bca9d6e188853fc\n"
+    "    .quad 0x9e74d1b791e07e48, 0x775ea264cf55347e, 0xc612062576589dda, 0x95364afe032a819e\n"
+    "    .quad 0xf79687aed3eec551, 0x3a83ddbd83f52205, 0x9abe14cd44753b52, 0xc4926a9672793543\n"
+    "    .quad 0xc16d9a0095928a27, 0x75b7053c0f178294, 0xf1c90080baf72cb1, 0x5324c68b12dd6339\n"
+    "    .quad 0x971da05074da7bee, 0xd3f6fc16ebca5e04, 0xbce5086492111aea, 0x88f4bb1ca6bcf585\n"
+    "    .quad 0xec1e4a7db69561a5, 0x2b31e9e3d06c32e6, 0x9392ee8e921d5d07, 0x3aff322e62439fd0\n"
+    "    .quad 0xb877aa3236a4b449, 0x09befeb9fad487c3, 0xe69594bec44de15b, 0x4c2ebe687989a9b4\n"
+    "    .quad 0x901d7cf73ab0acd9, 0x0f9d37014bf60a11, 0xb424dc35095cd80f, 0x538484c19ef38c95\n"
+    "    .quad 0xe12e13424bb40e13, 0x2865a5f206b06fba, 0x8cbccc096f5088cb, 0xf93f87b7442e45d4\n"
+    "    .quad 0xafebff0bcb24aafe, 0xf78f69a51539d749, 0xdbe6fecebdedd5be, 0xb573440e5a884d1c\n"
+    "    .quad 0x89705f4136b4a597, 0x31680a88f8953031, 0xabcc77118461cefc, 0xfdc20d2b36ba7c3e\n"
+    "    .quad 0xd6bf94d5e57a42bc, 0x3d32907604691b4d, 0x8637bd05af6c69b5, 0xa63f9a49c2c1b110\n"
+    "    .quad 0xa7c5ac471b478423, 0x0fcf80dc33721d54, 0xd1b71758e219652b, 0xd3c36113404ea4a9\n"
+    "    .quad 0x83126e978d4fdf3b, 0x645a1cac083126ea, 0xa3d70a3d70a3d70a, 0x3d70a3d70a3d70a4\n"
+    "    .quad 0xcccccccccccccccc, 0xcccccccccccccccd, 0x8000000000000000, 0x0000000000000000\n"
+    "    .quad 0xa000000000000000, 0x0000000000000000, 0xc800000000000000, 0x0000000000000000\n"
+    "    .quad 0xfa00000000000000, 0x0000000000000000, 0x9c40000000000000, 0x0000000000000000\n"
+    "    .quad 0xc350000000000000, 0x0000000000000000, 0xf424000000000000, 0x0000000000000000\n"
+    "    .quad 0x9896800000000000, 0x0000000000000000, 0xbebc200000000000, 0x0000000000000000\n"
+    "    .quad 0xee6b280000000000, 0x0000000000000000, 0x9502f90000000000, 0x0000000000000000\n"
+    "    .quad 0xba43b74000000000, 0x0000000000000000, 0xe8d4a51000000000, 0x0000000000000000\n"
+    "    .quad 0x9184e72a00000000, 0x0000000000000000, 0xb5e620f480000000, 0x0000000000000000\n"
+    "    .quad 0xe35fa931a0000000, 0x0000000000000000, 0x8e1bc9bf04000000, 0x0000000000000000\n"
+    "    .quad 0xb1a2bc2ec5000000, 0x0000000000000000, 0xde0b6b3a76400000, 0x0000000000000000\n"
+    "    .quad 0x8ac7230489e80000, 0x0000000000000000, 0xad78ebc5ac620000, 0x0000000000000000\n"
+    "    .quad 0xd8d726b7177a8000, 0x0000000000000000, 0x878678326eac9000, 0x0000000000000000\n"
+    "    .quad 0xa968163f0a57b400, 0x0000000000000000, 0xd3c21bcecceda100, 0x0000000000000000\n"
+    "    .quad 0x84595161401484a0, 0x0000000000000000, 0xa56fa5b99019a5c8, 0x0000000000000000\n"
+    "    .quad 0xcecb8f27f4200f3a, 0x0000000000000000, 0x813f3978f8940984, 0x4000000000000000\n"
+    "    .quad 0xa18f07d736b90be5, 0x5000000000000000, 0xc9f2c9cd04674ede, 0xa400000000000000\n"
+    "    .quad 0xfc6f7c4045812296, 0x4d00000000000000, 0x9dc5ada82b70b59d, 0xf020000000000000\n"
+    "    .quad 0xc5371912364ce305, 0x6c28000000000000, 0xf684df56c3e01bc6, 0xc732000000000000\n"
+    "    .quad 0x9a130b963a6c115c, 0x3c7f400000000000, 0xc097ce7bc90715b3, 0x4b9f100000000000\n"
+    "    .quad 0xf0bdc21abb48db20, 0x1e86d40000000000, 0x96769950b50d88f4, 0x1314448000000000\n"
+    "\n"
+    "    .data\n"
+    "    .balign 8\n"
+    "pas.in_position:\n"
+    "    .quad 0\n"
+    "pas.in_end:\n"
+    "    .quad 0\n"
+    "pas.in_eof:                          # 1 once nothing is left to read\n"
+    "    .quad 0\n"
+    "\n"
+    "    .bss\n"
+    "    .balign 16\n"
+    "pas.in_buffer:                       # 64 KiB of input, a zero byte after the data and room for a word loaded before its end\n"
+    "    .zero 65552\n";
@@ -0,0 +1,11 @@
+#ifndef READ_RUNTIME_H
+#define READ_RUNTIME_H
+
+// Runtime of read and readln in the native code, written after the program in its assembly with the one of write, whose
+// output is written out before waiting for input. The input comes from stdin in blocks of 64 KiB and is parsed like in
+// read_format.c: pas.read_int (eax), pas.read_real (xmm0), pas.read_char (eax), pas.read_string (rax, a new string) and
+// pas.read_line.
+
+extern const char *read_runtime_assembly;
+
+#endif
@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "scanner.h"
+#include "symbol_table.h"
+#include "tac.h"
+#include "tac_array.h"
+#include "control_flow.h"
+#include "liveness.h"
+#include "register_allocator.h"
+
+// Linear scan over the live intervals sorted by start (Poletto and Sarkar): the intervals holding a register are kept
+// sorted by end, when no register is free the interval ending last gives up its register and moves to a stack slot.
+
+const char *register_names[REGISTER_COUNT] = {
+    "rbx", "r12", "r13", "r14", "r15", "rsi", "rdi", "r8", "r9", "xmm8", "xmm9", "xmm10", "xmm11", "xmm12", "xmm13"
+};
+
+const char* register_name(int reg) {
+    return reg >= 0 && reg < REGISTER_COUNT ? register_names[reg] : "none";
+}
+
+typedef struct _LinearScan {
+    RegisterAllocation *alloc;
+    const LiveInterval *intervals;
+    int active[REGISTER_COUNT]; // Variables holding a register, sorted by the end of their interval
+    int active_count;
+    int *spilled; // Min heap of the spilled variables by the end of their interval, their slots are freed once it is over
+    int spilled_count;
+    int *free_slots;
+    int free_slot_count;
+} LinearScan;
+
+#define INT_REGISTERS ((1u << (REG_R9 + 1)) - 1)
+#define CALLEE_SAVED_REGISTERS ((1u << (REG_R15 + 1)) - 1)
+#define FLOAT_REGISTERS (((1u << REGISTER_COUNT) - 1) & ~INT_REGISTERS)
+
+int compare_interval_keys(const void *key_1, const void *key_2) { // Keys hold the interval start then the variable
+    uint64_t k1 = *(const uint64_t *) key_1, k2 = *(const uint64_t *) key_2;
+    return k1 < k2 ? -1 : k1 > k2;
+}
+
+void push_spilled(LinearScan *scan, int var) {
+    int i = scan->spilled_count++;
+    while (i > 0 && scan->intervals[scan->spilled[(i - 1) / 2]].end > scan->intervals[var].end) {
+        scan->spilled[i] = scan->spilled[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    scan->spilled[i] = var;
+}
+
+int pop_spilled(LinearScan *scan) {
+    int top = scan->spilled[0], last = scan->spilled[--scan->spilled_count];
+    int i = 0;
+    while (2 * i + 1 < scan->spilled_count) {
+        int child = 2 * i + 1;
+        if (child + 1 < scan->spilled_count && scan->intervals[scan->spilled[child + 1]].end < scan->intervals[scan->spilled[child]].end)
+            child++;
+        if (scan->intervals[scan->spilled[child]].end >= scan->intervals[last].end)
+            break;
+        scan->spilled[i] = scan->spilled[child];
+        i = child;
+    }
+    scan->spilled[i] = last;
+    return top;
+}
+
+void spill_var(LinearScan *scan, int var) { // Gives the variable a stack slot for its whole interval
+    RegisterAllocation *alloc = scan->alloc;
+    alloc->registers[var] = NO_REGISTER;
+    alloc->slots[var] = scan->free_slot_count > 0 ? scan->free_slots[--scan->free_slot_count] : alloc->slot_count++;
+    alloc->spill_count++;
+    push_spilled(scan, var);
+}
+
+void activate_var(LinearScan *scan, int var, int reg) {
+    int i = scan->active_count++;
+    while (i > 0 && scan->intervals[scan->active[i - 1]].end > scan->intervals[var].end) {
+        scan->active[i] = scan->active[i - 1];
+        i--;
+    }
+    scan->active[i] = var;
+    scan->alloc->registers[var] = reg;
+    scan->alloc->used_registers |= 1u << reg;
+}
+
+void expire_intervals(LinearScan *scan, int start, uint32_t *free_registers) { // Frees what the intervals over before start held
+    int kept = 0;
+    for (int a = 0; a < scan->active_count; a++) {
+        int var = scan->active[a];
+        if (scan->intervals[var].end < start)
+            *free_registers |= 1u << scan->alloc->registers[var];
+        else
+            scan->active[kept++] = var;
+    }
+    scan->active_count = kept;
+    while (scan->spilled_count > 0 && scan->intervals[scan->spilled[0]].end < start) {
+        int var = pop_spilled(scan);
+        scan->free_slots[scan->free_slot_count++] = scan->alloc->slots[var];
+    }
+}
+
+int pick_register(uint32_t candidates) { // Lowest register of the mask, NO_REGISTER when it is empty
+    for (int reg = 0; reg < REGISTER_COUNT; reg++) {
+        if (candidates & (1u << reg))
+            return reg;
+    }
+    return NO_REGISTER;
+}
+
+void scan_interval(LinearScan *scan, int var, uint32_t allowed, uint32_t *free_registers) {
+    // Caller saved registers first, the callee saved ones cost a save and a restore in the prologue and the epilogue
+    uint32_t candidates = *free_registers & allowed;
+    int reg = pick_register(candidates & ~CALLEE_SAVED_REGISTERS);
+    if (reg == NO_REGISTER)
+        reg = pick_register(candidates);
+    if (reg != NO_REGISTER) {
+        *free_registers &= ~(1u << reg);
+        activate_var(scan, var, reg);
+        return;
+    }
+    for (int a = scan->active_count - 1; a >= 0; a--) { // Ends last among the ones holding an allowed register
+        int victim = scan->active[a];
+        if (!(allowed & (1u << scan->alloc->registers[victim])))
+            continue;
+        if (scan->intervals[victim].end <= scan->intervals[var].end)
+            break;
+        reg = scan->alloc->registers[victim];
+        for (; a + 1 < scan->active_count; a++)
+            scan->active[a] = scan->active[a + 1];
+        scan->active_count--;
+        spill_var(scan, victim);
+        activate_var(scan, var, reg);
+        return;
+    }
+    spill_var(scan, var);
+}
+
+RegisterAllocation* allocate_registers(const ControlFlowGraph *cfg) {
+    const TacArray *code = cfg->code;
+    RegisterAllocation *alloc = malloc(sizeof(RegisterAllocation));
+    if (alloc == NULL) {
+        fprintf(code->log_fptr, "Error: failed to allocate memory for the register allocation\n");
+        return NULL;
+    }
+    alloc->live = compute_liveness(cfg);
+    int var_count = alloc->live != NULL ? alloc->live->var_count : 0;
+    alloc->registers = malloc((var_count + 1) * sizeof(int));
+    alloc->slots = malloc((var_count + 1) * sizeof(int));
+    alloc->slot_count = alloc->register_count = alloc->spill_count = 0;
+    alloc->used_registers = 0;
+    uint64_t *order = malloc((var_count + 1) * sizeof(uint64_t));
+    LinearScan scan;
+    scan.alloc = alloc;
+    scan.active_count = scan.spilled_count = scan.free_slot_count = 0;
+    scan.spilled = malloc((var_count + 1) * sizeof(int));
+    scan.free_slots = malloc((var_count + 1) * sizeof(int));
+    if (alloc->live == NULL || alloc->registers == NULL || alloc->slots == NULL || order == NULL || scan.spilled == NULL
+        || scan.free_slots == NULL) {
+        if (alloc->live != NULL)
+            fprintf(code->log_fptr, "Error: failed to allocate memory for the register allocation\n");
+        free(order);
+        free(scan.spilled);
+        free(scan.free_slots);
+        free_allocation(alloc);
+        return NULL;
+    }
+    scan.intervals = alloc->live->intervals;
+
+    int order_count = 0;
+    for (int var = 0; var < var_count; var++) {
+        alloc->registers[var] = NO_REGISTER;
+        alloc->slots[var] = -1;
+        if (scan.intervals[var].addressed) // Passed by reference, its slot is never shared
+            alloc->slots[var] = alloc->slot_count++;
+        else if (scan.intervals[var].start >= 0)
+            order[order_count++] = ((uint64_t) scan.intervals[var].start << 32) | (uint32_t) var;
+    }
+    qsort(order, order_count, sizeof(uint64_t), compare_interval_keys);
+
+    uint32_t free_registers = (1u << REGISTER_COUNT) - 1;
+    for (int n = 0; n < order_count; n++) {
+        int var = (int) (uint32_t) order[n];
+        const LiveInterval *interval = &scan.intervals[var];
+        expire_intervals(&scan, interval->start, &free_registers);
+        uint32_t allowed = operand_type(code, alloc->live->vars[var]) == REAL_TOKEN ? FLOAT_REGISTERS : INT_REGISTERS;
+        if (interval->crosses_call) // Only the callee saved registers survive the calls
+            allowed &= CALLEE_SAVED_REGISTERS;
+        scan_interval(&scan, var, allowed, &free_registers);
+    }
+    for (int var = 0; var < var_count; var++)
+        alloc->register_count += alloc->registers[var] != NO_REGISTER;
+    free(order);
+    free(scan.spilled);
+    free(scan.free_slots);
+    return alloc;
+}
+
+void free_allocation(RegisterAllocation *alloc) {
+    if (alloc != NULL) {
+        free_liveness(alloc->live);
+        free(alloc->registers);
+        free(alloc->slots);
+        free(alloc);
+    }
+}
+
+void print_allocation_stats(FILE *fptr, const TacArray *code, int routine_start, const RegisterAllocation *alloc) {
+    const Symbol *routine = operand_symbol(code, code->a[routine_start]);
+    int callee_saved_count = 0;
+    for (int reg = 0; reg < REGISTER_COUNT; reg++)
+        callee_saved_count += is_callee_saved(reg) && (alloc->used_registers & (1u << reg));
+    fprintf(fptr, "%s: %d variables, %d in registers, %d spilled, %d stack slots, %d callee saved registers\n",
+            routine != NULL ? routine->name : "program", alloc->live->var_count, alloc->register_count, alloc->spill_count,
+            alloc->slot_count, callee_saved_count);
+}
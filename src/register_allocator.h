@@ -0,0 +1,38 @@
+#ifndef REGISTER_ALLOCATOR_H
+#define REGISTER_ALLOCATOR_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "tac_array.h"
+#include "control_flow.h"
+#include "liveness.h"
+
+// x86-64 registers given to the variables. rax, rcx, rdx, r10, r11, xmm0 to xmm7, xmm14 and xmm15 are left to the code
+// generator for the operations with fixed registers, the arguments and the loads of the stack slots.
+typedef enum {
+    REG_RBX, REG_R12, REG_R13, REG_R14, REG_R15, // Saved by the callee
+    REG_RSI, REG_RDI, REG_R8, REG_R9, // Clobbered by calls
+    REG_XMM8, REG_XMM9, REG_XMM10, REG_XMM11, REG_XMM12, REG_XMM13, // Clobbered by calls
+    REGISTER_COUNT
+} Register;
+
+#define NO_REGISTER -1
+#define is_callee_saved(reg) ((reg) <= REG_R15)
+#define is_float_register(reg) ((reg) >= REG_XMM8)
+
+typedef struct _RegisterAllocation {
+    Liveness *live;
+    int *registers; // Register of each variable, NO_REGISTER when it lives in its stack slot
+    int *slots; // Stack slot of each variable that didn't get a register (8 bytes each), -1 otherwise
+    int slot_count;
+    uint32_t used_registers; // Bit mask of the registers given to variables
+    int register_count, spill_count; // Variables given a register, variables spilled to a stack slot because none was free
+} RegisterAllocation;
+
+RegisterAllocation* allocate_registers(const ControlFlowGraph *);
+void free_allocation(RegisterAllocation *);
+const char* register_name(int);
+void print_allocation_stats(FILE *, const TacArray *, int, const RegisterAllocation *);
+
+#endif
@@ -0,0 +1,110 @@
+#include "runtime.h"
+
+// Assembly of the runtime, lines starting with rt_ or .Lrt_ are private to it
+const char *runtime_assembly =
+    "    .text\n"
+    "    .globl _start\n"
+    "    .type _start, @function\n"
+    "_start:\n"
+    "    xorl %ebp, %ebp\n"
+    "    call main\n"
+    "    movl %eax, %edi\n"
+    "    movl $231, %eax                 # exit_group\n"
+    "    syscall\n"
+    "\n"
+    "    .type strlen, @function\n"
+    "strlen:\n"
+    "    movq %rdi, %rax\n"
+    ".Lrt_strlen_loop:\n"
+    "    cmpb $0, (%rax)\n"
+    "    je .Lrt_strlen_done\n"
+    "    incq %rax\n"
+    "    jmp .Lrt_strlen_loop\n"
+    ".Lrt_strlen_done:\n"
+    "    subq %rdi, %rax\n"
+    "    ret\n"
+    "\n"
+    "    .type strcmp, @function\n"
+    "strcmp:\n"
+    "    movzbl (%rdi), %eax\n"
+    "    movzbl (%rsi), %ecx\n"
+    "    subl %ecx, %eax\n"
+    "    jne .Lrt_strcmp_done\n"
+    "    testl %ecx, %ecx\n"
+    "    je .Lrt_strcmp_done\n"
+    "    incq %rdi\n"
+    "    incq %rsi\n"
+    "    jmp strcmp\n"
+    ".Lrt_strcmp_done:\n"
+    "    ret\n"
+    "\n"
+    "    .type strcpy, @function\n"
+    "strcpy:\n"
+    "    movq %rdi, %rax\n"
+    "    movq %rdi, %rdx\n"
+    ".Lrt_strcpy_loop:\n"
+    "    movzbl (%rsi), %ecx\n"
+    "    movb %cl, (%rdx)\n"
+    "    incq %rsi\n"
+    "    incq %rdx\n"
+    "    testl %ecx, %ecx\n"
+    "    jne .Lrt_strcpy_loop\n"
+    "    ret\n"
+    "\n"
+    "    .type strcat, @function\n"
+    "strcat:\n"
+    "    pushq %rdi\n"
+    "    pushq %rsi\n"
+    "    call strlen\n"
+    "    popq %rsi\n"
+    "    movq (%rsp), %rdi\n"
+    "    addq %rax, %rdi\n"
+    "    call strcpy\n"
+    "    popq %rax\n"
+    "    ret\n"
+    "\n"
+    "    .type malloc, @function\n"
+    "malloc:                             # Blocks carved from mappings of 1 MiB or more, never freed\n"
+    "    addq $15, %rdi\n"
+    "    andq $-16, %rdi\n"
+    "    movq rt_heap_next(%rip), %rax\n"
+    "    movq rt_heap_end(%rip), %rcx\n"
+    "    subq %rax, %rcx\n"
+    "    cmpq %rdi, %rcx\n"
+    "    jae .Lrt_malloc_take\n"
+    "    pushq %rdi\n"
+    "    movq %rdi, %rsi\n"
+    "    cmpq $1048576, %rsi\n"
+    "    jae .Lrt_malloc_map\n"
+    "    movl $1048576, %esi\n"
+    ".Lrt_malloc_map:\n"
+    "    pushq %rsi\n"
+    "    xorl %edi, %edi\n"
+    "    movl $3, %edx                   # PROT_READ | PROT_WRITE\n"
+    "    movl $34, %r10d                 # MAP_PRIVATE | MAP_ANONYMOUS\n"
+    "    movq $-1, %r8\n"
+    "    xorl %r9d, %r9d\n"
+    "    movl $9, %eax                   # mmap\n"
+    "    syscall\n"
+    "    popq %rsi\n"
+    "    popq %rdi\n"
+    "    cmpq $-4096, %rax\n"
+    "    ja .Lrt_malloc_failed\n"
+    "    movq %rax, rt_heap_next(%rip)\n"
+    "    addq %rax, %rsi\n"
+    "    movq %rsi, rt_heap_end(%rip)\n"
+    ".Lrt_malloc_take:\n"
+    "    movq rt_heap_next(%rip), %rax\n"
+    "    leaq (%rax,%rdi), %rcx\n"
+    "    movq %rcx, rt_heap_next(%rip)\n"
+    "    ret\n"
+    ".Lrt_malloc_failed:\n"
+    "    xorl %eax, %eax\n"
+    "    ret\n"
+    "\n"
+    "    .data\n"
+    "    .balign 8\n"
+    "rt_heap_next:\n"
+    "    .quad 0\n"
+    "rt_heap_end:\n"
+    "    .quad 0\n";
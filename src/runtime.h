@@ -0,0 +1,9 @@
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+// Runtime of the static executables, assembled with the program by the built-in assembler. It holds the entry point
+// and the C library functions the generated code calls, written over Linux system calls with no C library.
+
+extern const char *runtime_assembly;
+
+#endif
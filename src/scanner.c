@@ -3,11 +3,12 @@
 #include <string.h>
 #include <ctype.h>
 #include "scanner.h"
+#include "compiler_context.h"
 
 const char* const keywords[] = {
     "and", "array", "asm", "begin", "boolean", "break", "case", "char", "const", "constructor", "continue", "destructor", "div", "do", "downto",
     "else", "end", "file", "for", "function", "goto", "if", "implementation", "in", "inline", "integer", "interface", "label", "mod", "nil",
-    "not", "object", "of", "on", "operator", "or", "packed", "procedure", "program", "read", "real", "record", "repeat", "set", "shl", "shr",
+    "not", "object", "of", "on", "operator", "or", "packed", "procedure", "program", "read", "readln", "real", "record", "repeat", "set", "shl", "shr",
     "string", "then", "to", "type", "unit", "until", "uses", "var", "while", "with", "write", "writeln", "xor"
 };
 
@@ -18,19 +19,13 @@ const char* const token_type_map[] = {
     "CONSTRUCTOR_TOKEN", "CONTINUE_TOKEN", "DESTRUCTOR_TOKEN", "IDIV_TOKEN", "DO_TOKEN", "DOWNTO_TOKEN", "ELSE_TOKEN", "END_TOKEN", "FILE_TOKEN",
     "FOR_TOKEN", "FUNCTION_TOKEN", "GOTO_TOKEN", "IF_TOKEN", "IMPLEMENTATION_TOKEN", "IN_TOKEN", "INLINE_TOKEN", "INT_TOKEN", "INTERFACE_TOKEN",
     "LABEL_TOKEN", "MOD_TOKEN", "NIL_TOKEN", "NOT_TOKEN", "OBJECT_TOKEN", "OF_TOKEN", "ON_TOKEN", "OPERATOR_TOKEN", "OR_TOKEN", "PACKED_TOKEN",
-    "PROCEDURE_TOKEN", "PROGRAM_TOKEN", "READ_TOKEN", "REAL_TOKEN", "RECORD_TOKEN", "REPEAT_TOKEN", "SET_TOKEN", "SHL_TOKEN", "SHR_TOKEN",
+    "PROCEDURE_TOKEN", "PROGRAM_TOKEN", "READ_TOKEN", "READLN_TOKEN", "REAL_TOKEN", "RECORD_TOKEN", "REPEAT_TOKEN", "SET_TOKEN", "SHL_TOKEN", "SHR_TOKEN",
     "STRING_TOKEN", "THEN_TOKEN", "TO_TOKEN", "TYPE_TOKEN", "UNIT_TOKEN", "UNTIL_TOKEN", "USES_TOKEN", "VAR_TOKEN", "WHILE_TOKEN", "WITH_TOKEN",
     "WRITE_TOKEN", "WRITELN_TOKEN", "XOR_TOKEN", "SC_TOKEN", "COLON_TOKEN", "PERIOD_TOKEN", "PLUS_TOKEN", "MINUS_TOKEN", "MULT_TOKEN",
     "RDIV_TOKEN", "COMMA_TOKEN", "ASSIGN_TOKEN", "EQ_TOKEN", "LESS_TOKEN", "LEQ_TOKEN", "BIGGER_TOKEN", "BEQ_TOKEN", "DIFF_TOKEN", "OP_TOKEN",
     "CP_TOKEN", "EOF_TOKEN", "ID_TOKEN", "INUM_TOKEN", "RNUM_TOKEN", "SVAL_TOKEN", "CVAL_TOKEN", "RVALUE_TOKEN", "VTYPE_TOKEN", "ERROR_TOKEN"
 };
 
-int line_count = 1, char_count = 1;
-
-static FILE *target_fptr = NULL;
-TokenData *current_token = NULL;
-TokenData *stocked_token = NULL;
-
 char* to_lowercase(char *word) {
     // Pascal is case insensitive (program == Program == PROGRAM)
     for (char *c = word; *c != '\0'; c++)
@@ -103,120 +98,191 @@ TokenType find_token_type(char *word) {
     return ERROR_TOKEN; // If all previous tests failed (identifier starting with a digit)
 }
 
-void close_target_file() {
-    if (current_token != NULL) {
-        free(current_token->token);
-        free(current_token);
-        current_token = NULL;
+void close_target_file(CompilerContext *ctx) {
+    if (ctx->current_token != NULL) {
+        free(ctx->current_token->token);
+        free(ctx->current_token);
+        ctx->current_token = NULL;
+    }
+    if (ctx->stocked_token != NULL) {
+        free(ctx->stocked_token->token);
+        free(ctx->stocked_token);
+        ctx->stocked_token = NULL;
     }
-    if (target_fptr != NULL) {
-        fclose(target_fptr);
-        target_fptr = NULL;
+    if (ctx->target_fptr != NULL) {
+        fclose(ctx->target_fptr);
+        ctx->target_fptr = NULL;
     }
 }
 
-int open_target_file(const char *path) {
-    close_target_file();
+int open_target_file(CompilerContext *ctx, const char *path) {
+    close_target_file(ctx);
     if (path == NULL) {
-        printf("Error: no target source file path specified\n");
+        fprintf(ctx->log_fptr, "Error: no target source file path specified\n");
         return 0;
     }
-    target_fptr = fopen(path, "r+");
-    if (!target_fptr) {
-        printf("Error: failed to find target source file at path \"%s\"\n", path);
+    ctx->target_fptr = fopen(path, "r+");
+    if (!ctx->target_fptr) {
+        fprintf(ctx->log_fptr, "Error: failed to find target source file at path \"%s\"\n", path);
         return 0;
     }
+    ctx->line_count = 1;
+    ctx->char_count = 1;
     return 1;
 }
 
-void next_token() {
-    if (current_token != NULL) { // Freeing the memory allocated to the previous token
-        free(current_token->token);
-        free(current_token);
-        current_token = NULL;
+TokenStream* make_token_stream() {
+    TokenStream *stream = malloc(sizeof(TokenStream));
+    if (stream == NULL) // The file is then compiled without being cached
+        return NULL;
+    stream->tokens = NULL;
+    stream->token_count = 0;
+    stream->capacity = 0;
+    stream->position = 0;
+    stream->failed = 0;
+    return stream;
+}
+
+void free_token_stream(TokenStream *stream) {
+    if (stream != NULL) {
+        for (int i = 0; i < stream->token_count; i++)
+            free(stream->tokens[i].token);
+        free(stream->tokens);
+        free(stream);
     }
-    if (target_fptr != NULL) {
-        if (stocked_token != NULL) { // Next token has already been read in a previous call (Case of a special character)
-            current_token = stocked_token;
-            stocked_token = NULL;
-            printf("%s -> %s\n", current_token->token, token_type_map[(current_token->type) - 1]);
+}
+
+int is_complete_stream(const TokenStream *stream) { // A stream can only be replayed if it was recorded up to the end of the file
+    return !stream->failed && stream->token_count > 0 && stream->tokens[stream->token_count - 1].type == EOF_TOKEN;
+}
+
+void record_token(TokenStream *stream, const TokenData *data) { // A token that can't be recorded makes the stream unusable
+    if (stream->failed)
+        return;
+    if (stream->token_count >= stream->capacity) {
+        int new_capacity = stream->capacity == 0 ? BUFFER_SIZE : stream->capacity * 2;
+        TokenData *new_tokens = realloc(stream->tokens, new_capacity * sizeof(TokenData));
+        if (new_tokens == NULL) {
+            stream->failed = 1;
+            return;
+        }
+        stream->tokens = new_tokens;
+        stream->capacity = new_capacity;
+    }
+    TokenData *cpy_data = &stream->tokens[stream->token_count];
+    cpy_data->token = malloc(strlen(data->token) + 1);
+    if (cpy_data->token == NULL) {
+        stream->failed = 1;
+        return;
+    }
+    stream->token_count++;
+    strcpy(cpy_data->token, data->token);
+    cpy_data->type = data->type;
+    cpy_data->start_ln = data->start_ln;
+    cpy_data->start_col = data->start_col;
+}
+
+void replay_token(CompilerContext *ctx) {
+    TokenStream *stream = ctx->token_replay;
+    if (stream->position >= stream->token_count)
+        return;
+    const TokenData *data = &stream->tokens[stream->position++];
+    ctx->current_token = malloc(sizeof(TokenData));
+    ctx->current_token->token = malloc(strlen(data->token) + 1);
+    strcpy(ctx->current_token->token, data->token);
+    ctx->current_token->type = data->type;
+    ctx->current_token->start_ln = data->start_ln;
+    ctx->current_token->start_col = data->start_col;
+    if (ctx->options.list_tokens)
+        fprintf(ctx->log_fptr, "%s -> %s\n", ctx->current_token->token, token_type_map[ctx->current_token->type - 1]);
+}
+
+void scan_token(CompilerContext *ctx) {
+    if (ctx->target_fptr != NULL) {
+        if (ctx->stocked_token != NULL) { // Next token has already been read in a previous call (Case of a special character)
+            ctx->current_token = ctx->stocked_token;
+            ctx->stocked_token = NULL;
+            if (ctx->options.list_tokens)
+                fprintf(ctx->log_fptr, "%s -> %s\n", ctx->current_token->token, token_type_map[(ctx->current_token->type) - 1]);
             return;
         }
         // Reads the targeted file to scan for the next token
         int i = 0, n = 1, token_length = 0;
         char c = '\0', *buffer = malloc(n * BUFFER_SIZE);
         char *spec_str = NULL;
-        while (c != EOF && (c = getc(target_fptr)) != EOF) {
-            char_count++;
+        while (c != EOF && (c = getc(ctx->target_fptr)) != EOF) {
+            ctx->char_count++;
             token_length++;
             if (c == ' ' || c == '\n' || c == '\t') {
                 if (i != 0) {
                     buffer[i] = '\0';
                     TokenType type = find_token_type(buffer);
                     if (type == ERROR_TOKEN) {
-                        printf("Error: identifer %s starts with a digit at line %d, char %d\n", buffer, line_count, char_count-token_length);
+                        fprintf(ctx->log_fptr, "Error: identifer %s starts with a digit at line %d, char %d\n", buffer, ctx->line_count, ctx->char_count-token_length);
                         return;
                     }
-                    printf("%s -> %s\n", buffer, token_type_map[type - 1]);
-                    current_token = malloc(sizeof(TokenData));
-                    current_token->token = buffer;
-                    current_token->type = type;
-                    current_token->start_ln = line_count;
-                    current_token->start_col = char_count-token_length;
+                    if (ctx->options.list_tokens)
+                        fprintf(ctx->log_fptr, "%s -> %s\n", buffer, token_type_map[type - 1]);
+                    ctx->current_token = malloc(sizeof(TokenData));
+                    ctx->current_token->token = buffer;
+                    ctx->current_token->type = type;
+                    ctx->current_token->start_ln = ctx->line_count;
+                    ctx->current_token->start_col = ctx->char_count-token_length;
                     if (c == '\n') {
-                        char_count = 1;
-                        line_count++;
+                        ctx->char_count = 1;
+                        ctx->line_count++;
                     }
                     return;
                 }
                 if (c == '\n') {
-                    char_count = 1;
-                    line_count++;
+                    ctx->char_count = 1;
+                    ctx->line_count++;
                 }
                 token_length = 0;
             }
             else if (c == '{') { // Case of Pascal comments
                 int comment_length = 1;
-                while ((c = getc(target_fptr)) != '}' && c != EOF) {
+                while ((c = getc(ctx->target_fptr)) != '}' && c != EOF) {
                     comment_length++;
                     if (c == '\n') {
                         comment_length = 1;
-                        line_count++;
+                        ctx->line_count++;
                     }
                 }
                 if (i != 0) {
                     buffer[i] = '\0';
                     TokenType type = find_token_type(buffer);
                     if (type == ERROR_TOKEN) {
-                        printf("Error: identifer %s starts with a digit at line %d, char %d\n", buffer, line_count, char_count-token_length);
+                        fprintf(ctx->log_fptr, "Error: identifer %s starts with a digit at line %d, char %d\n", buffer, ctx->line_count, ctx->char_count-token_length);
                         return;
                     }
-                    printf("%s -> %s\n", buffer, token_type_map[type - 1]);
-                    current_token = malloc(sizeof(TokenData));
-                    current_token->token = buffer;
-                    current_token->type = type;
-                    current_token->start_ln = line_count;
-                    current_token->start_col = char_count-token_length;
+                    if (ctx->options.list_tokens)
+                        fprintf(ctx->log_fptr, "%s -> %s\n", buffer, token_type_map[type - 1]);
+                    ctx->current_token = malloc(sizeof(TokenData));
+                    ctx->current_token->token = buffer;
+                    ctx->current_token->type = type;
+                    ctx->current_token->start_ln = ctx->line_count;
+                    ctx->current_token->start_col = ctx->char_count-token_length;
                     if (c == '}')
-                        char_count += comment_length + 1;
+                        ctx->char_count += comment_length + 1;
                     return;
                 }
                 if (c == '}')
-                    char_count += comment_length + 1;
+                    ctx->char_count += comment_length + 1;
             }
             else if (c == '\'') { // String detection
                 n = 1;
                 int j = 0;
                 char *str_buffer = malloc(n * BUFFER_SIZE);
-                while ((c = getc(target_fptr)) != '\'' && c != EOF && c != '\n') {
-                    char_count++;
+                while ((c = getc(ctx->target_fptr)) != '\'' && c != EOF && c != '\n') {
+                    ctx->char_count++;
                     token_length++;
                     str_buffer[j++] = c;
                     if (j >= n * BUFFER_SIZE) {
                         char *new_buffer = realloc(str_buffer, ++n * BUFFER_SIZE);
                         if (new_buffer == NULL) {
                             // NULL value returned, failure to reallocate more memory for some reason
-                            printf("Error: failed to reallocate more memory to the buffer\n");
+                            fprintf(ctx->log_fptr, "Error: failed to reallocate more memory to the buffer\n");
                             return;
                         }
                         str_buffer = new_buffer;
@@ -224,31 +290,32 @@ void next_token() {
                 }
                 str_buffer[j] = '\0';
                 if (c == '\n') {
-                    printf("Error: string literal exceeds line at line %d, char %d\n", line_count, char_count-token_length);
+                    fprintf(ctx->log_fptr, "Error: string literal exceeds line at line %d, char %d\n", ctx->line_count, ctx->char_count-token_length);
                     return;
                 }
                 if (c != '\'') {
-                    printf("Error: unclosed string literal at line %d, char %d\n", line_count, char_count-token_length);
+                    fprintf(ctx->log_fptr, "Error: unclosed string literal at line %d, char %d\n", ctx->line_count, ctx->char_count-token_length);
                     return;
                 }
-                stocked_token = malloc(sizeof(TokenData));
-                stocked_token->token = str_buffer;
-                stocked_token->type = j == 1 ? CVAL_TOKEN : SVAL_TOKEN;
-                stocked_token->start_ln = line_count;
-                stocked_token->start_col = char_count-token_length+i;
+                ctx->stocked_token = malloc(sizeof(TokenData));
+                ctx->stocked_token->token = str_buffer;
+                ctx->stocked_token->type = j == 1 ? CVAL_TOKEN : SVAL_TOKEN;
+                ctx->stocked_token->start_ln = ctx->line_count;
+                ctx->stocked_token->start_col = ctx->char_count-token_length+i;
                 if (i != 0) {
                     buffer[i] = '\0';
-                    current_token = malloc(sizeof(TokenData));
-                    current_token->token = buffer;
-                    current_token->type = find_token_type(buffer);
-                    current_token->start_ln = line_count;
-                    current_token->start_col = char_count-token_length;
+                    ctx->current_token = malloc(sizeof(TokenData));
+                    ctx->current_token->token = buffer;
+                    ctx->current_token->type = find_token_type(buffer);
+                    ctx->current_token->start_ln = ctx->line_count;
+                    ctx->current_token->start_col = ctx->char_count-token_length;
                 }
                 else {
-                    current_token = stocked_token;
-                    stocked_token = NULL;
+                    ctx->current_token = ctx->stocked_token;
+                    ctx->stocked_token = NULL;
                 }
-                printf("%s -> %s\n", current_token->token, token_type_map[current_token->type - 1]);
+                if (ctx->options.list_tokens)
+                    fprintf(ctx->log_fptr, "%s -> %s\n", ctx->current_token->token, token_type_map[ctx->current_token->type - 1]);
                 return;
             }
             else if (i < n * BUFFER_SIZE) {
@@ -258,8 +325,8 @@ void next_token() {
                 int j;
                 spec_str[0] = c;
                 for (j = 1; j < MAX_SPECIAL_SIZE; j++) {
-                    char cc = getc(target_fptr);
-                    char_count++;
+                    char cc = getc(ctx->target_fptr);
+                    ctx->char_count++;
                     token_length++;
                     if (cc == EOF)
                         break;
@@ -273,54 +340,54 @@ void next_token() {
                         if (i != 0) {
                             type = find_token_type(buffer);
                             if (type == ERROR_TOKEN) {
-                                printf("Error: identifer %s starts with a digit at line %d, char %d\n",
-                                    buffer, line_count, char_count-token_length);
+                                fprintf(ctx->log_fptr, "Error: identifer %s starts with a digit at line %d, char %d\n",
+                                    buffer, ctx->line_count, ctx->char_count-token_length);
                                 return;
                             }
                         }
-                        stocked_token = malloc(sizeof(TokenData));
-                        stocked_token->token = spec_str;
-                        stocked_token->type = special;
-                        stocked_token->start_ln = line_count;
-                        stocked_token->start_col = char_count-k;
+                        ctx->stocked_token = malloc(sizeof(TokenData));
+                        ctx->stocked_token->token = spec_str;
+                        ctx->stocked_token->type = special;
+                        ctx->stocked_token->start_ln = ctx->line_count;
+                        ctx->stocked_token->start_col = ctx->char_count-k;
                         if (i != 0)
-                            stocked_token->start_col--;
+                            ctx->stocked_token->start_col--;
                         break;
                     }
                     if (k != 0) {
-                        char_count--;
+                        ctx->char_count--;
                         token_length--;
-                        ungetc(spec_str[k], target_fptr); // Returns the file pointer to its previous state.
+                        ungetc(spec_str[k], ctx->target_fptr); // Returns the file pointer to its previous state.
                     }
                     spec_str[k] = '\0';
                 }
                 if (special && (special != PERIOD_TOKEN || !is_number(buffer))) {
                     if (i != 0) {
-                        current_token = malloc(sizeof(TokenData));
-                        current_token->token = buffer;
-                        current_token->type = type;
-                        current_token->start_ln = line_count;
-                        current_token->start_col = char_count-token_length;
+                        ctx->current_token = malloc(sizeof(TokenData));
+                        ctx->current_token->token = buffer;
+                        ctx->current_token->type = type;
+                        ctx->current_token->start_ln = ctx->line_count;
+                        ctx->current_token->start_col = ctx->char_count-token_length;
                     }
                     else {
-                        current_token = stocked_token;
-                        current_token->start_col--;
-                        stocked_token = NULL;
+                        ctx->current_token = ctx->stocked_token;
+                        ctx->current_token->start_col--;
+                        ctx->stocked_token = NULL;
                     }
-                    printf("%s -> %s\n", current_token->token, token_type_map[current_token->type - 1]);
+                    if (ctx->options.list_tokens)
+                        fprintf(ctx->log_fptr, "%s -> %s\n", ctx->current_token->token, token_type_map[ctx->current_token->type - 1]);
                     return;
                 }
                 if (i < n * BUFFER_SIZE - 1)
                     buffer[i++] = c;
                 else { // Identifier name length exceeds buffer size. (Should a limit be set ? For now I keep reallocating indefinitely)
-                    printf("Warning: identifier name length exceeds buffer size at line %d, char %d\n", line_count, char_count-token_length);
+                    fprintf(ctx->log_fptr, "Warning: identifier name length exceeds buffer size at line %d, char %d\n", ctx->line_count, ctx->char_count-token_length);
                     char *new_buffer = realloc(buffer, ++n * BUFFER_SIZE);
                     if (new_buffer == NULL) {
                         // NULL value returned, failure to reallocate more memory for some reason
-                        printf("Error: failed to reallocate more memory to the buffer\n");
+                        fprintf(ctx->log_fptr, "Error: failed to reallocate more memory to the buffer\n");
                         return;
                     }
-                    free(buffer);
                     buffer = new_buffer;
                     buffer[i++] = c;
                     buffer[i] = '\0';
@@ -333,22 +400,38 @@ void next_token() {
         memset(spec_str, 0, MAX_SPECIAL_SIZE+1);
         spec_str[0] = c;
         TokenType type = find_token_type(spec_str);
-        printf("%s -> %s\n", spec_str, token_type_map[type - 1]);
-        current_token = malloc(sizeof(TokenData));
-        current_token->token = spec_str;
-        current_token->type = type;
-        current_token->start_ln = line_count;
+        if (ctx->options.list_tokens)
+            fprintf(ctx->log_fptr, "%s -> %s\n", spec_str, token_type_map[type - 1]);
+        ctx->current_token = malloc(sizeof(TokenData));
+        ctx->current_token->token = spec_str;
+        ctx->current_token->type = type;
+        ctx->current_token->start_ln = ctx->line_count;
         if (i != 0)
-            char_count--;
-        current_token->start_col = char_count;
+            ctx->char_count--;
+        ctx->current_token->start_col = ctx->char_count;
+    }
+}
+
+void next_token(CompilerContext *ctx) {
+    if (ctx->current_token != NULL) { // Freeing the memory allocated to the previous token
+        free(ctx->current_token->token);
+        free(ctx->current_token);
+        ctx->current_token = NULL;
+    }
+    if (ctx->token_replay != NULL) { // Tokens come from a previous scan of the same source file
+        replay_token(ctx);
+        return;
     }
+    scan_token(ctx);
+    if (ctx->token_record != NULL && ctx->current_token != NULL)
+        record_token(ctx->token_record, ctx->current_token);
 }
 
-void scan_file(const char *path) {
-    if (open_target_file(path)) {
+void scan_file(CompilerContext *ctx, const char *path) {
+    if (open_target_file(ctx, path)) {
         do {
-            next_token();
-        } while (current_token != NULL && current_token->type != EOF_TOKEN);
-        close_target_file();
+            next_token(ctx);
+        } while (ctx->current_token != NULL && ctx->current_token->type != EOF_TOKEN);
+        close_target_file(ctx);
     }
 }
@@ -0,0 +1,343 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#ifndef _WIN32
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#include "scanner.h"
+#include "compiler_context.h"
+#include "server.h"
+
+#ifndef _WIN32
+
+// Protocol: the client sends one request line per source file path (or an option line, "-t" to list tokens, "-tac" to list
+// the intermediate code, "-regalloc" to list the register allocation, "-S" to write the assembly, "-c" to write the
+// object file, "-static" to write the static executable, "-C" to write the C translation, "-pbc" to write the bytecode,
+// "--run" to run the program, "--jit" to run it as machine code, "-O0" to "-O2" for the optimization level,
+// "-fsyntax-only" to skip code generation and "-q" to stop the server) then closes its writing side.
+// The server answers with the diagnostics of every file, an "Output: <path>" line for each file it wrote and a
+// "Result: ok|failed <path>" line.
+
+typedef struct _CacheEntry {
+    char *path;
+    struct timespec mtime;
+    off_t size;
+    TokenStream *stream;
+} CacheEntry;
+
+typedef struct _TokenCache { // Token streams of previously compiled source files, kept warm between requests
+    CacheEntry entries[TOKEN_CACHE_SIZE];
+    int entry_count;
+    int next_victim; // Entries are replaced in a round robin fashion once the cache is full
+} TokenCache;
+
+CacheEntry* cache_lookup(TokenCache *cache, const char *path) {
+    for (int i = 0; i < cache->entry_count; i++) {
+        if (strcmp(cache->entries[i].path, path) == 0)
+            return &cache->entries[i];
+    }
+    return NULL;
+}
+
+int is_fresh_entry(const CacheEntry *entry, const struct stat *file_stat) {
+    return entry->size == file_stat->st_size && entry->mtime.tv_sec == file_stat->st_mtim.tv_sec &&
+        entry->mtime.tv_nsec == file_stat->st_mtim.tv_nsec;
+}
+
+void cache_store(TokenCache *cache, const char *path, const struct stat *file_stat, TokenStream *stream) {
+    CacheEntry *entry = cache_lookup(cache, path);
+    if (entry == NULL) {
+        if (cache->entry_count < TOKEN_CACHE_SIZE)
+            entry = &cache->entries[cache->entry_count++];
+        else {
+            entry = &cache->entries[cache->next_victim];
+            cache->next_victim = (cache->next_victim + 1) % TOKEN_CACHE_SIZE;
+            free(entry->path);
+            free_token_stream(entry->stream);
+        }
+        entry->path = malloc(strlen(path) + 1);
+        if (entry->path == NULL) { // The slot is dropped, the file is scanned again next time
+            *entry = cache->entries[--cache->entry_count];
+            if (cache->next_victim >= cache->entry_count)
+                cache->next_victim = 0;
+            free_token_stream(stream);
+            return;
+        }
+        strcpy(entry->path, path);
+    }
+    else
+        free_token_stream(entry->stream);
+    entry->mtime = file_stat->st_mtim;
+    entry->size = file_stat->st_size;
+    entry->stream = stream;
+}
+
+void clean_cache(TokenCache *cache) {
+    for (int i = 0; i < cache->entry_count; i++) {
+        free(cache->entries[i].path);
+        free_token_stream(cache->entries[i].stream);
+    }
+    cache->entry_count = 0;
+    cache->next_victim = 0;
+}
+
+int compile_cached(CompilerContext *ctx, TokenCache *cache, const char *path) {
+    struct stat file_stat;
+    if (stat(path, &file_stat) != 0) {
+        fprintf(ctx->log_fptr, "Error: failed to find target source file at path \"%s\"\n", path);
+        return 0;
+    }
+    CacheEntry *entry = cache_lookup(cache, path);
+    if (entry != NULL && is_fresh_entry(entry, &file_stat)) {
+        ctx->token_replay = entry->stream;
+        ctx->token_replay->position = 0;
+    }
+    else
+        ctx->token_record = make_token_stream();
+
+    int result = compile_file(ctx, path);
+
+    if (ctx->token_record != NULL) { // Only streams scanned up to the end of the file can be replayed later on
+        if (is_complete_stream(ctx->token_record))
+            cache_store(cache, path, &file_stat, ctx->token_record);
+        else
+            free_token_stream(ctx->token_record);
+    }
+    ctx->token_record = NULL;
+    ctx->token_replay = NULL;
+    return result;
+}
+
+void report_outputs(CompilerContext *ctx, const char *path, FILE *response_fptr) { // Files written by a successful compilation
+    const char *extensions[] = { ".s", ".o", executable_extension(path), ".c", ".pbc" };
+    const int emitted[] = { ctx->options.emit_assembly, ctx->options.emit_object, ctx->options.emit_executable,
+                            ctx->options.emit_c, ctx->options.emit_bytecode };
+    for (int i = 0; i < 5; i++) {
+        char *output = emitted[i] ? output_path(ctx, path, extensions[i]) : NULL;
+        if (output != NULL)
+            fprintf(response_fptr, "Output: %s\n", output);
+        free(output);
+    }
+}
+
+int handle_request(CompilerContext *ctx, TokenCache *cache, int client_fd) { // Returns 0 once the client asked the server to stop
+    FILE *request_fptr = fdopen(client_fd, "r");
+    FILE *response_fptr = fdopen(dup(client_fd), "w");
+    if (request_fptr == NULL || response_fptr == NULL) {
+        if (request_fptr != NULL)
+            fclose(request_fptr);
+        else
+            close(client_fd);
+        if (response_fptr != NULL)
+            fclose(response_fptr);
+        return 1;
+    }
+    ctx->log_fptr = response_fptr;
+    default_options(&ctx->options);
+    char line[MAX_REQUEST_LINE];
+    int keep_running = 1;
+    while (fgets(line, sizeof(line), request_fptr) != NULL) {
+        int length = strlen(line);
+        while (length > 0 && (line[length-1] == '\n' || line[length-1] == '\r'))
+            line[--length] = '\0';
+        if (length == 0)
+            continue;
+        if (strcmp(line, "-t") == 0) {
+            ctx->options.list_tokens = 1;
+            continue;
+        }
+        if (strcmp(line, "-tac") == 0) {
+            ctx->options.list_tac = 1;
+            continue;
+        }
+        if (strcmp(line, "--run") == 0) {
+            ctx->options.run_program = 1;
+            continue;
+        }
+        if (strcmp(line, "--jit") == 0) {
+            ctx->options.jit_program = 1;
+            continue;
+        }
+        if (strcmp(line, "-S") == 0) {
+            ctx->options.emit_assembly = 1;
+            continue;
+        }
+        if (strcmp(line, "-c") == 0) {
+            ctx->options.emit_object = 1;
+            continue;
+        }
+        if (strcmp(line, "-static") == 0) {
+            ctx->options.emit_executable = 1;
+            continue;
+        }
+        if (strcmp(line, "-C") == 0) {
+            ctx->options.emit_c = 1;
+            continue;
+        }
+        if (strcmp(line, "-pbc") == 0) {
+            ctx->options.emit_bytecode = 1;
+            continue;
+        }
+        if (strcmp(line, "-regalloc") == 0) {
+            ctx->options.list_allocation = 1;
+            continue;
+        }
+        if (line[0] == '-' && line[1] == 'O' && line[2] >= '0' && line[2] <= '2' && line[3] == '\0') {
+            ctx->options.optimize = line[2] - '0';
+            continue;
+        }
+        if (strcmp(line, "-fsyntax-only") == 0) {
+            ctx->options.syntax_only = 1;
+            continue;
+        }
+        if (strcmp(line, "-q") == 0) {
+            keep_running = 0;
+            continue;
+        }
+        int result = compile_cached(ctx, cache, line);
+        if (result)
+            report_outputs(ctx, line, response_fptr);
+        fprintf(response_fptr, "Result: %s %s\n", result ? "ok" : "failed", line);
+        fflush(response_fptr);
+    }
+    ctx->log_fptr = stdout;
+    fclose(request_fptr);
+    fclose(response_fptr);
+    return keep_running;
+}
+
+int open_socket(const char *socket_path, struct sockaddr_un *address) {
+    if (strlen(socket_path) >= sizeof(address->sun_path)) {
+        printf("Error: socket path \"%s\" is too long\n", socket_path);
+        return -1;
+    }
+    int socket_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socket_fd < 0) {
+        printf("Error: failed to create a local socket\n");
+        return -1;
+    }
+    memset(address, 0, sizeof(struct sockaddr_un));
+    address->sun_family = AF_UNIX;
+    strcpy(address->sun_path, socket_path);
+    return socket_fd;
+}
+
+int run_server(const char *socket_path) {
+    struct sockaddr_un address;
+    int server_fd = open_socket(socket_path, &address);
+    if (server_fd < 0)
+        return 0;
+    unlink(socket_path); // Left over by a previous server
+    if (bind(server_fd, (struct sockaddr *) &address, sizeof(address)) != 0 || listen(server_fd, SOMAXCONN) != 0) {
+        printf("Error: failed to listen on socket \"%s\"\n", socket_path);
+        close(server_fd);
+        return 0;
+    }
+    signal(SIGPIPE, SIG_IGN); // A client leaving early must not take the server down
+
+    CompilerContext *ctx = make_context(); // The same context serves every request
+    TokenCache *cache = malloc(sizeof(TokenCache));
+    if (ctx == NULL || cache == NULL) {
+        printf("Error: failed to allocate memory for the compile server\n");
+        close(server_fd);
+        return 0;
+    }
+    cache->entry_count = 0;
+    cache->next_victim = 0;
+    printf("Compile server listening on \"%s\"\n", socket_path);
+    fflush(stdout);
+    int keep_running = 1;
+    while (keep_running) {
+        int client_fd = accept(server_fd, NULL, NULL);
+        if (client_fd < 0)
+            continue;
+        keep_running = handle_request(ctx, cache, client_fd);
+    }
+
+    clean_cache(cache);
+    free(cache);
+    free_context(ctx);
+    close(server_fd);
+    unlink(socket_path);
+    return 1;
+}
+
+int run_client(const char *socket_path, char **paths, int path_count, const CompileOptions *options, int stop_server) {
+    // Returns the number of source files that failed
+    struct sockaddr_un address;
+    int client_fd = open_socket(socket_path, &address);
+    if (client_fd < 0)
+        return path_count + 1;
+    if (connect(client_fd, (struct sockaddr *) &address, sizeof(address)) != 0) {
+        printf("Error: failed to connect to a compile server on \"%s\"\n", socket_path);
+        close(client_fd);
+        return path_count + 1;
+    }
+    FILE *request_fptr = fdopen(dup(client_fd), "w");
+    if (options->list_tokens)
+        fprintf(request_fptr, "-t\n");
+    if (options->list_tac)
+        fprintf(request_fptr, "-tac\n");
+    if (options->emit_assembly)
+        fprintf(request_fptr, "-S\n");
+    if (options->emit_object)
+        fprintf(request_fptr, "-c\n");
+    if (options->emit_executable)
+        fprintf(request_fptr, "-static\n");
+    if (options->emit_c)
+        fprintf(request_fptr, "-C\n");
+    if (options->emit_bytecode)
+        fprintf(request_fptr, "-pbc\n");
+    if (options->run_program)
+        fprintf(request_fptr, "--run\n");
+    if (options->jit_program)
+        fprintf(request_fptr, "--jit\n");
+    if (options->list_allocation)
+        fprintf(request_fptr, "-regalloc\n");
+    fprintf(request_fptr, "-O%d\n", options->optimize);
+    if (options->syntax_only)
+        fprintf(request_fptr, "-fsyntax-only\n");
+    if (stop_server)
+        fprintf(request_fptr, "-q\n");
+    for (int i = 0; i < path_count; i++) {
+        char resolved_path[PATH_MAX]; // The server does not share the client's working directory
+        fprintf(request_fptr, "%s\n", realpath(paths[i], resolved_path) != NULL ? resolved_path : paths[i]);
+    }
+    fclose(request_fptr);
+    shutdown(client_fd, SHUT_WR);
+
+    FILE *response_fptr = fdopen(client_fd, "r");
+    char line[MAX_REQUEST_LINE];
+    int result_count = 0, failure_count = 0;
+    while (fgets(line, sizeof(line), response_fptr) != NULL) {
+        if (strncmp(line, "Result: ", 8) == 0) {
+            result_count++;
+            if (strncmp(line + 8, "failed", 6) == 0)
+                failure_count++;
+        }
+        fputs(line, stdout);
+    }
+    fclose(response_fptr);
+    return failure_count + (path_count - result_count);
+}
+
+#else
+
+int run_server(const char *socket_path) {
+    printf("Error: compile server mode is not supported on this platform\n");
+    return 0;
+}
+
+int run_client(const char *socket_path, char **paths, int path_count, const CompileOptions *options, int stop_server) {
+    printf("Error: compile server mode is not supported on this platform\n");
+    return path_count + 1;
+}
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "compiler_context.h"
+
+#define DEFAULT_SOCKET_PATH "/tmp/pcomp.sock"
+#define TOKEN_CACHE_SIZE 1024 // Max number of source files whose token streams are kept between requests
+#define MAX_REQUEST_LINE 4096
+
+int run_server(const char *);
+int run_client(const char *, char **, int, const CompileOptions *, int);
+
+#endif
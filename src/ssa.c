@@ -0,0 +1,1070 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "scanner.h"
+#include "symbol_table.h"
+#include "tac.h"
+#include "tac_array.h"
+#include "control_flow.h"
+#include "compiler_context.h"
+#include "ssa.h"
+
+#define GLOBAL_VAR -2 // Global variable the routine hasn't used yet
+#define UNTRACKED_VAR -3
+
+uint32_t operand_hash(Operand operand) { // Keeps the temporaries and literals of a routine, numbered in order, in neighbouring slots
+    return ((uint32_t) operand_index(operand) << 2) | operand_kind(operand);
+}
+
+uint32_t find_var_slot(const SsaForm *ssa, Operand operand) { // Slot of the operand or the empty slot where it goes
+    uint32_t slot = operand_hash(operand) & ssa->var_mask;
+    while (ssa->var_keys[slot] != NO_OPERAND && ssa->var_keys[slot] != operand)
+        slot = (slot + 1) & ssa->var_mask;
+    return slot;
+}
+
+int ssa_var(const SsaForm *ssa, Operand operand) { // Tracked variable of the operand, -1 when it isn't tracked
+    if (operand_kind(operand) != SYMBOL_OPERAND && operand_kind(operand) != TEMP_OPERAND)
+        return -1;
+    uint32_t slot = find_var_slot(ssa, operand);
+    return ssa->var_keys[slot] == operand && ssa->var_slots[slot] >= 0 ? ssa->var_slots[slot] : -1;
+}
+
+int is_ref_param(const ParamType *params, const Symbol *symb) {
+    for (; params != NULL; params = params->next) {
+        if (params->param_symbol == symb)
+            return params->ref_pass;
+    }
+    return 0;
+}
+
+int track_operand(SsaForm *ssa, Operand operand, const ParamType *params, int has_ref_params) {
+    // Gives a variable to the operand the first time it is met, parameters passed by reference alias other variables
+    OperandKind kind = operand_kind(operand);
+    if (kind != SYMBOL_OPERAND && kind != TEMP_OPERAND)
+        return -1;
+    uint32_t slot = find_var_slot(ssa, operand);
+    int global = 0;
+    if (ssa->var_keys[slot] == operand) {
+        if (ssa->var_slots[slot] != GLOBAL_VAR)
+            return ssa->var_slots[slot] >= 0 ? ssa->var_slots[slot] : -1;
+        global = 1;
+        if (has_ref_params) {
+            ssa->var_slots[slot] = UNTRACKED_VAR;
+            return -1;
+        }
+    }
+    else if (kind == SYMBOL_OPERAND) {
+        const Symbol *symb = operand_symbol(ssa->cfg->code, operand);
+        ssa->var_keys[slot] = operand;
+        if ((symb->declaration_type != VAR_TOKEN && symb->declaration_type != FUNCTION_TOKEN) || is_ref_param(params, symb)) {
+            ssa->var_slots[slot] = UNTRACKED_VAR;
+            return -1;
+        }
+    }
+    ssa->var_keys[slot] = operand;
+    ssa->var_slots[slot] = ssa->var_count;
+    ssa->vars[ssa->var_count] = operand;
+    ssa->global_vars[ssa->var_count] = global;
+    return ssa->var_count++;
+}
+
+int* frontiers(const ControlFlowGraph *cfg, int **frontier_start) {
+    // Dominance frontiers of the blocks, the entry block is a join point when it has predecessors (the routine entry is one more)
+    int *starts = calloc(cfg->block_count + 1, sizeof(int));
+    int *list = NULL;
+    for (int pass = 0; pass < 2; pass++) {
+        int *counts = pass == 0 ? starts : calloc(cfg->block_count, sizeof(int));
+        for (int b = 0; b < cfg->block_count; b++) {
+            const BasicBlock *block = &cfg->blocks[b];
+            if (block->rpo_index == -1 || block->pred_count + (b == 0) < 2)
+                continue;
+            for (int p = 0; p < block->pred_count; p++) {
+                int runner = cfg->preds[block->pred_start + p];
+                if (cfg->blocks[runner].rpo_index == -1)
+                    continue;
+                while (runner != block->idom && runner != -1) {
+                    if (pass == 0)
+                        counts[runner + 1]++;
+                    else
+                        list[starts[runner] + counts[runner]++] = b;
+                    runner = cfg->blocks[runner].idom;
+                }
+            }
+        }
+        if (pass == 0) {
+            for (int b = 0; b < cfg->block_count; b++)
+                starts[b + 1] += starts[b];
+            list = malloc((starts[cfg->block_count] > 0 ? starts[cfg->block_count] : 1) * sizeof(int));
+        }
+        else
+            free(counts);
+    }
+    *frontier_start = starts;
+    return list;
+}
+
+void place_phis(SsaForm *ssa, const int *def_start, const int *def_blocks, const uint8_t *nonlocal) {
+    // Minimal phi placement on the iterated dominance frontiers, for the variables used across blocks only
+    const ControlFlowGraph *cfg = ssa->cfg;
+    int *frontier_start;
+    int *frontier = frontiers(cfg, &frontier_start);
+    int *worklist = malloc(cfg->block_count * sizeof(int));
+    int *in_worklist = malloc(cfg->block_count * sizeof(int)); // Last variable for which the block was queued
+    int *has_phi = malloc(cfg->block_count * sizeof(int)); // Last variable for which the block got a phi
+    int *phi_blocks = NULL, *phi_vars = NULL;
+    int phi_capacity = 0;
+    for (int b = 0; b < cfg->block_count; b++)
+        in_worklist[b] = has_phi[b] = -1;
+
+    ssa->phi_count = 0;
+    for (int var = 0; var < ssa->var_count; var++) {
+        if (!nonlocal[var])
+            continue;
+        int worklist_count = 0;
+        for (int d = def_start[var]; d < def_start[var + 1]; d++) {
+            int b = def_blocks[d];
+            if (in_worklist[b] != var && cfg->blocks[b].rpo_index != -1) {
+                in_worklist[b] = var;
+                worklist[worklist_count++] = b;
+            }
+        }
+        while (worklist_count > 0) {
+            int b = worklist[--worklist_count];
+            for (int f = frontier_start[b]; f < frontier_start[b + 1]; f++) {
+                int join = frontier[f];
+                if (has_phi[join] == var)
+                    continue;
+                has_phi[join] = var;
+                if (ssa->phi_count >= phi_capacity) {
+                    phi_capacity = phi_capacity == 0 ? BUFFER_SIZE : phi_capacity * 2;
+                    phi_blocks = realloc(phi_blocks, phi_capacity * sizeof(int));
+                    phi_vars = realloc(phi_vars, phi_capacity * sizeof(int));
+                }
+                phi_blocks[ssa->phi_count] = join;
+                phi_vars[ssa->phi_count++] = var;
+                if (in_worklist[join] != var) {
+                    in_worklist[join] = var;
+                    worklist[worklist_count++] = join;
+                }
+            }
+        }
+    }
+    free(frontier);
+    free(frontier_start);
+    free(worklist);
+    free(in_worklist);
+    free(has_phi);
+
+    // Groups the phis by block, their values follow the entry values
+    ssa->block_phis = calloc(cfg->block_count + 1, sizeof(int));
+    ssa->phis = malloc((ssa->phi_count > 0 ? ssa->phi_count : 1) * sizeof(Phi));
+    for (int p = 0; p < ssa->phi_count; p++)
+        ssa->block_phis[phi_blocks[p] + 1]++;
+    for (int b = 0; b < cfg->block_count; b++)
+        ssa->block_phis[b + 1] += ssa->block_phis[b];
+    int *fill = malloc((cfg->block_count > 0 ? cfg->block_count : 1) * sizeof(int));
+    memcpy(fill, ssa->block_phis, cfg->block_count * sizeof(int));
+    int arg_total = 0;
+    for (int p = 0; p < ssa->phi_count; p++) {
+        int index = fill[phi_blocks[p]]++;
+        ssa->phis[index].block = phi_blocks[p];
+        ssa->phis[index].value = phi_vars[p]; // Variable of the phi until the values are allocated
+        ssa->phis[index].arg_count = cfg->blocks[phi_blocks[p]].pred_count + (phi_blocks[p] == 0);
+        arg_total += ssa->phis[index].arg_count;
+    }
+    ssa->phi_args = malloc((arg_total > 0 ? arg_total : 1) * sizeof(int));
+    arg_total = 0;
+    for (int p = 0; p < ssa->phi_count; p++) {
+        Phi *phi = &ssa->phis[p];
+        phi->arg_start = arg_total;
+        arg_total += phi->arg_count;
+        for (int a = 0; a < phi->arg_count; a++)
+            ssa->phi_args[phi->arg_start + a] = -1; // Edges from unreachable blocks keep no value
+        if (phi->block == 0)
+            ssa->phi_args[phi->arg_start + phi->arg_count - 1] = phi->value;
+    }
+    free(fill);
+    free(phi_blocks);
+    free(phi_vars);
+}
+
+int new_value(SsaForm *ssa, int var, int instruction, int *current, int *undo_vars, int *undo_values, int *undo_count) {
+    int value = ssa->value_count++;
+    ssa->values[value].var = var;
+    ssa->values[value].instruction = instruction;
+    ssa->values[value].phi = -1;
+    undo_vars[*undo_count] = var;
+    undo_values[(*undo_count)++] = current[var];
+    current[var] = value;
+    return value;
+}
+
+void rename_values(SsaForm *ssa, const int *operand_vars, const int *clobber_vars) {
+    // Walks the dominator tree, the current value of each variable is restored when leaving the blocks that redefined it
+    ControlFlowGraph *cfg = ssa->cfg;
+    TacArray *code = cfg->code;
+    int base = cfg->routine_start + 1;
+    int max_defs = ssa->phi_count + (cfg->routine_end - base) + ssa->clobber_start[cfg->routine_end - base];
+    int *current = malloc((ssa->var_count > 0 ? ssa->var_count : 1) * sizeof(int));
+    int *undo_vars = malloc((max_defs > 0 ? max_defs : 1) * sizeof(int));
+    int *undo_values = malloc((max_defs > 0 ? max_defs : 1) * sizeof(int));
+    int *stack = malloc(cfg->block_count * sizeof(int));
+    int *next_child = malloc(cfg->block_count * sizeof(int));
+    int *undo_marks = malloc(cfg->block_count * sizeof(int));
+    int stack_count = 0, undo_count = 0;
+    for (int var = 0; var < ssa->var_count; var++)
+        current[var] = var;
+
+    stack[stack_count++] = 0;
+    next_child[0] = -1;
+    while (stack_count > 0) {
+        int b = stack[stack_count - 1];
+        const BasicBlock *block = &cfg->blocks[b];
+        if (next_child[b] == -1) { // First visit of the block
+            undo_marks[b] = undo_count;
+            for (int p = ssa->block_phis[b]; p < ssa->block_phis[b + 1]; p++) {
+                int var = ssa->values[ssa->phis[p].value].var;
+                undo_vars[undo_count] = var;
+                undo_values[undo_count++] = current[var];
+                current[var] = ssa->phis[p].value;
+            }
+            for (int i = block->start; i < block->end; i++) {
+                if (code->ops[i] == TAC_UNDEF)
+                    continue;
+                const int *vars = &operand_vars[OPERAND_SLOTS * (i - base)];
+                for (int k = 0; k < MAX_USED_OPERANDS; k++)
+                    ssa->uses[MAX_USED_OPERANDS * (i - base) + k] = vars[k] >= 0 ? current[vars[k]] : -1;
+                int var = vars[MAX_USED_OPERANDS];
+                if (var >= 0)
+                    ssa->defs[i - base] = new_value(ssa, var, i, current, undo_vars, undo_values, &undo_count);
+                for (int c = ssa->clobber_start[i - base]; c < ssa->clobber_start[i - base + 1]; c++)
+                    ssa->clobbers[c] = new_value(ssa, clobber_vars[c], i, current, undo_vars, undo_values, &undo_count);
+            }
+            if (b == cfg->block_count - 1 && code->ops[cfg->routine_end] == TAC_ENDFUNC) { // The end of the routine follows the last block
+                int var = ssa_var(ssa, code->a[cfg->routine_end]);
+                ssa->result_value = var >= 0 ? current[var] : -1;
+            }
+            for (int s = 0; s < block->succ_count; s++) {
+                const BasicBlock *succ = &cfg->blocks[block->succs[s]];
+                int pred_index = 0;
+                while (cfg->preds[succ->pred_start + pred_index] != b)
+                    pred_index++;
+                for (int p = ssa->block_phis[block->succs[s]]; p < ssa->block_phis[block->succs[s] + 1]; p++) {
+                    const Phi *phi = &ssa->phis[p];
+                    ssa->phi_args[phi->arg_start + pred_index] = current[ssa->values[phi->value].var];
+                }
+            }
+            next_child[b] = 0;
+        }
+        if (next_child[b] < block->dom_child_count) {
+            int child = cfg->dom_children[block->dom_child_start + next_child[b]++];
+            next_child[child] = -1;
+            stack[stack_count++] = child;
+        }
+        else {
+            while (undo_count > undo_marks[b]) {
+                undo_count--;
+                current[undo_vars[undo_count]] = undo_values[undo_count];
+            }
+            stack_count--;
+        }
+    }
+    free(current);
+    free(undo_vars);
+    free(undo_values);
+    free(stack);
+    free(next_child);
+    free(undo_marks);
+}
+
+void link_users(SsaForm *ssa) { // Def-use chains of the values
+    const ControlFlowGraph *cfg = ssa->cfg;
+    int base = cfg->routine_start + 1;
+    int use_total = MAX_USED_OPERANDS * (cfg->routine_end - base);
+    ssa->user_start = calloc(ssa->value_count + 1, sizeof(int));
+    for (int pass = 0; pass < 2; pass++) {
+        int *counts = pass == 0 ? ssa->user_start : calloc(ssa->value_count, sizeof(int));
+        for (int u = 0; u < use_total; u++) {
+            int value = ssa->uses[u];
+            if (value < 0)
+                continue;
+            if (pass == 0)
+                counts[value + 1]++;
+            else
+                ssa->users[ssa->user_start[value] + counts[value]++] = base + u / MAX_USED_OPERANDS;
+        }
+        for (int p = 0; p < ssa->phi_count; p++) {
+            const Phi *phi = &ssa->phis[p];
+            for (int a = 0; a < phi->arg_count; a++) {
+                int value = ssa->phi_args[phi->arg_start + a];
+                if (value < 0)
+                    continue;
+                if (pass == 0)
+                    counts[value + 1]++;
+                else
+                    ssa->users[ssa->user_start[value] + counts[value]++] = -(p + 1);
+            }
+        }
+        if (pass == 0) {
+            for (int v = 0; v < ssa->value_count; v++)
+                ssa->user_start[v + 1] += ssa->user_start[v];
+            ssa->users = malloc((ssa->user_start[ssa->value_count] > 0 ? ssa->user_start[ssa->value_count] : 1) * sizeof(int));
+        }
+        else
+            free(counts);
+    }
+}
+
+SsaForm* build_ssa(ControlFlowGraph *cfg) { // The code of the routine can't be changed while its SSA form is used
+    TacArray *code = cfg->code;
+    int base = cfg->routine_start + 1;
+    int body_count = cfg->routine_end - base;
+    SsaForm *ssa = calloc(1, sizeof(SsaForm));
+    if (ssa == NULL) {
+        fprintf(cfg->code->log_fptr, "Error: failed to allocate memory for the SSA form\n");
+        return NULL;
+    }
+    ssa->cfg = cfg;
+
+    // Global variables are declared before the first routine
+    int global_count = 0;
+    for (int i = 0; i < code->tac_count && code->ops[i] != TAC_BEGINFUNC && code->ops[i] != TAC_BEGINPROC && code->ops[i] != TAC_BEGINPROG; i++)
+        global_count += code->ops[i] == TAC_VAR;
+    uint32_t map_size = 16;
+    while (map_size < 2 * (uint32_t) (OPERAND_SLOTS * body_count + global_count + 1))
+        map_size *= 2;
+    ssa->var_keys = calloc(map_size, sizeof(Operand));
+    ssa->var_slots = malloc(map_size * sizeof(int));
+    ssa->var_mask = map_size - 1;
+    ssa->vars = malloc((OPERAND_SLOTS * body_count + global_count + 1) * sizeof(Operand));
+    ssa->global_vars = malloc(OPERAND_SLOTS * body_count + global_count + 1);
+    for (int i = 0; i < code->tac_count && code->ops[i] != TAC_BEGINFUNC && code->ops[i] != TAC_BEGINPROC && code->ops[i] != TAC_BEGINPROG; i++) {
+        if (code->ops[i] == TAC_VAR) {
+            uint32_t slot = find_var_slot(ssa, code->a[i]);
+            ssa->var_keys[slot] = code->a[i];
+            ssa->var_slots[slot] = GLOBAL_VAR;
+        }
+    }
+
+    const Symbol *routine = operand_symbol(code, code->a[cfg->routine_start]);
+    const ParamType *params = routine != NULL ? routine->param_list : NULL;
+    int has_ref_params = 0;
+    for (const ParamType *param = params; param != NULL; param = param->next)
+        has_ref_params |= param->ref_pass;
+    int *operand_vars = malloc((body_count > 0 ? OPERAND_SLOTS * body_count : 1) * sizeof(int)); // Variables of the used and the defined operands
+    for (int i = base; i < cfg->routine_end; i++) {
+        int *vars = &operand_vars[OPERAND_SLOTS * (i - base)];
+        for (int k = 0; k < OPERAND_SLOTS; k++)
+            vars[k] = -1;
+        if (code->ops[i] == TAC_UNDEF)
+            continue;
+        Operand *slots[MAX_USED_OPERANDS];
+        int use_count = used_operands(code, i, slots);
+        for (int k = 0; k < use_count; k++)
+            vars[k] = track_operand(ssa, *slots[k], params, has_ref_params);
+        vars[MAX_USED_OPERANDS] = track_operand(ssa, defined_operand(code, i), params, has_ref_params);
+    }
+
+    // Variables clobbered by each call: the global ones and the ones passed by reference
+    int *global_list = malloc((ssa->var_count > 0 ? ssa->var_count : 1) * sizeof(int));
+    int tracked_globals = 0;
+    for (int var = 0; var < ssa->var_count; var++) {
+        if (ssa->global_vars[var])
+            global_list[tracked_globals++] = var;
+    }
+    int *clobber_stamps = malloc((ssa->var_count > 0 ? ssa->var_count : 1) * sizeof(int));
+    ssa->clobber_start = calloc(body_count + 1, sizeof(int));
+    int *clobber_vars = NULL;
+    for (int pass = 0; pass < 2; pass++) {
+        int clobber_count = 0;
+        for (int var = 0; var < ssa->var_count; var++) // Both passes must skip the same repeated variables
+            clobber_stamps[var] = -1;
+        for (int i = base; i < cfg->routine_end; i++) {
+            if (pass == 0)
+                ssa->clobber_start[i - base] = clobber_count;
+            if (code->ops[i] != TAC_CALL)
+                continue;
+            for (int g = 0; g < tracked_globals; g++) {
+                if (pass == 1)
+                    clobber_vars[clobber_count] = global_list[g];
+                clobber_stamps[global_list[g]] = i;
+                clobber_count++;
+            }
+            int arg_start = i;
+            while (arg_start > base && code->ops[arg_start - 1] == TAC_ARG)
+                arg_start--;
+            const ParamType *param = operand_symbol(code, code->b[i])->param_list;
+            for (int j = arg_start; j < i && param != NULL; j++, param = param->next) {
+                int var = operand_vars[OPERAND_SLOTS * (j - base)];
+                if (!param->ref_pass || var < 0 || clobber_stamps[var] == i)
+                    continue;
+                if (pass == 1)
+                    clobber_vars[clobber_count] = var;
+                clobber_stamps[var] = i;
+                clobber_count++;
+            }
+        }
+        if (pass == 0) {
+            ssa->clobber_start[body_count] = clobber_count;
+            clobber_vars = malloc((clobber_count > 0 ? clobber_count : 1) * sizeof(int));
+            ssa->clobbers = malloc((clobber_count > 0 ? clobber_count : 1) * sizeof(int));
+            for (int c = 0; c < clobber_count; c++)
+                ssa->clobbers[c] = -1;
+        }
+    }
+    free(global_list);
+    free(clobber_stamps);
+
+    // Blocks defining each variable and variables used before being defined in a block
+    int *def_start = calloc(ssa->var_count + 1, sizeof(int));
+    int *def_blocks = NULL;
+    int *defined_in = malloc((ssa->var_count > 0 ? ssa->var_count : 1) * sizeof(int));
+    uint8_t *nonlocal = calloc(ssa->var_count > 0 ? ssa->var_count : 1, 1);
+    int def_count = 0;
+    for (int var = 0; var < ssa->var_count; var++)
+        defined_in[var] = -1;
+    for (int pass = 0; pass < 2; pass++) {
+        int *counts = pass == 0 ? def_start : calloc(ssa->var_count > 0 ? ssa->var_count : 1, sizeof(int));
+        for (int b = 0; b < cfg->block_count; b++) {
+            for (int i = cfg->blocks[b].start; i < cfg->blocks[b].end; i++) {
+                if (code->ops[i] == TAC_UNDEF)
+                    continue;
+                const int *vars = &operand_vars[OPERAND_SLOTS * (i - base)];
+                if (pass == 0) {
+                    for (int k = 0; k < MAX_USED_OPERANDS; k++) {
+                        if (vars[k] >= 0 && defined_in[vars[k]] != b)
+                            nonlocal[vars[k]] = 1;
+                    }
+                }
+                int var = vars[MAX_USED_OPERANDS];
+                if (var >= 0) {
+                    if (pass == 0) {
+                        counts[var + 1]++;
+                        defined_in[var] = b;
+                        def_count++;
+                    }
+                    else
+                        def_blocks[def_start[var] + counts[var]++] = b;
+                }
+                for (int c = ssa->clobber_start[i - base]; c < ssa->clobber_start[i - base + 1]; c++) {
+                    if (pass == 0) {
+                        counts[clobber_vars[c] + 1]++;
+                        defined_in[clobber_vars[c]] = b;
+                    }
+                    else
+                        def_blocks[def_start[clobber_vars[c]] + counts[clobber_vars[c]]++] = b;
+                }
+            }
+        }
+        if (pass == 0) {
+            for (int var = 0; var < ssa->var_count; var++)
+                def_start[var + 1] += def_start[var];
+            def_blocks = malloc((def_start[ssa->var_count] > 0 ? def_start[ssa->var_count] : 1) * sizeof(int));
+        }
+        else
+            free(counts);
+    }
+    free(defined_in);
+    if (code->ops[cfg->routine_end] == TAC_ENDFUNC) { // The function result is read at the end of the routine
+        int var = ssa_var(ssa, code->a[cfg->routine_end]);
+        if (var >= 0)
+            nonlocal[var] = 1;
+    }
+
+    place_phis(ssa, def_start, def_blocks, nonlocal);
+    free(def_start);
+    free(def_blocks);
+    free(nonlocal);
+
+    // Values: the entry values, then the phi values, then the values defined by the instructions and the calls
+    int max_values = ssa->var_count + ssa->phi_count + def_count + ssa->clobber_start[body_count];
+    ssa->values = malloc((max_values > 0 ? max_values : 1) * sizeof(SsaValue));
+    for (int var = 0; var < ssa->var_count; var++) {
+        ssa->values[var].var = var;
+        ssa->values[var].instruction = -1;
+        ssa->values[var].phi = -1;
+    }
+    for (int p = 0; p < ssa->phi_count; p++) {
+        int var = ssa->phis[p].value;
+        ssa->phis[p].value = ssa->var_count + p;
+        ssa->values[ssa->var_count + p].var = var;
+        ssa->values[ssa->var_count + p].instruction = -1;
+        ssa->values[ssa->var_count + p].phi = p;
+    }
+    ssa->value_count = ssa->var_count + ssa->phi_count;
+    ssa->defs = malloc((body_count > 0 ? body_count : 1) * sizeof(int));
+    ssa->uses = malloc((body_count > 0 ? MAX_USED_OPERANDS * body_count : 1) * sizeof(int));
+    for (int i = 0; i < body_count; i++)
+        ssa->defs[i] = -1;
+    for (int u = 0; u < MAX_USED_OPERANDS * body_count; u++)
+        ssa->uses[u] = -1;
+    ssa->result_value = -1;
+    rename_values(ssa, operand_vars, clobber_vars);
+    free(operand_vars);
+    free(clobber_vars);
+    link_users(ssa);
+    return ssa;
+}
+
+void free_ssa(SsaForm *ssa) {
+    if (ssa != NULL) {
+        free(ssa->vars);
+        free(ssa->global_vars);
+        free(ssa->var_keys);
+        free(ssa->var_slots);
+        free(ssa->values);
+        free(ssa->phis);
+        free(ssa->phi_args);
+        free(ssa->block_phis);
+        free(ssa->defs);
+        free(ssa->uses);
+        free(ssa->clobber_start);
+        free(ssa->clobbers);
+        free(ssa->user_start);
+        free(ssa->users);
+        free(ssa);
+    }
+}
+
+typedef enum {
+    LATTICE_TOP = 0, LATTICE_CONSTANT, LATTICE_BOTTOM
+} LatticeState;
+
+typedef struct _Propagation { // State of the sparse conditional constant propagation of a routine
+    CompilerContext *ctx;
+    SsaForm *ssa;
+    uint8_t *states; // Lattice state of each value
+    Symbol **constants; // Literal of each constant value
+    uint8_t *executable_blocks;
+    uint8_t *executable_edges; // Two per block, in the order of the block successors
+    int *edge_worklist;
+    int edge_count;
+    int *value_worklist; // A value is lowered at most twice
+    int value_count;
+} Propagation;
+
+int same_constant(const Symbol *symb_1, const Symbol *symb_2) {
+    if (symb_1 == symb_2)
+        return 1;
+    if (symb_1->token_type != symb_2->token_type)
+        return 0;
+    switch (symb_1->token_type) {
+        case INT_TOKEN:
+            return symb_1->values->i == symb_2->values->i;
+        case REAL_TOKEN:
+            return memcmp(&symb_1->values->f, &symb_2->values->f, sizeof(float)) == 0;
+        case CHAR_TOKEN:
+            return symb_1->values->c == symb_2->values->c;
+        case STRING_TOKEN:
+            return strcmp(symb_1->values->str, symb_2->values->str) == 0;
+        default:
+            return 0;
+    }
+}
+
+void lower_value(Propagation *prop, int value, LatticeState state, Symbol *constant) {
+    LatticeState old_state = prop->states[value];
+    if (state == LATTICE_TOP || old_state == LATTICE_BOTTOM)
+        return;
+    if (old_state == LATTICE_CONSTANT) {
+        if (state == LATTICE_CONSTANT && same_constant(prop->constants[value], constant))
+            return;
+        state = LATTICE_BOTTOM;
+    }
+    prop->states[value] = state;
+    prop->constants[value] = state == LATTICE_CONSTANT ? constant : NULL;
+    prop->value_worklist[prop->value_count++] = value;
+}
+
+void mark_edge(Propagation *prop, int b, int target) {
+    const BasicBlock *block = &prop->ssa->cfg->blocks[b];
+    for (int s = 0; s < block->succ_count; s++) {
+        if (block->succs[s] == target && !prop->executable_edges[2 * b + s]) {
+            prop->executable_edges[2 * b + s] = 1;
+            prop->edge_worklist[prop->edge_count++] = 2 * b + s;
+        }
+    }
+}
+
+LatticeState operand_state(const Propagation *prop, int index, int k, Operand operand, Symbol **constant) {
+    int value = prop->ssa->uses[MAX_USED_OPERANDS * (index - prop->ssa->cfg->routine_start - 1) + k];
+    if (value >= 0) {
+        *constant = prop->constants[value];
+        return prop->states[value];
+    }
+    Symbol *symb = operand_symbol(prop->ssa->cfg->code, operand);
+    if (is_constant_symbol(symb)) {
+        *constant = symb;
+        return LATTICE_CONSTANT;
+    }
+    return LATTICE_BOTTOM;
+}
+
+int is_branch_taken(TacOp op, const Symbol *condition) { // -1 when the condition isn't a known number
+    if (condition->token_type == INT_TOKEN)
+        return (condition->values->i == 0) == (op == TAC_IFZ);
+    if (condition->token_type == REAL_TOKEN)
+        return (condition->values->f == 0) == (op == TAC_IFZ);
+    return -1;
+}
+
+void evaluate_phi(Propagation *prop, int p) {
+    const SsaForm *ssa = prop->ssa;
+    const ControlFlowGraph *cfg = ssa->cfg;
+    const Phi *phi = &ssa->phis[p];
+    if (!prop->executable_blocks[phi->block])
+        return;
+    const BasicBlock *block = &cfg->blocks[phi->block];
+    LatticeState state = LATTICE_TOP;
+    Symbol *constant = NULL;
+    for (int a = 0; a < phi->arg_count && state != LATTICE_BOTTOM; a++) {
+        if (a < block->pred_count) { // Only the executable edges count
+            int pred = cfg->preds[block->pred_start + a];
+            int s = cfg->blocks[pred].succs[0] == phi->block ? 0 : 1;
+            if (!prop->executable_edges[2 * pred + s])
+                continue;
+        }
+        int value = ssa->phi_args[phi->arg_start + a];
+        if (value < 0 || prop->states[value] == LATTICE_TOP)
+            continue;
+        if (prop->states[value] == LATTICE_BOTTOM || (state == LATTICE_CONSTANT && !same_constant(constant, prop->constants[value])))
+            state = LATTICE_BOTTOM;
+        else {
+            state = LATTICE_CONSTANT;
+            constant = prop->constants[value];
+        }
+    }
+    lower_value(prop, phi->value, state, constant);
+}
+
+void evaluate_instruction(Propagation *prop, int index) {
+    const ControlFlowGraph *cfg = prop->ssa->cfg;
+    TacArray *code = cfg->code;
+    int b = instruction_block(cfg, index);
+    if (!prop->executable_blocks[b])
+        return;
+    TacOp op = code->ops[index];
+    Operand *slots[MAX_USED_OPERANDS];
+    int use_count = used_operands(code, index, slots);
+    Symbol *constants[MAX_USED_OPERANDS] = { NULL };
+    LatticeState states[MAX_USED_OPERANDS];
+    for (int k = 0; k < MAX_USED_OPERANDS; k++)
+        states[k] = k < use_count ? operand_state(prop, index, k, *slots[k], &constants[k]) : LATTICE_BOTTOM;
+
+    if (op == TAC_IFZ || op == TAC_IFNZ) { // A jump always ends its block
+        int taken = states[0] == LATTICE_CONSTANT ? is_branch_taken(op, constants[0]) : -1;
+        if (states[0] == LATTICE_TOP)
+            return;
+        if (taken != 0)
+            mark_edge(prop, b, label_block(cfg, code->a[index]));
+        if (taken != 1 && b + 1 < cfg->block_count)
+            mark_edge(prop, b, b + 1);
+        return;
+    }
+    int value = prop->ssa->defs[index - cfg->routine_start - 1];
+    if (value < 0)
+        return;
+    LatticeState state = LATTICE_BOTTOM;
+    Symbol *constant = NULL;
+    switch (op) {
+        case TAC_CPY:
+            state = states[0];
+            constant = constants[0];
+            if (state == LATTICE_CONSTANT && constant->token_type == INT_TOKEN && operand_type(code, code->a[index]) == REAL_TOKEN)
+                constant = make_number(prop->ctx, REAL_TOKEN, 0, (float) constant->values->i);
+            break;
+        case TAC_POS: case TAC_NEG: case TAC_NOT:
+            state = states[0];
+            if (state == LATTICE_CONSTANT) {
+                constant = fold_unary_op(prop->ctx, op, constants[0]);
+                state = constant != NULL ? LATTICE_CONSTANT : LATTICE_BOTTOM;
+            }
+            break;
+        case TAC_ADD: case TAC_SUB: case TAC_MULT: case TAC_DIV: case TAC_MOD: case TAC_AND: case TAC_OR:
+        case TAC_LT: case TAC_GT: case TAC_NEQ: case TAC_LTE: case TAC_GTE: case TAC_EQ:
+            if (states[0] == LATTICE_BOTTOM || states[1] == LATTICE_BOTTOM)
+                state = LATTICE_BOTTOM;
+            else if (states[0] == LATTICE_TOP || states[1] == LATTICE_TOP)
+                state = LATTICE_TOP;
+            else {
+                constant = fold_binary_op(prop->ctx, op, constants[0], constants[1]);
+                state = constant != NULL ? LATTICE_CONSTANT : LATTICE_BOTTOM;
+            }
+            break;
+        default: // Call results
+            break;
+    }
+    lower_value(prop, value, state, constant);
+}
+
+void visit_block(Propagation *prop, int b) { // First time the block is reached
+    const ControlFlowGraph *cfg = prop->ssa->cfg;
+    const BasicBlock *block = &cfg->blocks[b];
+    prop->executable_blocks[b] = 1;
+    for (int p = prop->ssa->block_phis[b]; p < prop->ssa->block_phis[b + 1]; p++)
+        evaluate_phi(prop, p);
+    int conditional = 0;
+    for (int i = block->start; i < block->end; i++) {
+        if (cfg->code->ops[i] == TAC_UNDEF)
+            continue;
+        conditional = cfg->code->ops[i] == TAC_IFZ || cfg->code->ops[i] == TAC_IFNZ;
+        evaluate_instruction(prop, i);
+    }
+    if (!conditional) {
+        for (int s = 0; s < block->succ_count; s++)
+            mark_edge(prop, b, block->succs[s]);
+    }
+}
+
+int rewrite_constants(Propagation *prop) {
+    // Replaces the constant values by their literal and removes the blocks and branches that are never executed
+    const ControlFlowGraph *cfg = prop->ssa->cfg;
+    TacArray *code = cfg->code;
+    int base = cfg->routine_start + 1;
+    int change_count = 0;
+    Operand *literals = calloc(prop->ssa->value_count > 0 ? prop->ssa->value_count : 1, sizeof(Operand));
+    for (int b = 0; b < cfg->block_count; b++) {
+        const BasicBlock *block = &cfg->blocks[b];
+        for (int i = block->start; i < block->end; i++) {
+            TacOp op = code->ops[i];
+            if (op == TAC_UNDEF)
+                continue;
+            if (!prop->executable_blocks[b]) {
+                code->ops[i] = TAC_UNDEF;
+                change_count++;
+                continue;
+            }
+            if (op == TAC_ARG && is_ref_arg(code, i)) // Keeps the variables passed by reference
+                continue;
+            int value = prop->ssa->defs[i - base];
+            if (value >= 0 && prop->states[value] == LATTICE_CONSTANT) {
+                if (literals[value] == NO_OPERAND)
+                    literals[value] = add_symbol(code, prop->constants[value]);
+                if (op != TAC_CPY || code->b[i] != literals[value]) {
+                    code->ops[i] = TAC_CPY;
+                    code->b[i] = literals[value];
+                    code->c[i] = NO_OPERAND;
+                    change_count++;
+                }
+                continue;
+            }
+            Operand *slots[MAX_USED_OPERANDS];
+            int use_count = used_operands(code, i, slots);
+            for (int k = 0; k < use_count; k++) {
+                int used = prop->ssa->uses[MAX_USED_OPERANDS * (i - base) + k];
+                if (used < 0 || prop->states[used] != LATTICE_CONSTANT)
+                    continue;
+                if (literals[used] == NO_OPERAND)
+                    literals[used] = add_symbol(code, prop->constants[used]);
+                *slots[k] = literals[used];
+                change_count++;
+            }
+            if ((op == TAC_IFZ || op == TAC_IFNZ) && is_constant_symbol(operand_symbol(code, code->b[i]))) {
+                int taken = is_branch_taken(op, operand_symbol(code, code->b[i]));
+                if (taken == 1) {
+                    code->ops[i] = TAC_GOTO;
+                    code->b[i] = NO_OPERAND;
+                    change_count++;
+                }
+                else if (taken == 0) {
+                    code->ops[i] = TAC_UNDEF;
+                    change_count++;
+                }
+            }
+        }
+    }
+    free(literals);
+    return change_count;
+}
+
+int propagate_constants(CompilerContext *ctx, SsaForm *ssa) {
+    // Sparse conditional constant propagation (Wegman and Zadeck), returns the number of changed instructions
+    // The code is rewritten in place so the SSA form and the control flow graph are out of date afterwards
+    const ControlFlowGraph *cfg = ssa->cfg;
+    Propagation prop;
+    prop.ctx = ctx;
+    prop.ssa = ssa;
+    prop.states = calloc(ssa->value_count > 0 ? ssa->value_count : 1, 1);
+    prop.constants = calloc(ssa->value_count > 0 ? ssa->value_count : 1, sizeof(Symbol *));
+    prop.executable_blocks = calloc(cfg->block_count, 1);
+    prop.executable_edges = calloc(2 * cfg->block_count, 1);
+    prop.edge_worklist = malloc(2 * cfg->block_count * sizeof(int));
+    prop.value_worklist = malloc((ssa->value_count > 0 ? 2 * ssa->value_count : 1) * sizeof(int));
+    prop.edge_count = prop.value_count = 0;
+    if (prop.states == NULL || prop.constants == NULL || prop.executable_blocks == NULL || prop.executable_edges == NULL
+        || prop.edge_worklist == NULL || prop.value_worklist == NULL) {
+        fprintf(ctx->log_fptr, "Error: failed to allocate memory for the constant propagation\n");
+        free(prop.states);
+        free(prop.constants);
+        free(prop.executable_blocks);
+        free(prop.executable_edges);
+        free(prop.edge_worklist);
+        free(prop.value_worklist);
+        return 0;
+    }
+    for (int v = 0; v < ssa->value_count; v++) { // Values at the routine entry and values clobbered by calls are unknown
+        if (v < ssa->var_count || (ssa->values[v].instruction >= 0 && ssa->defs[ssa->values[v].instruction - cfg->routine_start - 1] != v))
+            prop.states[v] = LATTICE_BOTTOM;
+    }
+
+    visit_block(&prop, 0);
+    while (prop.edge_count > 0 || prop.value_count > 0) {
+        if (prop.edge_count > 0) {
+            int edge = prop.edge_worklist[--prop.edge_count];
+            int target = cfg->blocks[edge / 2].succs[edge % 2];
+            if (prop.executable_blocks[target]) { // Only the phis see the new edge
+                for (int p = ssa->block_phis[target]; p < ssa->block_phis[target + 1]; p++)
+                    evaluate_phi(&prop, p);
+            }
+            else
+                visit_block(&prop, target);
+            continue;
+        }
+        int value = prop.value_worklist[--prop.value_count];
+        for (int u = ssa->user_start[value]; u < ssa->user_start[value + 1]; u++) {
+            int user = ssa->users[u];
+            if (user < 0)
+                evaluate_phi(&prop, -user - 1);
+            else
+                evaluate_instruction(&prop, user);
+        }
+    }
+
+    int change_count = rewrite_constants(&prop);
+    free(prop.states);
+    free(prop.constants);
+    free(prop.executable_blocks);
+    free(prop.executable_edges);
+    free(prop.edge_worklist);
+    free(prop.value_worklist);
+    return change_count;
+}
+
+int is_pure_instruction(TacOp op) { // Instructions without side effects besides writing their result
+    switch (op) {
+        case TAC_ADD: case TAC_SUB: case TAC_MULT: case TAC_DIV: case TAC_MOD: case TAC_AND: case TAC_OR:
+        case TAC_LT: case TAC_GT: case TAC_NEQ: case TAC_LTE: case TAC_GTE: case TAC_EQ:
+        case TAC_POS: case TAC_NEG: case TAC_NOT: case TAC_CPY:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+int coalesce_copies(SsaForm *ssa) {
+    // Computes a value straight into the variable it is copied to when the copy is the only use of its temporary
+    // (t = x + 1; x = t becomes x = x + 1), returns the number of removed copies
+    const ControlFlowGraph *cfg = ssa->cfg;
+    TacArray *code = cfg->code;
+    int base = cfg->routine_start + 1;
+    int change_count = 0;
+    for (int i = base; i < cfg->routine_end; i++) {
+        if (code->ops[i] != TAC_CPY || operand_kind(code->b[i]) != TEMP_OPERAND)
+            continue;
+        int value = ssa->uses[MAX_USED_OPERANDS * (i - base)];
+        if (value < 0 || ssa->user_start[value + 1] - ssa->user_start[value] != 1 || ssa->values[value].instruction < 0)
+            continue;
+        int def = ssa->values[value].instruction;
+        Operand target = code->a[i];
+        if (ssa->defs[def - base] != value || instruction_block(cfg, def) != instruction_block(cfg, i)
+            || operand_type(code, target) != operand_type(code, code->b[i]))
+            continue;
+        int blocked = 0;
+        for (int j = def + 1; j < i && !blocked; j++) { // The target can't be read or written in between
+            if (code->ops[j] == TAC_UNDEF)
+                continue;
+            Operand *slots[MAX_USED_OPERANDS];
+            int use_count = used_operands(code, j, slots);
+            blocked = code->ops[j] == TAC_CALL || defined_operand(code, j) == target;
+            for (int k = 0; k < use_count; k++)
+                blocked |= *slots[k] == target;
+        }
+        if (blocked)
+            continue;
+        code->a[def] = target;
+        code->ops[i] = TAC_UNDEF;
+        int target_value = ssa->defs[i - base];
+        ssa->defs[def - base] = target_value;
+        if (target_value >= 0)
+            ssa->values[target_value].instruction = def;
+        ssa->values[value].instruction = -1;
+        ssa->defs[i - base] = ssa->uses[MAX_USED_OPERANDS * (i - base)] = -1;
+        change_count++;
+    }
+    return change_count;
+}
+
+int copy_source(const SsaForm *ssa, const int *current, int value, Operand *source) {
+    // Follows the copies defining the value while their source still holds the same value, returns the value of the
+    // source (-1 for a literal or a value parameter, that are never written) or -2 when there is nothing to propagate
+    const TacArray *code = ssa->cfg->code;
+    int base = ssa->cfg->routine_start + 1;
+    int result = -2;
+    while (value >= 0 && ssa->values[value].instruction >= 0) {
+        int def = ssa->values[value].instruction;
+        if (ssa->defs[def - base] != value || code->ops[def] != TAC_CPY || operand_type(code, code->a[def]) != operand_type(code, code->b[def]))
+            break;
+        int source_value = ssa->uses[MAX_USED_OPERANDS * (def - base)];
+        if (source_value >= 0) {
+            if (current[ssa->values[source_value].var] != source_value) // Written again since the copy
+                break;
+            *source = code->b[def];
+            result = value = source_value;
+            continue;
+        }
+        const Symbol *symb = operand_symbol(code, code->b[def]);
+        if (symb != NULL && symb->declaration_type == CONST_TOKEN) {
+            *source = code->b[def];
+            result = -1;
+        }
+        break;
+    }
+    return result;
+}
+
+int propagate_copies(SsaForm *ssa) {
+    // Replaces the uses of a copied variable by the copy source, walking the dominator tree to know the current values
+    ControlFlowGraph *cfg = ssa->cfg;
+    TacArray *code = cfg->code;
+    int base = cfg->routine_start + 1;
+    int *current = malloc((ssa->var_count > 0 ? ssa->var_count : 1) * sizeof(int));
+    int *saved = malloc((ssa->value_count > 0 ? ssa->value_count : 1) * sizeof(int)); // Values replaced by each value definition
+    int *stack = malloc(cfg->block_count * sizeof(int));
+    int *next_child = malloc(cfg->block_count * sizeof(int));
+    int stack_count = 0, change_count = 0;
+    for (int var = 0; var < ssa->var_count; var++)
+        current[var] = var;
+
+    stack[stack_count++] = 0;
+    next_child[0] = -1;
+    while (stack_count > 0) {
+        int b = stack[stack_count - 1];
+        const BasicBlock *block = &cfg->blocks[b];
+        if (next_child[b] == -1) {
+            for (int p = ssa->block_phis[b]; p < ssa->block_phis[b + 1]; p++) {
+                int value = ssa->phis[p].value;
+                saved[value] = current[ssa->values[value].var];
+                current[ssa->values[value].var] = value;
+            }
+            for (int i = block->start; i < block->end; i++) {
+                TacOp op = code->ops[i];
+                if (op == TAC_UNDEF)
+                    continue;
+                if (op != TAC_ARG || !is_ref_arg(code, i)) {
+                    Operand *slots[MAX_USED_OPERANDS];
+                    int use_count = used_operands(code, i, slots);
+                    for (int k = 0; k < use_count; k++) {
+                        Operand source;
+                        int source_value = copy_source(ssa, current, ssa->uses[MAX_USED_OPERANDS * (i - base) + k], &source);
+                        if (source_value == -2)
+                            continue;
+                        *slots[k] = source;
+                        ssa->uses[MAX_USED_OPERANDS * (i - base) + k] = source_value;
+                        change_count++;
+                    }
+                }
+                int value = ssa->defs[i - base];
+                if (value >= 0) {
+                    saved[value] = current[ssa->values[value].var];
+                    current[ssa->values[value].var] = value;
+                }
+                for (int c = ssa->clobber_start[i - base]; c < ssa->clobber_start[i - base + 1]; c++) {
+                    saved[ssa->clobbers[c]] = current[ssa->values[ssa->clobbers[c]].var];
+                    current[ssa->values[ssa->clobbers[c]].var] = ssa->clobbers[c];
+                }
+            }
+            next_child[b] = 0;
+        }
+        if (next_child[b] < block->dom_child_count) {
+            int child = cfg->dom_children[block->dom_child_start + next_child[b]++];
+            next_child[child] = -1;
+            stack[stack_count++] = child;
+            continue;
+        }
+        for (int i = block->end - 1; i >= block->start; i--) { // Restores the values in the reverse order of their definitions
+            if (code->ops[i] == TAC_UNDEF)
+                continue;
+            for (int c = ssa->clobber_start[i - base + 1] - 1; c >= ssa->clobber_start[i - base]; c--)
+                current[ssa->values[ssa->clobbers[c]].var] = saved[ssa->clobbers[c]];
+            if (ssa->defs[i - base] >= 0)
+                current[ssa->values[ssa->defs[i - base]].var] = saved[ssa->defs[i - base]];
+        }
+        for (int p = ssa->block_phis[b + 1] - 1; p >= ssa->block_phis[b]; p--)
+            current[ssa->values[ssa->phis[p].value].var] = saved[ssa->phis[p].value];
+        stack_count--;
+    }
+    free(current);
+    free(saved);
+    free(stack);
+    free(next_child);
+    return change_count;
+}
+
+int eliminate_dead_code(SsaForm *ssa) {
+    // Removes the pure instructions whose value is never used by an instruction with side effects, even through loops
+    // Writes to global and untracked variables are kept, returns the number of removed instructions
+    const ControlFlowGraph *cfg = ssa->cfg;
+    TacArray *code = cfg->code;
+    int base = cfg->routine_start + 1;
+    uint8_t *live = calloc(ssa->value_count > 0 ? ssa->value_count : 1, 1);
+    int *worklist = malloc((ssa->value_count > 0 ? ssa->value_count : 1) * sizeof(int));
+    int worklist_count = 0, change_count = 0;
+
+    if (ssa->result_value >= 0) {
+        live[ssa->result_value] = 1;
+        worklist[worklist_count++] = ssa->result_value;
+    }
+    for (int i = base; i < cfg->routine_end; i++) {
+        if (code->ops[i] == TAC_UNDEF)
+            continue;
+        int value = ssa->defs[i - base];
+        if (is_pure_instruction(code->ops[i]) && value >= 0 && !ssa->global_vars[ssa->values[value].var])
+            continue;
+        for (int k = 0; k < MAX_USED_OPERANDS; k++) { // Operands used by an instruction that has to stay
+            int used = ssa->uses[MAX_USED_OPERANDS * (i - base) + k];
+            if (used >= 0 && !live[used]) {
+                live[used] = 1;
+                worklist[worklist_count++] = used;
+            }
+        }
+    }
+    while (worklist_count > 0) {
+        int live_value = worklist[--worklist_count];
+        const SsaValue *value = &ssa->values[live_value];
+        int used_count = 0, used[MAX_USED_OPERANDS];
+        if (value->phi >= 0) {
+            const Phi *phi = &ssa->phis[value->phi];
+            for (int a = 0; a < phi->arg_count; a++) {
+                int arg = ssa->phi_args[phi->arg_start + a];
+                if (arg >= 0 && !live[arg]) {
+                    live[arg] = 1;
+                    worklist[worklist_count++] = arg;
+                }
+            }
+        }
+        else if (value->instruction >= 0 && ssa->defs[value->instruction - base] == live_value) {
+            for (int k = 0; k < MAX_USED_OPERANDS; k++)
+                used[used_count++] = ssa->uses[MAX_USED_OPERANDS * (value->instruction - base) + k];
+        }
+        for (int k = 0; k < used_count; k++) {
+            if (used[k] >= 0 && !live[used[k]]) {
+                live[used[k]] = 1;
+                worklist[worklist_count++] = used[k];
+            }
+        }
+    }
+    for (int i = base; i < cfg->routine_end; i++) {
+        int value = ssa->defs[i - base];
+        if (code->ops[i] != TAC_UNDEF && is_pure_instruction(code->ops[i]) && value >= 0 && !ssa->global_vars[ssa->values[value].var]
+            && !live[value]) {
+            code->ops[i] = TAC_UNDEF;
+            change_count++;
+        }
+    }
+    free(live);
+    free(worklist);
+    return change_count;
+}
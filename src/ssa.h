@@ -0,0 +1,58 @@
+#ifndef SSA_H
+#define SSA_H
+
+#include <stdint.h>
+
+#include "tac_array.h"
+#include "control_flow.h"
+
+// The SSA form is kept beside the code: instructions aren't renamed, every definition and use is mapped to a value instead.
+// Temporaries, local variables and function results are tracked, as are global variables when the routine has no parameter
+// passed by reference (a call clobbers the global variables and the variables it passes by reference).
+
+typedef struct _SsaValue {
+    int var; // Tracked variable the value belongs to
+    int instruction; // Defining instruction (a call for a clobbered variable), -1 for a phi and for the value at the routine entry
+    int phi; // Defining phi, -1 otherwise
+} SsaValue;
+
+typedef struct _Phi {
+    int block;
+    int value;
+    int arg_start, arg_count; // One argument per predecessor of the block, the entry block also gets the entry value last
+} Phi;
+
+typedef struct _SsaForm {
+    ControlFlowGraph *cfg;
+    Operand *vars; // Tracked variables, the values 0 to var_count - 1 are their values at the routine entry
+    uint8_t *global_vars; // Set for the global variables, they are clobbered by calls
+    int var_count;
+    Operand *var_keys; // Open addressing map from the operands of the routine to their tracked variable
+    int *var_slots;
+    uint32_t var_mask;
+    SsaValue *values;
+    int value_count;
+    Phi *phis; // Grouped by block
+    int *phi_args;
+    int *block_phis; // Phis of block b are block_phis[b] to block_phis[b + 1] - 1
+    int phi_count;
+    int *defs; // Value defined by each instruction of the routine (indexed from routine_start + 1), -1 when there is none
+    int *uses; // Values read by the used operands of each instruction, MAX_USED_OPERANDS per instruction, -1 for an operand that isn't tracked
+    int *clobber_start; // Values clobbered by the call at each instruction are clobbers[clobber_start[i]] to clobbers[clobber_start[i + 1] - 1]
+    int *clobbers;
+    int *user_start; // Users of value v are users[user_start[v]] to users[user_start[v + 1] - 1], an instruction index or -(phi + 1)
+    int *users;
+    int result_value; // Value of the function result variable at the routine end, -1 otherwise
+} SsaForm;
+
+SsaForm* build_ssa(ControlFlowGraph *);
+void free_ssa(SsaForm *);
+int ssa_var(const SsaForm *, Operand);
+int propagate_constants(CompilerContext *, SsaForm *);
+int coalesce_copies(SsaForm *);
+int propagate_copies(SsaForm *);
+int eliminate_dead_code(SsaForm *);
+int is_pure_instruction(TacOp);
+int is_ref_param(const ParamType *, const Symbol *);
+
+#endif
@@ -1,12 +1,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
-#include <time.h>
 #include "symbol_table.h"
-
-uint32_t *DEFAULT_SEED = NULL;
-
-SymbolTable *main_table = NULL;
+#include "compiler_context.h"
 
 TokenType declaration_value_map(TokenType type) {
     if (type == INT_TOKEN)
@@ -29,18 +25,7 @@ TokenType declaration_value_map(TokenType type) {
 }
 
 uint32_t hash(const void *key, int len, uint32_t seed) {
-    // This is a copy of the excellent murmur2 hash function
-    if (seed == 0) { // Define a fixed random seed for the entirety of runtime (Do not free DEFAULT_SEED until program's end)
-        if (!DEFAULT_SEED) {
-            srand(time(0));
-            DEFAULT_SEED = malloc(sizeof(uint32_t));
-            do {
-                *DEFAULT_SEED = (uint32_t) (rand()*100);
-            } while(*DEFAULT_SEED == 0);
-        }
-        seed = *DEFAULT_SEED;
-    }
-
+    // This is a copy of the excellent murmur2 hash function (the seed comes from the compiler context owning the table)
     const uint32_t m = 0x5bd1e995;
     const int r = 24;
     uint32_t h = seed ^ len; // Initialize the hash to a 'random' value
@@ -113,30 +98,43 @@ SymbolTable* make_table(SymbolTable *previous) {
     for (int i = 0; i < HASH_SIZE; i++)
         tmp->symbol_table[i] = NULL;
     tmp->symbol_count = 0;
+    tmp->seed = previous == NULL ? 0 : previous->seed;
     tmp->nesting_level = previous == NULL ? 0 : previous->nesting_level+1;
     return tmp;
 }
 
-void init_main_table() { // Don't forget to call this on start !!
-    if (main_table == NULL) {
-        main_table = make_table(NULL);
-        SymbolValue *value_ptr = malloc(sizeof(SymbolValue));
-        value_ptr->i = 1;
-        symbol_insert(main_table, make_symbol("true", VAR_TOKEN, INT_TOKEN, 0, 0, 1, NULL, value_ptr));
-        value_ptr->i = 0;
-        symbol_insert(main_table, make_symbol("false", VAR_TOKEN, INT_TOKEN, 0, 0, 1, NULL, value_ptr));
+// Builtin symbols are shared by every compilation and must never be modified, true and false are constants so no
+// assignment or var argument reaches them
+static SymbolValue builtin_values[] = { { .i = 1 }, { .i = 0 } };
+static Symbol builtin_symbols[] = {
+    { .declaration_type = CONST_TOKEN, .token_type = INT_TOKEN, .dimension = 1, .name = "true", .values = &builtin_values[0] },
+    { .declaration_type = CONST_TOKEN, .token_type = INT_TOKEN, .dimension = 1, .name = "false", .values = &builtin_values[1] }
+};
+
+void init_main_table(CompilerContext *ctx) { // Don't forget to call this on start !!
+    if (ctx->main_table == NULL) {
+        ctx->main_table = make_table(NULL);
+        ctx->main_table->seed = ctx->hash_seed;
+    }
+}
+
+Symbol* symbol_builtin_lookup(const char *name) {
+    for (int i = 0; i < BUILTIN_COUNT; i++) {
+        if (strcmp(builtin_symbols[i].name, name) == 0)
+            return &builtin_symbols[i];
     }
+    return NULL;
 }
 
 void symbol_insert(SymbolTable *table_ptr, Symbol *symbol) { // Simply inserts at list's head (Does not check for redundancy)
-    int index = hash(symbol->name, strlen(symbol->name), 0);
+    int index = hash(symbol->name, strlen(symbol->name), table_ptr->seed);
     symbol->next = table_ptr->symbol_table[index]; // Insertion at table's head
     table_ptr->symbol_table[index] = symbol;
     table_ptr->symbol_count++;
 }
 
 Symbol* symbol_lookup(SymbolTable *table_ptr, char *name) {
-    int index = hash(name, strlen(name), 0);
+    int index = hash(name, strlen(name), table_ptr->seed);
     Symbol *tmp = table_ptr->symbol_table[index];
     while (tmp) {
         if (strcmp(tmp->name, name) == 0)
@@ -146,24 +144,24 @@ Symbol* symbol_lookup(SymbolTable *table_ptr, char *name) {
     return tmp; // Returns NULL if symbol's not found on given table
 }
 
-Symbol* symbol_deep_lookup(char *name) { // Looks up in the current and the main table and returns the result
-    Symbol *tmp = symbol_lookup(current_table, name);
-    if (tmp == NULL && current_table->nesting_level != main_table->nesting_level)
-        tmp = symbol_lookup(main_table, name);
+Symbol* symbol_deep_lookup(CompilerContext *ctx, char *name) { // Looks up in the current table, the main table and the builtins and returns the result
+    Symbol *tmp = symbol_lookup(ctx->current_table, name);
+    if (tmp == NULL && ctx->current_table->nesting_level != ctx->main_table->nesting_level)
+        tmp = symbol_lookup(ctx->main_table, name);
+    if (tmp == NULL)
+        tmp = symbol_builtin_lookup(name);
     return tmp;
 }
 
 void symbol_memfree(Symbol *symbol) {
     if (symbol) {
-        symbol->name = NULL;
+        free(symbol->name);
         ParamType *param = symbol->param_list;
-        while (param && param->param_symbol) {
-            Symbol *to_free = param->param_symbol;
+        while (param) { // Parameter symbols are owned by the function/procedure table, only the list itself is freed here
+            ParamType *to_free = param;
             param = param->next;
-            symbol_memfree(to_free);
+            free(to_free);
         }
-        if (symbol->param_list)
-            free(symbol->param_list);
         if (symbol->values)
             free(symbol->values);
         free(symbol);
@@ -171,7 +169,7 @@ void symbol_memfree(Symbol *symbol) {
 }
 
 int symbol_lookup_insert(SymbolTable *table_ptr, Symbol *symbol) {
-    int index = hash(symbol->name, strlen(symbol->name), 0);
+    int index = hash(symbol->name, strlen(symbol->name), table_ptr->seed);
     Symbol *tmp = table_ptr->symbol_table[index], *previous = NULL;
     while (tmp) {
         if (strcmp(tmp->name, symbol->name) == 0)
@@ -200,7 +198,7 @@ int symbol_lookup_insert(SymbolTable *table_ptr, Symbol *symbol) {
 }
 
 void symbol_delete(SymbolTable *table_ptr, char *name) {
-    int index = hash(name, strlen(name), 0);
+    int index = hash(name, strlen(name), table_ptr->seed);
     Symbol *tmp = table_ptr->symbol_table[index], *previous = NULL;
     while (tmp) {
         if (strcmp(tmp->name, name) == 0) {
@@ -234,3 +232,25 @@ void clean_table(SymbolTable *table_ptr) {
     }
     free(table_ptr);
 }
+
+Symbol* clean_routine_table(SymbolTable *table_ptr, const ParamType *params) {
+    // Frees the table of a routine but its parameters, calls still need them: they are returned chained through their next pointer
+    Symbol *kept = NULL;
+    for (int i = 0; i < HASH_SIZE; i++) {
+        while (table_ptr->symbol_table[i] != NULL) {
+            Symbol *symbol = table_ptr->symbol_table[i];
+            table_ptr->symbol_table[i] = symbol->next;
+            const ParamType *param = params;
+            while (param != NULL && param->param_symbol != symbol)
+                param = param->next;
+            if (param != NULL) {
+                symbol->next = kept;
+                kept = symbol;
+            }
+            else
+                symbol_memfree(symbol);
+        }
+    }
+    free(table_ptr);
+    return kept;
+}
@@ -1,12 +1,15 @@
 #ifndef SYMBOL_TABLE_H
 #define SYMBOL_TABLE_H
 
+#include <stdint.h>
+
 #include "scanner.h"
 
 #define HASH_SIZE 1049
+#define BUILTIN_COUNT 2 // true, false
 
 typedef struct _SymbolValue {
-    union Value {
+    union {
         int i;
         float f;
         char c;
@@ -38,23 +41,23 @@ typedef struct _SymbolTable {
     struct _SymbolTable *child;
     int nesting_level;
     int symbol_count;
+    uint32_t seed; // Hash seed, inherited from the parent table
     Symbol *symbol_table[HASH_SIZE];
 } SymbolTable;
 
-SymbolTable *main_table;
-SymbolTable *current_table;
-
 TokenType declaration_value_map(TokenType);
 Symbol* make_symbol(const char *name, TokenType dt, TokenType tt, int line, int col, int dim, ParamType *param_list, SymbolValue *value_list);
 SymbolValue* make_symbol_value(char *, TokenType);
 SymbolTable* make_table(SymbolTable *);
-void init_main_table();
+void init_main_table(CompilerContext *);
+Symbol* symbol_builtin_lookup(const char *);
 void symbol_insert(SymbolTable *, Symbol *);
 Symbol* symbol_lookup(SymbolTable *, char *);
-Symbol* symbol_deep_lookup(char *);
+Symbol* symbol_deep_lookup(CompilerContext *, char *);
 void symbol_memfree(Symbol *);
 int symbol_lookup_insert(SymbolTable *, Symbol *);
 void symbol_delete(SymbolTable *, char *);
 void clean_table(SymbolTable *);
+Symbol* clean_routine_table(SymbolTable *, const ParamType *);
 
 #endif
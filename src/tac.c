@@ -1,18 +1,32 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
 
 #include "scanner.h"
 #include "symbol_table.h"
 #include "tac.h"
-
-int label_idx = 0;
-
-Tac* make_tac(TacOp op, Symbol *a, Symbol *b, Symbol *c) {
-    Tac *new_tac = malloc(sizeof(new_tac));
+#include "compiler_context.h"
+
+Tac* make_tac(CompilerContext *ctx, TacOp op, Symbol *a, Symbol *b, Symbol *c) {
+    // NULL when out of memory, the builders go on without the instruction and flatten_tac then fails
+    if (ctx->tac_blocks == NULL || ctx->tac_blocks->used == TAC_BLOCK_SIZE) {
+        TacBlock *new_block = malloc(sizeof(TacBlock));
+        if (new_block == NULL) {
+            fprintf(ctx->log_fptr, "Error: failed to allocate memory for the intermediate code\n");
+            ctx->tac_failed = 1;
+            return NULL;
+        }
+        new_block->next = ctx->tac_blocks;
+        new_block->used = 0;
+        ctx->tac_blocks = new_block;
+    }
+    Tac *new_tac = &ctx->tac_blocks->tacs[ctx->tac_blocks->used++];
     new_tac->prev = NULL;
     new_tac->next = NULL;
-    
+
     new_tac->op = op;
+    new_tac->temps = 0;
     new_tac->a.symb = a;
     new_tac->b.symb = b;
     new_tac->c.symb = c;
@@ -20,401 +34,706 @@ Tac* make_tac(TacOp op, Symbol *a, Symbol *b, Symbol *c) {
     return new_tac;
 }
 
-Tac* join_tac(Tac *tac_1, Tac *tac_2) {
-    if (tac_1 == NULL)
-        return tac_2;
-    if (tac_2 == NULL)
-        return tac_1;
+TacList empty_tac() {
+    TacList list = { NULL, NULL };
+    return list;
+}
 
-    Tac *tac_ptr = tac_2;
-    while (tac_ptr->prev != NULL) {
-        tac_ptr = tac_ptr->prev;
-    }
+TacList single_tac(Tac *tac) {
+    TacList list = { tac, tac };
+    return list;
+}
+
+TacList join_tac(TacList list_1, TacList list_2) {
+    if (list_1.head == NULL)
+        return list_2;
+    if (list_2.head == NULL)
+        return list_1;
+
+    list_1.tail->next = list_2.head;
+    list_2.head->prev = list_1.tail;
+    list_1.tail = list_2.tail;
+    return list_1;
+}
 
-    tac_ptr->prev = tac_1;
-    return tac_2;
+void free_tac_blocks(CompilerContext *ctx) { // Frees every instruction, the linked code can't be used afterwards
+    while (ctx->tac_blocks != NULL) {
+        TacBlock *to_free = ctx->tac_blocks;
+        ctx->tac_blocks = to_free->next;
+        free(to_free);
+    }
+    ctx->program_tac = empty_tac();
 }
 
-ExprNode* make_node(ExprNode *next, Symbol *result, Tac *code) {
-    ExprNode *new_node = malloc(sizeof(new_node));
-    new_node->next = next;
-    new_node->result = result;
-    new_node->tac = code;
+void free_ir_symbols(CompilerContext *ctx, const Symbol *last) { // Frees the intermediate code symbols made after last
+    while (ctx->ir_symbols != last) {
+        Symbol *to_free = ctx->ir_symbols;
+        ctx->ir_symbols = to_free->next;
+        if (to_free->values != NULL && to_free->token_type == STRING_TOKEN)
+            free(to_free->values->str);
+        free(to_free->values);
+        free(to_free->name);
+        free(to_free);
+    }
+}
 
-    return new_node;
+void free_tac(CompilerContext *ctx) { // Frees every instruction and intermediate code symbol of the compilation
+    free_tac_blocks(ctx);
+    free_ir_symbols(ctx, NULL);
+    free_constant_pool(&ctx->constants);
+    free(ctx->temp_types);
+    ctx->temp_types = NULL;
+    ctx->temp_count = ctx->temp_capacity = 0;
+    ctx->program_tac = empty_tac();
+    ctx->label_idx = 0;
+    ctx->tac_failed = 0;
 }
 
-Tac* tac_declare(Symbol *symb) {
-    Tac *tac = make_tac(TAC_VAR, symb, NULL, NULL);
+TacMark mark_tac(CompilerContext *ctx) {
+    TacMark mark = { ctx->tac_blocks, ctx->tac_blocks != NULL ? ctx->tac_blocks->used : 0, ctx->ir_symbols, ctx->temp_count };
+    return mark;
 }
 
-Tac* tac_assign(Symbol *symb, ExprNode *expr)  {
-    if (symb->declaration_type != VAR_TOKEN) {
-        printf("Error: assignment to non-variable at line %d\n", symb->line);
-        return NULL;
+void release_tac(CompilerContext *ctx, TacMark mark) {
+    // Frees the instructions and intermediate code symbols made since the mark and reuses the temporary numbers taken
+    // since, the code linked to them can't be used afterwards
+    while (ctx->tac_blocks != mark.block) {
+        TacBlock *to_free = ctx->tac_blocks;
+        ctx->tac_blocks = to_free->next;
+        free(to_free);
     }
+    if (mark.block != NULL)
+        mark.block->used = mark.used;
+    free_ir_symbols(ctx, mark.ir_symbols);
+    ctx->temp_count = mark.temp_count;
+}
 
-    Tac *code = make_tac(TAC_CPY, symb, expr->result, NULL);
-    return code;
+TokenType value_type(TokenType type) { // Type keyword of a value token (INUM_TOKEN -> INT_TOKEN ...)
+    if (type == INUM_TOKEN || type == RNUM_TOKEN || type == CVAL_TOKEN || type == SVAL_TOKEN)
+        return declaration_value_map(type);
+    return type;
 }
 
-ExprNode* tac_unary_op(TacOp op, ExprNode *expr) {
-    if (expr->result->token_type == INT_TOKEN) {
-        switch (op) {
-            case TAC_POS: {
-                if (expr->result->values->i < 0) {
-                    expr->result->values->i *= -1;
-                }
-                break;
-            }
-            case TAC_NEG: {
-                if (expr->result->values->i > 0) {
-                    expr->result->values->i *= -1;
-                }
-                break;
-            }
-            case TAC_NOT: {
-                expr->result->values->i = (expr->result->values->i == 0);
-                break;
-            }
+int is_constant_symbol(const Symbol *symb) {
+    return symb != NULL && symb->declaration_type == CONST_TOKEN && symb->values != NULL; // Value parameters are constants without values
+}
+
+int is_number_type(TokenType type) {
+    return type == INT_TOKEN || type == REAL_TOKEN;
+}
+
+Symbol* register_symbol(CompilerContext *ctx, Symbol *symb) { // Intermediate code symbols are chained through their next pointer
+    symb->next = ctx->ir_symbols;
+    ctx->ir_symbols = symb;
+    return symb;
+}
+
+int make_temp(CompilerContext *ctx, TokenType type) { // Number of a new temporary, NO_TEMP when out of memory
+    if (ctx->temp_count == ctx->temp_capacity) {
+        int capacity = ctx->temp_capacity == 0 ? BUFFER_SIZE : ctx->temp_capacity * 2;
+        TokenType *temp_types = realloc(ctx->temp_types, capacity * sizeof(TokenType));
+        if (temp_types == NULL) {
+            fprintf(ctx->log_fptr, "Error: failed to allocate memory for the temporaries\n");
+            ctx->tac_failed = 1;
+            return NO_TEMP;
         }
-        return expr;
+        ctx->temp_types = temp_types;
+        ctx->temp_capacity = capacity;
     }
+    ctx->temp_types[ctx->temp_count] = type;
+    return ctx->temp_count++;
+}
 
-    if (expr->result->token_type == REAL_TOKEN) {
-        switch (op) {
-            case TAC_POS: {
-                if (expr->result->values->f < 0) {
-                    expr->result->values->f *= -1;
-                }
-                break;
-            }
-            case TAC_NEG: {
-                if (expr->result->values->f > 0) {
-                    expr->result->values->f *= -1;
-                }
-                break;
-            }
-            case TAC_NOT: {
-                expr->result->values->f = (expr->result->values->f == 0);
-                break;
-            }
-        }
-        return expr;
+TokenType node_type(CompilerContext *ctx, const ExprNode *node) {
+    return node->temp != NO_TEMP ? ctx->temp_types[node->temp] : node->result->token_type;
+}
+
+void set_node_operand(Tac *tac, int slot, const ExprNode *node) { // Operand a, b or c (slot 0, 1 or 2) takes the value of the node
+    if (tac == NULL) // Not allocated
+        return;
+    TacOperand *operand = slot == 0 ? &tac->a : slot == 1 ? &tac->b : &tac->c;
+    if (node->temp != NO_TEMP) {
+        operand->temp = node->temp;
+        tac->temps |= 1 << slot;
     }
+    else
+        operand->symb = node->result;
+}
 
-    Symbol *tmp_symb = make_symbol(NULL, 0, 0, 0, 0, 0, NULL, NULL);
+void set_temp_result(Tac *tac, ExprNode *node, int temp) { // The instruction writes its result to the temporary the node now holds
+    if (tac != NULL) {
+        tac->a.temp = temp;
+        tac->temps |= TEMP_A;
+    }
+    node->result = NULL;
+    node->temp = temp;
+}
 
-    Tac *tmp = make_tac(TAC_VAR, tmp_symb, NULL, NULL);
-    tmp->prev = expr->tac;
-    Tac *result = make_tac(op, tmp->a.symb, NULL, expr->result);
-    result->prev = tmp;
+uint32_t constant_hash(TokenType type, uint32_t bits, const char *str) { // FNV-1a of the type and value of a literal
+    uint32_t h = (2166136261u ^ (uint32_t) type) * 16777619u;
+    if (str == NULL) {
+        for (int n = 0; n < 4; n++)
+            h = (h ^ ((bits >> (8 * n)) & 0xff)) * 16777619u;
+    }
+    else {
+        for (; *str != '\0'; str++)
+            h = (h ^ (unsigned char) *str) * 16777619u;
+    }
+    return h;
+}
 
-    expr->result = tmp->a.symb;
-    expr->tac = result;
+uint32_t constant_bits(TokenType type, const SymbolValue *value) { // Numbers are compared by their bits, -0.0 isn't 0.0
+    uint32_t bits = 0;
+    if (type == REAL_TOKEN)
+        memcpy(&bits, &value->f, sizeof(bits));
+    else if (type == CHAR_TOKEN)
+        bits = (unsigned char) value->c;
+    else if (type == INT_TOKEN)
+        bits = (uint32_t) value->i;
+    return bits;
+}
 
-    return expr;
+int find_constant(const ConstantPool *pool, TokenType type, const SymbolValue *value, uint32_t *slot) {
+    // Pool index of the literal, -1 when it isn't interned yet (slot is then the empty bucket it would take)
+    if (pool->bucket_count == 0)
+        return -1;
+    const char *str = type == STRING_TOKEN ? value->str : NULL;
+    uint32_t bits = constant_bits(type, value);
+    uint32_t mask = pool->bucket_count - 1;
+    for (uint32_t s = constant_hash(type, bits, str) & mask; ; s = (s + 1) & mask) {
+        int index = pool->buckets[s];
+        if (index < 0) {
+            *slot = s;
+            return -1;
+        }
+        const Symbol *symb = pool->constants[index];
+        if (symb->token_type == type && (str != NULL ? !strcmp(symb->values->str, str) : constant_bits(type, symb->values) == bits))
+            return index;
+    }
 }
 
-ExprNode* tac_binary_op(TacOp op, ExprNode *expr_1, ExprNode *expr_2) {
-    if (expr_1->result->token_type == INT_TOKEN && expr_2->result->token_type == INT_TOKEN) {
-        switch (op) {
-            case TAC_ADD:
-                expr_1->result->values->i = expr_1->result->values->i + expr_2->result->values->i;
-                break;
-            case TAC_SUB:
-                expr_1->result->values->i = expr_1->result->values->i - expr_2->result->values->i;
-                break;
-            case TAC_MULT:
-                expr_1->result->values->i = expr_1->result->values->i * expr_2->result->values->i;
-                break;
-            case TAC_DIV:
-                expr_1->result->values->i = expr_1->result->values->i / expr_2->result->values->i;
-                break;
-            case TAC_MOD:
-                expr_1->result->values->i = expr_1->result->values->i % expr_2->result->values->i;
-                break;
-            case TAC_AND:
-                if (expr_1->result->values->i && expr_2->result->values->i)
-                    expr_1->result->values->i = 1;
-                else
-                    expr_1->result->values->i = 0;
-                break;
-            case TAC_OR:
-                if (expr_1->result->values->i || expr_2->result->values->i)
-                    expr_1->result->values->i = 1;
-                else
-                    expr_1->result->values->i = 0;
-                break;
+int constant_index(const ConstantPool *pool, const Symbol *symb) { // Pool index of a literal symbol, -1 for any other symbol
+    uint32_t slot;
+    if (!is_constant_symbol(symb))
+        return -1;
+    int index = find_constant(pool, symb->token_type, symb->values, &slot);
+    return index >= 0 && pool->constants[index] == symb ? index : -1;
+}
+
+int grow_constant_pool(CompilerContext *ctx, ConstantPool *pool) { // Keeps the buckets at most half full
+    if (pool->count == pool->capacity) {
+        int capacity = pool->capacity == 0 ? BUFFER_SIZE : pool->capacity * 2;
+        Symbol **constants = realloc(pool->constants, capacity * sizeof(Symbol *));
+        if (constants == NULL) {
+            fprintf(ctx->log_fptr, "Error: failed to allocate memory for the constant pool\n");
+            return 0;
         }
-        sprintf(expr_1->result->name, "%d", expr_1->result->values->i);
-        return expr_1;
+        pool->constants = constants;
+        pool->capacity = capacity;
+    }
+    if (2 * (pool->count + 1) <= pool->bucket_count)
+        return 1;
+    int bucket_count = pool->bucket_count == 0 ? 2 * BUFFER_SIZE : 2 * pool->bucket_count;
+    int *buckets = malloc(bucket_count * sizeof(int));
+    if (buckets == NULL) {
+        fprintf(ctx->log_fptr, "Error: failed to allocate memory for the constant pool\n");
+        return 0;
     }
+    memset(buckets, -1, bucket_count * sizeof(int));
+    free(pool->buckets);
+    pool->buckets = buckets;
+    pool->bucket_count = bucket_count;
+    for (int index = 0; index < pool->count; index++) {
+        uint32_t slot;
+        find_constant(pool, pool->constants[index]->token_type, pool->constants[index]->values, &slot);
+        pool->buckets[slot] = index;
+    }
+    return 1;
+}
 
-    if (expr_1->result->token_type == REAL_TOKEN && expr_2 -> result->token_type == REAL_TOKEN) {
-        switch (op) {
-            case TAC_ADD:
-                expr_1->result->values->f = expr_1->result->values->f + expr_2->result->values->f;
-                break;
-            case TAC_SUB:
-                expr_1->result->values->f = expr_1->result->values->f - expr_2->result->values->f;
-                break;
-            case TAC_MULT:
-                expr_1->result->values->f = expr_1->result->values->f * expr_2->result->values->f;
-                break;
-            case TAC_DIV:
-                expr_1->result->values->f = expr_1->result->values->f / expr_2->result->values->f;
-                break;
+Symbol* intern_constant(CompilerContext *ctx, TokenType type, SymbolValue value, const char *name) {
+    // Literal symbol of the value, made (with a copy of its string) only the first time the value is used
+    ConstantPool *pool = &ctx->constants;
+    uint32_t slot;
+    int index = find_constant(pool, type, &value, &slot);
+    if (index >= 0)
+        return pool->constants[index];
+    if (!grow_constant_pool(ctx, pool))
+        return NULL;
+    find_constant(pool, type, &value, &slot); // The buckets may have been rebuilt
+    SymbolValue *new_value = malloc(sizeof(SymbolValue));
+    if (new_value == NULL) {
+        fprintf(ctx->log_fptr, "Error: failed to allocate memory for a constant\n");
+        return NULL;
+    }
+    *new_value = value;
+    if (type == STRING_TOKEN) {
+        new_value->str = malloc(strlen(value.str) + 1);
+        if (new_value->str == NULL) {
+            fprintf(ctx->log_fptr, "Error: failed to allocate memory for a constant\n");
+            free(new_value);
+            return NULL;
         }
-        sprintf(expr_1->result->name, "%f", expr_1->result->values->f);
-        return expr_1;
+        strcpy(new_value->str, value.str);
     }
+    pool->buckets[slot] = pool->count;
+    pool->constants[pool->count] = make_symbol(type == STRING_TOKEN ? new_value->str : name, CONST_TOKEN, type, 0, 0, 1, NULL, new_value);
+    return pool->constants[pool->count++];
+}
 
-    if (expr_1->result->token_type == INT_TOKEN && expr_2->result->token_type == REAL_TOKEN) {
-        expr_1->result->values->f = expr_1->result->values->i;
+void free_constant_pool(ConstantPool *pool) {
+    for (int index = 0; index < pool->count; index++) {
+        Symbol *symb = pool->constants[index];
+        if (symb->token_type == STRING_TOKEN)
+            free(symb->values->str);
+        free(symb->values);
+        free(symb->name);
+        free(symb);
+    }
+    free(pool->constants);
+    free(pool->buckets);
+    memset(pool, 0, sizeof(ConstantPool));
+}
+
+Symbol* make_number(CompilerContext *ctx, TokenType type, int i, float f) {
+    char name[BUFFER_SIZE];
+    SymbolValue value;
+    if (type == REAL_TOKEN) {
+        value.f = f;
+        snprintf(name, sizeof(name), "%g", f);
+    }
+    else {
+        value.i = i;
+        snprintf(name, sizeof(name), "%d", i);
+    }
+    return intern_constant(ctx, type, value, name);
+}
+
+Symbol* make_char_constant(CompilerContext *ctx, char c) {
+    char name[2] = { c, '\0' };
+    SymbolValue value;
+    value.c = c;
+    return intern_constant(ctx, CHAR_TOKEN, value, name);
+}
+
+Symbol* make_string_constant(CompilerContext *ctx, const char *str) {
+    SymbolValue value;
+    value.str = (char *) str;
+    return intern_constant(ctx, STRING_TOKEN, value, str);
+}
+
+Symbol* make_constant(CompilerContext *ctx, TokenType type, const char *token) { // Literal of a value token type
+    if (type == INUM_TOKEN)
+        return make_number(ctx, INT_TOKEN, atoi(token), 0);
+    if (type == RNUM_TOKEN)
+        return make_number(ctx, REAL_TOKEN, 0, atof(token));
+    if (type == CVAL_TOKEN)
+        return make_char_constant(ctx, *token);
+    return make_string_constant(ctx, token);
+}
+
+Symbol* copy_constant(CompilerContext *ctx, const Symbol *symb) { // Named constants and builtins are used through their literal
+    TokenType type = value_type(symb->token_type);
+    if (type == CHAR_TOKEN)
+        return make_char_constant(ctx, symb->values->c);
+    if (type == STRING_TOKEN)
+        return make_string_constant(ctx, symb->values->str);
+    return make_number(ctx, type, symb->values->i, symb->values->f);
+}
+
+Symbol* make_label(CompilerContext *ctx) {
+    char name[BUFFER_SIZE];
+    SymbolValue *new_value = malloc(sizeof(SymbolValue));
+    if (new_value == NULL) {
+        fprintf(ctx->log_fptr, "Error: failed to allocate memory for a label\n");
+        ctx->tac_failed = 1;
+        return NULL;
+    }
+    new_value->i = ctx->label_idx++;
+    snprintf(name, sizeof(name), "L%d", new_value->i);
+    return register_symbol(ctx, make_symbol(name, LABEL_TOKEN, 0, 0, 0, 0, NULL, new_value));
+}
+
+ExprNode* make_node(CompilerContext *ctx, Symbol *symb) { // Returns NULL when no intermediate code is generated
+    if (ctx->options.syntax_only || symb == NULL)
+        return NULL;
+    ExprNode *new_node = malloc(sizeof(ExprNode));
+    new_node->next = NULL;
+    new_node->tac = empty_tac();
+    new_node->result = symb;
+    new_node->temp = NO_TEMP;
+    if (is_constant_symbol(symb) || symbol_builtin_lookup(symb->name) == symb)
+        new_node->result = copy_constant(ctx, symb);
+
+    new_node->array = NULL;
+    new_node->offset = NULL;
+    new_node->dim = 0;
+    return new_node;
+}
+
+void free_node(ExprNode *node) { // The code and symbols of the node belong to the compiler context
+    free(node);
+}
+
+TacList tac_declare(CompilerContext *ctx, Symbol *symb) {
+    if (ctx->options.syntax_only)
+        return empty_tac();
+    return single_tac(make_tac(ctx, TAC_VAR, symb, NULL, NULL));
+}
+
+TacList tac_assign(CompilerContext *ctx, Symbol *symb, ExprNode *expr)  {
+    if (expr == NULL)
+        return empty_tac();
+    if (symb->declaration_type != VAR_TOKEN && symb->declaration_type != FUNCTION_TOKEN) { // Function result variable
+        fprintf(ctx->log_fptr, "Error: assignment to non-variable at line %d\n", symb->line);
+        free_node(expr);
+        return empty_tac();
+    }
+
+    Tac *copy = make_tac(ctx, TAC_CPY, symb, NULL, NULL);
+    set_node_operand(copy, 1, expr);
+    TacList code = join_tac(expr->tac, single_tac(copy));
+    free_node(expr);
+    return code;
+}
+
+Symbol* fold_unary_op(CompilerContext *ctx, TacOp op, const Symbol *symb) { // Returns NULL when the operation can't be folded
+    if (!is_constant_symbol(symb) || !is_number_type(symb->token_type))
+        return NULL;
+    if (symb->token_type == INT_TOKEN) {
         switch (op) {
-            case TAC_ADD:
-                expr_1->result->values->f = expr_1->result->values->f + expr_2->result->values->f;
-                break;
-            case TAC_SUB:
-                expr_1->result->values->f = expr_1->result->values->f - expr_2->result->values->f;
-                break;
-            case TAC_MULT:
-                expr_1->result->values->f = expr_1->result->values->f * expr_2->result->values->f;
-                break;
-            case TAC_DIV:
-                expr_1->result->values->f = expr_1->result->values->f / expr_2->result->values->f;
-                break;
+            case TAC_POS:
+                return make_number(ctx, INT_TOKEN, symb->values->i, 0);
+            case TAC_NEG:
+                return make_number(ctx, INT_TOKEN, (int) (0u - (unsigned) symb->values->i), 0);
+            case TAC_NOT:
+                return make_number(ctx, INT_TOKEN, symb->values->i == 0, 0);
+            default:
+                return NULL;
         }
-        sprintf(expr_1->result->name, "%f", expr_1->result->values->f);
-        return expr_1;
     }
+    switch (op) {
+        case TAC_POS:
+            return make_number(ctx, REAL_TOKEN, 0, symb->values->f);
+        case TAC_NEG:
+            return make_number(ctx, REAL_TOKEN, 0, -symb->values->f);
+        default:
+            return NULL;
+    }
+}
 
-    if (expr_1->result->token_type = REAL_TOKEN && expr_2->result->token_type == INT_TOKEN) {
-        expr_2->result->values->f = expr_2->result->values->i;
+Symbol* fold_binary_op(CompilerContext *ctx, TacOp op, const Symbol *symb_1, const Symbol *symb_2) {
+    // Returns NULL when the operation can't be folded, integers wrap around like they do at run time
+    if (!is_constant_symbol(symb_1) || !is_constant_symbol(symb_2) || !is_number_type(symb_1->token_type) || !is_number_type(symb_2->token_type))
+        return NULL;
+    if (symb_1->token_type == INT_TOKEN && symb_2->token_type == INT_TOKEN) {
+        int x = symb_1->values->i, y = symb_2->values->i;
         switch (op) {
             case TAC_ADD:
-                expr_1->result->values->f = expr_1->result->values->f + expr_2->result->values->f;
-                break;
+                return make_number(ctx, INT_TOKEN, (int) ((unsigned) x + (unsigned) y), 0);
             case TAC_SUB:
-                expr_1->result->values->f = expr_1->result->values->f - expr_2->result->values->f;
-                break;
+                return make_number(ctx, INT_TOKEN, (int) ((unsigned) x - (unsigned) y), 0);
             case TAC_MULT:
-                expr_1->result->values->f = expr_1->result->values->f * expr_2->result->values->f;
-                break;
+                return make_number(ctx, INT_TOKEN, (int) ((unsigned) x * (unsigned) y), 0);
             case TAC_DIV:
-                expr_1->result->values->f = expr_1->result->values->f / expr_2->result->values->f;
-                break;
+                if (y == 0 || (y == -1 && x == (int) 0x80000000u)) // Left to the run time
+                    return NULL;
+                return make_number(ctx, INT_TOKEN, x / y, 0);
+            case TAC_MOD:
+                if (y == 0 || (y == -1 && x == (int) 0x80000000u))
+                    return NULL;
+                return make_number(ctx, INT_TOKEN, x % y, 0);
+            case TAC_AND:
+                return make_number(ctx, INT_TOKEN, x && y, 0);
+            case TAC_OR:
+                return make_number(ctx, INT_TOKEN, x || y, 0);
+            case TAC_LT:
+                return make_number(ctx, INT_TOKEN, x < y, 0);
+            case TAC_GT:
+                return make_number(ctx, INT_TOKEN, x > y, 0);
+            case TAC_NEQ:
+                return make_number(ctx, INT_TOKEN, x != y, 0);
+            case TAC_LTE:
+                return make_number(ctx, INT_TOKEN, x <= y, 0);
+            case TAC_GTE:
+                return make_number(ctx, INT_TOKEN, x >= y, 0);
+            case TAC_EQ:
+                return make_number(ctx, INT_TOKEN, x == y, 0);
+            default:
+                return NULL;
         }
-        sprintf(expr_1->result->name, "%f", expr_1->result->values->f);
-        return expr_1;
     }
+    float x = symb_1->token_type == REAL_TOKEN ? symb_1->values->f : symb_1->values->i;
+    float y = symb_2->token_type == REAL_TOKEN ? symb_2->values->f : symb_2->values->i;
+    switch (op) {
+        case TAC_ADD:
+            return make_number(ctx, REAL_TOKEN, 0, x + y);
+        case TAC_SUB:
+            return make_number(ctx, REAL_TOKEN, 0, x - y);
+        case TAC_MULT:
+            return make_number(ctx, REAL_TOKEN, 0, x * y);
+        case TAC_DIV:
+            if (y == 0)
+                return NULL;
+            return make_number(ctx, REAL_TOKEN, 0, x / y);
+        case TAC_LT:
+            return make_number(ctx, INT_TOKEN, x < y, 0);
+        case TAC_GT:
+            return make_number(ctx, INT_TOKEN, x > y, 0);
+        case TAC_NEQ:
+            return make_number(ctx, INT_TOKEN, x != y, 0);
+        case TAC_LTE:
+            return make_number(ctx, INT_TOKEN, x <= y, 0);
+        case TAC_GTE:
+            return make_number(ctx, INT_TOKEN, x >= y, 0);
+        case TAC_EQ:
+            return make_number(ctx, INT_TOKEN, x == y, 0);
+        default:
+            return NULL;
+    }
+}
 
-    Symbol *tmp_symb = make_symbol(NULL, 0, 0, 0, 0, 0, NULL, NULL);
+TokenType result_type(TacOp op, TokenType type_1, TokenType type_2) {
+    if (op == TAC_AND || op == TAC_OR || op == TAC_NOT || (op >= TAC_LT && op <= TAC_EQ))
+        return INT_TOKEN;
+    if (type_1 == STRING_TOKEN || type_2 == STRING_TOKEN || type_1 == CHAR_TOKEN || type_2 == CHAR_TOKEN)
+        return STRING_TOKEN;
+    if (type_1 == REAL_TOKEN || type_2 == REAL_TOKEN)
+        return REAL_TOKEN;
+    return INT_TOKEN;
+}
 
-    Tac *tmp = make_tac(TAC_VAR, tmp_symb, NULL, NULL);
-    tmp->prev = join_tac(expr_1->tac, expr_2->tac);
-    Tac *result = make_tac(op, tmp->a.symb, expr_2->result, expr_1->result);
-    result->prev = tmp;
+ExprNode* tac_unary_op(CompilerContext *ctx, TacOp op, ExprNode *expr) {
+    if (expr == NULL)
+        return NULL;
+    Symbol *folded = fold_unary_op(ctx, op, expr->result);
+    if (folded != NULL) {
+        expr->result = folded;
+        return expr;
+    }
 
-    expr_1->result = tmp->a.symb;
-    expr_1->tac = result;
+    TokenType type = node_type(ctx, expr);
+    Tac *operation = make_tac(ctx, op, NULL, NULL, NULL);
+    set_node_operand(operation, 1, expr);
+    set_temp_result(operation, expr, make_temp(ctx, result_type(op, type, type)));
+    expr->tac = join_tac(expr->tac, single_tac(operation));
 
-    return expr_1;
+    return expr;
 }
 
-ExprNode* tac_relation_op(TacOp op, ExprNode *expr_1, ExprNode *expr_2) {
-    if (expr_1->result->declaration_type == CONST_TOKEN && expr_2->result->declaration_type == CONST_TOKEN) {
-        if (expr_1->result->token_type == INT_TOKEN && expr_2->result->token_type == INT_TOKEN) {
-            switch (op) {
-                case TAC_EQ: {
-                    expr_1->result->values->i = (expr_1->result->values->i == expr_2->result->values->i);
-                    break;
-                }
-                case TAC_NEQ: {
-                    expr_1->result->values->i = (expr_1->result->values->i != expr_2->result->values->i);
-                    break;
-                }
-                case TAC_LT: {
-                    expr_1->result->values->i = (expr_1->result->values->i < expr_2->result->values->i);
-                    break;
-                }
-                case TAC_LTE: {
-                    expr_1->result->values->i = (expr_1->result->values->i <= expr_2->result->values->i);
-                    break;
-                }
-                case TAC_GT: {
-                    expr_1->result->values->i = (expr_1->result->values->i > expr_2->result->values->i);
-                    break;
-                }
-                case TAC_GTE: {
-                    expr_1->result->values->i = (expr_1->result->values->i >= expr_2->result->values->i);
-                    break;
-                }
-            }
-            sprintf(expr_1->result->name, "%d", expr_1->result->values->i);
-            return expr_1;
-        }
-        if (expr_1->result->token_type == REAL_TOKEN && expr_2->result->token_type == REAL_TOKEN) {
-            switch (op) {
-                case TAC_EQ: {
-                    expr_1->result->values->f = (expr_1->result->values->f == expr_2->result->values->f);
-                    break;
-                }
-                case TAC_NEQ: {
-                    expr_1->result->values->f = (expr_1->result->values->f != expr_2->result->values->f);
-                    break;
-                }
-                case TAC_LT: {
-                    expr_1->result->values->f = (expr_1->result->values->f < expr_2->result->values->f);
-                    break;
-                }
-                case TAC_LTE: {
-                    expr_1->result->values->f = (expr_1->result->values->f <= expr_2->result->values->f);
-                    break;
-                }
-                case TAC_GT: {
-                    expr_1->result->values->f = (expr_1->result->values->f > expr_2->result->values->f);
-                    break;
-                }
-                case TAC_GTE: {
-                    expr_1->result->values->f = (expr_1->result->values->f >= expr_2->result->values->f);
-                    break;
-                }
-            }
-            sprintf(expr_1->result->name, "%f", expr_1->result->values->f);
-            return expr_1;
-        }
-        if (expr_1->result->token_type == REAL_TOKEN && expr_2->result->token_type == INT_TOKEN) {
-            expr_2->result->values->f = expr_2->result->values->i;
-            switch (op) {
-                case TAC_EQ: {
-                    expr_1->result->values->f = (expr_1->result->values->f == expr_2->result->values->f);
-                    break;
-                }
-                case TAC_NEQ: {
-                    expr_1->result->values->f = (expr_1->result->values->f != expr_2->result->values->f);
-                    break;
-                }
-                case TAC_LT: {
-                    expr_1->result->values->f = (expr_1->result->values->f < expr_2->result->values->f);
-                    break;
-                }
-                case TAC_LTE: {
-                    expr_1->result->values->f = (expr_1->result->values->f <= expr_2->result->values->f);
-                    break;
-                }
-                case TAC_GT: {
-                    expr_1->result->values->f = (expr_1->result->values->f > expr_2->result->values->f);
-                    break;
-                }
-                case TAC_GTE: {
-                    expr_1->result->values->f = (expr_1->result->values->f >= expr_2->result->values->f);
-                    break;
-                }
-            }
-            sprintf(expr_1->result->name, "%f", expr_1->result->values->f);
-            return expr_1;
-        }
-        if (expr_1->result->token_type == INT_TOKEN && expr_2->result->token_type == REAL_TOKEN) {
-            expr_1->result->values->f = expr_1->result->values->i;
-            switch (op) {
-                case TAC_EQ: {
-                    expr_1->result->values->f = (expr_1->result->values->f == expr_2->result->values->f);
-                    break;
-                }
-                case TAC_NEQ: {
-                    expr_1->result->values->f = (expr_1->result->values->f != expr_2->result->values->f);
-                    break;
-                }
-                case TAC_LT: {
-                    expr_1->result->values->f = (expr_1->result->values->f < expr_2->result->values->f);
-                    break;
-                }
-                case TAC_LTE: {
-                    expr_1->result->values->f = (expr_1->result->values->f <= expr_2->result->values->f);
-                    break;
-                }
-                case TAC_GT: {
-                    expr_1->result->values->f = (expr_1->result->values->f > expr_2->result->values->f);
-                    break;
-                }
-                case TAC_GTE: {
-                    expr_1->result->values->f = (expr_1->result->values->f >= expr_2->result->values->f);
-                    break;
-                }
-            }
-            sprintf(expr_1->result->name, "%f", expr_1->result->values->f);
-            return expr_1;
-        }
+ExprNode* tac_binary_op(CompilerContext *ctx, TacOp op, ExprNode *expr_1, ExprNode *expr_2) {
+    // expr_1 = expr_1 op expr_2, expr_2 is freed
+    if (expr_1 == NULL || expr_2 == NULL) {
+        free_node(expr_2);
+        return expr_1;
+    }
+    Symbol *folded = fold_binary_op(ctx, op, expr_1->result, expr_2->result);
+    if (folded != NULL) {
+        expr_1->result = folded;
+        free_node(expr_2);
+        return expr_1;
     }
 
-    Symbol *tmp_symb = make_symbol(NULL, 0, 0, 0, 0, 0, NULL, NULL);
-
-    Tac *tmp = make_tac(TAC_VAR, tmp_symb, NULL, NULL);
-    tmp->prev = join_tac(expr_1->tac, expr_2->tac);
-    Tac *result = make_tac(op, tmp->a.symb, expr_2->result, expr_1->result);
-    result->prev = tmp;
-
-    expr_1->result = tmp->a.symb;
-    expr_1->tac = result;
+    Tac *operation = make_tac(ctx, op, NULL, NULL, NULL);
+    set_node_operand(operation, 1, expr_1);
+    set_node_operand(operation, 2, expr_2);
+    set_temp_result(operation, expr_1, make_temp(ctx, result_type(op, node_type(ctx, expr_1), node_type(ctx, expr_2))));
+    expr_1->tac = join_tac(join_tac(expr_1->tac, expr_2->tac), single_tac(operation));
+    free_node(expr_2);
 
     return expr_1;
 }
 
-Symbol* make_label(int value) {
-    SymbolValue *new_value = malloc(sizeof(SymbolValue));
-    new_value->i = label_idx;
-    Symbol *new_label = make_symbol(NULL, 0, LABEL_TOKEN, 0, 0, 0, NULL, new_value);
+ExprNode* tac_relation_op(CompilerContext *ctx, TacOp op, ExprNode *expr_1, ExprNode *expr_2) {
+    return tac_binary_op(ctx, op, expr_1, expr_2);
+}
 
-    return new_label;
+ExprNode* tac_call(CompilerContext *ctx, Symbol *routine, ExprNode *args) {
+    // Arguments are all evaluated before being pushed, a procedure call has no result
+    if (ctx->options.syntax_only)
+        return NULL;
+    TacList code = empty_tac();
+    for (ExprNode *arg = args; arg != NULL; arg = arg->next)
+        code = join_tac(code, arg->tac);
+    while (args != NULL) {
+        ExprNode *to_free = args;
+        Tac *arg = make_tac(ctx, TAC_ARG, NULL, NULL, NULL);
+        set_node_operand(arg, 0, args);
+        code = join_tac(code, single_tac(arg));
+        args = args->next;
+        free_node(to_free);
+    }
+    Tac *call_tac = make_tac(ctx, TAC_CALL, NULL, routine, NULL);
+    ExprNode *call = malloc(sizeof(ExprNode));
+    call->next = NULL;
+    call->result = NULL;
+    call->temp = NO_TEMP;
+    if (routine->declaration_type == FUNCTION_TOKEN)
+        set_temp_result(call_tac, call, make_temp(ctx, routine->token_type));
+    call->tac = join_tac(code, single_tac(call_tac));
+    call->array = NULL;
+    call->offset = NULL;
+    call->dim = 0;
+    return call;
 }
 
-Tac* tac_program(Symbol *func, Symbol *args, Tac *code) {
-    Tac *label = make_tac(TAC_LABEL, make_label(label_idx++), NULL, NULL);
-    Tac *begin = make_tac(TAC_BEGINPROC, func, NULL, NULL);
-    Tac *end = make_tac(TAC_ENDPROC, NULL, NULL, NULL);
-    Tac *arg_list = make_tac(TAC_ARGLIST, args, NULL, NULL);
+TacList tac_function(CompilerContext *ctx, Symbol *func, Symbol *result, TacList declarations, TacList code) {
+    if (ctx->options.syntax_only)
+        return empty_tac();
+    TacList begin = single_tac(make_tac(ctx, TAC_BEGINFUNC, func, NULL, NULL));
+    begin = join_tac(begin, single_tac(make_tac(ctx, TAC_VAR, result, NULL, NULL)));
+    code = join_tac(join_tac(begin, declarations), code);
+    return join_tac(code, single_tac(make_tac(ctx, TAC_ENDFUNC, result, NULL, NULL)));
+}
 
-    begin->prev = label;
-    code = join_tac(arg_list, code);
-    end->prev = join_tac(begin, code);
+TacList tac_procedure(CompilerContext *ctx, Symbol *proc, TacList declarations, TacList code) {
+    if (ctx->options.syntax_only)
+        return empty_tac();
+    code = join_tac(join_tac(single_tac(make_tac(ctx, TAC_BEGINPROC, proc, NULL, NULL)), declarations), code);
+    return join_tac(code, single_tac(make_tac(ctx, TAC_ENDPROC, proc, NULL, NULL)));
+}
 
-    return end;
+TacList tac_program(CompilerContext *ctx, TacList initializations, TacList code) {
+    if (ctx->options.syntax_only)
+        return empty_tac();
+    code = join_tac(join_tac(single_tac(make_tac(ctx, TAC_BEGINPROG, NULL, NULL, NULL)), initializations), code);
+    return join_tac(code, single_tac(make_tac(ctx, TAC_ENDPROG, NULL, NULL, NULL)));
 }
 
-ExprNode *tac_function(Symbol *func, ExprNode *args) {
+TacList tac_if(CompilerContext *ctx, ExprNode *expr, TacList statement) {
+    if (expr == NULL)
+        return empty_tac();
+    Symbol *end_label = make_label(ctx);
+    Tac *jump = make_tac(ctx, TAC_IFZ, end_label, NULL, NULL);
+    set_node_operand(jump, 1, expr);
+    TacList code = join_tac(expr->tac, single_tac(jump));
+    free_node(expr);
 
+    code = join_tac(code, statement);
+    return join_tac(code, single_tac(make_tac(ctx, TAC_LABEL, end_label, NULL, NULL)));
 }
 
-ExprNode *tac_procedure(Symbol *proc, ExprNode *args) {
-    
+TacList tac_if_else(CompilerContext *ctx, ExprNode *expr, TacList statement, TacList else_statement) {
+    if (expr == NULL)
+        return empty_tac();
+    Symbol *else_label = make_label(ctx);
+    Symbol *end_label = make_label(ctx);
+    Tac *jump = make_tac(ctx, TAC_IFZ, else_label, NULL, NULL);
+    set_node_operand(jump, 1, expr);
+    TacList code = join_tac(expr->tac, single_tac(jump));
+    free_node(expr);
+
+    code = join_tac(code, statement);
+    code = join_tac(code, single_tac(make_tac(ctx, TAC_GOTO, end_label, NULL, NULL)));
+    code = join_tac(code, single_tac(make_tac(ctx, TAC_LABEL, else_label, NULL, NULL)));
+    code = join_tac(code, else_statement);
+    return join_tac(code, single_tac(make_tac(ctx, TAC_LABEL, end_label, NULL, NULL)));
 }
 
-Tac* tac_if(ExprNode *expr, Tac *statement) {
-    Tac *label = make_tac(TAC_LABEL, make_label(label_idx++), NULL, NULL);
-    Tac *code = make_tac(TAC_IFZ, label->a.symb, expr->result, NULL);
+TacList tac_while(CompilerContext *ctx, ExprNode *expr, TacList statement) {
+    if (expr == NULL)
+        return empty_tac();
+    Symbol *start_label = make_label(ctx);
+    TacList code = single_tac(make_tac(ctx, TAC_LABEL, start_label, NULL, NULL));
 
-    code->prev = expr->tac;
-    code = join_tac(code, statement);
-    label->prev = code;
+    statement = join_tac(statement, single_tac(make_tac(ctx, TAC_GOTO, start_label, NULL, NULL)));
+    return join_tac(code, tac_if(ctx, expr, statement));
+}
+
+TacList tac_for(CompilerContext *ctx, Symbol *symb, ExprNode *start, ExprNode *limit, int downto, TacList statement) {
+    // The limit is evaluated once before the loop, the loop variable is then incremented (decremented) until it passes it
+    if (start == NULL || limit == NULL) {
+        free_node(start);
+        free_node(limit);
+        return empty_tac();
+    }
+    TacList code = join_tac(tac_assign(ctx, symb, start), limit->tac);
+    limit->tac = empty_tac(); // The node is then the limit operand of the condition
+    if (limit->temp == NO_TEMP && !is_constant_symbol(limit->result)) { // The statement could modify a variable limit
+        Tac *copy = make_tac(ctx, TAC_CPY, NULL, limit->result, NULL);
+        set_temp_result(copy, limit, make_temp(ctx, limit->result->token_type));
+        code = join_tac(code, single_tac(copy));
+    }
 
-    return label;
+    ExprNode *condition = tac_relation_op(ctx, downto ? TAC_GTE : TAC_LTE, make_node(ctx, symb), limit);
+    ExprNode *step = tac_binary_op(ctx, downto ? TAC_SUB : TAC_ADD, make_node(ctx, symb), make_node(ctx, make_number(ctx, INT_TOKEN, 1, 0)));
+    statement = join_tac(statement, tac_assign(ctx, symb, step));
+    return join_tac(code, tac_while(ctx, condition, statement));
 }
 
-Tac* tac_while(ExprNode *expr, Tac *statement) {
-    Tac *label = make_tac(TAC_LABEL, make_label(label_idx++), NULL, NULL);
-    Tac *code = make_tac(TAC_GOTO, label->a.symb, NULL, NULL);
+TacList tac_print(CompilerContext *ctx, ExprNode *expr, ExprNode *width, ExprNode *precision) {
+    // Width and precision are NULL when the value has none
+    if (expr == NULL) {
+        free_node(width);
+        free_node(precision);
+        return empty_tac();
+    }
+    Tac *print = make_tac(ctx, TAC_PRINT, NULL, NULL, NULL);
+    set_node_operand(print, 0, expr);
+    TacList code = expr->tac;
+    free_node(expr);
+    if (width != NULL) {
+        set_node_operand(print, 1, width);
+        code = join_tac(code, width->tac);
+        free_node(width);
+    }
+    if (precision != NULL) {
+        set_node_operand(print, 2, precision);
+        code = join_tac(code, precision->tac);
+        free_node(precision);
+    }
+    return join_tac(code, single_tac(print));
+}
 
-    code->prev = statement;
-    return join_tac(label, tac_if(expr, code));
+TacList tac_println(CompilerContext *ctx) {
+    if (ctx->options.syntax_only)
+        return empty_tac();
+    return single_tac(make_tac(ctx, TAC_PRINTLN, NULL, NULL, NULL));
 }
 
-Tac* tac_print(ExprNode *expr) {
-    Tac *code;
+TacList tac_read(CompilerContext *ctx, Symbol *symb) {
+    if (ctx->options.syntax_only)
+        return empty_tac();
+    return single_tac(make_tac(ctx, TAC_READ, symb, NULL, NULL));
+}
 
-    code = make_tac(TAC_PRINT, expr->result, NULL, NULL);
-    code->prev = expr->tac;
+TacList tac_readln(CompilerContext *ctx) {
+    if (ctx->options.syntax_only)
+        return empty_tac();
+    return single_tac(make_tac(ctx, TAC_READLN, NULL, NULL, NULL));
+}
 
-    return code;
-}
\ No newline at end of file
+const char* operator_name(TacOp op) {
+    switch (op) {
+        case TAC_ADD: case TAC_POS:
+            return "+";
+        case TAC_SUB: case TAC_NEG:
+            return "-";
+        case TAC_MULT:
+            return "*";
+        case TAC_DIV:
+            return "/";
+        case TAC_MOD:
+            return "mod";
+        case TAC_AND:
+            return "and";
+        case TAC_OR:
+            return "or";
+        case TAC_NOT:
+            return "not ";
+        case TAC_LT:
+            return "<";
+        case TAC_GT:
+            return ">";
+        case TAC_NEQ:
+            return "<>";
+        case TAC_LTE:
+            return "<=";
+        case TAC_GTE:
+            return ">=";
+        case TAC_EQ:
+            return "=";
+        default:
+            return "";
+    }
+}
@@ -1,50 +1,135 @@
 #ifndef TAC_H
 #define TAC_H
 
+#include <stdio.h>
+#include <stdint.h>
+
 #include "symbol_table.h"
 
+#define TAC_BLOCK_SIZE 256 // Number of instructions allocated at once
+
 typedef enum {
     TAC_UNDEF = 1, TAC_ADD, TAC_SUB, TAC_MULT, TAC_DIV, TAC_POS, TAC_NEG, TAC_CPY, TAC_GOTO, TAC_IFZ, TAC_IFNZ, TAC_MOD, TAC_AND, TAC_OR, TAC_NOT,
     TAC_LT, TAC_GT, TAC_NEQ, TAC_LTE, TAC_GTE, TAC_EQ, TAC_VAR, TAC_LABEL, TAC_PRINT, TAC_BEGINFUNC, TAC_ENDFUNC, TAC_ARGLIST, TAC_BEGINPROC,
-    TAC_ENDPROC, TAC_BEGINPROG, TAC_ENDPROG
+    TAC_ENDPROC, TAC_BEGINPROG, TAC_ENDPROG, TAC_PRINTLN, TAC_ARG, TAC_CALL, TAC_READ, TAC_READLN
 } TacOp;
 
+// Operands of each instruction:
+//  a = b op c          TAC_ADD ... TAC_DIV, TAC_MOD, TAC_AND, TAC_OR, TAC_LT ... TAC_EQ
+//  a = op b            TAC_POS, TAC_NEG, TAC_NOT
+//  a = b               TAC_CPY
+//  goto a              TAC_GOTO (a is a label symbol)
+//  ifz b goto a        TAC_IFZ, TAC_IFNZ
+//  a:                  TAC_LABEL
+//  var a               TAC_VAR (a global variable before the first routine, a local one inside a routine)
+//  print a:b:c         TAC_PRINT (b is the width and c the decimals of a real, NULL when not given), TAC_PRINTLN has none
+//  read a              TAC_READ (a is the variable read), TAC_READLN has none and skips the rest of the line
+//  arg a               TAC_ARG (arguments of the following call, in order)
+//  a = call b          TAC_CALL (a is NULL when calling a procedure)
+//  begin a / end a     TAC_BEGINFUNC / TAC_BEGINPROC (a is the routine), TAC_ENDFUNC (a is the result variable), TAC_ENDPROC
+//  begin / end         TAC_BEGINPROG / TAC_ENDPROG (main block)
+// Literals have the declaration type CONST_TOKEN and labels LABEL_TOKEN, temporaries are numbered virtual registers
+// whose type is the only thing stored (in the compiler context)
+
+#define NO_TEMP -1
+#define TEMP_A 1 // Flags of the operands holding a temporary number instead of a symbol
+#define TEMP_B 2
+#define TEMP_C 4
+
+typedef union _TacOperand {
+    Symbol *symb;
+    struct _Tac *label;
+    int temp;
+} TacOperand;
+
 typedef struct _Tac {
     struct _Tac *prev;
     struct _Tac *next;
     TacOp op;
+    uint8_t temps; // TEMP_A, TEMP_B and TEMP_C flags
 
-    union {
-        Symbol *symb;
-        struct _Tac *label;
-    } a;
+    TacOperand a;
+    TacOperand b;
+    TacOperand c;
+} Tac;
 
-    union {
-        Symbol *symb;
-        struct _Tac *label;
-    } b;
+typedef struct _TacList { // First and last instructions of a code sequence, joining two sequences doesn't walk any of them
+    Tac *head;
+    Tac *tail;
+} TacList;
 
-    union {
-        Symbol *symb;
-        struct _Tac *label;
-    } c;
-} Tac;
+typedef struct _TacBlock { // Instructions are allocated by blocks and all freed at once with the compilation
+    struct _TacBlock *next;
+    int used;
+    Tac tacs[TAC_BLOCK_SIZE];
+} TacBlock;
+
+typedef struct _TacMark { // Allocation state of the intermediate code, everything allocated after it can be released
+    TacBlock *block;
+    int used;
+    Symbol *ir_symbols;
+    int temp_count;
+} TacMark;
+
+typedef struct _ConstantPool { // Literals of the compilation, equal literals are interned as a single symbol
+    Symbol **constants; // By pool index
+    int count, capacity;
+    int *buckets; // Open addressing table of pool indexes (-1 when empty)
+    int bucket_count;
+} ConstantPool;
 
 typedef struct _ExprNode {
     struct _ExprNode *next;
-    Tac *tac;
-    Symbol *result;
+    TacList tac;
+    Symbol *result; // NULL when the result is a temporary
+    int temp; // Temporary holding the result, NO_TEMP when it is the result symbol
 
     Symbol *array;
     Symbol *offset;
     int dim;
 } ExprNode;
 
-Tac* make_tac(TacOp, Symbol *, Symbol *, Symbol *);
-Tac* join_tac(Tac *, Tac *);
-Tac* tac_program(Symbol *, Symbol *, Tac *);
-Tac* tac_declare(Symbol *);
+Tac* make_tac(CompilerContext *, TacOp, Symbol *, Symbol *, Symbol *);
+TacList empty_tac();
+TacList single_tac(Tac *);
+TacList join_tac(TacList, TacList);
+void free_tac_blocks(CompilerContext *);
+void free_tac(CompilerContext *);
+TacMark mark_tac(CompilerContext *);
+void release_tac(CompilerContext *, TacMark);
+const char* operator_name(TacOp);
+
+TokenType value_type(TokenType);
+int is_constant_symbol(const Symbol *);
+Symbol* register_symbol(CompilerContext *, Symbol *);
+int make_temp(CompilerContext *, TokenType);
+int constant_index(const ConstantPool *, const Symbol *);
+void free_constant_pool(ConstantPool *);
+Symbol* make_constant(CompilerContext *, TokenType, const char *);
+Symbol* make_number(CompilerContext *, TokenType, int, float);
+Symbol* fold_unary_op(CompilerContext *, TacOp, const Symbol *);
+Symbol* fold_binary_op(CompilerContext *, TacOp, const Symbol *, const Symbol *);
+
+ExprNode* make_node(CompilerContext *, Symbol *);
+TokenType node_type(CompilerContext *, const ExprNode *);
+void free_node(ExprNode *);
 
-Tac *program_tac;
+TacList tac_declare(CompilerContext *, Symbol *);
+TacList tac_assign(CompilerContext *, Symbol *, ExprNode *);
+ExprNode* tac_unary_op(CompilerContext *, TacOp, ExprNode *);
+ExprNode* tac_binary_op(CompilerContext *, TacOp, ExprNode *, ExprNode *);
+ExprNode* tac_relation_op(CompilerContext *, TacOp, ExprNode *, ExprNode *);
+ExprNode* tac_call(CompilerContext *, Symbol *, ExprNode *);
+TacList tac_function(CompilerContext *, Symbol *, Symbol *, TacList, TacList);
+TacList tac_procedure(CompilerContext *, Symbol *, TacList, TacList);
+TacList tac_program(CompilerContext *, TacList, TacList);
+TacList tac_if(CompilerContext *, ExprNode *, TacList);
+TacList tac_if_else(CompilerContext *, ExprNode *, TacList, TacList);
+TacList tac_while(CompilerContext *, ExprNode *, TacList);
+TacList tac_for(CompilerContext *, Symbol *, ExprNode *, ExprNode *, int, TacList);
+TacList tac_print(CompilerContext *, ExprNode *, ExprNode *, ExprNode *);
+TacList tac_println(CompilerContext *);
+TacList tac_read(CompilerContext *, Symbol *);
+TacList tac_readln(CompilerContext *);
 
 #endif
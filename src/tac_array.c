@@ -0,0 +1,449 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "scanner.h"
+#include "symbol_table.h"
+#include "tac.h"
+#include "tac_array.h"
+
+int grow_array(FILE *log_fptr, void **array, int *capacity, int count, size_t element_size) { // Doubles the capacity once the array is full
+    if (count < *capacity)
+        return 1;
+    int new_capacity = *capacity == 0 ? BUFFER_SIZE : *capacity * 2;
+    void *new_array = realloc(*array, new_capacity * element_size);
+    if (new_array == NULL) {
+        fprintf(log_fptr, "Error: failed to reallocate more memory to the intermediate code\n");
+        return 0;
+    }
+    *array = new_array;
+    *capacity = new_capacity;
+    return 1;
+}
+
+TacArray* make_tac_array(FILE *log_fptr) {
+    TacArray *code = calloc(1, sizeof(TacArray));
+    if (code == NULL)
+        fprintf(log_fptr, "Error: failed to allocate memory for the intermediate code\n");
+    else
+        code->log_fptr = log_fptr;
+    return code;
+}
+
+void free_tac_array(TacArray *code) {
+    if (code != NULL) {
+        free(code->ops);
+        free(code->a);
+        free(code->b);
+        free(code->c);
+        free(code->symbols);
+        free(code->temp_types);
+        free(code->labels);
+        free(code);
+    }
+}
+
+int push_tac(TacArray *code, TacOp op, Operand a, Operand b, Operand c) { // Returns the index of the new instruction or -1
+    if (code->tac_count >= code->tac_capacity) {
+        int capacity = code->tac_capacity;
+        if (!grow_array(code->log_fptr, (void **) &code->ops, &capacity, code->tac_count, sizeof(uint8_t)))
+            return -1;
+        capacity = code->tac_capacity;
+        if (!grow_array(code->log_fptr, (void **) &code->a, &capacity, code->tac_count, sizeof(Operand)))
+            return -1;
+        capacity = code->tac_capacity;
+        if (!grow_array(code->log_fptr, (void **) &code->b, &capacity, code->tac_count, sizeof(Operand)))
+            return -1;
+        capacity = code->tac_capacity;
+        if (!grow_array(code->log_fptr, (void **) &code->c, &capacity, code->tac_count, sizeof(Operand)))
+            return -1;
+        code->tac_capacity = capacity;
+    }
+    code->ops[code->tac_count] = op;
+    code->a[code->tac_count] = a;
+    code->b[code->tac_count] = b;
+    code->c[code->tac_count] = c;
+    return code->tac_count++;
+}
+
+int splice_code(TacArray *code, int start, int end, int pushed_start, const int *order, int count) {
+    // Replaces the instructions between start and end (both excluded) by the ones listed in order, taken from the routine
+    // or from the instructions pushed since pushed_start, that are dropped from the end of the code; returns the new end
+    uint8_t *ops = malloc((count > 0 ? count : 1) * sizeof(uint8_t));
+    Operand *operands = malloc((count > 0 ? 3 * count : 1) * sizeof(Operand));
+    if (ops == NULL || operands == NULL) {
+        fprintf(code->log_fptr, "Error: failed to allocate memory to reorder the intermediate code\n");
+        free(ops);
+        free(operands);
+        code->tac_count = pushed_start;
+        return end;
+    }
+    for (int k = 0; k < count; k++) {
+        ops[k] = code->ops[order[k]];
+        operands[3 * k] = code->a[order[k]];
+        operands[3 * k + 1] = code->b[order[k]];
+        operands[3 * k + 2] = code->c[order[k]];
+    }
+    int shift = count - (end - start - 1); // Room taken by the pushed instructions, they are at most as many
+    if (shift != 0) {
+        memmove(code->ops + end + shift, code->ops + end, (pushed_start - end) * sizeof(uint8_t));
+        memmove(code->a + end + shift, code->a + end, (pushed_start - end) * sizeof(Operand));
+        memmove(code->b + end + shift, code->b + end, (pushed_start - end) * sizeof(Operand));
+        memmove(code->c + end + shift, code->c + end, (pushed_start - end) * sizeof(Operand));
+        for (int l = 0; l < code->label_count; l++) {
+            if (code->labels[l] >= end)
+                code->labels[l] += shift;
+        }
+    }
+    for (int k = 0; k < count; k++) {
+        int i = start + 1 + k;
+        code->ops[i] = ops[k];
+        code->a[i] = operands[3 * k];
+        code->b[i] = operands[3 * k + 1];
+        code->c[i] = operands[3 * k + 2];
+        if (ops[k] == TAC_LABEL)
+            code->labels[operand_index(code->a[i])] = i;
+    }
+    code->tac_count = pushed_start + shift;
+    free(ops);
+    free(operands);
+    return end + shift;
+}
+
+Operand add_symbol(TacArray *code, Symbol *symb) {
+    if (!grow_array(code->log_fptr, (void **) &code->symbols, &code->symbol_capacity, code->symbol_count, sizeof(Symbol *)))
+        return NO_OPERAND;
+    code->symbols[code->symbol_count] = symb;
+    return make_operand(SYMBOL_OPERAND, code->symbol_count++);
+}
+
+Operand add_temp(TacArray *code, TokenType type) {
+    if (!grow_array(code->log_fptr, (void **) &code->temp_types, &code->temp_capacity, code->temp_count, sizeof(TokenType)))
+        return NO_OPERAND;
+    code->temp_types[code->temp_count] = type;
+    return make_operand(TEMP_OPERAND, code->temp_count++);
+}
+
+Operand add_label(TacArray *code) { // The label position is set once its TAC_LABEL instruction is pushed
+    if (!grow_array(code->log_fptr, (void **) &code->labels, &code->label_capacity, code->label_count, sizeof(int)))
+        return NO_OPERAND;
+    code->labels[code->label_count] = -1;
+    return make_operand(LABEL_OPERAND, code->label_count++);
+}
+
+Symbol* operand_symbol(const TacArray *code, Operand operand) { // NULL for anything but a symbol operand
+    if (operand_kind(operand) != SYMBOL_OPERAND)
+        return NULL;
+    return code->symbols[operand_index(operand)];
+}
+
+TokenType operand_type(const TacArray *code, Operand operand) {
+    if (operand_kind(operand) == SYMBOL_OPERAND)
+        return value_type(code->symbols[operand_index(operand)]->token_type);
+    if (operand_kind(operand) == TEMP_OPERAND)
+        return code->temp_types[operand_index(operand)];
+    return 0;
+}
+
+int used_operands(TacArray *code, int index, Operand **slots) { // Operands read by the instruction, returns their count
+    switch (code->ops[index]) {
+        case TAC_ADD: case TAC_SUB: case TAC_MULT: case TAC_DIV: case TAC_MOD: case TAC_AND: case TAC_OR:
+        case TAC_LT: case TAC_GT: case TAC_NEQ: case TAC_LTE: case TAC_GTE: case TAC_EQ:
+            slots[0] = &code->b[index];
+            slots[1] = &code->c[index];
+            return 2;
+        case TAC_POS: case TAC_NEG: case TAC_NOT: case TAC_CPY: case TAC_IFZ: case TAC_IFNZ:
+            slots[0] = &code->b[index];
+            return 1;
+        case TAC_PRINT: { // The width and precision are optional
+            int count = 0;
+            slots[count++] = &code->a[index];
+            if (code->b[index] != NO_OPERAND)
+                slots[count++] = &code->b[index];
+            if (code->c[index] != NO_OPERAND)
+                slots[count++] = &code->c[index];
+            return count;
+        }
+        case TAC_ARG: case TAC_ENDFUNC:
+            slots[0] = &code->a[index];
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+Operand defined_operand(const TacArray *code, int index) { // Operand written by the instruction, NO_OPERAND when there is none
+    switch (code->ops[index]) {
+        case TAC_ADD: case TAC_SUB: case TAC_MULT: case TAC_DIV: case TAC_MOD: case TAC_AND: case TAC_OR:
+        case TAC_LT: case TAC_GT: case TAC_NEQ: case TAC_LTE: case TAC_GTE: case TAC_EQ:
+        case TAC_POS: case TAC_NEG: case TAC_NOT: case TAC_CPY: case TAC_CALL: case TAC_READ:
+            return code->a[index];
+        default:
+            return NO_OPERAND;
+    }
+}
+
+const ParamType* arg_param(const TacArray *code, int index) { // Parameter an argument is passed to, NULL when unknown
+    int position = 0, call = index;
+    while (code->ops[call] == TAC_ARG)
+        call++;
+    for (int i = index - 1; i >= 0 && code->ops[i] == TAC_ARG; i--)
+        position++;
+    if (code->ops[call] != TAC_CALL)
+        return NULL;
+    const ParamType *param = operand_symbol(code, code->b[call])->param_list;
+    for (; param != NULL && position > 0; position--)
+        param = param->next;
+    return param;
+}
+
+int is_ref_arg(const TacArray *code, int index) { // Argument passed to a parameter by reference
+    const ParamType *param = arg_param(code, index);
+    return param != NULL && param->ref_pass;
+}
+
+typedef struct _OperandMap { // Open addressing map from the symbols of the linked code to their operands
+    const Symbol **keys;
+    Operand *values;
+    uint32_t mask;
+    uint32_t count;
+} OperandMap;
+
+uint32_t pointer_hash(const void *pointer) {
+    uint64_t key = (uint64_t) (uintptr_t) pointer;
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (uint32_t) key;
+}
+
+int init_map(FILE *log_fptr, OperandMap *map, uint32_t size) {
+    map->keys = calloc(size, sizeof(Symbol *));
+    map->values = malloc(size * sizeof(Operand));
+    map->mask = size - 1;
+    map->count = 0;
+    if (map->keys == NULL || map->values == NULL) {
+        fprintf(log_fptr, "Error: failed to allocate memory for the intermediate code\n");
+        free(map->keys);
+        free(map->values);
+        return 0;
+    }
+    return 1;
+}
+
+void map_insert(OperandMap *map, const Symbol *symb, Operand operand) {
+    uint32_t slot = pointer_hash(symb) & map->mask;
+    while (map->keys[slot] != NULL)
+        slot = (slot + 1) & map->mask;
+    map->keys[slot] = symb;
+    map->values[slot] = operand;
+    map->count++;
+}
+
+int grow_map(FILE *log_fptr, OperandMap *map) { // Keeps the map at most half full
+    OperandMap new_map;
+    if (!init_map(log_fptr, &new_map, (map->mask + 1) * 2))
+        return 0;
+    for (uint32_t slot = 0; slot <= map->mask; slot++) {
+        if (map->keys[slot] != NULL)
+            map_insert(&new_map, map->keys[slot], map->values[slot]);
+    }
+    free(map->keys);
+    free(map->values);
+    *map = new_map;
+    return 1;
+}
+
+Operand map_operand(TacArray *code, OperandMap *map, Symbol *symb) {
+    if (symb == NULL)
+        return NO_OPERAND;
+    uint32_t slot = pointer_hash(symb) & map->mask;
+    while (map->keys[slot] != NULL) {
+        if (map->keys[slot] == symb)
+            return map->values[slot];
+        slot = (slot + 1) & map->mask;
+    }
+    Operand operand;
+    if (symb->declaration_type == LABEL_TOKEN)
+        operand = add_label(code);
+    else
+        operand = add_symbol(code, symb);
+    if ((map->count + 1) * 2 > map->mask + 1 && !grow_map(code->log_fptr, map))
+        return NO_OPERAND;
+    map_insert(map, symb, operand);
+    return operand;
+}
+
+Operand map_temp(TacArray *code, Operand *temp_operands, const TokenType *temp_types, int temp_count, int temp) {
+    // Temporaries of the array are numbered in the order they first appear
+    if (temp < 0 || temp >= temp_count) {
+        fprintf(code->log_fptr, "Error: unknown temporary t%d in the intermediate code\n", temp);
+        return NO_OPERAND;
+    }
+    if (temp_operands[temp] == NO_OPERAND)
+        temp_operands[temp] = add_temp(code, temp_types[temp]);
+    return temp_operands[temp];
+}
+
+TacArray* flatten_tac(CompilerContext *ctx, TacList list, const TokenType *temp_types, int temp_count) {
+    // Copies the linked code into a new array, the linked code can be freed afterwards; NULL on any failure
+    if (ctx->tac_failed) // Reported already
+        return NULL;
+    TacArray *code = make_tac_array(ctx->log_fptr);
+    Operand *temp_operands = calloc(temp_count + 1, sizeof(Operand));
+    OperandMap map;
+    if (code == NULL || temp_operands == NULL || !init_map(ctx->log_fptr, &map, 1024)) {
+        if (temp_operands == NULL)
+            fprintf(ctx->log_fptr, "Error: failed to allocate memory for the intermediate code\n");
+        free_tac_array(code);
+        free(temp_operands);
+        return NULL;
+    }
+
+    for (Tac *tac = list.head; tac != NULL; tac = tac == list.tail ? NULL : tac->next) {
+        Operand a = tac->temps & TEMP_A ? map_temp(code, temp_operands, temp_types, temp_count, tac->a.temp) : map_operand(code, &map, tac->a.symb);
+        Operand b = tac->temps & TEMP_B ? map_temp(code, temp_operands, temp_types, temp_count, tac->b.temp) : map_operand(code, &map, tac->b.symb);
+        Operand c = tac->temps & TEMP_C ? map_temp(code, temp_operands, temp_types, temp_count, tac->c.temp) : map_operand(code, &map, tac->c.symb);
+        // The helpers give no operand for a missing symbol only, otherwise they failed and reported it
+        int failed = (a == NO_OPERAND && (tac->temps & TEMP_A || tac->a.symb != NULL))
+            || (b == NO_OPERAND && (tac->temps & TEMP_B || tac->b.symb != NULL))
+            || (c == NO_OPERAND && (tac->temps & TEMP_C || tac->c.symb != NULL));
+        int index = failed ? -1 : push_tac(code, tac->op, a, b, c);
+        if (index < 0) {
+            free_tac_array(code);
+            code = NULL;
+            break;
+        }
+        if (tac->op == TAC_LABEL)
+            code->labels[operand_index(a)] = index;
+    }
+    free(map.keys);
+    free(map.values);
+    free(temp_operands);
+    return code;
+}
+
+void print_operand(FILE *fptr, const TacArray *code, Operand operand) {
+    switch (operand_kind(operand)) {
+        case SYMBOL_OPERAND: {
+            const Symbol *symb = code->symbols[operand_index(operand)];
+            if (is_constant_symbol(symb) && (symb->token_type == STRING_TOKEN || symb->token_type == CHAR_TOKEN))
+                fprintf(fptr, "'%s'", symb->name);
+            else
+                fprintf(fptr, "%s", symb->name);
+            break;
+        }
+        case TEMP_OPERAND:
+            fprintf(fptr, "t%d", operand_index(operand));
+            break;
+        case LABEL_OPERAND:
+            fprintf(fptr, "L%d", operand_index(operand));
+            break;
+        default:
+            fprintf(fptr, "?");
+            break;
+    }
+}
+
+void print_tac_array(FILE *fptr, const TacArray *code) { // Intermediate code listing, one instruction per line
+    for (int i = 0; i < code->tac_count; i++) {
+        Operand a = code->a[i], b = code->b[i], c = code->c[i];
+        switch (code->ops[i]) {
+            case TAC_ADD: case TAC_SUB: case TAC_MULT: case TAC_DIV: case TAC_MOD: case TAC_AND: case TAC_OR:
+            case TAC_LT: case TAC_GT: case TAC_NEQ: case TAC_LTE: case TAC_GTE: case TAC_EQ: {
+                fprintf(fptr, "    ");
+                print_operand(fptr, code, a);
+                fprintf(fptr, " = ");
+                print_operand(fptr, code, b);
+                fprintf(fptr, " %s ", operator_name(code->ops[i]));
+                print_operand(fptr, code, c);
+                fprintf(fptr, "\n");
+                break;
+            }
+            case TAC_POS: case TAC_NEG: case TAC_NOT: case TAC_CPY: {
+                fprintf(fptr, "    ");
+                print_operand(fptr, code, a);
+                fprintf(fptr, " = %s", operator_name(code->ops[i]));
+                print_operand(fptr, code, b);
+                fprintf(fptr, "\n");
+                break;
+            }
+            case TAC_GOTO: {
+                fprintf(fptr, "    goto ");
+                print_operand(fptr, code, a);
+                fprintf(fptr, "\n");
+                break;
+            }
+            case TAC_IFZ: case TAC_IFNZ: {
+                fprintf(fptr, "    %s ", code->ops[i] == TAC_IFZ ? "ifz" : "ifnz");
+                print_operand(fptr, code, b);
+                fprintf(fptr, " goto ");
+                print_operand(fptr, code, a);
+                fprintf(fptr, "\n");
+                break;
+            }
+            case TAC_LABEL: {
+                print_operand(fptr, code, a);
+                fprintf(fptr, ":\n");
+                break;
+            }
+            case TAC_VAR: case TAC_PRINT: case TAC_ARG: {
+                fprintf(fptr, "    %s ", code->ops[i] == TAC_VAR ? "var" : code->ops[i] == TAC_PRINT ? "print" : "arg");
+                print_operand(fptr, code, a);
+                for (Operand operand = code->ops[i] == TAC_PRINT ? b : NO_OPERAND; operand != NO_OPERAND; operand = operand == b ? c : NO_OPERAND) {
+                    fprintf(fptr, ":");
+                    print_operand(fptr, code, operand);
+                }
+                fprintf(fptr, "\n");
+                break;
+            }
+            case TAC_PRINTLN:
+                fprintf(fptr, "    println\n");
+                break;
+            case TAC_READ: {
+                fprintf(fptr, "    read ");
+                print_operand(fptr, code, a);
+                fprintf(fptr, "\n");
+                break;
+            }
+            case TAC_READLN:
+                fprintf(fptr, "    readln\n");
+                break;
+            case TAC_CALL: {
+                fprintf(fptr, "    ");
+                if (a != NO_OPERAND) {
+                    print_operand(fptr, code, a);
+                    fprintf(fptr, " = ");
+                }
+                fprintf(fptr, "call ");
+                print_operand(fptr, code, b);
+                fprintf(fptr, "\n");
+                break;
+            }
+            case TAC_BEGINFUNC: case TAC_BEGINPROC: {
+                fprintf(fptr, "begin %s ", code->ops[i] == TAC_BEGINFUNC ? "function" : "procedure");
+                print_operand(fptr, code, a);
+                fprintf(fptr, "\n");
+                break;
+            }
+            case TAC_ENDFUNC: case TAC_ENDPROC: {
+                fprintf(fptr, "end %s ", code->ops[i] == TAC_ENDFUNC ? "function" : "procedure");
+                print_operand(fptr, code, a);
+                fprintf(fptr, "\n");
+                break;
+            }
+            case TAC_BEGINPROG:
+                fprintf(fptr, "begin program\n");
+                break;
+            case TAC_ENDPROG:
+                fprintf(fptr, "end program\n");
+                break;
+            case TAC_UNDEF: // Removed instruction
+                break;
+            default:
+                fprintf(fptr, "    (op %d)\n", code->ops[i]);
+                break;
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef TAC_ARRAY_H
+#define TAC_ARRAY_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "symbol_table.h"
+#include "tac.h"
+#include "compiler_context.h"
+
+#define OPERAND_KIND_SHIFT 30
+#define OPERAND_INDEX_MASK 0x3fffffffu
+
+typedef uint32_t Operand; // Kind in the 2 high bits, index in its table in the others (0 is no operand)
+
+typedef enum {
+    NO_OPERAND = 0, SYMBOL_OPERAND, TEMP_OPERAND, LABEL_OPERAND
+} OperandKind;
+
+#define make_operand(kind, index) ((Operand) (((uint32_t) (kind) << OPERAND_KIND_SHIFT) | (uint32_t) (index)))
+#define operand_kind(operand) ((OperandKind) ((operand) >> OPERAND_KIND_SHIFT))
+#define operand_index(operand) ((int) ((operand) & OPERAND_INDEX_MASK))
+
+typedef struct _TacArray { // Whole program code stored as parallel arrays, passes walk it by instruction index
+    uint8_t *ops; // TacOp of each instruction, TAC_UNDEF for a removed instruction
+    Operand *a;
+    Operand *b;
+    Operand *c;
+    int tac_count, tac_capacity;
+
+    Symbol **symbols; // Variables, literals and routines (owned by the symbol tables and the compiler context)
+    int symbol_count, symbol_capacity;
+    TokenType *temp_types;
+    int temp_count, temp_capacity;
+    int *labels; // Instruction index of each label
+    int label_count, label_capacity;
+    FILE *log_fptr; // Where the allocation failures of the passes are reported
+} TacArray;
+
+TacArray* make_tac_array(FILE *);
+TacArray* flatten_tac(CompilerContext *, TacList, const TokenType *, int);
+void free_tac_array(TacArray *);
+int push_tac(TacArray *, TacOp, Operand, Operand, Operand);
+int splice_code(TacArray *, int, int, int, const int *, int);
+Operand add_symbol(TacArray *, Symbol *);
+Operand add_temp(TacArray *, TokenType);
+Operand add_label(TacArray *);
+Symbol* operand_symbol(const TacArray *, Operand);
+TokenType operand_type(const TacArray *, Operand);
+#define MAX_USED_OPERANDS 3 // Operands an instruction reads at most
+#define OPERAND_SLOTS (MAX_USED_OPERANDS + 1) // Used operands followed by the defined one
+
+int used_operands(TacArray *, int, Operand **);
+Operand defined_operand(const TacArray *, int);
+const ParamType* arg_param(const TacArray *, int);
+int is_ref_arg(const TacArray *, int);
+void print_tac_array(FILE *, const TacArray *);
+
+#endif
@@ -0,0 +1,335 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "scanner.h"
+#include "symbol_table.h"
+#include "tac.h"
+#include "tac_array.h"
+#include "control_flow.h"
+#include "ssa.h"
+#include "value_numbering.h"
+
+// Value numbers: an SSA value is numbered by the value it is known to be equal to, operands that aren't tracked are
+// numbered by what they hold when it can't change (literals and value parameters)
+#define NUMBER_TAG_SHIFT 32
+#define VALUE_NUMBER 1ULL
+#define PARAM_NUMBER 2ULL
+#define INT_NUMBER 3ULL
+#define REAL_NUMBER 4ULL
+#define make_number_key(tag, bits) (((tag) << NUMBER_TAG_SHIFT) | (uint32_t) (bits))
+
+typedef struct _Expression { // Entry of the value table, key 0 for an empty slot
+    uint64_t op;
+    uint64_t left, right;
+    int value; // Value computed by the expression and the operand holding it
+    Operand holder;
+} Expression;
+
+typedef struct _ValueTable { // Open addressing table scoped by an undo log, entries are only removed in the reverse order of their insertion
+    Expression *slots;
+    uint32_t mask;
+    uint32_t *undo_slots;
+    Expression *undo_entries; // Previous content of the slot
+    int undo_count;
+} ValueTable;
+
+typedef struct _Numbering {
+    SsaForm *ssa;
+    uint64_t *numbers; // Value number of each SSA value
+    int *current; // Current value of each tracked variable
+    ValueTable table;
+} Numbering;
+
+uint32_t expression_hash(uint64_t op, uint64_t left, uint64_t right) {
+    uint64_t key = op * 0x9e3779b97f4a7c15ULL;
+    key = (key ^ left) * 0xff51afd7ed558ccdULL;
+    key = (key ^ right) * 0xc4ceb9fe1a85ec53ULL;
+    return (uint32_t) (key ^ (key >> 29));
+}
+
+uint32_t find_expression(const ValueTable *table, uint64_t op, uint64_t left, uint64_t right) {
+    uint32_t slot = expression_hash(op, left, right) & table->mask;
+    while (table->slots[slot].op != 0
+           && (table->slots[slot].op != op || table->slots[slot].left != left || table->slots[slot].right != right))
+        slot = (slot + 1) & table->mask;
+    return slot;
+}
+
+void set_expression(ValueTable *table, uint32_t slot, uint64_t op, uint64_t left, uint64_t right, int value, Operand holder) {
+    table->undo_slots[table->undo_count] = slot;
+    table->undo_entries[table->undo_count++] = table->slots[slot];
+    table->slots[slot].op = op;
+    table->slots[slot].left = left;
+    table->slots[slot].right = right;
+    table->slots[slot].value = value;
+    table->slots[slot].holder = holder;
+}
+
+void undo_expressions(ValueTable *table, int mark) {
+    while (table->undo_count > mark) {
+        table->undo_count--;
+        table->slots[table->undo_slots[table->undo_count]] = table->undo_entries[table->undo_count];
+    }
+}
+
+uint64_t operand_number(const Numbering *numbering, int index, int k, Operand operand) { // 0 when the operand can't be numbered
+    const SsaForm *ssa = numbering->ssa;
+    int value = ssa->uses[MAX_USED_OPERANDS * (index - ssa->cfg->routine_start - 1) + k];
+    if (value >= 0)
+        return numbering->numbers[value];
+    const Symbol *symb = operand_symbol(ssa->cfg->code, operand);
+    if (is_constant_symbol(symb)) {
+        if (symb->token_type == INT_TOKEN)
+            return make_number_key(INT_NUMBER, symb->values->i);
+        if (symb->token_type == REAL_TOKEN) {
+            uint32_t bits;
+            memcpy(&bits, &symb->values->f, sizeof(bits));
+            return make_number_key(REAL_NUMBER, bits);
+        }
+        return 0;
+    }
+    if (symb != NULL && symb->declaration_type == CONST_TOKEN) // Value parameters are never written
+        return make_number_key(PARAM_NUMBER, operand);
+    return 0;
+}
+
+int is_commutative(TacOp op) {
+    return op == TAC_ADD || op == TAC_MULT || op == TAC_AND || op == TAC_OR || op == TAC_EQ || op == TAC_NEQ;
+}
+
+int is_number_literal(const TacArray *code, Operand operand, int number) { // Literal equal to the integer number
+    const Symbol *symb = operand_symbol(code, operand);
+    if (!is_constant_symbol(symb))
+        return 0;
+    if (symb->token_type == INT_TOKEN)
+        return symb->values->i == number;
+    return symb->token_type == REAL_TOKEN && symb->values->f == (float) number;
+}
+
+void make_copy(SsaForm *ssa, int index, int k) { // The instruction becomes a copy of its used operand k
+    TacArray *code = ssa->cfg->code;
+    int use = MAX_USED_OPERANDS * (index - ssa->cfg->routine_start - 1);
+    code->b[index] = k == 0 ? code->b[index] : code->c[index];
+    code->c[index] = NO_OPERAND;
+    ssa->uses[use] = ssa->uses[use + k];
+    ssa->uses[use + 1] = -1;
+    code->ops[index] = TAC_CPY;
+}
+
+int simplify_instruction(SsaForm *ssa, int index) {
+    // Algebraic identities on numbers: x + 0 (integers), x - 0, x * 1 and x / 1 become copies, x * 2 becomes x + x
+    // The literal is the right operand once the commutative operands are in order, returns 1 when the instruction changed
+    TacArray *code = ssa->cfg->code;
+    TacOp op = code->ops[index];
+    TokenType left_type = operand_type(code, code->b[index]), right_type = operand_type(code, code->c[index]);
+    if ((left_type != INT_TOKEN && left_type != REAL_TOKEN) || (right_type != INT_TOKEN && right_type != REAL_TOKEN))
+        return 0;
+    if (left_type != operand_type(code, code->a[index])) // The copy can't convert the left operand
+        return 0;
+    if ((op == TAC_ADD && left_type == INT_TOKEN && is_number_literal(code, code->c[index], 0)) // -0 + 0 is 0
+        || (op == TAC_SUB && is_number_literal(code, code->c[index], 0))
+        || ((op == TAC_MULT || op == TAC_DIV) && is_number_literal(code, code->c[index], 1))) {
+        make_copy(ssa, index, 0);
+        return 1;
+    }
+    if (op == TAC_MULT && is_number_literal(code, code->c[index], 2)) {
+        int use = MAX_USED_OPERANDS * (index - ssa->cfg->routine_start - 1);
+        code->ops[index] = TAC_ADD;
+        code->c[index] = code->b[index];
+        ssa->uses[use + 1] = ssa->uses[use];
+        return 1;
+    }
+    return 0;
+}
+
+int is_expression(TacOp op) { // Pure computation of a new value from its operands
+    switch (op) {
+        case TAC_ADD: case TAC_SUB: case TAC_MULT: case TAC_DIV: case TAC_MOD: case TAC_AND: case TAC_OR:
+        case TAC_LT: case TAC_GT: case TAC_NEQ: case TAC_LTE: case TAC_GTE: case TAC_EQ:
+        case TAC_POS: case TAC_NEG: case TAC_NOT:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+int is_number_operand(const TacArray *code, Operand operand) {
+    TokenType type = operand_type(code, operand);
+    return type == INT_TOKEN || type == REAL_TOKEN;
+}
+
+int number_instruction(Numbering *numbering, int index) {
+    // Numbers the value of the instruction, an expression already computed in a dominating block becomes a copy
+    SsaForm *ssa = numbering->ssa;
+    TacArray *code = ssa->cfg->code;
+    int use = MAX_USED_OPERANDS * (index - ssa->cfg->routine_start - 1);
+    int value = ssa->defs[use / MAX_USED_OPERANDS];
+    TacOp op = code->ops[index];
+    int change_count = 0;
+    int binary = is_expression(op) && op != TAC_POS && op != TAC_NEG && op != TAC_NOT;
+    if (binary && is_number_operand(code, code->b[index]) && is_number_operand(code, code->c[index])) {
+        if (is_commutative(op)) { // Canonical order: operands that can't be numbered, then values, then literals
+            uint64_t left = operand_number(numbering, index, 0, code->b[index]);
+            uint64_t right = operand_number(numbering, index, 1, code->c[index]);
+            if (right < left) {
+                Operand operand = code->b[index];
+                int used = ssa->uses[use];
+                code->b[index] = code->c[index];
+                code->c[index] = operand;
+                ssa->uses[use] = ssa->uses[use + 1];
+                ssa->uses[use + 1] = used;
+                change_count++;
+            }
+        }
+        if (simplify_instruction(ssa, index)) {
+            change_count++;
+            op = code->ops[index];
+        }
+    }
+    if (op == TAC_CPY) {
+        uint64_t number = operand_number(numbering, index, 0, code->b[index]);
+        if (value >= 0 && number != 0 && operand_type(code, code->a[index]) == operand_type(code, code->b[index]))
+            numbering->numbers[value] = number;
+        return change_count;
+    }
+    if (!is_expression(op))
+        return change_count;
+
+    int unary = op == TAC_POS || op == TAC_NEG || op == TAC_NOT;
+    uint64_t left = operand_number(numbering, index, 0, code->b[index]);
+    uint64_t right = unary ? 0 : operand_number(numbering, index, 1, code->c[index]);
+    if (left == 0 || (!unary && right == 0))
+        return change_count;
+    uint64_t key_op = ((uint64_t) operand_type(code, code->a[index]) << 8) | op; // Same operands but another result type aren't equal
+    uint32_t slot = find_expression(&numbering->table, key_op, left, right);
+    const Expression *found = &numbering->table.slots[slot];
+    if (found->op != 0) {
+        int holder_var = ssa_var(ssa, found->holder);
+        if (holder_var >= 0 && numbering->current[holder_var] == found->value) { // The holder wasn't written since
+            code->ops[index] = TAC_CPY;
+            code->b[index] = found->holder;
+            code->c[index] = NO_OPERAND;
+            ssa->uses[use] = found->value;
+            ssa->uses[use + 1] = -1;
+            if (value >= 0)
+                numbering->numbers[value] = numbering->numbers[found->value];
+            return change_count + 1;
+        }
+    }
+    if (value >= 0)
+        set_expression(&numbering->table, slot, key_op, left, right, value, code->a[index]);
+    return change_count;
+}
+
+void number_phi(Numbering *numbering, const Phi *phi) { // A phi whose arguments all have the same number has it too
+    const SsaForm *ssa = numbering->ssa;
+    uint64_t number = 0;
+    for (int a = 0; a < phi->arg_count; a++) {
+        int arg = ssa->phi_args[phi->arg_start + a];
+        if (arg < 0)
+            continue;
+        if (arg == phi->value || (number != 0 && numbering->numbers[arg] != number))
+            return;
+        number = numbering->numbers[arg];
+    }
+    if (number != 0)
+        numbering->numbers[phi->value] = number;
+}
+
+void set_current(Numbering *numbering, int value, int *saved) {
+    int var = numbering->ssa->values[value].var;
+    saved[value] = numbering->current[var];
+    numbering->current[var] = value;
+}
+
+int number_values(SsaForm *ssa, int global) {
+    // Hash based value numbering, of each block on its own or over the dominator tree when global is set (an expression
+    // computed in a block is then reused in the blocks it dominates), returns the number of changed instructions
+    ControlFlowGraph *cfg = ssa->cfg;
+    TacArray *code = cfg->code;
+    int base = cfg->routine_start + 1;
+    int body_count = cfg->routine_end - base;
+    Numbering numbering;
+    numbering.ssa = ssa;
+    numbering.numbers = malloc((ssa->value_count > 0 ? ssa->value_count : 1) * sizeof(uint64_t));
+    numbering.current = malloc((ssa->var_count > 0 ? ssa->var_count : 1) * sizeof(int));
+    uint32_t table_size = 16;
+    while (table_size < 2 * (uint32_t) body_count)
+        table_size *= 2;
+    numbering.table.slots = calloc(table_size, sizeof(Expression));
+    numbering.table.mask = table_size - 1;
+    numbering.table.undo_slots = malloc((body_count > 0 ? body_count : 1) * sizeof(uint32_t));
+    numbering.table.undo_entries = malloc((body_count > 0 ? body_count : 1) * sizeof(Expression));
+    numbering.table.undo_count = 0;
+    int *saved = malloc((ssa->value_count > 0 ? ssa->value_count : 1) * sizeof(int));
+    int *stack = malloc(cfg->block_count * sizeof(int));
+    int *next_child = malloc(cfg->block_count * sizeof(int));
+    int *undo_marks = malloc(cfg->block_count * sizeof(int));
+    if (numbering.numbers == NULL || numbering.current == NULL || numbering.table.slots == NULL || numbering.table.undo_slots == NULL
+        || numbering.table.undo_entries == NULL || saved == NULL || stack == NULL || next_child == NULL || undo_marks == NULL) {
+        fprintf(cfg->code->log_fptr, "Error: failed to allocate memory for the value numbering\n");
+        global = -1;
+    }
+    int stack_count = 0, change_count = 0;
+    if (global >= 0) {
+        for (int v = 0; v < ssa->value_count; v++)
+            numbering.numbers[v] = make_number_key(VALUE_NUMBER, v);
+        for (int var = 0; var < ssa->var_count; var++)
+            numbering.current[var] = var;
+        stack[stack_count++] = 0;
+        next_child[0] = -1;
+    }
+    while (stack_count > 0) {
+        int b = stack[stack_count - 1];
+        const BasicBlock *block = &cfg->blocks[b];
+        if (next_child[b] == -1) {
+            undo_marks[b] = numbering.table.undo_count;
+            for (int p = ssa->block_phis[b]; p < ssa->block_phis[b + 1]; p++) {
+                number_phi(&numbering, &ssa->phis[p]);
+                set_current(&numbering, ssa->phis[p].value, saved);
+            }
+            for (int i = block->start; i < block->end; i++) {
+                if (code->ops[i] == TAC_UNDEF)
+                    continue;
+                change_count += number_instruction(&numbering, i);
+                if (ssa->defs[i - base] >= 0)
+                    set_current(&numbering, ssa->defs[i - base], saved);
+                for (int c = ssa->clobber_start[i - base]; c < ssa->clobber_start[i - base + 1]; c++)
+                    set_current(&numbering, ssa->clobbers[c], saved);
+            }
+            if (!global) // Local numbering forgets the expressions of the block right away
+                undo_expressions(&numbering.table, undo_marks[b]);
+            next_child[b] = 0;
+        }
+        if (next_child[b] < block->dom_child_count) {
+            int child = cfg->dom_children[block->dom_child_start + next_child[b]++];
+            next_child[child] = -1;
+            stack[stack_count++] = child;
+            continue;
+        }
+        undo_expressions(&numbering.table, undo_marks[b]);
+        for (int i = block->end - 1; i >= block->start; i--) { // Restores the values in the reverse order of their definitions
+            if (code->ops[i] == TAC_UNDEF)
+                continue;
+            for (int c = ssa->clobber_start[i - base + 1] - 1; c >= ssa->clobber_start[i - base]; c--)
+                numbering.current[ssa->values[ssa->clobbers[c]].var] = saved[ssa->clobbers[c]];
+            if (ssa->defs[i - base] >= 0)
+                numbering.current[ssa->values[ssa->defs[i - base]].var] = saved[ssa->defs[i - base]];
+        }
+        for (int p = ssa->block_phis[b + 1] - 1; p >= ssa->block_phis[b]; p--)
+            numbering.current[ssa->values[ssa->phis[p].value].var] = saved[ssa->phis[p].value];
+        stack_count--;
+    }
+    free(numbering.numbers);
+    free(numbering.current);
+    free(numbering.table.slots);
+    free(numbering.table.undo_slots);
+    free(numbering.table.undo_entries);
+    free(saved);
+    free(stack);
+    free(next_child);
+    free(undo_marks);
+    return change_count;
+}
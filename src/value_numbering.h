@@ -0,0 +1,8 @@
+#ifndef VALUE_NUMBERING_H
+#define VALUE_NUMBERING_H
+
+#include "ssa.h"
+
+int number_values(SsaForm *, int);
+
+#endif
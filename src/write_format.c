@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "write_format.h"
+
+#define POWER(exponent) write_powers[(exponent) + 46]
+#define MIN_EXPONENT -46
+#define MAX_EXPONENT 38 // Decimal exponent of the largest float
+#define FLOAT_DIGITS 9 // Significant digits telling any two floats apart
+
+const double write_powers[] = { // 10^-46 to 10^54, enough to scale any float to 9 digits and to 32 decimals
+    1e-46, 1e-45, 1e-44, 1e-43, 1e-42, 1e-41, 1e-40, 1e-39, 1e-38, 1e-37, 1e-36, 1e-35,
+    1e-34, 1e-33, 1e-32, 1e-31, 1e-30, 1e-29, 1e-28, 1e-27, 1e-26, 1e-25, 1e-24, 1e-23,
+    1e-22, 1e-21, 1e-20, 1e-19, 1e-18, 1e-17, 1e-16, 1e-15, 1e-14, 1e-13, 1e-12, 1e-11,
+    1e-10, 1e-9, 1e-8, 1e-7, 1e-6, 1e-5, 1e-4, 1e-3, 1e-2, 1e-1, 1e0, 1e1,
+    1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13,
+    1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22, 1e23, 1e24, 1e25,
+    1e26, 1e27, 1e28, 1e29, 1e30, 1e31, 1e32, 1e33, 1e34, 1e35, 1e36, 1e37,
+    1e38, 1e39, 1e40, 1e41, 1e42, 1e43, 1e44, 1e45, 1e46, 1e47, 1e48, 1e49,
+    1e50, 1e51, 1e52, 1e53, 1e54
+};
+
+const char digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+uint64_t round_even(double value) { // Nearest integer, ties to even like cvtsd2si, the value is under 2^63
+    uint64_t n = (uint64_t) value;
+    double fraction = value - (double) n;
+    return n + (fraction > 0.5 || (fraction == 0.5 && (n & 1)));
+}
+
+int format_digits(char *buffer, uint64_t n) { // Decimal digits of n, returns their count
+    char digits[20];
+    int start = sizeof(digits);
+    for (; n >= 100; n /= 100) {
+        start -= 2;
+        memcpy(digits + start, digit_pairs + 2 * (n % 100), 2);
+    }
+    if (n >= 10) {
+        start -= 2;
+        memcpy(digits + start, digit_pairs + 2 * n, 2);
+    }
+    else
+        digits[--start] = '0' + n;
+    memcpy(buffer, digits + start, sizeof(digits) - start);
+    return sizeof(digits) - start;
+}
+
+int format_int(char *buffer, int value) {
+    if (value >= 0)
+        return format_digits(buffer, value);
+    buffer[0] = '-';
+    return 1 + format_digits(buffer + 1, -(int64_t) value);
+}
+
+double scale_power(double value, int exponent) { // Value times 10^exponent, exact powers up to 10^22 both ways
+    return exponent >= 0 ? value * POWER(exponent) : value / POWER(-exponent);
+}
+
+int shortest_digits(char *digits, float value, int *exponent) {
+    // Fewest significant digits reading back as the positive value, exponent is the one of the first digit
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    double d = value;
+    int e = ((int) (bits >> 23) - 127) * 1233 / 4096; // log10(2) times the binary exponent, then corrected
+    while (e < MAX_EXPONENT && POWER(e + 1) <= d)
+        e++;
+    while (e > MIN_EXPONENT && POWER(e) > d)
+        e--;
+    uint64_t n = 0, limit = 10;
+    for (int count = 1; count <= FLOAT_DIGITS; count++, limit *= 10) {
+        n = round_even(scale_power(d, count - 1 - e));
+        *exponent = e;
+        if (n >= limit) { // Rounded up to the next power of 10
+            n /= 10;
+            *exponent = e + 1;
+        }
+        if ((float) scale_power(n, *exponent + 1 - count) == value)
+            break;
+    }
+    int count = format_digits(digits, n);
+    while (count > 1 && digits[count - 1] == '0')
+        count--;
+    return count;
+}
+
+int fixed_notation(char *buffer, const char *digits, int count, int exponent, int decimals) {
+    // Digits with the exponent of the first one, zeros before and after them
+    int length = 0;
+    if (exponent < 0)
+        buffer[length++] = '0';
+    for (int n = 0; n <= exponent; n++)
+        buffer[length++] = n < count ? digits[n] : '0';
+    if (decimals > 0)
+        buffer[length++] = '.';
+    for (int n = exponent + 1; n <= exponent + decimals; n++)
+        buffer[length++] = n >= 0 && n < count ? digits[n] : '0';
+    return length;
+}
+
+int exponent_notation(char *buffer, const char *digits, int count, int exponent) { // d.ddde+XX
+    int length = 0;
+    buffer[length++] = digits[0];
+    if (count > 1) {
+        buffer[length++] = '.';
+        memcpy(buffer + length, digits + 1, count - 1);
+        length += count - 1;
+    }
+    buffer[length++] = 'e';
+    buffer[length++] = exponent < 0 ? '-' : '+';
+    memcpy(buffer + length, digit_pairs + 2 * (exponent < 0 ? -exponent : exponent), 2);
+    return length + 2;
+}
+
+int format_real(char *buffer, float value, int precision) {
+    // Shortest digits when precision is NO_WRITE_PRECISION, else that many decimals, returns the length of the text
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    int sign = bits >> 31;
+    buffer[0] = '-';
+    buffer += sign;
+    if ((bits >> 23 & 0xff) == 0xff) {
+        memcpy(buffer, bits & 0x7fffff ? "nan" : "inf", 3);
+        return sign + 3;
+    }
+    bits &= 0x7fffffff;
+    memcpy(&value, &bits, sizeof(bits));
+    char digits[20];
+    int count, exponent;
+    if (precision >= 0) {
+        if (precision > MAX_WRITE_PRECISION)
+            precision = MAX_WRITE_PRECISION;
+        double scaled = scale_power(value, precision);
+        if (scaled < 9223372036854775808.0) { // Rounded at the last decimal, else the shortest digits are padded with zeros
+            count = format_digits(digits, round_even(scaled));
+            return sign + fixed_notation(buffer, digits, count, count - 1 - precision, precision);
+        }
+    }
+    if (bits == 0) {
+        digits[0] = '0';
+        count = 1;
+        exponent = 0;
+    }
+    else
+        count = shortest_digits(digits, value, &exponent);
+    if (precision >= 0)
+        return sign + fixed_notation(buffer, digits, count, exponent, precision);
+    if (exponent < -4 || exponent >= 6)
+        return sign + exponent_notation(buffer, digits, count, exponent);
+    return sign + fixed_notation(buffer, digits, count, exponent, count - exponent - 1 > 0 ? count - exponent - 1 : 0);
+}
+
+void write_padded(FILE *fptr, const char *text, int length, int width) { // Right aligned in width characters
+    for (; width > length; width--)
+        fputc(' ', fptr);
+    fwrite(text, 1, length, fptr);
+}
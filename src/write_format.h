@@ -0,0 +1,26 @@
+#ifndef WRITE_FORMAT_H
+#define WRITE_FORMAT_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Text of the values written by write and writeln for the interpreter and the JIT. The runtime of the native code and the
+// prelude of the C translation take the same steps, in double precision, so that every backend writes the same characters.
+// Integers are converted two digits at a time. Reals are written with the fewest significant digits reading back as the
+// same float, in fixed notation from 1e-4 up to 1e6 and with an exponent (1.5e+07) outside; x:w:p writes p decimals.
+// A width pads the value with spaces on its left.
+
+#define WRITE_BUFFER_SIZE 96 // Longest formatted value: sign, 39 integer digits, the point and the decimals
+#define MAX_WRITE_PRECISION 32
+#define NO_WRITE_PRECISION -1 // Reals are written with their shortest digits
+
+extern const double write_powers[];
+extern const char digit_pairs[];
+
+uint64_t round_even(double);
+int format_digits(char *, uint64_t);
+int format_int(char *, int);
+int format_real(char *, float, int);
+void write_padded(FILE *, const char *, int, int);
+
+#endif
@@ -0,0 +1,576 @@
+#include "write_runtime.h"
+
+// Assembly of the runtime, its symbols start with pas. so that no routine of the program (pas_<name>) can clash with them
+const char *write_runtime_assembly =
+    "    .text\n"
+    "    .type pas.flush, @function\n"
+    "pas.flush:                           # Writes the buffered output to stdout\n"
+    "    pushq %rbx\n"
+    "    leaq pas.out_buffer(%rip), %rsi\n"
+    "    movq pas.out_count(%rip), %rbx\n"
+    ".Lpas_flush_loop:\n"
+    "    testq %rbx, %rbx\n"
+    "    je .Lpas_flush_done\n"
+    "    movl $1, %edi\n"
+    "    movq %rbx, %rdx\n"
+    "    movl $1, %eax                   # write\n"
+    "    syscall\n"
+    "    cmpq $-4, %rax                  # Interrupted\n"
+    "    je .Lpas_flush_loop\n"
+    "    testq %rax, %rax\n"
+    "    jle .Lpas_flush_done\n"
+    "    addq %rax, %rsi\n"
+    "    subq %rax, %rbx\n"
+    "    jmp .Lpas_flush_loop\n"
+    ".Lpas_flush_done:\n"
+    "    movq $0, pas.out_count(%rip)\n"
+    "    popq %rbx\n"
+    "    ret\n"
+    "    .size pas.flush, .-pas.flush\n"
+    "\n"
+    "    .type pas.write_bytes, @function\n"
+    "pas.write_bytes:                     # rsi bytes from rdi, the buffer is written out when full\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    subq $8, %rsp\n"
+    "    movq %rdi, %rbx\n"
+    "    movq %rsi, %r12\n"
+    ".Lpas_write_bytes_loop:\n"
+    "    testq %r12, %r12\n"
+    "    je .Lpas_write_bytes_done\n"
+    "    movq pas.out_count(%rip), %rax\n"
+    "    movl $65536, %ecx\n"
+    "    subq %rax, %rcx                 # Room left in the buffer\n"
+    "    jne .Lpas_write_bytes_copy\n"
+    "    call pas.flush\n"
+    "    jmp .Lpas_write_bytes_loop\n"
+    ".Lpas_write_bytes_copy:\n"
+    "    cmpq %r12, %rcx\n"
+    "    cmova %r12, %rcx\n"
+    "    subq %rcx, %r12\n"
+    "    leaq pas.out_buffer(%rip), %rdx\n"
+    "    addq %rax, %rdx\n"
+    "    addq %rcx, %rax\n"
+    "    movq %rax, pas.out_count(%rip)\n"
+    ".Lpas_write_bytes_words:            # 8 bytes at a time, then the rest one by one\n"
+    "    cmpq $8, %rcx\n"
+    "    jb .Lpas_write_bytes_byte\n"
+    "    movq (%rbx), %rax\n"
+    "    movq %rax, (%rdx)\n"
+    "    addq $8, %rbx\n"
+    "    addq $8, %rdx\n"
+    "    subq $8, %rcx\n"
+    "    jmp .Lpas_write_bytes_words\n"
+    ".Lpas_write_bytes_byte:\n"
+    "    testq %rcx, %rcx\n"
+    "    je .Lpas_write_bytes_loop\n"
+    "    movzbl (%rbx), %eax\n"
+    "    movb %al, (%rdx)\n"
+    "    incq %rbx\n"
+    "    incq %rdx\n"
+    "    decq %rcx\n"
+    "    jmp .Lpas_write_bytes_byte\n"
+    ".Lpas_write_bytes_done:\n"
+    "    addq $8, %rsp\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    ret\n"
+    "    .size pas.write_bytes, .-pas.write_bytes\n"
+    "\n"
+    "    .type pas.write_text, @function\n"
+    "pas.write_text:                      # esi bytes from rdi right aligned in edx characters\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    movq %rdi, %rbx\n"
+    "    movl %esi, %r12d\n"
+    "    movl %edx, %r13d\n"
+    "    subl %esi, %r13d                # Spaces before the text\n"
+    ".Lpas_write_text_padding:\n"
+    "    testl %r13d, %r13d\n"
+    "    jle .Lpas_write_text_bytes\n"
+    "    movl $16, %esi\n"
+    "    cmpl %esi, %r13d\n"
+    "    cmovl %r13d, %esi\n"
+    "    subl %esi, %r13d\n"
+    "    leaq pas.spaces(%rip), %rdi\n"
+    "    call pas.write_bytes\n"
+    "    jmp .Lpas_write_text_padding\n"
+    ".Lpas_write_text_bytes:\n"
+    "    movq %rbx, %rdi\n"
+    "    movl %r12d, %esi\n"
+    "    call pas.write_bytes\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    ret\n"
+    "    .size pas.write_text, .-pas.write_text\n"
+    "\n"
+    "    .type pas.write_string, @function\n"
+    "pas.write_string:                    # String rdi in esi characters\n"
+    "    movq %rdi, %rax\n"
+    ".Lpas_write_string_length:\n"
+    "    cmpb $0, (%rax)\n"
+    "    je .Lpas_write_string_text\n"
+    "    incq %rax\n"
+    "    jmp .Lpas_write_string_length\n"
+    ".Lpas_write_string_text:\n"
+    "    movl %esi, %edx\n"
+    "    movq %rax, %rsi\n"
+    "    subq %rdi, %rsi\n"
+    "    jmp pas.write_text\n"
+    "    .size pas.write_string, .-pas.write_string\n"
+    "\n"
+    "    .type pas.write_char, @function\n"
+    "pas.write_char:                      # Character edi in esi characters\n"
+    "    subq $24, %rsp\n"
+    "    movb %dil, (%rsp)\n"
+    "    movl %esi, %edx\n"
+    "    movq %rsp, %rdi\n"
+    "    movl $1, %esi\n"
+    "    call pas.write_text\n"
+    "    addq $24, %rsp\n"
+    "    ret\n"
+    "    .size pas.write_char, .-pas.write_char\n"
+    "\n"
+    "    .type pas.write_int, @function\n"
+    "pas.write_int:                       # Integer edi in esi characters\n"
+    "    pushq %rbx\n"
+    "    subq $32, %rsp\n"
+    "    movl %esi, %ebx\n"
+    "    movslq %edi, %rdi\n"
+    "    movq %rsp, %rsi\n"
+    "    testq %rdi, %rdi\n"
+    "    jns .Lpas_write_int_digits\n"
+    "    movb $45, (%rsi)\n"
+    "    incq %rsi\n"
+    "    negq %rdi\n"
+    ".Lpas_write_int_digits:\n"
+    "    call pas.format_digits\n"
+    "    movq %rax, %rsi\n"
+    "    subq %rsp, %rsi\n"
+    "    movq %rsp, %rdi\n"
+    "    movl %ebx, %edx\n"
+    "    call pas.write_text\n"
+    "    addq $32, %rsp\n"
+    "    popq %rbx\n"
+    "    ret\n"
+    "    .size pas.write_int, .-pas.write_int\n"
+    "\n"
+    "    .type pas.write_real, @function\n"
+    "pas.write_real:                      # Float xmm0 in edi characters with esi decimals (shortest digits when negative)\n"
+    "    pushq %rbx\n"
+    "    subq $96, %rsp\n"
+    "    movl %edi, %ebx\n"
+    "    movl %esi, %edi\n"
+    "    movq %rsp, %rsi\n"
+    "    call pas.format_real\n"
+    "    movq %rax, %rsi\n"
+    "    subq %rsp, %rsi\n"
+    "    movq %rsp, %rdi\n"
+    "    movl %ebx, %edx\n"
+    "    call pas.write_text\n"
+    "    addq $96, %rsp\n"
+    "    popq %rbx\n"
+    "    ret\n"
+    "    .size pas.write_real, .-pas.write_real\n"
+    "\n"
+    "    .type pas.write_line, @function\n"
+    "pas.write_line:                      # New line, the buffer is written out at once when stdout is a terminal\n"
+    "    subq $72, %rsp\n"
+    "    leaq pas.new_line(%rip), %rdi\n"
+    "    movl $1, %esi\n"
+    "    call pas.write_bytes\n"
+    "    movq pas.out_tty(%rip), %rax\n"
+    "    testq %rax, %rax\n"
+    "    jne .Lpas_write_line_known\n"
+    "    movl $1, %edi\n"
+    "    movl $0x5401, %esi              # TCGETS, fails when stdout is not a terminal\n"
+    "    movq %rsp, %rdx\n"
+    "    movl $16, %eax                  # ioctl\n"
+    "    syscall\n"
+    "    testq %rax, %rax\n"
+    "    setne %al\n"
+    "    movzbl %al, %eax\n"
+    "    incl %eax\n"
+    "    movq %rax, pas.out_tty(%rip)\n"
+    ".Lpas_write_line_known:\n"
+    "    cmpq $1, %rax\n"
+    "    jne .Lpas_write_line_done\n"
+    "    call pas.flush\n"
+    ".Lpas_write_line_done:\n"
+    "    addq $72, %rsp\n"
+    "    ret\n"
+    "    .size pas.write_line, .-pas.write_line\n"
+    "\n"
+    "    .type pas.format_digits, @function\n"
+    "pas.format_digits:                   # Digits of the unsigned rdi at rsi two at a time, rax points after them\n"
+    "    leaq -8(%rsp), %r8              # Written backwards in the red zone\n"
+    "    movq %r8, %r9\n"
+    "    leaq pas.digit_pairs(%rip), %r10\n"
+    "    movq %rdi, %rax\n"
+    ".Lpas_format_digits_pair:\n"
+    "    cmpq $100, %rax\n"
+    "    jb .Lpas_format_digits_last\n"
+    "    movq %rax, %rcx\n"
+    "    shrq $2, %rax                   # Divided by 100 with a multiply\n"
+    "    movq $0x28f5c28f5c28f5c3, %rdx\n"
+    "    mulq %rdx\n"
+    "    shrq $2, %rdx\n"
+    "    imulq $100, %rdx, %rax\n"
+    "    subq %rax, %rcx\n"
+    "    movzwl (%r10,%rcx,2), %eax\n"
+    "    subq $2, %r8\n"
+    "    movw %ax, (%r8)\n"
+    "    movq %rdx, %rax\n"
+    "    jmp .Lpas_format_digits_pair\n"
+    ".Lpas_format_digits_last:\n"
+    "    cmpq $10, %rax\n"
+    "    jb .Lpas_format_digits_one\n"
+    "    movzwl (%r10,%rax,2), %eax\n"
+    "    subq $2, %r8\n"
+    "    movw %ax, (%r8)\n"
+    "    jmp .Lpas_format_digits_copy\n"
+    ".Lpas_format_digits_one:\n"
+    "    addl $48, %eax\n"
+    "    decq %r8\n"
+    "    movb %al, (%r8)\n"
+    ".Lpas_format_digits_copy:\n"
+    "    movzbl (%r8), %eax\n"
+    "    movb %al, (%rsi)\n"
+    "    incq %r8\n"
+    "    incq %rsi\n"
+    "    cmpq %r9, %r8\n"
+    "    jb .Lpas_format_digits_copy\n"
+    "    movq %rsi, %rax\n"
+    "    ret\n"
+    "    .size pas.format_digits, .-pas.format_digits\n"
+    "\n"
+    "    .type pas.scale_power, @function\n"
+    "pas.scale_power:                     # xmm0 times 10 to the power edi, divided by the exact power when edi is negative\n"
+    "    leaq pas.powers(%rip), %rax\n"
+    "    testl %edi, %edi\n"
+    "    js .Lpas_scale_power_down\n"
+    "    movslq %edi, %rdi\n"
+    "    mulsd (%rax,%rdi,8), %xmm0\n"
+    "    ret\n"
+    ".Lpas_scale_power_down:\n"
+    "    negl %edi\n"
+    "    movslq %edi, %rdi\n"
+    "    divsd (%rax,%rdi,8), %xmm0\n"
+    "    ret\n"
+    "    .size pas.scale_power, .-pas.scale_power\n"
+    "\n"
+    "    .type pas.shortest_digits, @function\n"
+    "pas.shortest_digits:                 # Fewest digits at rsi reading back as the float of bits edi (xmm0), eax of them\n"
+    "    pushq %rbx                      # and edx the exponent of the first one\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    subq $16, %rsp\n"
+    "    movsd %xmm0, (%rsp)\n"
+    "    movl %edi, 8(%rsp)\n"
+    "    movq %rsi, %r12\n"
+    "    shrl $23, %edi\n"
+    "    subl $127, %edi\n"
+    "    imull $1233, %edi, %r13d\n"
+    "    sarl $12, %r13d                 # log10(2) times the binary exponent, then corrected\n"
+    "    leaq pas.powers(%rip), %rax\n"
+    ".Lpas_shortest_digits_up:\n"
+    "    cmpl $38, %r13d\n"
+    "    jge .Lpas_shortest_digits_down\n"
+    "    movslq %r13d, %rcx\n"
+    "    movsd 8(%rax,%rcx,8), %xmm1\n"
+    "    ucomisd (%rsp), %xmm1\n"
+    "    ja .Lpas_shortest_digits_down\n"
+    "    incl %r13d\n"
+    "    jmp .Lpas_shortest_digits_up\n"
+    ".Lpas_shortest_digits_down:\n"
+    "    cmpl $-46, %r13d\n"
+    "    jle .Lpas_shortest_digits_search\n"
+    "    movslq %r13d, %rcx\n"
+    "    movsd (%rax,%rcx,8), %xmm1\n"
+    "    ucomisd (%rsp), %xmm1\n"
+    "    jbe .Lpas_shortest_digits_search\n"
+    "    decl %r13d\n"
+    "    jmp .Lpas_shortest_digits_down\n"
+    ".Lpas_shortest_digits_search:       # r14d digits rounded to nearest even, under r15 unless rounded up to it\n"
+    "    movl $1, %r14d\n"
+    "    movl $10, %r15d\n"
+    ".Lpas_shortest_digits_try:\n"
+    "    movsd (%rsp), %xmm0\n"
+    "    movl %r14d, %edi\n"
+    "    subl %r13d, %edi\n"
+    "    decl %edi\n"
+    "    call pas.scale_power\n"
+    "    cvtsd2si %xmm0, %rbx\n"
+    "    movl %r13d, 12(%rsp)\n"
+    "    cmpq %r15, %rbx\n"
+    "    jb .Lpas_shortest_digits_check\n"
+    "    movq %rbx, %rax\n"
+    "    xorl %edx, %edx\n"
+    "    movl $10, %ecx\n"
+    "    divq %rcx\n"
+    "    movq %rax, %rbx\n"
+    "    leal 1(%r13), %eax\n"
+    "    movl %eax, 12(%rsp)\n"
+    ".Lpas_shortest_digits_check:        # Read back as a float\n"
+    "    cvtsi2sdq %rbx, %xmm0\n"
+    "    movl 12(%rsp), %edi\n"
+    "    incl %edi\n"
+    "    subl %r14d, %edi\n"
+    "    call pas.scale_power\n"
+    "    cvtsd2ss %xmm0, %xmm0\n"
+    "    movd %xmm0, %eax\n"
+    "    cmpl 8(%rsp), %eax\n"
+    "    je .Lpas_shortest_digits_found\n"
+    "    cmpl $9, %r14d\n"
+    "    jge .Lpas_shortest_digits_found\n"
+    "    incl %r14d\n"
+    "    imulq $10, %r15, %r15\n"
+    "    jmp .Lpas_shortest_digits_try\n"
+    ".Lpas_shortest_digits_found:\n"
+    "    movq %rbx, %rdi\n"
+    "    movq %r12, %rsi\n"
+    "    call pas.format_digits\n"
+    ".Lpas_shortest_digits_trim:         # Trailing zeros dropped\n"
+    "    leaq 1(%r12), %rcx\n"
+    "    cmpq %rcx, %rax\n"
+    "    jbe .Lpas_shortest_digits_done\n"
+    "    cmpb $48, -1(%rax)\n"
+    "    jne .Lpas_shortest_digits_done\n"
+    "    decq %rax\n"
+    "    jmp .Lpas_shortest_digits_trim\n"
+    ".Lpas_shortest_digits_done:\n"
+    "    subq %r12, %rax\n"
+    "    movl 12(%rsp), %edx\n"
+    "    addq $16, %rsp\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    ret\n"
+    "    .size pas.shortest_digits, .-pas.shortest_digits\n"
+    "\n"
+    "    .type pas.fixed_notation, @function\n"
+    "pas.fixed_notation:                  # Digits of r8 (esi of them, the first one of exponent edx) at rdi with ecx decimals\n"
+    "    testl %edx, %edx                # and the zeros around them, rax points after the text\n"
+    "    jns .Lpas_fixed_notation_integer_start\n"
+    "    movb $48, (%rdi)\n"
+    "    incq %rdi\n"
+    ".Lpas_fixed_notation_integer_start:\n"
+    "    xorl %eax, %eax\n"
+    ".Lpas_fixed_notation_integer:\n"
+    "    cmpl %edx, %eax\n"
+    "    jg .Lpas_fixed_notation_point\n"
+    "    movb $48, %r9b\n"
+    "    cmpl %esi, %eax\n"
+    "    jge .Lpas_fixed_notation_integer_put\n"
+    "    movb (%r8,%rax), %r9b\n"
+    ".Lpas_fixed_notation_integer_put:\n"
+    "    movb %r9b, (%rdi)\n"
+    "    incq %rdi\n"
+    "    incl %eax\n"
+    "    jmp .Lpas_fixed_notation_integer\n"
+    ".Lpas_fixed_notation_point:\n"
+    "    testl %ecx, %ecx\n"
+    "    jle .Lpas_fixed_notation_done\n"
+    "    movb $46, (%rdi)\n"
+    "    incq %rdi\n"
+    "    leal 1(%rdx), %eax\n"
+    "    addl %eax, %ecx                 # Index of the digit after the last decimal\n"
+    ".Lpas_fixed_notation_decimal:\n"
+    "    cmpl %ecx, %eax\n"
+    "    jge .Lpas_fixed_notation_done\n"
+    "    movb $48, %r9b\n"
+    "    testl %eax, %eax\n"
+    "    js .Lpas_fixed_notation_decimal_put\n"
+    "    cmpl %esi, %eax\n"
+    "    jge .Lpas_fixed_notation_decimal_put\n"
+    "    movb (%r8,%rax), %r9b\n"
+    ".Lpas_fixed_notation_decimal_put:\n"
+    "    movb %r9b, (%rdi)\n"
+    "    incq %rdi\n"
+    "    incl %eax\n"
+    "    jmp .Lpas_fixed_notation_decimal\n"
+    ".Lpas_fixed_notation_done:\n"
+    "    movq %rdi, %rax\n"
+    "    ret\n"
+    "    .size pas.fixed_notation, .-pas.fixed_notation\n"
+    "\n"
+    "    .type pas.exponent_notation, @function\n"
+    "pas.exponent_notation:               # d.ddde+XX of the digits of r8 (esi of them, the first one of exponent edx) at rdi\n"
+    "    movb (%r8), %al\n"
+    "    movb %al, (%rdi)\n"
+    "    incq %rdi\n"
+    "    cmpl $1, %esi\n"
+    "    jle .Lpas_exponent_notation_sign\n"
+    "    movb $46, (%rdi)\n"
+    "    incq %rdi\n"
+    "    movl $1, %ecx\n"
+    ".Lpas_exponent_notation_digit:\n"
+    "    movb (%r8,%rcx), %al\n"
+    "    movb %al, (%rdi)\n"
+    "    incq %rdi\n"
+    "    incl %ecx\n"
+    "    cmpl %esi, %ecx\n"
+    "    jl .Lpas_exponent_notation_digit\n"
+    ".Lpas_exponent_notation_sign:\n"
+    "    movb $101, (%rdi)\n"
+    "    movb $43, 1(%rdi)\n"
+    "    testl %edx, %edx\n"
+    "    jns .Lpas_exponent_notation_value\n"
+    "    movb $45, 1(%rdi)\n"
+    "    negl %edx\n"
+    ".Lpas_exponent_notation_value:\n"
+    "    leaq pas.digit_pairs(%rip), %rax\n"
+    "    movzwl (%rax,%rdx,2), %eax\n"
+    "    movw %ax, 2(%rdi)\n"
+    "    leaq 4(%rdi), %rax\n"
+    "    ret\n"
+    "    .size pas.exponent_notation, .-pas.exponent_notation\n"
+    "\n"
+    "    .type pas.format_real, @function\n"
+    "pas.format_real:                     # Text of the float xmm0 at rsi with edi decimals (shortest digits when negative),\n"
+    "    pushq %rbx                      # rax points after it\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    subq $32, %rsp\n"
+    "    movd %xmm0, %eax\n"
+    "    movq %rsi, %rbx\n"
+    "    movl %edi, %r12d\n"
+    "    testl %eax, %eax\n"
+    "    jns .Lpas_format_real_unsigned\n"
+    "    movb $45, (%rbx)\n"
+    "    incq %rbx\n"
+    ".Lpas_format_real_unsigned:\n"
+    "    andl $0x7fffffff, %eax\n"
+    "    movl %eax, %r13d\n"
+    "    cmpl $0x7f800000, %eax\n"
+    "    jb .Lpas_format_real_finite\n"
+    "    movl $0x666e69, %ecx            # inf\n"
+    "    movl $0x6e616e, %edx            # nan\n"
+    "    cmova %edx, %ecx\n"
+    "    movl %ecx, (%rbx)\n"
+    "    leaq 3(%rbx), %rax\n"
+    "    jmp .Lpas_format_real_done\n"
+    ".Lpas_format_real_finite:\n"
+    "    movd %eax, %xmm0\n"
+    "    cvtss2sd %xmm0, %xmm0\n"
+    "    movsd %xmm0, 24(%rsp)\n"
+    "    testl %r12d, %r12d\n"
+    "    js .Lpas_format_real_shortest\n"
+    "    cmpl $32, %r12d\n"
+    "    jle .Lpas_format_real_decimals\n"
+    "    movl $32, %r12d\n"
+    ".Lpas_format_real_decimals:         # Rounded at the last decimal, else the shortest digits are padded with zeros\n"
+    "    movl %r12d, %edi\n"
+    "    call pas.scale_power\n"
+    "    ucomisd pas.two_63(%rip), %xmm0\n"
+    "    jae .Lpas_format_real_shortest\n"
+    "    cvtsd2si %xmm0, %rdi\n"
+    "    movq %rsp, %rsi\n"
+    "    call pas.format_digits\n"
+    "    subq %rsp, %rax\n"
+    "    movl %eax, %esi\n"
+    "    leal -1(%rax), %edx\n"
+    "    subl %r12d, %edx\n"
+    "    movl %r12d, %ecx\n"
+    "    jmp .Lpas_format_real_fixed\n"
+    ".Lpas_format_real_shortest:\n"
+    "    testl %r13d, %r13d\n"
+    "    jne .Lpas_format_real_search\n"
+    "    movb $48, (%rsp)\n"
+    "    movl $1, %esi\n"
+    "    xorl %edx, %edx\n"
+    "    jmp .Lpas_format_real_style\n"
+    ".Lpas_format_real_search:\n"
+    "    movsd 24(%rsp), %xmm0\n"
+    "    movl %r13d, %edi\n"
+    "    movq %rsp, %rsi\n"
+    "    call pas.shortest_digits\n"
+    "    movl %eax, %esi\n"
+    ".Lpas_format_real_style:            # esi digits, the first one of exponent edx\n"
+    "    movl %r12d, %ecx\n"
+    "    testl %r12d, %r12d\n"
+    "    jns .Lpas_format_real_fixed\n"
+    "    cmpl $-4, %edx\n"
+    "    jl .Lpas_format_real_exponent\n"
+    "    cmpl $6, %edx\n"
+    "    jge .Lpas_format_real_exponent\n"
+    "    movl %esi, %ecx\n"
+    "    subl %edx, %ecx\n"
+    "    decl %ecx\n"
+    "    xorl %eax, %eax\n"
+    "    testl %ecx, %ecx\n"
+    "    cmovs %eax, %ecx\n"
+    ".Lpas_format_real_fixed:\n"
+    "    movq %rbx, %rdi\n"
+    "    movq %rsp, %r8\n"
+    "    call pas.fixed_notation\n"
+    "    jmp .Lpas_format_real_done\n"
+    ".Lpas_format_real_exponent:\n"
+    "    movq %rbx, %rdi\n"
+    "    movq %rsp, %r8\n"
+    "    call pas.exponent_notation\n"
+    ".Lpas_format_real_done:\n"
+    "    addq $32, %rsp\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    ret\n"
+    "    .size pas.format_real, .-pas.format_real\n"
+    "\n"
+    "    .section .rodata\n"
+    "pas.spaces:\n"
+    "    .ascii \"                \"\n"
+    "pas.new_line:\n"
+    "    .ascii \"\\n\"\n"
+    "pas.digit_pairs:\n"
+    "    .ascii \"00010203040506070809101112131415161718192021222324252627282930313233343536373839\"\n"
+    "    .ascii \"40414243444546474849505152535455565758596061626364656667686970717273747576777879\"\n"
+    "    .ascii \"8081828384858687888990919293949596979899\"\n"
+    "    .balign 8\n"
+    "pas.two_63:\n"
+    "    .double 9223372036854775808.0\n"
+    "    .quad 0x366244ce242c5561, 0x3696d601ad376ab9, 0x36cc8b8218854567, 0x3701d7314f534b61\n"
+    "    .quad 0x37364cfda3281e39, 0x376be03d0bf225c7, 0x37a16c262777579c, 0x37d5c72fb1552d83\n"
+    "    .quad 0x380b38fb9daa78e4, 0x3841039d428a8b8f, 0x38754484932d2e72, 0x38aa95a5b7f87a0f\n"
+    "    .quad 0x38e09d8792fb4c49, 0x3914c4e977ba1f5c, 0x3949f623d5a8a733, 0x398039d665896880\n"
+    "    .quad 0x39b4484bfeebc2a0, 0x39e95a5efea6b347, 0x3a1fb0f6be506019, 0x3a53ce9a36f23c10\n"
+    "    .quad 0x3a88c240c4aecb14, 0x3abef2d0f5da7dd9, 0x3af357c299a88ea7, 0x3b282db34012b251\n"
+    "    .quad 0x3b5e392010175ee6, 0x3b92e3b40a0e9b4f, 0x3bc79ca10c924223, 0x3bfd83c94fb6d2ac\n"
+    "    .quad 0x3c32725dd1d243ac, 0x3c670ef54646d497, 0x3c9cd2b297d889bc, 0x3cd203af9ee75616\n"
+    "    .quad 0x3d06849b86a12b9b, 0x3d3c25c268497682, 0x3d719799812dea11, 0x3da5fd7fe1796495\n"
+    "    .quad 0x3ddb7cdfd9d7bdbb, 0x3e112e0be826d695, 0x3e45798ee2308c3a, 0x3e7ad7f29abcaf48\n"
+    "    .quad 0x3eb0c6f7a0b5ed8d, 0x3ee4f8b588e368f1, 0x3f1a36e2eb1c432d, 0x3f50624dd2f1a9fc\n"
+    "    .quad 0x3f847ae147ae147b, 0x3fb999999999999a\n"
+    "pas.powers:                          # 10^-46 to 10^54 around 10^0, by their bits as not all assemblers round 1e23 right\n"
+    "    .quad 0x3ff0000000000000, 0x4024000000000000, 0x4059000000000000, 0x408f400000000000\n"
+    "    .quad 0x40c3880000000000, 0x40f86a0000000000, 0x412e848000000000, 0x416312d000000000\n"
+    "    .quad 0x4197d78400000000, 0x41cdcd6500000000, 0x4202a05f20000000, 0x42374876e8000000\n"
+    "    .quad 0x426d1a94a2000000, 0x42a2309ce5400000, 0x42d6bcc41e900000, 0x430c6bf526340000\n"
+    "    .quad 0x4341c37937e08000, 0x4376345785d8a000, 0x43abc16d674ec800, 0x43e158e460913d00\n"
+    "    .quad 0x4415af1d78b58c40, 0x444b1ae4d6e2ef50, 0x4480f0cf064dd592, 0x44b52d02c7e14af6\n"
+    "    .quad 0x44ea784379d99db4, 0x45208b2a2c280291, 0x4554adf4b7320335, 0x4589d971e4fe8402\n"
+    "    .quad 0x45c027e72f1f1281, 0x45f431e0fae6d721, 0x46293e5939a08cea, 0x465f8def8808b024\n"
+    "    .quad 0x4693b8b5b5056e17, 0x46c8a6e32246c99c, 0x46fed09bead87c03, 0x4733426172c74d82\n"
+    "    .quad 0x476812f9cf7920e3, 0x479e17b84357691b, 0x47d2ced32a16a1b1, 0x48078287f49c4a1d\n"
+    "    .quad 0x483d6329f1c35ca5, 0x48725dfa371a19e7, 0x48a6f578c4e0a061, 0x48dcb2d6f618c879\n"
+    "    .quad 0x4911efc659cf7d4c, 0x49466bb7f0435c9e, 0x497c06a5ec5433c6, 0x49b18427b3b4a05c\n"
+    "    .quad 0x49e5e531a0a1c873, 0x4a1b5e7e08ca3a8f, 0x4a511b0ec57e649a, 0x4a8561d276ddfdc0\n"
+    "    .quad 0x4ababa4714957d30, 0x4af0b46c6cdd6e3e, 0x4b24e1878814c9ce\n"
+    "\n"
+    "    .data\n"
+    "    .balign 8\n"
+    "pas.out_count:\n"
+    "    .quad 0\n"
+    "pas.out_tty:                         # 1 when stdout is a terminal, 2 when it is not, 0 until the first new line\n"
+    "    .quad 0\n"
+    "\n"
+    "    .bss\n"
+    "    .balign 16\n"
+    "pas.out_buffer:\n"
+    "    .zero 65536\n";
@@ -0,0 +1,12 @@
+#ifndef WRITE_RUNTIME_H
+#define WRITE_RUNTIME_H
+
+// Runtime of write and writeln in the native code, written after the program in its assembly. The output goes to a 64 KiB
+// buffer written out with the write system call when it is full, at each new line when stdout is a terminal and when the
+// main block returns. The values are formatted like in write_format.c: pas.write_int (edi in esi characters),
+// pas.write_char, pas.write_string (rdi), pas.write_real (xmm0 in edi characters with esi decimals), pas.write_line and
+// pas.flush.
+
+extern const char *write_runtime_assembly;
+
+#endif
@@ -0,0 +1,110 @@
+#!/bin/sh
+# Checks the ways of driving the compiler beyond a single source file: very long section lists, batches of files
+# compiled on worker threads and the compile server. Exits with 1 on any failure. PCOMP selects the compiler.
+
+TESTS_DIR=$(cd "$(dirname "$0")" && pwd)/programs
+ERRORS_DIR=$(cd "$(dirname "$0")" && pwd)/errors
+PCOMP=$(cd "$(dirname "${PCOMP:-$TESTS_DIR/../../pcomp}")" && pwd)/$(basename "${PCOMP:-pcomp}")
+
+if [ ! -x "$PCOMP" ]; then
+    echo "Error: build the compiler first (make test)" >&2
+    exit 1
+fi
+WORK=$(cd "$(mktemp -d)" && pwd -P) # The client sends resolved paths
+server=
+trap '[ -z "$server" ] || kill $server 2>/dev/null; rm -rf "$WORK"' EXIT
+failures=0
+count=0
+
+fail() { # name message
+    echo "FAIL $1: $2"
+    failures=$((failures + 1))
+}
+
+expect() { # name expected-output-file command..., the output of the command against the expected one
+    name=$1
+    expected=$2
+    shift 2
+    count=$((count + 1))
+    if ! "$@" > "$WORK/out" 2>&1 || ! cmp -s "$WORK/out" "$expected"; then
+        echo "FAIL $name"
+        diff "$expected" "$WORK/out" | head -n 10
+        failures=$((failures + 1))
+    fi
+}
+
+# Thousands of alternating constant and variable sections, parsed in a loop within a small stack
+awk 'BEGIN {
+    print "program deep_sections;"
+    for (i = 0; i < 20000; i++) {
+        print "const c" i " = " i ";"
+        print "var v" i ": integer;"
+    }
+    print "begin"
+    print "    v19999 := c19999 + c1;"
+    print "    writeln(v19999)"
+    print "end."
+}' > "$WORK/deep_sections.pas"
+echo 20000 > "$WORK/deep_sections.out"
+expect "deep sections" "$WORK/deep_sections.out" sh -c 'ulimit -s 256 && "$1" --run "$2"' sh "$PCOMP" "$WORK/deep_sections.pas"
+
+# A batch listed in a response file, compiled on worker threads: the same files as one by one, none for the rejected one
+mkdir "$WORK/batch" "$WORK/single"
+for program in loops var_params write_format string_heap; do
+    cp "$TESTS_DIR/$program.pas" "$WORK/batch/"
+    cp "$TESTS_DIR/$program.pas" "$WORK/single/"
+    "$PCOMP" -S -C "$WORK/single/$program.pas" > /dev/null
+    echo "$WORK/batch/$program.pas" >> "$WORK/batch.rsp"
+done
+cp "$ERRORS_DIR/assign_builtin.pas" "$WORK/batch/"
+echo "$WORK/batch/assign_builtin.pas" >> "$WORK/batch.rsp"
+count=$((count + 1))
+if "$PCOMP" -j 3 -S -C "@$WORK/batch.rsp" > "$WORK/out" 2>&1; then
+    fail "batch" "a rejected file must fail the batch"
+elif [ "$(tail -n 1 "$WORK/out")" != "Compiled 4 of 5 source files" ]; then
+    fail "batch" "unexpected summary \"$(tail -n 1 "$WORK/out")\""
+elif ! grep -A 1 -x "$WORK/batch/assign_builtin.pas:" "$WORK/out" | tail -n 1 | cmp -s - "$ERRORS_DIR/assign_builtin.err"; then
+    fail "batch" "missing diagnostics of the rejected file"
+elif [ -e "$WORK/batch/assign_builtin.s" ] || [ -e "$WORK/batch/assign_builtin.c" ]; then
+    fail "batch" "output written for the rejected file"
+else
+    for program in loops var_params write_format string_heap; do
+        for extension in s c; do
+            if ! cmp -s "$WORK/batch/$program.$extension" "$WORK/single/$program.$extension"; then
+                fail "batch" "$program.$extension differs from the one compiled on its own"
+                break 2
+            fi
+        done
+    done
+fi
+
+# A compile server round trip: the files it wrote, then the cached tokens of a file whose size and time did not change
+printf 'program served;\nbegin\n    writeln(%s)\nend.\n' "'first'" > "$WORK/served.pas"
+"$PCOMP" --server --socket "$WORK/socket" > "$WORK/server.log" 2>&1 &
+server=$!
+tries=0
+while [ ! -S "$WORK/socket" ] && [ $tries -lt 50 ]; do
+    sleep 0.1
+    tries=$((tries + 1))
+done
+printf 'Output: %s\nResult: ok %s\n' "$WORK/served.s" "$WORK/served.pas" > "$WORK/served.reply"
+expect "server outputs" "$WORK/served.reply" "$PCOMP" --client --socket "$WORK/socket" -S "$WORK/served.pas"
+printf 'first\nResult: ok %s\n' "$WORK/served.pas" > "$WORK/served.reply"
+expect "server run" "$WORK/served.reply" "$PCOMP" --client --socket "$WORK/socket" --run "$WORK/served.pas"
+cp -p "$WORK/served.pas" "$WORK/served.orig"
+sed 's/first/other/' "$WORK/served.orig" > "$WORK/served.pas"
+touch -r "$WORK/served.orig" "$WORK/served.pas"
+expect "server cache hit" "$WORK/served.reply" "$PCOMP" --client --socket "$WORK/socket" --run "$WORK/served.pas"
+sed 's/first/other file/' "$WORK/served.orig" > "$WORK/served.pas"
+printf 'other file\nResult: ok %s\n' "$WORK/served.pas" > "$WORK/served.reply"
+expect "server cache miss" "$WORK/served.reply" "$PCOMP" --client --socket "$WORK/socket" --run "$WORK/served.pas"
+: > "$WORK/stopped.reply"
+stopped=$failures
+expect "server stop" "$WORK/stopped.reply" "$PCOMP" --stop-server --socket "$WORK/socket"
+if [ $failures -eq $stopped ]; then
+    wait $server || fail "server stop" "the server exited with $?"
+    server=
+fi
+
+echo "$((count - failures)) of $count driver checks passed"
+[ $failures -eq 0 ]
@@ -0,0 +1,8 @@
+program assign_builtin;
+{ true and false are constants, they can't be assigned }
+var x: integer;
+begin
+    true := 5;
+    x := true;
+    writeln(x)
+end.
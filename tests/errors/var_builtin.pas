@@ -0,0 +1,10 @@
+program var_builtin;
+{ A constant can't be passed by reference }
+procedure reset(var a: integer);
+begin
+    a := 0
+end;
+
+begin
+    reset(false)
+end.
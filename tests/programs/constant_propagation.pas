@@ -0,0 +1,65 @@
+program constant_propagation;
+{ Sparse conditional constant propagation: constants through branches, loops and calls, and branches never taken }
+const limit = 10; scale = 2.5;
+var g, h: integer;
+    r: real;
+    s: string;
+
+function pick(n: integer): integer;
+var x, y: integer;
+begin
+    x := 3;
+    if x > 2 then
+        y := 10
+    else
+        y := n;
+    pick := y + x
+end;
+
+function grow(n: integer): integer;
+var k, total: integer;
+begin
+    k := 1;
+    total := 0;
+    while k < n do
+    begin
+        total := total + k;
+        k := k * 2
+    end;
+    grow := total
+end;
+
+procedure never(n: integer);
+var z: integer;
+begin
+    z := 0;
+    if z <> 0 then
+        writeln('unreachable ', n)
+    else
+        writeln('reached ', n);
+    while z > 0 do
+        z := z - 1;
+    writeln('z=', z)
+end;
+
+begin
+    g := limit * 4 - 2;
+    h := g / 3;
+    writeln('g=', g, ' h=', h);
+    r := scale * 4.0;
+    writeln('r=', r);
+    s := 'con' + 'cat';
+    writeln(s);
+    writeln('pick=', pick(7));
+    writeln('grow=', grow(100));
+    never(5);
+    g := 0;
+    if g = 0 then
+        h := 1
+    else
+        h := 2;
+    writeln('h=', h);
+    g := 2147483647;
+    g := g + 1;
+    writeln('wrap=', g)
+end.
@@ -0,0 +1,64 @@
+program copies_dead_code;
+{ Copy propagation and dead code elimination: copy chains, copies broken by a later assignment, dead stores and function
+  results assigned on several paths }
+var g, h: integer;
+    s, t: string;
+
+function sign(n: integer): integer;
+begin
+    if n > 0 then
+        sign := 1
+    else if n < 0 then
+        sign := 0 - 1
+    else
+        sign := 0
+end;
+
+function chain(n: integer): integer;
+var a, b, c, unused: integer;
+begin
+    a := n;
+    b := a;
+    c := b;
+    unused := c * 100;
+    a := 5;
+    chain := c + a + b
+end;
+
+procedure swap_loop(n: integer);
+var x, y, t, i: integer;
+begin
+    x := 1;
+    y := 2;
+    for i := 1 to n do
+    begin
+        t := x;
+        x := y;
+        y := t
+    end;
+    writeln('x=', x, ' y=', y)
+end;
+
+procedure bump(n: integer);
+begin
+    g := g + n
+end;
+
+begin
+    h := 0 - 5;
+    writeln(sign(5), ' ', sign(h), ' ', sign(0));
+    writeln('chain=', chain(7));
+    swap_loop(3);
+    swap_loop(4);
+    g := 1;
+    h := g;
+    bump(10);
+    writeln('g=', g, ' h=', h);
+    s := 'first';
+    t := s;
+    s := 'second';
+    writeln(t, ' ', s);
+    h := 99;
+    h := 42;
+    writeln('h=', h)
+end.
@@ -0,0 +1,72 @@
+program loops;
+{ Loop invariant code motion and strength reduction: invariant expressions, multiplications of the counter, counters
+  stepping down, nested loops, loops that never run (nothing hoisted out of them may fail) and invariants changed inside }
+var g, total, i, j, zero, a: integer;
+
+function scaled(n, k: integer): integer;
+var i, sum: integer;
+begin
+    sum := 0;
+    for i := 1 to n do
+        sum := sum + i * 4 + k * k;
+    scaled := sum
+end;
+
+function down(n: integer): integer;
+var i, sum: integer;
+begin
+    sum := 0;
+    for i := n downto 1 do
+        sum := sum + i * 3;
+    down := sum
+end;
+
+function nested(n: integer): integer;
+var i, j, sum, row: integer;
+begin
+    sum := 0;
+    for i := 1 to n do
+    begin
+        row := i * 10;
+        for j := 1 to n do
+            sum := sum + row + j * 2
+    end;
+    nested := sum
+end;
+
+function varying(n: integer): integer;
+var i, k, sum: integer;
+begin
+    k := 1;
+    sum := 0;
+    i := 0;
+    while i < n do
+    begin
+        sum := sum + k * 5;
+        k := k + 1;
+        i := i + 1
+    end;
+    varying := sum
+end;
+
+begin
+    writeln('scaled=', scaled(10, 3));
+    writeln('down=', down(10));
+    writeln('nested=', nested(4));
+    writeln('varying=', varying(4));
+    zero := 0;
+    a := 7;
+    g := 0;
+    for i := 1 to 0 do
+        g := a / zero;
+    writeln('empty loop g=', g);
+    total := 0;
+    for i := 1 to 3 do
+        for j := i to 3 do
+            total := total + i * j;
+    writeln('triangle=', total);
+    g := 0;
+    for i := 1 to 5 do
+        g := g + i * 100;
+    writeln('i=', i, ' g=', g)
+end.
@@ -0,0 +1,37 @@
+program read_parse;
+{ read and readln: integers of any length, signs and wrapping, reals in both notations rounded to the nearest float,
+  characters, strings up to the end of the line and the end of the input }
+var n, i, k: integer;
+    r: real;
+    c, none: char; { none is never assigned and stays #0 }
+    s: string;
+
+begin
+    readln(n);
+    for i := 1 to n do
+    begin
+        read(k);
+        write(k, ' ')
+    end;
+    writeln;
+    readln(n);
+    for i := 1 to n do
+    begin
+        read(r);
+        write(r, ' ')
+    end;
+    writeln;
+    readln;
+    read(c, c);
+    writeln('[', c, ']');
+    readln(s);
+    writeln('<', s, '>');
+    readln(s);
+    writeln('<', s, '>');
+    read(r, k);
+    writeln(r, ' ', k);
+    read(c);
+    read(c);
+    if c = none then
+        writeln('end of input')
+end.
@@ -0,0 +1,39 @@
+program sections;
+{ Constant, variable and routine sections in any order and any number, each one sees what the sections before it declared }
+const base = 10;
+var total: integer;
+const step = 3;
+var count: integer;
+    name: string;
+procedure add(n: integer);
+begin
+    total := total + n
+end;
+const limit = 4;
+var i: integer;
+function scaled(n: integer): integer;
+begin
+    scaled := n * step
+end;
+const greeting = 'sections';
+var last: integer;
+procedure report(n: integer);
+begin
+    writeln(name, ' ', total, ' ', n, ' ', last)
+end;
+const bonus = 1.5;
+var ratio: real;
+begin
+    name := greeting;
+    total := base;
+    count := 0;
+    for i := 1 to limit do
+    begin
+        last := scaled(i);
+        add(last);
+        count := count + 1
+    end;
+    ratio := bonus * bonus;
+    report(count);
+    writeln(ratio:0:2)
+end.
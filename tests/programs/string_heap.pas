@@ -0,0 +1,66 @@
+program string_heap;
+{ More strings than the interpreter and the JIT hold before collecting them: the ones still in a global, in the locals
+  of the calls under the running one, behind a var parameter or returned by a function survive every collection }
+var kept, word: string;
+    mark: string;
+    rounds, depth: integer;
+
+procedure churn(n: integer);
+{ About n times 100 bytes of strings dropped right away }
+var junk, piece: string;
+    i: integer;
+begin
+    piece := '012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789';
+    for i := 1 to n do
+        junk := piece + word;
+    if junk = piece then
+        writeln('lost')
+end;
+
+procedure grow(var s: string; n: integer);
+var i: integer;
+begin
+    for i := 1 to n do
+    begin
+        s := s + mark;
+        churn(rounds);
+        s := s + '..'
+    end
+end;
+
+function nest(level: integer): string;
+var mine, below: string;
+    next: integer;
+begin
+    mine := word + '::';
+    churn(rounds);
+    next := level - 1;
+    if level = 0 then
+        below := 'bottom'
+    else
+        below := nest(next);
+    churn(rounds);
+    nest := mine + below
+end;
+
+procedure local(n: integer);
+var own: string;
+begin
+    own := 'own';
+    grow(own, n);
+    writeln(own)
+end;
+
+begin
+    rounds := 20000;
+    depth := 4;
+    mark := '**';
+    word := 'ww';
+    kept := 'kept';
+    grow(kept, depth);
+    writeln(kept);
+    word := word + 'vv';
+    writeln(nest(depth));
+    local(depth);
+    writeln(kept, ' ', word)
+end.
@@ -0,0 +1,59 @@
+program value_numbering;
+{ Value numbering: repeated expressions in a block and in dominated blocks, and expressions that must be computed again
+  after one of their operands changes, also through a call or a reference }
+var g, h: integer;
+    r: real;
+
+procedure bump(n: integer);
+begin
+    g := g + n
+end;
+
+procedure twice(var x: integer);
+begin
+    x := x * 2
+end;
+
+function same(a, b: integer): integer;
+var x, y, z: integer;
+begin
+    x := a * b + 1;
+    y := a * b + 1;
+    if a > b then
+        z := a * b + 1
+    else
+        z := b * a + 2;
+    same := x + y + z
+end;
+
+function changed(a, b: integer): integer;
+var x, y, c: integer;
+begin
+    c := a;
+    x := c + b;
+    c := 10;
+    y := c + b;
+    changed := x * 100 + y
+end;
+
+function through_ref(a: integer): integer;
+var x, y, k: integer;
+begin
+    k := a;
+    x := k * 3;
+    twice(k);
+    y := k * 3;
+    through_ref := x * 1000 + y
+end;
+
+begin
+    writeln('same=', same(3, 4), ' ', same(4, 3));
+    writeln('changed=', changed(1, 2));
+    writeln('ref=', through_ref(5));
+    g := 2;
+    h := g * g;
+    bump(1);
+    writeln('g*g before=', h, ' after=', g * g);
+    r := 1.5;
+    writeln(r * r + r * r)
+end.
@@ -0,0 +1,41 @@
+program var_params;
+{ Locals passed by reference are redefined by the call, also when the same one is passed twice }
+var g1, g2: integer;
+
+procedure add(var x: integer; y: integer);
+begin
+    x := x + y
+end;
+
+procedure both(var x, y: integer);
+begin
+    x := x + 1;
+    y := y + 1
+end;
+
+procedure sum(n: integer);
+var i, k: integer;
+begin
+    k := 0;
+    for i := 1 to n do
+        add(k, i);
+    writeln('k=', k)
+end;
+
+function twice(a: integer): integer;
+var b: integer;
+begin
+    b := a;
+    both(b, b);
+    twice := b
+end;
+
+begin
+    sum(3);
+    sum(10);
+    g1 := 1;
+    g2 := twice(g1);
+    writeln('g2=', g2);
+    both(g1, g2);
+    writeln('g1=', g1, ' g2=', g2)
+end.
@@ -0,0 +1,33 @@
+program write_format;
+{ write and writeln: widths, decimals, shortest real digits, both notations, characters and strings }
+var i, n: integer;
+    r, big, small: real;
+    c: char;
+    s: string;
+
+begin
+    i := 42;
+    n := 0 - 7;
+    writeln(i, ' ', n, ' ', 0);
+    writeln('[', i:6, '][', n:4, '][', i:1, ']');
+    i := 2147483647;
+    n := 0 - i - 1;
+    writeln(i, ' ', n);
+    r := 0.1;
+    writeln(r, ' ', r * 3.0, ' ', 1.0 / 3.0);
+    r := 2.5;
+    writeln('[', r:8:3, '][', r:0:0, '][', r:6, ']');
+    r := 0.0 - 1.125;
+    writeln(r:0:2, ' ', r:10:4);
+    big := 123456.0;
+    writeln(big, ' ', big * 10.0, ' ', big * 1000000.0);
+    small := 0.0001;
+    writeln(small, ' ', small / 10.0);
+    writeln(big:0:1, ' ', small:0:6);
+    c := 'x';
+    s := 'text';
+    writeln('[', c, '][', c:3, '][', s:6, '][', s:2, ']');
+    write('no newline');
+    writeln;
+    writeln(1.0 / 0.0, ' ', 0.0 - 1.0 / 0.0)
+end.
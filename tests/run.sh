@@ -0,0 +1,113 @@
+#!/bin/sh
+# Runs the programs of tests/programs (or the ones named as arguments) at -O0, -O1 and -O2 on every backend and compares
+# their output with <program>.out, the input comes from <program>.in when there is one. The programs of tests/errors
+# must be rejected with the diagnostics of <program>.err and no output file, with or without -fsyntax-only, which must
+# accept the others silently without writing any file. Exits with 1 on any difference.
+# PCOMP and CC select the compiler and the C compiler.
+
+TESTS_DIR=$(cd "$(dirname "$0")" && pwd)/programs
+ERRORS_DIR=$(cd "$(dirname "$0")" && pwd)/errors
+PCOMP=$(cd "$(dirname "${PCOMP:-$TESTS_DIR/../../pcomp}")" && pwd)/$(basename "${PCOMP:-pcomp}")
+CC=${CC:-cc}
+
+if [ ! -x "$PCOMP" ]; then
+    echo "Error: build the compiler first (make test)" >&2
+    exit 1
+fi
+if [ $# -eq 0 ]; then
+    set -- $(cd "$TESTS_DIR" && ls *.pas | sed 's/\.pas$//') $(cd "$ERRORS_DIR" && ls *.pas | sed 's/\.pas$//')
+fi
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+failures=0
+count=0
+
+check() { # program level backend command..., the output of the command against the expected one
+    program=$1
+    level=$2
+    backend=$3
+    shift 3
+    count=$((count + 1))
+    input=$TESTS_DIR/$program.in
+    [ -f "$input" ] || input=/dev/null
+    if ! "$@" < "$input" > "$WORK/out" 2>&1 || ! cmp -s "$WORK/out" "$TESTS_DIR/$program.out"; then
+        echo "FAIL $program $level $backend"
+        diff "$TESTS_DIR/$program.out" "$WORK/out" | head -n 10
+        failures=$((failures + 1))
+    fi
+}
+
+compiled() { # program level backend compile-status command...
+    if [ "$4" -ne 0 ]; then
+        count=$((count + 1))
+        echo "FAIL $1 $2 $3 (compile)"
+        failures=$((failures + 1))
+        return
+    fi
+    program=$1
+    level=$2
+    backend=$3
+    shift 4
+    check "$program" "$level" "$backend" "$@"
+}
+
+rejected() { # program options..., the diagnostics of the compilation against the expected ones
+    program=$1
+    shift
+    count=$((count + 1))
+    rm -f "$WORK"/*
+    cp "$ERRORS_DIR/$program.pas" "$WORK/"
+    if "$PCOMP" "$@" "$WORK/$program.pas" > "$WORK/out" 2>&1 || ! cmp -s "$WORK/out" "$ERRORS_DIR/$program.err" \
+        || [ "$(ls "$WORK" | wc -l)" -ne 2 ]; then # Only the source and the diagnostics
+        echo "FAIL $program $* (rejected)"
+        diff "$ERRORS_DIR/$program.err" "$WORK/out" | head -n 10
+        failures=$((failures + 1))
+    fi
+}
+
+checked() { # program, the program only checked for errors despite the output options
+    program=$1
+    count=$((count + 1))
+    rm -f "$WORK"/*
+    cp "$TESTS_DIR/$program.pas" "$WORK/"
+    if ! "$PCOMP" -fsyntax-only -S -c -static -C -pbc "$WORK/$program.pas" > "$WORK/out" 2>&1 || [ -s "$WORK/out" ] \
+        || [ "$(ls "$WORK" | wc -l)" -ne 2 ]; then # Only the source and the empty diagnostics
+        echo "FAIL $program -fsyntax-only"
+        head -n 10 "$WORK/out"
+        failures=$((failures + 1))
+    fi
+}
+
+for program in "$@"; do
+    if [ -f "$ERRORS_DIR/$program.pas" ] && [ -f "$ERRORS_DIR/$program.err" ]; then
+        rejected "$program" -S -c -static -C -pbc
+        rejected "$program" -fsyntax-only -S -c -static -C -pbc
+        continue
+    fi
+    if [ ! -f "$TESTS_DIR/$program.pas" ] || [ ! -f "$TESTS_DIR/$program.out" ]; then
+        echo "Error: no test $program with its expected output" >&2
+        failures=$((failures + 1))
+        continue
+    fi
+    checked "$program"
+    for level in -O0 -O1 -O2; do
+        rm -f "$WORK"/*
+        cp "$TESTS_DIR/$program.pas" "$WORK/"
+        source=$WORK/$program.pas
+        base=$WORK/$program
+        check "$program" $level run "$PCOMP" $level --run "$source"
+        check "$program" $level jit "$PCOMP" $level --jit "$source"
+        "$PCOMP" $level -pbc "$source" >/dev/null
+        compiled "$program" $level bytecode $? "$PCOMP" "$base.pbc"
+        "$PCOMP" $level -C "$source" >/dev/null && "$CC" -O2 -w "$base.c" -o "$base.c.exe"
+        compiled "$program" $level c $? "$base.c.exe"
+        "$PCOMP" $level -S "$source" >/dev/null && "$CC" "$base.s" -o "$base.s.exe"
+        compiled "$program" $level native $? "$base.s.exe"
+        "$PCOMP" $level -static "$source" >/dev/null
+        compiled "$program" $level static $? "$base"
+        "$PCOMP" $level -regalloc "$source" >/dev/null && "$PCOMP" $level -regalloc -static "$source" >/dev/null
+        compiled "$program" $level regalloc $? "$base"
+    done
+done
+echo "$((count - failures)) of $count runs passed"
+[ $failures -eq 0 ]